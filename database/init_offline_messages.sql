@@ -0,0 +1,21 @@
+-- MyTelegram 离线消息表初始化脚本
+-- 执行前请确保已连接到testdb数据库
+
+-- 接收方不在线时的点对点消息，登录时按页投递后删除
+-- 主键 (recipient_id, msg_id) 即 InnoDB 聚簇索引：同一接收方的消息按消息ID连续存放，
+-- 登录时的 "WHERE recipient_id = ? AND msg_id > ? ORDER BY msg_id LIMIT ?" 和按页删除都是主键范围扫描
+CREATE TABLE IF NOT EXISTS offline_messages (
+    recipient_id BIGINT NOT NULL COMMENT '接收方用户ID',
+    msg_id BIGINT UNSIGNED NOT NULL COMMENT '服务器消息ID（递增）',
+    sender_id BIGINT NOT NULL COMMENT '发送方用户ID',
+    timestamp_ms BIGINT NOT NULL COMMENT '服务器接收时间（unix毫秒）',
+    content VARBINARY(16384) NOT NULL COMMENT '消息内容',
+
+    PRIMARY KEY (recipient_id, msg_id)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci COMMENT='离线消息表';
+
+-- 验证表创建成功
+SELECT 'Offline messages table created successfully' AS status;
+
+-- 显示表结构
+DESCRIBE offline_messages;
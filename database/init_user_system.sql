@@ -2,16 +2,15 @@
 -- 执行前请确保已连接到testdb数据库
 
 -- 创建用户表
+-- 索引只保留查询真正用到的两个：主键 user_id（按ID查询）和 username 上的唯一索引（登录查询 + 重名检测）。
+-- UNIQUE 约束本身就是一个 B+ 树索引，再建同列的 INDEX 只会让每次 INSERT 多维护一棵树；
+-- 服务器不按 created_at 查询，也不为它建索引。已有库用 migrate_user_indexes.sql 删除多余索引。
 CREATE TABLE IF NOT EXISTS users (
     user_id BIGINT AUTO_INCREMENT PRIMARY KEY COMMENT '用户ID',
     username VARCHAR(50) UNIQUE NOT NULL COMMENT '用户名',
     password_hash VARCHAR(255) NOT NULL COMMENT '密码哈希',
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP COMMENT '创建时间',
-    updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP COMMENT '更新时间',
-    
-    -- 添加索引提高查询性能
-    INDEX idx_username (username),
-    INDEX idx_created_at (created_at)
+    updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP ON UPDATE CURRENT_TIMESTAMP COMMENT '更新时间'
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci COMMENT='用户表';
 
 -- 创建测试用户（可选）
@@ -0,0 +1,12 @@
+-- MyTelegram 用户表索引迁移脚本
+-- 用旧版 init_user_system.sql 建的库执行一次；新建的库不需要执行
+-- 执行前请确保已连接到testdb数据库
+
+-- username 上已有 UNIQUE 约束生成的唯一索引，idx_username 与它重复
+ALTER TABLE users DROP INDEX idx_username;
+
+-- 服务器的查询不使用 created_at
+ALTER TABLE users DROP INDEX idx_created_at;
+
+-- 剩余索引应为 PRIMARY 和 username
+SHOW INDEX FROM users;
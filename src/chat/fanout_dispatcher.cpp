@@ -0,0 +1,139 @@
+#include "fanout_dispatcher.h"
+#include <algorithm>
+#include "../server/io_context_pool.h"
+#include "../server/session.h"
+#include "../server/session_manager.h"
+#include "../protocol/protocol_handler.h"
+
+FanoutDispatcher::FanoutDispatcher(IoContextPool &io_pool)
+    : io_pool_(io_pool),
+      fanout_sessions_(MetricsRegistry::get_instance().counter("im_fanout_sessions_total",
+                                                               "Sessions a shared frame was handed to")),
+      fanout_batches_(MetricsRegistry::get_instance().counter("im_fanout_batches_total",
+                                                              "Fan-out batches posted to io_context threads")),
+      dropped_backlog_(MetricsRegistry::get_instance().counter("im_fanout_dropped_total",
+                                                               "Fan-out frames a member session did not take",
+                                                               MetricsRegistry::label("reason", "backlog"))),
+      dropped_closed_(MetricsRegistry::get_instance().counter("im_fanout_dropped_total",
+                                                              "Fan-out frames a member session did not take",
+                                                              MetricsRegistry::label("reason", "closed")))
+{
+}
+
+SharedFrame FanoutDispatcher::make_shared_frame(const Packet &packet)
+{
+    auto frame = std::make_shared<std::string>();
+    if (!ProtocolHandler::serialize_frame_into(packet, *frame))
+    {
+        return nullptr;
+    }
+    return frame;
+}
+
+size_t FanoutDispatcher::deliver_to_users(const std::vector<int64_t> &user_ids, const SharedFrame &frame,
+                                          const Session *exclude)
+{
+    if (!frame || user_ids.empty())
+    {
+        return 0;
+    }
+
+    std::vector<std::shared_ptr<Session>> sessions;
+    sessions.reserve(user_ids.size());
+    SessionManager::get_instance().collect_user_sessions(user_ids, sessions, exclude);
+    return dispatch(std::move(sessions), frame);
+}
+
+size_t FanoutDispatcher::broadcast(const SharedFrame &frame)
+{
+    if (!frame)
+    {
+        return 0;
+    }
+
+    auto &manager = SessionManager::get_instance();
+    std::vector<std::shared_ptr<Session>> sessions;
+    sessions.reserve(manager.get_active_session_count());
+    manager.for_each_session([&sessions](const std::shared_ptr<Session> &session)
+                             { sessions.push_back(session); });
+    return dispatch(std::move(sessions), frame);
+}
+
+/**
+ * 按 io_index 分组后每 BATCH_SIZE 个一批 post 到会话所在的 io_context；
+ * 批内对每个会话调用 send_frame：只复制 shared_ptr，收件箱由空变非空时才唤醒会话一次
+ */
+size_t FanoutDispatcher::dispatch(std::vector<std::shared_ptr<Session>> sessions, const SharedFrame &frame)
+{
+    size_t total = sessions.size();
+    if (total == 0)
+    {
+        return 0;
+    }
+    fanout_sessions_.add(total);
+
+    if (total <= INLINE_LIMIT)
+    {
+        send_to(sessions, frame);
+        return total;
+    }
+
+    size_t context_count = io_pool_.context_count();
+    std::vector<std::vector<std::shared_ptr<Session>>> by_context(context_count);
+    for (auto &session : sessions)
+    {
+        auto &group = by_context[session->io_index() % context_count];
+        if (group.empty())
+        {
+            group.reserve(std::min(total, BATCH_SIZE));
+        }
+        group.push_back(std::move(session));
+
+        if (group.size() == BATCH_SIZE)
+        {
+            size_t index = &group - by_context.data();
+            asio::post(io_pool_.context(index),
+                       [this, batch = std::move(group), frame]()
+                       { send_to(batch, frame); });
+            group.clear();
+            fanout_batches_.add();
+        }
+    }
+
+    for (size_t i = 0; i < context_count; ++i)
+    {
+        if (by_context[i].empty())
+        {
+            continue;
+        }
+        asio::post(io_pool_.context(i),
+                   [this, batch = std::move(by_context[i]), frame]()
+                   { send_to(batch, frame); });
+        fanout_batches_.add();
+    }
+    return total;
+}
+
+/**
+ * 逐个调用 send_frame；积压满或已关闭的成员只丢这一帧，不阻塞也不影响同批的其他成员
+ */
+void FanoutDispatcher::send_to(const std::vector<std::shared_ptr<Session>> &sessions, const SharedFrame &frame)
+{
+    size_t backlog = 0;
+    size_t closed = 0;
+    for (const auto &session : sessions)
+    {
+        if (!session->send_frame(frame))
+        {
+            ++(session->is_closed() ? closed : backlog);
+        }
+    }
+    if (backlog > 0)
+    {
+        dropped_backlog_.add(backlog);
+    }
+    if (closed > 0)
+    {
+        dropped_closed_.add(closed);
+    }
+}
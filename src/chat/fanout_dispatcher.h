@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <messages.pb.h>
+#include "../server/outbound_queue.h"
+#include "../metrics/metrics_registry.h"
+
+class IoContextPool;
+class Session;
+
+/**
+ * @brief 一对多投递（群消息、全员广播）
+ *
+ * 帧只序列化一次，放进引用计数的只读缓冲区（SharedFrame），每个接收方的出站队列只持有一个引用，
+ * 不复制字节。扇出工作按接收方所在的 io_context 分组、每 BATCH_SIZE 个会话一批，
+ * 投递到对应的 io_context 上执行，发送方线程只负责查成员和分组，不会因为一个大群被占住几毫秒。
+ * 接收方不多（<= INLINE_LIMIT）时直接在调用线程投递，省掉一次 post。
+ * 每个接收方受 Session::send_frame 的积压硬上限约束：读得太慢的成员丢掉这一帧，按原因计数，不影响其他成员。
+ */
+class FanoutDispatcher
+{
+public:
+    static constexpr size_t INLINE_LIMIT = 64;
+    static constexpr size_t BATCH_SIZE = 1024;
+
+    explicit FanoutDispatcher(IoContextPool &io_pool);
+
+    FanoutDispatcher(const FanoutDispatcher &) = delete;
+    FanoutDispatcher &operator=(const FanoutDispatcher &) = delete;
+
+    // 编码为共享帧，失败（超过 MAX_FRAME_SIZE）时返回空指针
+    static SharedFrame make_shared_frame(const Packet &packet);
+
+    /**
+     * @brief 投递给一组用户的所有在线会话
+     * @param user_ids 接收方 user_id（如群成员快照）
+     * @param frame 共享帧
+     * @param exclude 跳过的会话（发送方当前会话），可以为空
+     * @return 交给投递的会话数（包括之后因积压或已关闭被丢弃的）
+     */
+    size_t deliver_to_users(const std::vector<int64_t> &user_ids, const SharedFrame &frame,
+                            const Session *exclude = nullptr);
+
+    // 投递给所有已注册的会话（系统公告等），返回会话数
+    size_t broadcast(const SharedFrame &frame);
+
+private:
+    size_t dispatch(std::vector<std::shared_ptr<Session>> sessions, const SharedFrame &frame);
+    void send_to(const std::vector<std::shared_ptr<Session>> &sessions, const SharedFrame &frame);
+
+    IoContextPool &io_pool_;
+    Counter &fanout_sessions_;
+    Counter &fanout_batches_;
+    Counter &dropped_backlog_;
+    Counter &dropped_closed_;
+};
@@ -0,0 +1,136 @@
+#include "group_manager.h"
+#include <algorithm>
+
+GroupManager &GroupManager::get_instance()
+{
+    static GroupManager instance;
+    return instance;
+}
+
+int64_t GroupManager::create_group(int64_t owner_id, const std::string &name, const std::vector<int64_t> &member_ids)
+{
+    auto members = std::make_shared<std::vector<int64_t>>();
+    members->reserve(std::min(member_ids.size() + 1, MAX_MEMBERS));
+    members->push_back(owner_id);
+    for (size_t i = 0; i < member_ids.size() && members->size() < MAX_MEMBERS; ++i)
+    {
+        if (member_ids[i] > 0)
+        {
+            members->push_back(member_ids[i]);
+        }
+    }
+    std::sort(members->begin(), members->end());
+    members->erase(std::unique(members->begin(), members->end()), members->end());
+    members->shrink_to_fit();
+
+    int64_t group_id = next_group_id_.fetch_add(1, std::memory_order_relaxed);
+    auto &shard = shards_[shard_of(group_id)];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto &group = shard.groups[group_id];
+        group.name = name;
+        group.owner_id = owner_id;
+        group.members = std::move(members);
+    }
+    group_count_.fetch_add(1, std::memory_order_relaxed);
+    return group_id;
+}
+
+GroupManager::Result GroupManager::join(int64_t group_id, int64_t user_id)
+{
+    auto &shard = shards_[shard_of(group_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.groups.find(group_id);
+    if (it == shard.groups.end())
+    {
+        return Result::NOT_FOUND;
+    }
+
+    const auto &current = *it->second.members;
+    auto pos = std::lower_bound(current.begin(), current.end(), user_id);
+    if (pos != current.end() && *pos == user_id)
+    {
+        return Result::ALREADY_MEMBER;
+    }
+    if (current.size() >= MAX_MEMBERS)
+    {
+        return Result::FULL;
+    }
+
+    // 写时复制：正在扇出的线程继续使用旧快照
+    auto updated = std::make_shared<std::vector<int64_t>>();
+    updated->reserve(current.size() + 1);
+    updated->insert(updated->end(), current.begin(), pos);
+    updated->push_back(user_id);
+    updated->insert(updated->end(), pos, current.end());
+    it->second.members = std::move(updated);
+    return Result::OK;
+}
+
+GroupManager::Result GroupManager::leave(int64_t group_id, int64_t user_id)
+{
+    auto &shard = shards_[shard_of(group_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.groups.find(group_id);
+    if (it == shard.groups.end())
+    {
+        return Result::NOT_FOUND;
+    }
+
+    const auto &current = *it->second.members;
+    auto pos = std::lower_bound(current.begin(), current.end(), user_id);
+    if (pos == current.end() || *pos != user_id)
+    {
+        return Result::NOT_MEMBER;
+    }
+
+    if (current.size() == 1)
+    {
+        // 最后一个成员退出，群组随之删除
+        shard.groups.erase(it);
+        group_count_.fetch_sub(1, std::memory_order_relaxed);
+        return Result::OK;
+    }
+
+    auto updated = std::make_shared<std::vector<int64_t>>();
+    updated->reserve(current.size() - 1);
+    updated->insert(updated->end(), current.begin(), pos);
+    updated->insert(updated->end(), pos + 1, current.end());
+    it->second.members = std::move(updated);
+    return Result::OK;
+}
+
+GroupManager::MemberList GroupManager::members(int64_t group_id) const
+{
+    const auto &shard = shards_[shard_of(group_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.groups.find(group_id);
+    return it == shard.groups.end() ? nullptr : it->second.members;
+}
+
+bool GroupManager::is_member(int64_t group_id, int64_t user_id) const
+{
+    auto snapshot = members(group_id);
+    return snapshot && std::binary_search(snapshot->begin(), snapshot->end(), user_id);
+}
+
+const char *GroupManager::result_to_string(Result result)
+{
+    switch (result)
+    {
+    case Result::OK:
+        return "ok";
+    case Result::NOT_FOUND:
+        return "group not found";
+    case Result::ALREADY_MEMBER:
+        return "already a member";
+    case Result::NOT_MEMBER:
+        return "not a member";
+    case Result::FULL:
+        return "group is full";
+    }
+    return "unknown";
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief 群组成员表（内存）
+ *
+ * 成员列表是按 user_id 排序的 std::vector<int64_t>：每个成员 8 字节，1 万人的群约 80KB，
+ * 查成员资格二分查找，比 unordered_set（每个节点约 40 字节 + 桶数组）紧凑得多，遍历也是顺序访问。
+ *
+ * 成员列表写时复制：members() 返回 shared_ptr<const vector> 快照，扇出在锁外遍历快照，
+ * 加入 / 退出在分片锁内复制一份新数组再替换指针。群消息远多于成员变更，复制的代价摊得很薄。
+ * 群表按 group_id 拆成 SHARD_COUNT 个分片，每个分片一把锁。
+ *
+ * 群组只保存在内存中，进程重启后需要重新创建。
+ */
+class GroupManager
+{
+public:
+    static constexpr size_t SHARD_COUNT = 32;
+    static constexpr size_t MAX_MEMBERS = 100000;
+
+    using MemberList = std::shared_ptr<const std::vector<int64_t>>;
+
+    enum class Result
+    {
+        OK,
+        NOT_FOUND,
+        ALREADY_MEMBER,
+        NOT_MEMBER,
+        FULL
+    };
+
+    static GroupManager &get_instance();
+
+    GroupManager(const GroupManager &) = delete;
+    GroupManager &operator=(const GroupManager &) = delete;
+
+    /**
+     * @brief 创建群组，创建者自动成为成员
+     * @param member_ids 初始成员（可以重复或包含创建者，会去重），连同创建者超过 MAX_MEMBERS 的部分忽略
+     * @return 新群组ID
+     */
+    int64_t create_group(int64_t owner_id, const std::string &name, const std::vector<int64_t> &member_ids);
+
+    Result join(int64_t group_id, int64_t user_id);
+    Result leave(int64_t group_id, int64_t user_id);
+
+    // 成员列表快照，群组不存在时为空指针
+    MemberList members(int64_t group_id) const;
+
+    bool is_member(int64_t group_id, int64_t user_id) const;
+
+    size_t group_count() const { return group_count_.load(std::memory_order_relaxed); }
+
+    static const char *result_to_string(Result result);
+
+private:
+    GroupManager() = default;
+    ~GroupManager() = default;
+
+    struct Group
+    {
+        std::string name;
+        int64_t owner_id = 0;
+        MemberList members;
+    };
+
+    struct alignas(64) Shard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<int64_t, Group> groups;
+    };
+
+    static size_t shard_of(int64_t group_id)
+    {
+        return static_cast<size_t>(group_id) & (SHARD_COUNT - 1);
+    }
+
+    std::array<Shard, SHARD_COUNT> shards_;
+    std::atomic<int64_t> next_group_id_{1};
+    std::atomic<size_t> group_count_{0};
+};
@@ -0,0 +1,28 @@
+#include "message_id.h"
+#include <chrono>
+
+MessageIdGenerator &MessageIdGenerator::get_instance()
+{
+    static MessageIdGenerator instance;
+    return instance;
+}
+
+static uint64_t start_of_now()
+{
+    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+    return static_cast<uint64_t>(now_ms) << 16;
+}
+
+MessageIdGenerator::MessageIdGenerator()
+{
+    next_.store(start_of_now(), std::memory_order_relaxed);
+}
+
+void MessageIdGenerator::set_node(uint32_t node_id)
+{
+    uint64_t node_bits = (node_id - 1) & ((1u << NODE_BITS) - 1);
+    step_ = uint64_t{1} << NODE_BITS;
+    next_.store((start_of_now() & ~(step_ - 1)) | node_bits, std::memory_order_relaxed);
+}
@@ -0,0 +1,409 @@
+#include "offline_store.h"
+#include "../database/query.h"
+#include "../logging/log_limiter.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    // 写入失败后重试前的等待，数据库不可用时不空转
+    constexpr std::chrono::milliseconds RETRY_BACKOFF{1000};
+
+    constexpr const char *INSERT_PREFIX =
+        "INSERT IGNORE INTO offline_messages (recipient_id, msg_id, sender_id, timestamp_ms, content) VALUES ";
+
+    constexpr const char *SQL_SELECT_PAGE =
+        "SELECT msg_id, sender_id, timestamp_ms, content FROM offline_messages "
+        "WHERE recipient_id = ? AND msg_id > ? ORDER BY msg_id LIMIT ?";
+    constexpr const char *DELETE_PREFIX = "DELETE FROM offline_messages WHERE recipient_id = ? AND msg_id IN (";
+
+    std::string build_insert_sql(size_t rows)
+    {
+        std::string sql(INSERT_PREFIX);
+        sql.reserve(sql.size() + rows * 17);
+        for (size_t i = 0; i < rows; ++i)
+        {
+            sql += i == 0 ? "(?, ?, ?, ?, ?)" : ", (?, ?, ?, ?, ?)";
+        }
+        return sql;
+    }
+
+    std::string build_delete_sql(size_t ids)
+    {
+        std::string sql(DELETE_PREFIX);
+        sql.reserve(sql.size() + ids * 3 + 1);
+        for (size_t i = 0; i < ids; ++i)
+        {
+            sql += i == 0 ? "?" : ", ?";
+        }
+        sql += ")";
+        return sql;
+    }
+
+    void log_sql_error(const char *what, PooledConnection &conn, const sql::SQLException &e)
+    {
+        conn.invalidate_if_lost(e);
+        LOG_RATE_LIMITED(spdlog::level::err, "Offline store {} failed: {} (code: {}, state: {})",
+                         what, e.what(), e.getErrorCode(), e.getSQLState());
+    }
+}
+
+OfflineMessageStore &OfflineMessageStore::get_instance()
+{
+    static OfflineMessageStore instance;
+    return instance;
+}
+
+OfflineMessageStore::OfflineMessageStore()
+    : stored_(MetricsRegistry::get_instance().counter("im_offline_messages_total", "Offline messages by outcome",
+                                                      MetricsRegistry::label("result", "stored"))),
+      rejected_(MetricsRegistry::get_instance().counter("im_offline_messages_total", "Offline messages by outcome",
+                                                        MetricsRegistry::label("result", "rejected"))),
+      dropped_(MetricsRegistry::get_instance().counter("im_offline_messages_total", "Offline messages by outcome",
+                                                       MetricsRegistry::label("result", "dropped"))),
+      batches_(MetricsRegistry::get_instance().counter("im_offline_store_batches_total",
+                                                       "Group commits written to the offline message table")),
+      write_errors_(MetricsRegistry::get_instance().counter("im_offline_store_write_errors_total",
+                                                            "Offline store batch writes that failed and were retried")),
+      batch_latency_(MetricsRegistry::get_instance().histogram("im_db_query_duration_seconds",
+                                                               "Time spent executing SQL statements",
+                                                               MetricsRegistry::label("query", "insert_offline_batch")))
+{
+}
+
+OfflineMessageStore::~OfflineMessageStore()
+{
+    shutdown();
+}
+
+bool OfflineMessageStore::initialize(const Config::OfflineStoreConfig &config)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (started_)
+    {
+        return true;
+    }
+    if (!config.enabled)
+    {
+        spdlog::info("Offline message store disabled");
+        return true;
+    }
+
+    batch_size_ = static_cast<size_t>(std::max(1, config.batch_size));
+    flush_interval_ = std::chrono::milliseconds(std::max(1, config.flush_interval_ms));
+    max_pending_ = static_cast<size_t>(std::max(1, config.max_pending));
+    page_size_ = static_cast<size_t>(std::max(1, config.page_size));
+    max_drain_messages_ = static_cast<size_t>(std::max(1, config.max_drain_messages));
+
+    full_batch_sql_ = build_insert_sql(batch_size_);
+    full_delete_sql_ = build_delete_sql(page_size_);
+    pending_.reserve(batch_size_);
+    stopping_ = false;
+    started_ = true;
+    writer_thread_ = std::thread([this]()
+                                 { writer_loop(); });
+
+    spdlog::info("Offline message store started (batch {}, flush every {}ms, max pending {})",
+                 batch_size_, flush_interval_.count(), max_pending_);
+    return true;
+}
+
+void OfflineMessageStore::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_ || stopping_)
+        {
+            return;
+        }
+        stopping_ = true;
+    }
+    writer_cv_.notify_one();
+    if (writer_thread_.joinable())
+    {
+        writer_thread_.join();
+    }
+    spdlog::info("Offline message store stopped");
+}
+
+bool OfflineMessageStore::append(OfflineMessage message)
+{
+    bool wake_writer = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_ || stopping_ || pending_.size() >= max_pending_)
+        {
+            rejected_.add();
+            return false;
+        }
+        if (pending_.empty())
+        {
+            oldest_pending_at_ = std::chrono::steady_clock::now();
+        }
+        pending_.push_back(std::move(message));
+        ++appended_seq_;
+        // 写线程在按时间等待；只有第一条（开始计时）和攒满一批时需要叫醒它
+        wake_writer = pending_.size() == 1 || pending_.size() == batch_size_;
+    }
+    if (wake_writer)
+    {
+        writer_cv_.notify_one();
+    }
+    return true;
+}
+
+bool OfflineMessageStore::flush(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!started_)
+    {
+        return true;
+    }
+
+    uint64_t target = appended_seq_;
+    if (retired_seq_ >= target)
+    {
+        return true;
+    }
+
+    ++flush_waiters_;
+    writer_cv_.notify_one();
+    bool done = retired_cv_.wait_for(lock, timeout, [this, target]()
+                                     { return retired_seq_ >= target; });
+    --flush_waiters_;
+    return done;
+}
+
+size_t OfflineMessageStore::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+/**
+ * 组提交循环：
+ * 1. 等到日志非空，再等到 攒满 batch_size / 最早一条超过 flush_interval / 有 flush() 在等 / 停止
+ * 2. 整段日志换出（swap，不复制），释放锁后写库，期间新消息继续追加到空日志
+ * 3. 成功：推进 retired_seq_ 唤醒 flush()；失败：整批放回日志头部保持 FIFO，超出上限的最旧消息丢弃，退避后重试
+ * 停止时写完剩余日志才退出；停止过程中写入失败的消息直接丢弃并记录
+ */
+void OfflineMessageStore::writer_loop()
+{
+    std::vector<OfflineMessage> batch;
+    batch.reserve(batch_size_);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        writer_cv_.wait(lock, [this]()
+                        { return stopping_ || !pending_.empty(); });
+        if (pending_.empty())
+        {
+            break; // stopping_ 且日志已写完
+        }
+
+        writer_cv_.wait_until(lock, oldest_pending_at_ + flush_interval_, [this]()
+                              { return stopping_ || flush_waiters_ > 0 || pending_.size() >= batch_size_; });
+
+        batch.swap(pending_);
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = write_batch(batch);
+        batch_latency_.record(elapsed_us(start));
+
+        lock.lock();
+        if (ok)
+        {
+            stored_.add(batch.size());
+            retired_seq_ += batch.size();
+            batch.clear();
+            retired_cv_.notify_all();
+            continue;
+        }
+
+        write_errors_.add();
+        if (stopping_)
+        {
+            spdlog::error("Offline store stopping, {} message(s) could not be written and are lost", batch.size());
+            dropped_.add(batch.size());
+            retired_seq_ += batch.size();
+            batch.clear();
+            retired_cv_.notify_all();
+            continue;
+        }
+
+        // 失败的一批放回头部，后来追加的接在后面
+        batch.insert(batch.end(), std::make_move_iterator(pending_.begin()), std::make_move_iterator(pending_.end()));
+        pending_.swap(batch);
+        batch.clear();
+        if (pending_.size() > max_pending_)
+        {
+            size_t excess = pending_.size() - max_pending_;
+            LOG_RATE_LIMITED(spdlog::level::err, "Offline store backlog full, dropping {} oldest message(s)", excess);
+            pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(excess));
+            dropped_.add(excess);
+            retired_seq_ += excess;
+            retired_cv_.notify_all();
+        }
+        oldest_pending_at_ = std::chrono::steady_clock::now();
+        writer_cv_.wait_for(lock, RETRY_BACKOFF, [this]()
+                            { return stopping_; });
+    }
+}
+
+bool OfflineMessageStore::write_batch(const std::vector<OfflineMessage> &batch)
+{
+    auto conn = DatabaseManager::get_instance().get_connection();
+    if (!conn)
+    {
+        LOG_RATE_LIMITED(spdlog::level::warn, "Offline store could not borrow a database connection");
+        return false;
+    }
+
+    try
+    {
+        // 满批次的 SQL 文本固定，走连接的语句缓存；最后不足一批的行数不定，单独准备、用完即弃
+        sql::PreparedStatement *full_stmt = nullptr;
+        for (size_t offset = 0; offset < batch.size(); offset += batch_size_)
+        {
+            size_t rows = std::min(batch_size_, batch.size() - offset);
+            std::unique_ptr<sql::PreparedStatement> tail_stmt;
+            sql::PreparedStatement *stmt;
+            if (rows == batch_size_)
+            {
+                if (!full_stmt)
+                {
+                    full_stmt = conn.prepare(full_batch_sql_);
+                }
+                stmt = full_stmt;
+            }
+            else
+            {
+                tail_stmt.reset(conn->prepareStatement(build_insert_sql(rows)));
+                stmt = tail_stmt.get();
+            }
+
+            unsigned index = 1;
+            for (size_t i = offset; i < offset + rows; ++i)
+            {
+                const auto &message = batch[i];
+                stmt->setInt64(index++, message.recipient_id);
+                stmt->setUInt64(index++, message.msg_id);
+                stmt->setInt64(index++, message.sender_id);
+                stmt->setInt64(index++, message.timestamp_ms);
+                stmt->setString(index++, message.content);
+            }
+            stmt->executeUpdate();
+            batches_.add();
+        }
+        return true;
+    }
+    catch (sql::SQLException &e)
+    {
+        log_sql_error("batch insert", conn, e);
+        return false;
+    }
+    catch (const std::exception &e)
+    {
+        LOG_RATE_LIMITED(spdlog::level::err, "Offline store batch insert failed: {}", e.what());
+        return false;
+    }
+}
+
+bool OfflineMessageStore::fetch_page(int64_t recipient_id, uint64_t after_msg_id, size_t limit,
+                                     std::vector<OfflineMessage> &out)
+{
+    out.clear();
+    auto conn = DatabaseManager::get_instance().get_connection();
+    if (!conn)
+    {
+        return false;
+    }
+
+    try
+    {
+        static LatencyHistogram &select_latency = MetricsRegistry::get_instance().histogram(
+            "im_db_query_duration_seconds", "Time spent executing SQL statements",
+            MetricsRegistry::label("query", "select_offline_page"));
+        ScopedLatency timer(select_latency);
+
+        // 主键 (recipient_id, msg_id) 上的范围扫描，按主键顺序返回，不需要额外排序
+        auto rs = Query(conn, SQL_SELECT_PAGE).bind(recipient_id, after_msg_id, static_cast<int>(limit)).execute_query();
+        while (rs->next())
+        {
+            OfflineMessage message;
+            message.recipient_id = recipient_id;
+            message.msg_id = rs->getUInt64("msg_id");
+            message.sender_id = rs->getInt64("sender_id");
+            message.timestamp_ms = rs->getInt64("timestamp_ms");
+            message.content = rs->getString("content");
+            out.push_back(std::move(message));
+        }
+        return true;
+    }
+    catch (sql::SQLException &e)
+    {
+        log_sql_error("page select", conn, e);
+        return false;
+    }
+}
+
+bool OfflineMessageStore::remove_messages(int64_t recipient_id, const std::vector<uint64_t> &msg_ids)
+{
+    if (msg_ids.empty())
+    {
+        return true;
+    }
+
+    auto conn = DatabaseManager::get_instance().get_connection();
+    if (!conn)
+    {
+        return false;
+    }
+
+    try
+    {
+        static LatencyHistogram &delete_latency = MetricsRegistry::get_instance().histogram(
+            "im_db_query_duration_seconds", "Time spent executing SQL statements",
+            MetricsRegistry::label("query", "delete_offline_page"));
+        ScopedLatency timer(delete_latency);
+
+        // 与批量写入相同：整页的 SQL 文本固定，走连接的语句缓存；不足一页的单独准备、用完即弃
+        sql::PreparedStatement *full_stmt = nullptr;
+        for (size_t offset = 0; offset < msg_ids.size(); offset += page_size_)
+        {
+            size_t count = std::min(page_size_, msg_ids.size() - offset);
+            std::unique_ptr<sql::PreparedStatement> tail_stmt;
+            sql::PreparedStatement *stmt;
+            if (count == page_size_)
+            {
+                if (!full_stmt)
+                {
+                    full_stmt = conn.prepare(full_delete_sql_);
+                }
+                stmt = full_stmt;
+            }
+            else
+            {
+                tail_stmt.reset(conn->prepareStatement(build_delete_sql(count)));
+                stmt = tail_stmt.get();
+            }
+
+            unsigned index = 1;
+            stmt->setInt64(index++, recipient_id);
+            for (size_t i = offset; i < offset + count; ++i)
+            {
+                stmt->setUInt64(index++, msg_ids[i]);
+            }
+            stmt->executeUpdate();
+        }
+        return true;
+    }
+    catch (sql::SQLException &e)
+    {
+        log_sql_error("page delete", conn, e);
+        return false;
+    }
+}
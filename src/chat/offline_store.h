@@ -0,0 +1,122 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../config/config.h"
+#include "../metrics/metrics_registry.h"
+
+/**
+ * @brief 一条待投递的离线消息（点对点）
+ */
+struct OfflineMessage
+{
+    int64_t recipient_id = 0;
+    uint64_t msg_id = 0;
+    int64_t sender_id = 0;
+    int64_t timestamp_ms = 0;
+    std::string content;
+};
+
+/**
+ * @brief 离线消息存储（MySQL，批量写后落盘）
+ *
+ * 接收方不在线时 ChatHandler 调用 append()：消息只追加到内存日志，io 线程不碰数据库。
+ * 后台写线程按组提交：攒够 batch_size 条或最早一条已等待 flush_interval_ms 时，
+ * 把整段日志取走，用多行 INSERT 一次写入（一次往返、一次事务提交），
+ * 不再每条消息借一次连接、执行一次 INSERT。
+ *
+ * 表以 (recipient_id, msg_id) 为主键（InnoDB 聚簇索引），同一接收方的消息在磁盘上按消息 ID 连续存放，
+ * 登录时的分页读取是主键上的范围扫描，删除按已投递的消息 ID 逐个命中主键。写入用 INSERT IGNORE，失败重试时重复的行被忽略。
+ *
+ * 内存日志有上限（max_pending）：数据库长时间不可用时新消息被拒绝并计数，append() 返回 false，
+ * 发送方从 ChatAck 得知消息没有被保存。
+ */
+class OfflineMessageStore
+{
+public:
+    static OfflineMessageStore &get_instance();
+
+    // 启动后台写线程；未调用或 enabled=false 时 append() 返回 false
+    bool initialize(const Config::OfflineStoreConfig &config);
+
+    // 写完内存日志中剩余的消息后停止写线程
+    void shutdown();
+
+    bool is_enabled() const { return started_; }
+
+    // 追加到内存日志，可以从任意线程调用；日志已满或未启用时返回 false
+    bool append(OfflineMessage message);
+
+    /**
+     * @brief 等待调用之前追加的消息全部落盘（或确认丢弃）
+     * 登录取离线消息前调用，保证刚写进内存日志、尚未提交的消息也能读到
+     * @return false 如果超时
+     */
+    bool flush(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief 按消息 ID 升序读取一页离线消息
+     * @param after_msg_id 只返回 msg_id 大于它的消息（上一页最后一条），第一页传 0
+     * @return false 如果数据库出错
+     */
+    bool fetch_page(int64_t recipient_id, uint64_t after_msg_id, size_t limit, std::vector<OfflineMessage> &out);
+
+    /**
+     * @brief 按消息 ID 精确删除已投递 / 已确认的离线消息
+     * 只删除列出的 ID（msg_id IN (...)），不用范围删除：页取出之后才提交的、ID 更小的消息
+     * （发送方在上线前一刻查到接收方离线、其他节点的写后日志）不会被一起删掉
+     * @return false 如果数据库出错
+     */
+    bool remove_messages(int64_t recipient_id, const std::vector<uint64_t> &msg_ids);
+
+    size_t page_size() const { return page_size_; }
+    size_t max_drain_messages() const { return max_drain_messages_; }
+
+    // 内存日志中尚未提交的消息数
+    size_t pending() const;
+
+private:
+    OfflineMessageStore();
+    ~OfflineMessageStore();
+
+    OfflineMessageStore(const OfflineMessageStore &) = delete;
+    OfflineMessageStore &operator=(const OfflineMessageStore &) = delete;
+
+    void writer_loop();
+
+    // 以 batch_size 行为一组写入 MySQL，全部成功返回 true
+    bool write_batch(const std::vector<OfflineMessage> &batch);
+
+    size_t batch_size_ = 256;
+    std::chrono::milliseconds flush_interval_{20};
+    size_t max_pending_ = 100000;
+    size_t page_size_ = 100;
+    size_t max_drain_messages_ = 5000;
+    std::string full_batch_sql_; // batch_size_ 行的多行 INSERT，启动时拼好一次
+    std::string full_delete_sql_; // page_size_ 个 ID 的 DELETE ... IN，启动时拼好一次
+
+    mutable std::mutex mutex_;
+    std::condition_variable writer_cv_;  // 有新消息 / 需要立即刷新 / 停止
+    std::condition_variable retired_cv_; // 一批消息已提交或丢弃
+    std::vector<OfflineMessage> pending_;
+    std::chrono::steady_clock::time_point oldest_pending_at_;
+    // 追加序号与已退役（提交或丢弃）序号，日志按 FIFO 退役，flush() 等待 retired_seq_ 追上
+    uint64_t appended_seq_ = 0;
+    uint64_t retired_seq_ = 0;
+    size_t flush_waiters_ = 0;
+    bool stopping_ = false;
+    bool started_ = false;
+    std::thread writer_thread_;
+
+    Counter &stored_;
+    Counter &rejected_;
+    Counter &dropped_;
+    Counter &batches_;
+    Counter &write_errors_;
+    LatencyHistogram &batch_latency_;
+};
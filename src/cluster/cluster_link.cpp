@@ -0,0 +1,296 @@
+#include "cluster_link.h"
+#include "../logging/log_limiter.h"
+#include "../metrics/metrics_registry.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace
+{
+
+// 所有节点间连接共享的计数器：frames / writes 就是每次系统调用平均携带的帧数
+struct LinkMetrics
+{
+    Counter &frames;
+    Counter &writes;
+    Counter &bytes_sent;
+    Counter &connects;
+
+    static LinkMetrics &get()
+    {
+        static LinkMetrics metrics{
+            MetricsRegistry::get_instance().counter("im_cluster_link_frames_total", "Frames queued on inter-node links"),
+            MetricsRegistry::get_instance().counter("im_cluster_link_writes_total", "Gather writes issued on inter-node links"),
+            MetricsRegistry::get_instance().counter("im_cluster_link_bytes_sent_total", "Bytes written to other nodes"),
+            MetricsRegistry::get_instance().counter("im_cluster_link_connects_total", "Inter-node links established")};
+        return metrics;
+    }
+};
+
+} // namespace
+
+ClusterLink::ClusterLink(asio::io_context &io_context, const Config::ClusterConfig::Peer &peer,
+                         const Config::ClusterConfig &config, ConnectedCallback on_connected)
+    : io_context_(io_context), peer_(peer), socket_(io_context), resolver_(io_context), timer_(io_context),
+      reconnect_interval_(std::max(1, config.reconnect_interval_ms)),
+      max_pending_bytes_(static_cast<size_t>(std::max(1, config.link_max_pending_bytes))),
+      on_connected_(std::move(on_connected))
+{
+}
+
+ClusterLink::~ClusterLink()
+{
+    inbox_.clear();
+}
+
+void ClusterLink::start()
+{
+    running_ = true;
+    connect();
+}
+
+void ClusterLink::stop()
+{
+    running_ = false;
+    connected_.store(false, std::memory_order_release);
+
+    asio::error_code ignored;
+    timer_.cancel(ignored);
+    resolver_.cancel();
+    socket_.close(ignored);
+}
+
+bool ClusterLink::send(OutboundFrame frame)
+{
+    if (!connected())
+    {
+        return false;
+    }
+
+    size_t size = frame.size();
+    if (queued_bytes_.fetch_add(size, std::memory_order_relaxed) + size > max_pending_bytes_)
+    {
+        queued_bytes_.fetch_sub(size, std::memory_order_relaxed);
+        LOG_RATE_LIMITED(spdlog::level::warn, "Cluster link to node {} backlog exceeds {} bytes, dropping frame",
+                         peer_.node_id, max_pending_bytes_);
+        return false;
+    }
+
+    if (inbox_.push(std::move(frame)))
+    {
+        asio::post(io_context_, [this]()
+                   { drain_inbox(); });
+    }
+    return true;
+}
+
+void ClusterLink::push_direct(OutboundFrame frame)
+{
+    queued_bytes_.fetch_add(frame.size(), std::memory_order_relaxed);
+    outbound_.push(std::move(frame));
+    LinkMetrics::get().frames.add();
+}
+
+/**
+ * 解析 peer 地址并发起连接；旧 socket 上的读写回调还没结束时推迟到下一个重连间隔
+ * 连接超时与重连间隔共用 timer_：到点还没连上就关闭 socket，async_connect 以 operation_aborted 结束
+ */
+void ClusterLink::connect()
+{
+    if (!running_)
+    {
+        return;
+    }
+    if (reading_ || writing_)
+    {
+        schedule_reconnect();
+        return;
+    }
+
+    connecting_ = true;
+    resolver_.async_resolve(
+        peer_.host, std::to_string(peer_.port),
+        [this](std::error_code ec, asio::ip::tcp::resolver::results_type endpoints)
+        {
+            if (ec || !running_)
+            {
+                connecting_ = false;
+                if (ec != asio::error::operation_aborted)
+                {
+                    LOG_RATE_LIMITED(spdlog::level::warn, "Cannot resolve cluster node {} ({}): {}",
+                                     peer_.node_id, peer_.host, ec.message());
+                }
+                schedule_reconnect();
+                return;
+            }
+
+            asio::async_connect(socket_, endpoints,
+                                [this](std::error_code connect_ec, const asio::ip::tcp::endpoint &)
+                                {
+                                    connecting_ = false;
+                                    asio::error_code ignored;
+                                    timer_.cancel(ignored);
+                                    if (connect_ec || !running_)
+                                    {
+                                        LOG_RATE_LIMITED(spdlog::level::warn, "Cannot connect to cluster node {} at {}:{}: {}",
+                                                         peer_.node_id, peer_.host, peer_.port, connect_ec.message());
+                                        socket_.close(ignored);
+                                        schedule_reconnect();
+                                        return;
+                                    }
+                                    on_connected();
+                                });
+
+            timer_.expires_after(std::max(reconnect_interval_, std::chrono::milliseconds(1000)));
+            timer_.async_wait([this](std::error_code timer_ec)
+                              {
+                                  if (!timer_ec && connecting_)
+                                  {
+                                      asio::error_code ignored;
+                                      socket_.close(ignored);
+                                  }
+                              });
+        });
+}
+
+/**
+ * 连接建立：丢掉上一条连接残留的帧，由回调写入 Hello + 全量同步，再开放 send()
+ */
+void ClusterLink::on_connected()
+{
+    asio::error_code ignored;
+    socket_.set_option(asio::ip::tcp::no_delay(true), ignored);
+
+    discard_pending();
+    on_connected_(*this);
+    connected_.store(true, std::memory_order_release);
+    LinkMetrics::get().connects.add();
+    spdlog::info("Cluster link to node {} at {}:{} established", peer_.node_id, peer_.host, peer_.port);
+
+    do_read();
+    if (!writing_ && !outbound_.empty())
+    {
+        do_write();
+    }
+}
+
+void ClusterLink::schedule_reconnect()
+{
+    if (!running_)
+    {
+        return;
+    }
+    timer_.expires_after(reconnect_interval_);
+    timer_.async_wait([this](std::error_code ec)
+                      {
+                          if (!ec)
+                          {
+                              connect();
+                          }
+                      });
+}
+
+/**
+ * 读写任一方向出错都会调用，只处理第一次
+ */
+void ClusterLink::disconnect(const std::error_code &ec)
+{
+    if (!connected_.exchange(false, std::memory_order_acq_rel))
+    {
+        return;
+    }
+
+    if (ec != asio::error::operation_aborted)
+    {
+        spdlog::warn("Cluster link to node {} lost: {}", peer_.node_id, ec.message());
+    }
+
+    asio::error_code ignored;
+    socket_.close(ignored);
+    discard_pending();
+    schedule_reconnect();
+}
+
+void ClusterLink::do_read()
+{
+    reading_ = true;
+    socket_.async_read_some(asio::buffer(read_scratch_),
+                            [this](std::error_code ec, std::size_t)
+                            {
+                                reading_ = false;
+                                if (ec)
+                                {
+                                    disconnect(ec);
+                                    return;
+                                }
+                                do_read();
+                            });
+}
+
+void ClusterLink::do_write()
+{
+    writing_ = true;
+    LinkMetrics::get().writes.add();
+    asio::async_write(socket_, outbound_.prepare_write(),
+                      [this](std::error_code ec, std::size_t length)
+                      {
+                          size_t before = outbound_.pending_bytes();
+                          outbound_.consume_in_flight();
+                          queued_bytes_.fetch_sub(before - outbound_.pending_bytes(), std::memory_order_relaxed);
+                          LinkMetrics::get().bytes_sent.add(length);
+
+                          if (ec)
+                          {
+                              writing_ = false;
+                              disconnect(ec);
+                              discard_pending();
+                              return;
+                          }
+                          if (!connected())
+                          {
+                              writing_ = false;
+                              discard_pending();
+                              return;
+                          }
+
+                          if (!outbound_.empty())
+                          {
+                              do_write();
+                          }
+                          else
+                          {
+                              writing_ = false;
+                          }
+                      });
+}
+
+void ClusterLink::drain_inbox()
+{
+    if (!connected())
+    {
+        discard_pending();
+        return;
+    }
+
+    size_t frames = inbox_.consume_all([this](OutboundFrame &&frame)
+                                       { outbound_.push(std::move(frame)); });
+    LinkMetrics::get().frames.add(frames);
+
+    if (!writing_ && !outbound_.empty())
+    {
+        do_write();
+    }
+}
+
+// 丢弃收件箱和出站队列中的帧；写进行中时出站队列不动，由写回调处理
+void ClusterLink::discard_pending()
+{
+    size_t dropped = 0;
+    inbox_.consume_all([&dropped](OutboundFrame &&frame)
+                       { dropped += frame.size(); });
+    if (!writing_)
+    {
+        dropped += outbound_.pending_bytes();
+        outbound_.clear();
+    }
+    queued_bytes_.fetch_sub(dropped, std::memory_order_relaxed);
+}
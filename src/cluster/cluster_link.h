@@ -0,0 +1,88 @@
+#pragma once
+
+#define ASIO_STANDALONE
+#include <asio.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "../config/config.h"
+#include "../server/mpsc_queue.h"
+#include "../server/outbound_queue.h"
+
+/**
+ * @brief 到另一个节点的出站长连接
+ *
+ * 每个节点为每个 peer 保持一条出站连接，只用来发送（对方发给本节点的数据走它自己的出站连接），
+ * 帧格式与客户端协议相同（ProtocolHandler 的长度头 + Packet）。
+ *
+ * 批量发送：send() 可以从任意线程调用，帧经无锁收件箱交给集群线程，收件箱由空变非空时才投递一次；
+ * 写进行中到达的帧在出站队列里排队，上一次写完成后一次 gather 写全部发出。
+ * 负载越高每次系统调用携带的帧越多，不需要额外的攒批延迟。
+ *
+ * 连接断开时丢弃未发出的帧，按 reconnect_interval_ms 重连；重连成功后由 on_connected 回调
+ * 先写入 ClusterHello 和在线用户全量同步，然后才接受新的 send()。
+ * 除 send() 外的所有成员只在集群线程（所属 io_context）上访问。
+ */
+class ClusterLink
+{
+public:
+    using ConnectedCallback = std::function<void(ClusterLink &)>;
+
+    ClusterLink(asio::io_context &io_context, const Config::ClusterConfig::Peer &peer,
+                const Config::ClusterConfig &config, ConnectedCallback on_connected);
+    ~ClusterLink();
+
+    ClusterLink(const ClusterLink &) = delete;
+    ClusterLink &operator=(const ClusterLink &) = delete;
+
+    // 开始连接，集群线程上调用（或 io 线程启动之前）
+    void start();
+
+    // 停止重连并关闭连接，集群线程上调用
+    void stop();
+
+    /**
+     * @brief 发送一个编码好的帧，可以从任意线程调用
+     * @return false 如果连接当前不可用，或积压超过 link_max_pending_bytes（帧被丢弃）
+     */
+    bool send(OutboundFrame frame);
+
+    // 在 on_connected 回调中使用：直接进入出站队列，排在收件箱中的帧之前
+    void push_direct(OutboundFrame frame);
+
+    uint32_t node_id() const { return peer_.node_id; }
+    bool connected() const { return connected_.load(std::memory_order_acquire); }
+
+private:
+    void connect();
+    void on_connected();
+    void schedule_reconnect();
+    void disconnect(const std::error_code &ec);
+    void do_read();
+    void do_write();
+    void drain_inbox();
+    void discard_pending();
+
+    asio::io_context &io_context_;
+    Config::ClusterConfig::Peer peer_;
+    asio::ip::tcp::socket socket_;
+    asio::ip::tcp::resolver resolver_;
+    asio::steady_timer timer_; // 重连间隔 / 连接超时
+    std::chrono::milliseconds reconnect_interval_;
+    size_t max_pending_bytes_;
+    ConnectedCallback on_connected_;
+
+    MpscQueue<OutboundFrame> inbox_;
+    OutboundQueue outbound_;
+    std::atomic<size_t> queued_bytes_{0}; // 收件箱 + 出站队列中的字节数，send() 据此做上限检查
+    std::atomic<bool> connected_{false};
+    bool running_ = false;
+    bool connecting_ = false;
+    bool reading_ = false;
+    bool writing_ = false;
+
+    // 对端不会在这条连接上发数据，读只用来及时发现断开
+    std::array<char, 256> read_scratch_;
+};
@@ -0,0 +1,592 @@
+#include "cluster_node.h"
+#include "../chat/fanout_dispatcher.h"
+#include "../chat/message_id.h"
+#include "../logging/log_limiter.h"
+#include "../protocol/packet_arena.h"
+#include "../protocol/protocol_handler.h"
+#include "../server/read_buffer.h"
+#include "../server/session_manager.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+static int64_t unix_now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief 来自其他节点的入站连接，只读
+ * 第一帧必须是 ClusterHello，之后的每一帧交给 ClusterNode::on_packet；解析方式与 Session 相同（ReadBuffer + FrameView）
+ */
+class ClusterNode::InboundConnection : public std::enable_shared_from_this<InboundConnection>
+{
+public:
+    static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+    InboundConnection(ClusterNode &node, asio::ip::tcp::socket socket)
+        : node_(node), socket_(std::move(socket))
+    {
+    }
+
+    void start() { do_read(); }
+
+    void close()
+    {
+        if (closed_)
+        {
+            return;
+        }
+        closed_ = true;
+        asio::error_code ignored;
+        socket_.close(ignored);
+        node_.on_inbound_closed(*this);
+    }
+
+    uint32_t node_id() const { return node_id_; }
+
+private:
+    void do_read()
+    {
+        auto self(shared_from_this());
+        socket_.async_read_some(read_buffer_.prepare(READ_CHUNK_SIZE),
+                                [this, self](std::error_code ec, std::size_t length)
+                                {
+                                    if (ec)
+                                    {
+                                        if (node_id_ != 0 && ec != asio::error::operation_aborted)
+                                        {
+                                            spdlog::warn("Connection from cluster node {} closed: {}", node_id_, ec.message());
+                                        }
+                                        close();
+                                        return;
+                                    }
+                                    read_buffer_.commit(length);
+                                    process_frames();
+                                    if (!closed_)
+                                    {
+                                        do_read();
+                                    }
+                                });
+    }
+
+    void process_frames()
+    {
+        while (!closed_)
+        {
+            ProtocolHandler::FrameView frame;
+            size_t consumed_bytes;
+            if (!ProtocolHandler::parse_frame(read_buffer_.data(), read_buffer_.size(), frame, consumed_bytes))
+            {
+                if (consumed_bytes > 0)
+                {
+                    LOG_RATE_LIMITED(spdlog::level::warn, "Invalid frame header from cluster node {}, closing", node_id_);
+                    close();
+                }
+                return;
+            }
+
+            PacketArena::Scope arena_scope;
+            Packet *packet = arena_scope.new_packet();
+            bool parsed = !frame.compressed && ProtocolHandler::deserialize_frame(frame.data, frame.length, *packet);
+            read_buffer_.consume(consumed_bytes);
+            if (!parsed)
+            {
+                LOG_RATE_LIMITED(spdlog::level::warn, "Malformed packet from cluster node {}, closing", node_id_);
+                close();
+                return;
+            }
+
+            if (node_id_ == 0)
+            {
+                if (!packet->has_cluster_hello() || !node_.on_hello(shared_from_this(), packet->cluster_hello().node_id()))
+                {
+                    close();
+                    return;
+                }
+                node_id_ = packet->cluster_hello().node_id();
+                continue;
+            }
+            node_.on_packet(node_id_, *packet);
+        }
+    }
+
+    ClusterNode &node_;
+    asio::ip::tcp::socket socket_;
+    ReadBuffer read_buffer_;
+    uint32_t node_id_ = 0;
+    bool closed_ = false;
+};
+
+ClusterNode::ClusterNode(asio::io_context &io_context, const Config::ClusterConfig &config, FanoutDispatcher &fanout)
+    : io_context_(io_context), config_(config), fanout_(fanout),
+      heartbeat_interval_(std::max(10, config.heartbeat_interval_ms)),
+      lease_timeout_(std::max(config.heartbeat_interval_ms * 2, config.lease_timeout_ms)),
+      presence_flush_(std::max(0, config.presence_flush_ms)),
+      acceptor_(io_context), heartbeat_timer_(io_context), presence_timer_(io_context),
+      forwarded_(MetricsRegistry::get_instance().counter("im_cluster_forwarded_total", "Deliveries forwarded to other nodes",
+                                                         MetricsRegistry::label("result", "sent"))),
+      forward_dropped_(MetricsRegistry::get_instance().counter("im_cluster_forwarded_total", "Deliveries forwarded to other nodes",
+                                                               MetricsRegistry::label("result", "dropped"))),
+      deliveries_received_(MetricsRegistry::get_instance().counter("im_cluster_deliveries_received_total",
+                                                                   "ClusterDelivery packets received from other nodes")),
+      presence_updates_sent_(MetricsRegistry::get_instance().counter("im_cluster_presence_updates_total",
+                                                                     "PresenceUpdate packets built (each sent to every connected node)")),
+      node_expirations_(MetricsRegistry::get_instance().counter("im_cluster_node_expirations_total",
+                                                                "Nodes dropped from the presence directory"))
+{
+}
+
+ClusterNode::~ClusterNode()
+{
+    SessionManager::get_instance().set_presence_listener(nullptr);
+    presence_changes_.clear();
+}
+
+bool ClusterNode::start()
+{
+    if (!PresenceDirectory::valid_node(config_.node_id))
+    {
+        spdlog::error("Cluster node_id must be 1-{}, got {}", PresenceDirectory::MAX_NODES, config_.node_id);
+        return false;
+    }
+
+    for (const auto &peer : config_.peers)
+    {
+        if (!PresenceDirectory::valid_node(peer.node_id) || peer.node_id == config_.node_id || peers_[peer.node_id].link)
+        {
+            spdlog::error("Ignoring cluster peer {} at {}:{} (invalid or duplicate node_id)", peer.node_id, peer.host, peer.port);
+            continue;
+        }
+        peers_[peer.node_id].link = std::make_unique<ClusterLink>(io_context_, peer, config_,
+                                                                  [this](ClusterLink &link)
+                                                                  { on_link_connected(link); });
+        peer_ids_.push_back(peer.node_id);
+    }
+
+    try
+    {
+        asio::ip::tcp::endpoint endpoint(asio::ip::make_address(config_.host), static_cast<unsigned short>(config_.port));
+        acceptor_.open(endpoint.protocol());
+        acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true));
+        acceptor_.bind(endpoint);
+        acceptor_.listen();
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("Failed to listen on cluster port {}:{}: {}", config_.host, config_.port, e.what());
+        return false;
+    }
+
+    // 不同节点分配的消息 ID 不能重复（离线表主键）
+    MessageIdGenerator::get_instance().set_node(config_.node_id);
+    SessionManager::get_instance().set_presence_listener([this](int64_t user_id, bool online)
+                                                         { on_presence_change(user_id, online); });
+
+    running_ = true;
+    do_accept();
+    for (uint32_t peer_id : peer_ids_)
+    {
+        peers_[peer_id].link->start();
+    }
+    arm_heartbeat();
+
+    spdlog::info("Cluster node {} listening on {}:{} with {} peer(s), lease {}ms",
+                 config_.node_id, config_.host, config_.port, peer_ids_.size(), lease_timeout_.count());
+    return true;
+}
+
+void ClusterNode::stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+
+    asio::post(io_context_, [this]()
+               {
+                   asio::error_code ignored;
+                   acceptor_.close(ignored);
+                   heartbeat_timer_.cancel(ignored);
+                   presence_timer_.cancel(ignored);
+                   for (uint32_t peer_id : peer_ids_)
+                   {
+                       peers_[peer_id].link->stop();
+                   }
+                   for (auto &weak : inbound_)
+                   {
+                       if (auto connection = weak.lock())
+                       {
+                           connection->close();
+                       }
+                   }
+                   inbound_.clear();
+               });
+}
+
+size_t ClusterNode::connected_links() const
+{
+    size_t connected = 0;
+    for (uint32_t peer_id : peer_ids_)
+    {
+        connected += peers_[peer_id].link->connected() ? 1 : 0;
+    }
+    return connected;
+}
+
+void ClusterNode::do_accept()
+{
+    acceptor_.async_accept(
+        [this](std::error_code ec, asio::ip::tcp::socket socket)
+        {
+            if (!ec)
+            {
+                asio::error_code ignored;
+                socket.set_option(asio::ip::tcp::no_delay(true), ignored);
+                auto connection = std::make_shared<InboundConnection>(*this, std::move(socket));
+
+                inbound_.erase(std::remove_if(inbound_.begin(), inbound_.end(),
+                                              [](const std::weak_ptr<InboundConnection> &weak)
+                                              { return weak.expired(); }),
+                               inbound_.end());
+                inbound_.push_back(connection);
+                connection->start();
+            }
+            else if (ec != asio::error::operation_aborted)
+            {
+                LOG_RATE_LIMITED(spdlog::level::err, "Cluster accept failed: {}", ec.message());
+            }
+
+            if (running_)
+            {
+                do_accept();
+            }
+        });
+}
+
+/**
+ * 新的出站连接：Hello 之后是本节点在线用户的全量同步，第一个包带 full_sync，对方据此清掉旧条目。
+ * 快照之后才入队的上下线变更随后照常发出，重复的上线 / 下线是幂等的
+ */
+void ClusterNode::on_link_connected(ClusterLink &link)
+{
+    Packet hello = ProtocolHandler::create_packet();
+    hello.mutable_cluster_hello()->set_node_id(config_.node_id);
+    link.push_direct(ProtocolHandler::serialize_frame(hello));
+
+    std::vector<int64_t> online;
+    SessionManager::get_instance().collect_online_users(online);
+
+    size_t offset = 0;
+    do
+    {
+        size_t count = std::min(MAX_USERS_PER_PACKET, online.size() - offset);
+        Packet packet = ProtocolHandler::create_packet();
+        auto *update = packet.mutable_presence_update();
+        update->set_full_sync(offset == 0);
+        update->mutable_online()->Add(online.begin() + offset, online.begin() + offset + count);
+        link.push_direct(ProtocolHandler::serialize_frame(packet));
+        offset += count;
+    } while (offset < online.size());
+
+    spdlog::info("Sent presence snapshot of {} user(s) to cluster node {}", online.size(), link.node_id());
+}
+
+/**
+ * SessionManager 分片锁内调用：只入队；队列由空变非空时让集群线程在 presence_flush_ms 后统一发出
+ */
+void ClusterNode::on_presence_change(int64_t user_id, bool online)
+{
+    if (presence_changes_.push(PresenceChange{user_id, online}))
+    {
+        asio::post(io_context_, [this]()
+                   {
+                       presence_timer_.expires_after(presence_flush_);
+                       presence_timer_.async_wait([this](std::error_code ec)
+                                                  {
+                                                      if (!ec)
+                                                      {
+                                                          flush_presence();
+                                                      }
+                                                  });
+                   });
+    }
+}
+
+void ClusterNode::flush_presence()
+{
+    Packet packet = ProtocolHandler::create_packet();
+    auto *update = packet.mutable_presence_update();
+
+    auto send = [this, &packet, update]()
+    {
+        if (update->online_size() == 0 && update->offline_size() == 0)
+        {
+            return;
+        }
+        presence_updates_sent_.add();
+        send_to_connected_links(FanoutDispatcher::make_shared_frame(packet));
+        update->clear_online();
+        update->clear_offline();
+    };
+
+    presence_changes_.consume_all([&](PresenceChange &&change)
+                                  {
+                                      if (change.online)
+                                      {
+                                          update->add_online(change.user_id);
+                                      }
+                                      else
+                                      {
+                                          update->add_offline(change.user_id);
+                                      }
+                                      if (static_cast<size_t>(update->online_size() + update->offline_size()) >= MAX_USERS_PER_PACKET)
+                                      {
+                                          send();
+                                      }
+                                  });
+    send();
+}
+
+void ClusterNode::arm_heartbeat()
+{
+    heartbeat_timer_.expires_after(heartbeat_interval_);
+    heartbeat_timer_.async_wait([this](std::error_code ec)
+                                {
+                                    if (!ec && running_)
+                                    {
+                                        on_heartbeat();
+                                        arm_heartbeat();
+                                    }
+                                });
+}
+
+void ClusterNode::on_heartbeat()
+{
+    Packet packet = ProtocolHandler::create_packet();
+    packet.mutable_cluster_heartbeat()->set_timestamp_ms(unix_now_ms());
+    send_to_connected_links(FanoutDispatcher::make_shared_frame(packet));
+
+    auto now = std::chrono::steady_clock::now();
+    for (uint32_t peer_id : peer_ids_)
+    {
+        const auto &peer = peers_[peer_id];
+        if (peer.leased && now > peer.lease_until)
+        {
+            expire_node(peer_id, "lease expired");
+        }
+    }
+}
+
+void ClusterNode::send_to_connected_links(const SharedFrame &frame)
+{
+    if (!frame)
+    {
+        return;
+    }
+    for (uint32_t peer_id : peer_ids_)
+    {
+        auto &link = *peers_[peer_id].link;
+        if (link.connected())
+        {
+            link.send(frame);
+        }
+    }
+}
+
+bool ClusterNode::send_delivery(uint32_t node_id, const int64_t *user_ids, size_t count, const std::string &frame)
+{
+    const auto &link = peers_[node_id].link;
+    if (!link || !link->connected())
+    {
+        forward_dropped_.add();
+        return false;
+    }
+
+    Packet packet = ProtocolHandler::create_packet();
+    auto *delivery = packet.mutable_cluster_delivery();
+    delivery->mutable_user_ids()->Add(user_ids, user_ids + count);
+    delivery->set_frame(frame);
+
+    std::string encoded = ProtocolHandler::serialize_frame(packet);
+    if (encoded.empty() || !link->send(std::move(encoded)))
+    {
+        forward_dropped_.add();
+        return false;
+    }
+    forwarded_.add();
+    return true;
+}
+
+size_t ClusterNode::forward_to_user(int64_t user_id, const std::string &frame)
+{
+    PresenceDirectory::NodeMask nodes = directory_.lookup(user_id);
+    size_t forwarded = 0;
+    while (nodes)
+    {
+        uint32_t node_id = static_cast<uint32_t>(__builtin_ctzll(nodes)) + 1;
+        nodes &= nodes - 1;
+        forwarded += send_delivery(node_id, &user_id, 1, frame) ? 1 : 0;
+    }
+    return forwarded;
+}
+
+size_t ClusterNode::forward_to_users(const std::vector<int64_t> &user_ids, const std::string &frame)
+{
+    if (directory_.size() == 0 || user_ids.empty())
+    {
+        return 0;
+    }
+
+    thread_local std::vector<std::pair<int64_t, PresenceDirectory::NodeMask>> found;
+    thread_local std::array<std::vector<int64_t>, PresenceDirectory::MAX_NODES + 1> by_node;
+    found.clear();
+    directory_.lookup_many(user_ids, found);
+    if (found.empty())
+    {
+        return 0;
+    }
+
+    for (const auto &[user_id, mask] : found)
+    {
+        PresenceDirectory::NodeMask nodes = mask;
+        while (nodes)
+        {
+            by_node[__builtin_ctzll(nodes) + 1].push_back(user_id);
+            nodes &= nodes - 1;
+        }
+    }
+
+    size_t forwarded = 0;
+    for (uint32_t node_id = 1; node_id <= PresenceDirectory::MAX_NODES; ++node_id)
+    {
+        auto &ids = by_node[node_id];
+        if (ids.empty())
+        {
+            continue;
+        }
+        bool sent = false;
+        for (size_t offset = 0; offset < ids.size(); offset += MAX_USERS_PER_PACKET)
+        {
+            size_t count = std::min(MAX_USERS_PER_PACKET, ids.size() - offset);
+            sent = send_delivery(node_id, ids.data() + offset, count, frame) || sent;
+        }
+        forwarded += sent ? 1 : 0;
+        ids.clear();
+    }
+    return forwarded;
+}
+
+/**
+ * 只接受配置中的 peer；同一节点的新连接（重启、重连）取代旧连接，旧连接关闭时不再影响租约
+ */
+bool ClusterNode::on_hello(const std::shared_ptr<InboundConnection> &connection, uint32_t node_id)
+{
+    if (!PresenceDirectory::valid_node(node_id) || !peers_[node_id].link)
+    {
+        LOG_RATE_LIMITED(spdlog::level::warn, "Rejecting cluster connection from unknown node {}", node_id);
+        return false;
+    }
+
+    auto &peer = peers_[node_id];
+    auto previous = peer.inbound.lock();
+    peer.inbound = connection;
+    peer.leased = true;
+    peer.lease_until = std::chrono::steady_clock::now() + lease_timeout_;
+    if (previous)
+    {
+        previous->close();
+    }
+
+    spdlog::info("Cluster node {} connected", node_id);
+    return true;
+}
+
+void ClusterNode::on_packet(uint32_t node_id, const Packet &packet)
+{
+    auto &peer = peers_[node_id];
+    peer.leased = true;
+    peer.lease_until = std::chrono::steady_clock::now() + lease_timeout_;
+
+    switch (packet.payload_case())
+    {
+    case Packet::kClusterDelivery:
+    {
+        const auto &delivery = packet.cluster_delivery();
+        deliveries_received_.add();
+        if (delivery.frame().size() <= 4 || delivery.user_ids_size() == 0)
+        {
+            return;
+        }
+        std::vector<int64_t> user_ids(delivery.user_ids().begin(), delivery.user_ids().end());
+        fanout_.deliver_to_users(user_ids, std::make_shared<std::string>(delivery.frame()));
+        return;
+    }
+    case Packet::kPresenceUpdate:
+    {
+        const auto &update = packet.presence_update();
+        if (update.full_sync())
+        {
+            directory_.drop_node(node_id);
+        }
+        for (int64_t user_id : update.online())
+        {
+            directory_.set_online(node_id, user_id);
+        }
+        for (int64_t user_id : update.offline())
+        {
+            directory_.set_offline(node_id, user_id);
+        }
+        return;
+    }
+    case Packet::kClusterHeartbeat:
+        return;
+    default:
+        LOG_RATE_LIMITED(spdlog::level::warn, "Unexpected packet type {} from cluster node {}",
+                         static_cast<int>(packet.payload_case()), node_id);
+        return;
+    }
+}
+
+void ClusterNode::on_inbound_closed(const InboundConnection &connection)
+{
+    uint32_t node_id = connection.node_id();
+    if (node_id == 0)
+    {
+        return;
+    }
+    auto current = peers_[node_id].inbound.lock();
+    if (current.get() == &connection)
+    {
+        expire_node(node_id, "connection closed");
+    }
+}
+
+void ClusterNode::expire_node(uint32_t node_id, const char *reason)
+{
+    auto &peer = peers_[node_id];
+    peer.leased = false;
+    auto inbound = peer.inbound.lock();
+    peer.inbound.reset();
+
+    size_t dropped = directory_.drop_node(node_id);
+    node_expirations_.add();
+    spdlog::warn("Cluster node {} {}, dropped {} presence entries", node_id, reason, dropped);
+
+    if (inbound)
+    {
+        inbound->close();
+    }
+}
+
+void ClusterNode::register_metrics()
+{
+    auto &registry = MetricsRegistry::get_instance();
+    registry.gauge("im_cluster_presence_entries", "Users known to be online on other nodes", "",
+                   [this]()
+                   { return static_cast<double>(directory_.size()); });
+    registry.gauge("im_cluster_links_connected", "Outbound inter-node links currently connected", "",
+                   [this]()
+                   { return static_cast<double>(connected_links()); });
+}
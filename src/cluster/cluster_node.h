@@ -0,0 +1,136 @@
+#pragma once
+
+#define ASIO_STANDALONE
+#include <asio.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <messages.pb.h>
+#include "presence_directory.h"
+#include "cluster_link.h"
+#include "../config/config.h"
+#include "../metrics/metrics_registry.h"
+#include "../server/mpsc_queue.h"
+
+class FanoutDispatcher;
+
+/**
+ * @brief 集群模式：多个 im_server 节点放在 TCP 负载均衡后面，用户连到任意节点都能互相收发消息
+ *
+ * 在线目录：每个节点把本节点用户的上线 / 下线（SessionManager 的 presence 回调）攒 presence_flush_ms
+ * 合并成一个 PresenceUpdate，序列化一次后发给所有 peer；新连接建立时先发一次全量同步。
+ * 收到的条目记在 PresenceDirectory 里，查找不出本进程。
+ *
+ * 租约：每个节点每 heartbeat_interval_ms 给所有 peer 发一次 ClusterHeartbeat，收到某个节点的任何帧
+ * 都会续约；lease_timeout_ms 内没有任何帧（节点宕机、网络分区），或者它的连接断开，它在目录中的条目一次性删除。
+ * 租约以节点为单位，在线用户本身不需要续约。
+ *
+ * 转发：ChatHandler / GroupHandler 在本节点投递之后调用 forward_to_user(s)，按目录把客户端帧
+ * 包进 ClusterDelivery 发给用户所在的节点（每个节点一个包，群消息按节点合并接收方），
+ * 对方节点直接把里面的帧写给本地会话，不再解码内层消息，也不会再次转发。
+ *
+ * 连接：节点之间两两各有一条出站 ClusterLink（只发不收），入站连接由本类接受后只读。
+ * 所有连接、定时器和租约状态都在同一个 io_context（集群线程）上处理；转发接口可以从任意 io 线程调用。
+ * 链路断开时在途的转发会丢失，发送方的 ChatAck 已经返回，不会重发。
+ */
+class ClusterNode
+{
+public:
+    // 单个 ClusterDelivery / PresenceUpdate 最多携带的 user_id 数，保证包不超过 MAX_FRAME_SIZE
+    static constexpr size_t MAX_USERS_PER_PACKET = 8192;
+
+    ClusterNode(asio::io_context &io_context, const Config::ClusterConfig &config, FanoutDispatcher &fanout);
+    ~ClusterNode();
+
+    ClusterNode(const ClusterNode &) = delete;
+    ClusterNode &operator=(const ClusterNode &) = delete;
+
+    /**
+     * @brief 监听集群端口、开始连接所有 peer、挂上在线状态回调，在 worker 线程启动前调用
+     * @return false 如果配置无效或端口无法监听
+     */
+    bool start();
+
+    // 关闭所有节点间连接，可以从任意线程调用
+    void stop();
+
+    uint32_t node_id() const { return config_.node_id; }
+
+    /**
+     * @brief 把编码好的客户端帧转发给用户在其他节点上的会话
+     * @return 转发到的节点数，用户不在其他节点上线或链路不可用时为 0
+     */
+    size_t forward_to_user(int64_t user_id, const std::string &frame);
+
+    // 群消息：按节点合并接收方，每个节点发一个包，返回转发到的节点数
+    size_t forward_to_users(const std::vector<int64_t> &user_ids, const std::string &frame);
+
+    const PresenceDirectory &directory() const { return directory_; }
+    size_t connected_links() const;
+
+    void register_metrics();
+
+private:
+    class InboundConnection;
+    friend class InboundConnection;
+
+    struct PresenceChange
+    {
+        int64_t user_id;
+        bool online;
+    };
+
+    // 每个 peer 一份，按 node_id 下标；link 构造后不变，其余字段只在集群线程上访问
+    struct Peer
+    {
+        std::unique_ptr<ClusterLink> link;
+        std::weak_ptr<InboundConnection> inbound; // 当前有效的入站连接
+        std::chrono::steady_clock::time_point lease_until;
+        bool leased = false;
+    };
+
+    void do_accept();
+    void on_link_connected(ClusterLink &link);
+    void on_presence_change(int64_t user_id, bool online);
+    void flush_presence();
+    void arm_heartbeat();
+    void on_heartbeat();
+    void send_to_connected_links(const SharedFrame &frame);
+    bool send_delivery(uint32_t node_id, const int64_t *user_ids, size_t count, const std::string &frame);
+
+    // 入站连接回调（集群线程）
+    bool on_hello(const std::shared_ptr<InboundConnection> &connection, uint32_t node_id);
+    void on_packet(uint32_t node_id, const Packet &packet);
+    void on_inbound_closed(const InboundConnection &connection);
+    void expire_node(uint32_t node_id, const char *reason);
+
+    asio::io_context &io_context_;
+    Config::ClusterConfig config_;
+    FanoutDispatcher &fanout_;
+    std::chrono::milliseconds heartbeat_interval_;
+    std::chrono::milliseconds lease_timeout_;
+    std::chrono::milliseconds presence_flush_;
+
+    asio::ip::tcp::acceptor acceptor_;
+    asio::steady_timer heartbeat_timer_;
+    asio::steady_timer presence_timer_;
+    std::atomic<bool> running_{false};
+
+    PresenceDirectory directory_;
+    std::array<Peer, PresenceDirectory::MAX_NODES + 1> peers_;
+    std::vector<uint32_t> peer_ids_;
+    std::vector<std::weak_ptr<InboundConnection>> inbound_;
+
+    // 本节点用户的上线 / 下线，在 SessionManager 分片锁内入队，集群线程批量发出
+    MpscQueue<PresenceChange> presence_changes_;
+
+    Counter &forwarded_;
+    Counter &forward_dropped_;
+    Counter &deliveries_received_;
+    Counter &presence_updates_sent_;
+    Counter &node_expirations_;
+};
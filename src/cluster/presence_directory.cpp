@@ -0,0 +1,112 @@
+#include "presence_directory.h"
+
+void PresenceDirectory::set_online(uint32_t node_id, int64_t user_id)
+{
+    auto &shard = shards_[shard_of(user_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto [it, inserted] = shard.users.try_emplace(user_id, 0);
+    it->second |= node_bit(node_id);
+    if (inserted)
+    {
+        size_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void PresenceDirectory::set_offline(uint32_t node_id, int64_t user_id)
+{
+    auto &shard = shards_[shard_of(user_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.users.find(user_id);
+    if (it == shard.users.end())
+    {
+        return;
+    }
+    it->second &= ~node_bit(node_id);
+    if (it->second == 0)
+    {
+        shard.users.erase(it);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * 遍历所有分片，O(目录大小)；只在节点失效或重新同步时发生
+ */
+size_t PresenceDirectory::drop_node(uint32_t node_id)
+{
+    NodeMask bit = node_bit(node_id);
+    size_t affected = 0;
+    for (auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto it = shard.users.begin(); it != shard.users.end();)
+        {
+            if (!(it->second & bit))
+            {
+                ++it;
+                continue;
+            }
+            ++affected;
+            it->second &= ~bit;
+            if (it->second == 0)
+            {
+                it = shard.users.erase(it);
+                size_.fetch_sub(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    return affected;
+}
+
+PresenceDirectory::NodeMask PresenceDirectory::lookup(int64_t user_id) const
+{
+    const auto &shard = shards_[shard_of(user_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.users.find(user_id);
+    return it == shard.users.end() ? 0 : it->second;
+}
+
+void PresenceDirectory::lookup_many(const std::vector<int64_t> &user_ids,
+                                    std::vector<std::pair<int64_t, NodeMask>> &out) const
+{
+    // 与 SessionManager::collect_user_sessions 相同：先按分片归类，缓冲区在线程内复用
+    thread_local std::array<std::vector<int64_t>, SHARD_COUNT> by_shard;
+    for (auto &ids : by_shard)
+    {
+        ids.clear();
+    }
+    for (int64_t user_id : user_ids)
+    {
+        by_shard[shard_of(user_id)].push_back(user_id);
+    }
+
+    for (size_t i = 0; i < SHARD_COUNT; ++i)
+    {
+        if (by_shard[i].empty())
+        {
+            continue;
+        }
+
+        const auto &shard = shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.users.empty())
+        {
+            continue;
+        }
+        for (int64_t user_id : by_shard[i])
+        {
+            auto it = shard.users.find(user_id);
+            if (it != shard.users.end())
+            {
+                out.emplace_back(user_id, it->second);
+            }
+        }
+    }
+}
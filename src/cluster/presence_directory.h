@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 集群在线目录：user_id -> 该用户有会话的其他节点
+ *
+ * 每个节点只发布自己的用户（PresenceUpdate），这里保存的是从其他节点收到的部分，本节点的用户仍由
+ * SessionManager 的 user_id 索引负责。值是 64 位节点掩码（节点 ID 1-64 对应第 0-63 位），
+ * 多端登录在不同节点上时各占一位；每个在线用户一个 8 字节的值，百万在线用户的目录只有几十 MB。
+ *
+ * 条目没有各自的过期时间：租约以节点为单位，节点心跳超时或断开时 drop_node() 一次清掉它的所有位，
+ * 在线用户不需要逐个续约。写入只发生在集群线程上，查找来自任意 io 线程，按 user_id 分片加锁。
+ */
+class PresenceDirectory
+{
+public:
+    static constexpr size_t SHARD_COUNT = 32;
+    static constexpr uint32_t MAX_NODES = 64;
+
+    using NodeMask = uint64_t;
+
+    static bool valid_node(uint32_t node_id) { return node_id >= 1 && node_id <= MAX_NODES; }
+    static NodeMask node_bit(uint32_t node_id) { return NodeMask{1} << (node_id - 1); }
+
+    void set_online(uint32_t node_id, int64_t user_id);
+    void set_offline(uint32_t node_id, int64_t user_id);
+
+    // 删除某个节点的全部条目（租约过期 / 全量同步之前），返回受影响的用户数
+    size_t drop_node(uint32_t node_id);
+
+    // 用户所在的其他节点，不在线时为 0
+    NodeMask lookup(int64_t user_id) const;
+
+    /**
+     * @brief 批量查找（群消息转发），每个分片只加一次锁
+     * @param out 追加 (user_id, 节点掩码)，不在任何其他节点上的用户不输出
+     */
+    void lookup_many(const std::vector<int64_t> &user_ids, std::vector<std::pair<int64_t, NodeMask>> &out) const;
+
+    // 目录中的用户数
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(64) Shard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<int64_t, NodeMask> users;
+    };
+
+    static size_t shard_of(int64_t user_id)
+    {
+        return std::hash<int64_t>{}(user_id) & (SHARD_COUNT - 1);
+    }
+
+    std::array<Shard, SHARD_COUNT> shards_;
+    std::atomic<size_t> size_{0};
+};
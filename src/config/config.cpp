@@ -22,6 +22,31 @@ bool Config::load_from_file(const std::string &config_path)
         server_.port = server_json["port"];
         server_.max_connections = server_json["max_connections"];
         server_.worker_threads = server_json["worker_threads"];
+        server_.blocking_threads = server_json.value("blocking_threads", server_.blocking_threads);
+        server_.blocking_queue_limit = server_json.value("blocking_queue_limit", server_.blocking_queue_limit);
+        server_.request_timeout_ms = server_json.value("request_timeout_ms", server_.request_timeout_ms);
+        server_.write_high_water_mark_bytes =
+            server_json.value("write_high_water_mark_bytes", server_.write_high_water_mark_bytes);
+        server_.threading_mode = server_json.value("threading_mode", server_.threading_mode);
+        server_.cpu_affinity = server_json.value("cpu_affinity", server_.cpu_affinity);
+        server_.accept_balancing = server_json.value("accept_balancing", server_.accept_balancing);
+        server_.per_ip_accept_rate = server_json.value("per_ip_accept_rate", server_.per_ip_accept_rate);
+        server_.per_ip_accept_burst = server_json.value("per_ip_accept_burst", server_.per_ip_accept_burst);
+        server_.reject_with_error_frame =
+            server_json.value("reject_with_error_frame", server_.reject_with_error_frame);
+        server_.reuse_port = server_json.value("reuse_port", server_.reuse_port);
+        server_.listen_backlog = server_json.value("listen_backlog", server_.listen_backlog);
+        server_.tcp_nodelay = server_json.value("tcp_nodelay", server_.tcp_nodelay);
+        server_.tcp_keepalive = server_json.value("tcp_keepalive", server_.tcp_keepalive);
+        server_.keepalive_idle_sec = server_json.value("keepalive_idle_sec", server_.keepalive_idle_sec);
+        server_.keepalive_interval_sec =
+            server_json.value("keepalive_interval_sec", server_.keepalive_interval_sec);
+        server_.keepalive_probes = server_json.value("keepalive_probes", server_.keepalive_probes);
+        server_.idle_timeout_sec = server_json.value("idle_timeout_sec", server_.idle_timeout_sec);
+        server_.heartbeat_interval_sec = server_json.value("heartbeat_interval_sec", server_.heartbeat_interval_sec);
+        server_.timer_wheel_tick_ms = server_json.value("timer_wheel_tick_ms", server_.timer_wheel_tick_ms);
+        server_.compression = server_json.value("compression", server_.compression);
+        server_.compression_threshold_bytes = server_json.value("compression_threshold_bytes", server_.compression_threshold_bytes);
 
         // Parse logging config
         const auto &logging_json = j["logging"];
@@ -29,6 +54,108 @@ bool Config::load_from_file(const std::string &config_path)
         logging_.file = logging_json["file"];
         logging_.max_size_mb = logging_json["max_size_mb"];
         logging_.max_files = logging_json["max_files"];
+        logging_.async = logging_json.value("async", logging_.async);
+        logging_.async_queue_size = logging_json.value("async_queue_size", logging_.async_queue_size);
+        logging_.async_threads = logging_json.value("async_threads", logging_.async_threads);
+        logging_.overflow_policy = logging_json.value("overflow_policy", logging_.overflow_policy);
+        logging_.rate_limit_per_sec = logging_json.value("rate_limit_per_sec", logging_.rate_limit_per_sec);
+
+        // Parse database config (optional, missing keys keep their defaults)
+        if (j.contains("database"))
+        {
+            const auto &db_json = j["database"];
+            database_.host = db_json.value("host", database_.host);
+            database_.user = db_json.value("user", database_.user);
+            database_.password = db_json.value("password", database_.password);
+            database_.database = db_json.value("database", database_.database);
+
+            if (db_json.contains("pool"))
+            {
+                const auto &pool_json = db_json["pool"];
+                database_.pool_min_size = pool_json.value("min_size", database_.pool_min_size);
+                database_.pool_max_size = pool_json.value("max_size", database_.pool_max_size);
+                database_.idle_timeout_sec = pool_json.value("idle_timeout_sec", database_.idle_timeout_sec);
+                database_.borrow_timeout_ms = pool_json.value("borrow_timeout_ms", database_.borrow_timeout_ms);
+                database_.health_check_interval_sec =
+                    pool_json.value("health_check_interval_sec", database_.health_check_interval_sec);
+            }
+        }
+
+        // Parse user cache config (optional)
+        if (j.contains("user_cache"))
+        {
+            const auto &cache_json = j["user_cache"];
+            user_cache_.capacity = cache_json.value("capacity", user_cache_.capacity);
+            user_cache_.ttl_sec = cache_json.value("ttl_sec", user_cache_.ttl_sec);
+            user_cache_.negative_capacity = cache_json.value("negative_capacity", user_cache_.negative_capacity);
+            user_cache_.negative_ttl_sec = cache_json.value("negative_ttl_sec", user_cache_.negative_ttl_sec);
+        }
+
+        // Parse auth config (optional)
+        if (j.contains("auth"))
+        {
+            const auto &auth_json = j["auth"];
+            auth_.resume_secret = auth_json.value("resume_secret", auth_.resume_secret);
+            auth_.resume_token_ttl_sec = auth_json.value("resume_token_ttl_sec", auth_.resume_token_ttl_sec);
+        }
+
+        // Parse password config (optional)
+        if (j.contains("password"))
+        {
+            const auto &password_json = j["password"];
+            password_.rounds = password_json.value("rounds", password_.rounds);
+            password_.hash_threads = password_json.value("hash_threads", password_.hash_threads);
+            password_.hash_queue_limit = password_json.value("hash_queue_limit", password_.hash_queue_limit);
+        }
+
+        // Parse metrics config (optional)
+        if (j.contains("metrics"))
+        {
+            const auto &metrics_json = j["metrics"];
+            metrics_.enabled = metrics_json.value("enabled", metrics_.enabled);
+            metrics_.host = metrics_json.value("host", metrics_.host);
+            metrics_.port = metrics_json.value("port", metrics_.port);
+            metrics_.path = metrics_json.value("path", metrics_.path);
+        }
+
+        // Parse offline message store config (optional)
+        if (j.contains("offline_store"))
+        {
+            const auto &offline_json = j["offline_store"];
+            offline_store_.enabled = offline_json.value("enabled", offline_store_.enabled);
+            offline_store_.batch_size = offline_json.value("batch_size", offline_store_.batch_size);
+            offline_store_.flush_interval_ms = offline_json.value("flush_interval_ms", offline_store_.flush_interval_ms);
+            offline_store_.max_pending = offline_json.value("max_pending", offline_store_.max_pending);
+            offline_store_.page_size = offline_json.value("page_size", offline_store_.page_size);
+            offline_store_.max_drain_messages = offline_json.value("max_drain_messages", offline_store_.max_drain_messages);
+        }
+
+        // Parse cluster config (optional)
+        if (j.contains("cluster"))
+        {
+            const auto &cluster_json = j["cluster"];
+            cluster_.enabled = cluster_json.value("enabled", cluster_.enabled);
+            cluster_.node_id = cluster_json.value("node_id", cluster_.node_id);
+            cluster_.host = cluster_json.value("host", cluster_.host);
+            cluster_.port = cluster_json.value("port", cluster_.port);
+            cluster_.heartbeat_interval_ms = cluster_json.value("heartbeat_interval_ms", cluster_.heartbeat_interval_ms);
+            cluster_.lease_timeout_ms = cluster_json.value("lease_timeout_ms", cluster_.lease_timeout_ms);
+            cluster_.reconnect_interval_ms = cluster_json.value("reconnect_interval_ms", cluster_.reconnect_interval_ms);
+            cluster_.presence_flush_ms = cluster_json.value("presence_flush_ms", cluster_.presence_flush_ms);
+            cluster_.link_max_pending_bytes = cluster_json.value("link_max_pending_bytes", cluster_.link_max_pending_bytes);
+
+            if (cluster_json.contains("peers"))
+            {
+                for (const auto &peer_json : cluster_json["peers"])
+                {
+                    ClusterConfig::Peer peer;
+                    peer.node_id = peer_json.value("node_id", peer.node_id);
+                    peer.host = peer_json.value("host", peer.host);
+                    peer.port = peer_json.value("port", peer.port);
+                    cluster_.peers.push_back(std::move(peer));
+                }
+            }
+        }
 
         return true;
     }
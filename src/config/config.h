@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 
 class Config
@@ -12,6 +14,44 @@ public:
         int port;
         int max_connections;
         int worker_threads;
+
+        // 阻塞任务线程池（DB、密码哈希），与 io worker_threads 分开配置
+        int blocking_threads = 8;
+        int blocking_queue_limit = 10000; // 排队任务上限，超过后请求直接返回"服务器繁忙"
+        int request_timeout_ms = 5000;    // 协程处理器（登录、注册）的请求超时，从路由时刻算起
+
+        // 单个会话出站队列的高水位（字节），超过后暂停读取该会话，直到队列回落到一半以下；
+        // 其他会话推送的帧在积压超过两倍高水位后被丢弃
+        int write_high_water_mark_bytes = 4 * 1024 * 1024;
+
+        // 线程模型："shared"（所有线程共享一个 io_context）、"strand"（共享 io_context + 每连接 strand）、
+        // "per_core"（每个 worker 线程一个 io_context）；多线程下 shared 与 strand 相同，会话都绑定 strand
+        std::string threading_mode = "strand";
+        bool cpu_affinity = false;                   // per_core 模式下把 worker 线程绑定到 CPU
+        std::string accept_balancing = "round_robin"; // per_core 模式下新连接的分配策略："round_robin" 或 "least_load"
+
+        // 准入控制：max_connections 之外，按来源 IP 限制新建连接速率（令牌桶），<= 0 表示不限速
+        double per_ip_accept_rate = 20.0;   // 每个 IP 每秒补充的令牌数
+        double per_ip_accept_burst = 40.0;  // 令牌桶容量，允许的突发连接数
+        bool reject_with_error_frame = true; // 拒绝时先写一个错误帧再关闭；false 时直接 RST
+
+        // 监听与 socket 选项
+        bool reuse_port = false;     // 每个 io_context（shared/strand 模式下每个 worker 线程）一个 SO_REUSEPORT acceptor
+        int listen_backlog = 4096;   // listen() 的 backlog，实际上限受 net.core.somaxconn 限制
+        bool tcp_nodelay = true;     // 关闭 Nagle，小帧立即发出
+        bool tcp_keepalive = true;   // 开启 TCP keepalive，探测断网后残留的半开连接
+        int keepalive_idle_sec = 60;     // 空闲多久开始探测，<= 0 使用系统默认
+        int keepalive_interval_sec = 10; // 探测间隔，<= 0 使用系统默认
+        int keepalive_probes = 3;        // 探测失败多少次判定断开，<= 0 使用系统默认
+
+        // 应用层心跳与空闲超时，由每个 io_context 一个的时间轮驱动
+        int idle_timeout_sec = 90;       // 多久没有收到任何数据就关闭连接，<= 0 不做空闲检测
+        int heartbeat_interval_sec = 30; // 空闲多久后服务器主动发送 Ping，<= 0 不主动发送
+        int timer_wheel_tick_ms = 1000;  // 时间轮刻度，超时精度为一个刻度
+
+        // 帧压缩：客户端用 CapabilityRequest 声明支持后才启用；"lz4" 或 "none"
+        std::string compression = "lz4";
+        int compression_threshold_bytes = 1024; // 帧体小于该值时不压缩
     };
 
     struct LoggingConfig
@@ -20,6 +60,87 @@ public:
         std::string file;
         int max_size_mb;
         int max_files;
+        bool async = true;                         // 使用 spdlog 异步线程池，业务线程只负责入队
+        int async_queue_size = 8192;               // 异步队列长度（条）
+        int async_threads = 1;                     // 后台写日志线程数
+        std::string overflow_policy = "overrun_oldest"; // 队列满时：overrun_oldest 丢弃最旧的，block 阻塞等待
+        int rate_limit_per_sec = 20;               // 连接 / 请求级日志每个调用点每秒最多条数，0 不限
+    };
+
+    struct DatabaseConfig
+    {
+        std::string host = "tcp://127.0.0.1:3306";
+        std::string user = "will";
+        std::string password = "abcd1234";
+        std::string database = "testdb";
+
+        // 连接池参数
+        int pool_min_size = 2;              // 启动时预建、维护线程保底的空闲连接数
+        int pool_max_size = 16;             // 连接总数上限（空闲 + 借出）
+        int idle_timeout_sec = 300;         // 超过该时长的空闲连接会被回收（保留 min_size 个）
+        int borrow_timeout_ms = 3000;       // 池满时借用连接的最长等待时间
+        int health_check_interval_sec = 30; // 维护线程的巡检周期，同时作为借用时的校验阈值
+    };
+
+    struct UserCacheConfig
+    {
+        int capacity = 100000;       // 缓存的用户记录数上限，0 表示关闭缓存
+        int ttl_sec = 300;           // 用户记录的有效期
+        int negative_capacity = 50000; // "用户名不存在" 负缓存容量，0 表示关闭负缓存
+        int negative_ttl_sec = 30;   // 负缓存有效期，较短，新注册的用户名在注册时也会主动失效
+    };
+
+    struct AuthConfig
+    {
+        // 会话恢复令牌的 HMAC 密钥，建议至少 32 字节；为空时启动时随机生成（重启后旧令牌全部失效）
+        std::string resume_secret;
+        int resume_token_ttl_sec = 7 * 24 * 3600; // 令牌有效期
+    };
+
+    struct PasswordConfig
+    {
+        int rounds = 5000;          // SHA-512 crypt 轮数，调整后老用户在下次登录时自动重新哈希
+        int hash_threads = 0;       // 密码哈希线程数，0 表示 CPU 核数
+        int hash_queue_limit = 1024; // 等待哈希的任务上限，超出时回复"服务器繁忙"
+    };
+
+    struct MetricsConfig
+    {
+        bool enabled = true;            // 是否开启 Prometheus 抓取端点
+        std::string host = "127.0.0.1"; // 监听地址，默认只对本机开放
+        int port = 9100;
+        std::string path = "/metrics";
+    };
+
+    struct OfflineStoreConfig
+    {
+        bool enabled = true;          // 接收方不在线时把点对点消息写入 offline_messages 表
+        int batch_size = 256;         // 攒够这么多条立即组提交（多行 INSERT 的行数上限）
+        int flush_interval_ms = 20;   // 最早一条消息最多等待这么久就提交
+        int max_pending = 100000;     // 内存日志上限，数据库不可用时超出的新消息被拒绝
+        int page_size = 100;          // 登录时每页读取的离线消息数
+        int max_drain_messages = 5000; // 一次登录最多投递的离线消息数，剩余的下次登录再取
+    };
+
+    struct ClusterConfig
+    {
+        struct Peer
+        {
+            uint32_t node_id = 0;
+            std::string host;
+            int port = 0;
+        };
+
+        bool enabled = false;           // 集群模式：多个节点共享在线目录，跨节点转发消息
+        uint32_t node_id = 1;           // 本节点 ID，1-64，集群内唯一
+        std::string host = "0.0.0.0";   // 节点间连接的监听地址，只应对内网开放
+        int port = 9200;
+        std::vector<Peer> peers;        // 其他节点（不含自己）
+        int heartbeat_interval_ms = 1000; // 节点心跳间隔
+        int lease_timeout_ms = 5000;      // 这么久没有收到某个节点的任何帧，它的在线条目全部失效
+        int reconnect_interval_ms = 1000; // 节点间连接断开后的重连间隔
+        int presence_flush_ms = 10;       // 上下线变更攒这么久合并成一个 PresenceUpdate
+        int link_max_pending_bytes = 64 * 1024 * 1024; // 单条节点间连接的积压上限，超过后转发失败
     };
 
     Config() = default;
@@ -29,8 +150,22 @@ public:
 
     const ServerConfig &get_server_config() const { return server_; }
     const LoggingConfig &get_logging_config() const { return logging_; }
+    const DatabaseConfig &get_database_config() const { return database_; }
+    const UserCacheConfig &get_user_cache_config() const { return user_cache_; }
+    const AuthConfig &get_auth_config() const { return auth_; }
+    const PasswordConfig &get_password_config() const { return password_; }
+    const MetricsConfig &get_metrics_config() const { return metrics_; }
+    const OfflineStoreConfig &get_offline_store_config() const { return offline_store_; }
+    const ClusterConfig &get_cluster_config() const { return cluster_; }
 
 private:
     ServerConfig server_;
     LoggingConfig logging_;
+    DatabaseConfig database_;
+    UserCacheConfig user_cache_;
+    AuthConfig auth_;
+    PasswordConfig password_;
+    MetricsConfig metrics_;
+    OfflineStoreConfig offline_store_;
+    ClusterConfig cluster_;
 };
\ No newline at end of file
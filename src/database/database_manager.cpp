@@ -1,5 +1,124 @@
 #include "database_manager.h"
+#include "../logging/log_limiter.h"
 #include <stdexcept>
+#include <sstream>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // MySQL 客户端错误码：连接已经不可用
+    constexpr int CR_SERVER_GONE_ERROR = 2006;
+    constexpr int CR_SERVER_LOST = 2013;
+    constexpr int CR_SERVER_LOST_EXTENDED = 2055;
+}
+
+PooledConnection::PooledConnection(DatabaseManager *owner, std::unique_ptr<PooledSlot> slot)
+    : owner_(owner), slot_(std::move(slot))
+{
+}
+
+PooledConnection::~PooledConnection()
+{
+    release();
+}
+
+PooledConnection::PooledConnection(PooledConnection &&other) noexcept
+    : owner_(other.owner_), slot_(std::move(other.slot_)), broken_(other.broken_)
+{
+    other.owner_ = nullptr;
+    other.broken_ = false;
+}
+
+PooledConnection &PooledConnection::operator=(PooledConnection &&other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        owner_ = other.owner_;
+        slot_ = std::move(other.slot_);
+        broken_ = other.broken_;
+        other.owner_ = nullptr;
+        other.broken_ = false;
+    }
+    return *this;
+}
+
+void PooledConnection::release()
+{
+    if (owner_ && slot_)
+    {
+        owner_->return_slot(std::move(slot_), broken_);
+    }
+    owner_ = nullptr;
+    broken_ = false;
+}
+
+void PooledConnection::invalidate()
+{
+    broken_ = true;
+    if (slot_)
+    {
+        slot_->statements.clear();
+    }
+}
+
+bool PooledConnection::is_connection_lost(const sql::SQLException &e)
+{
+    int code = e.getErrorCode();
+    return code == CR_SERVER_GONE_ERROR || code == CR_SERVER_LOST || code == CR_SERVER_LOST_EXTENDED;
+}
+
+bool PooledConnection::invalidate_if_lost(const sql::SQLException &e)
+{
+    if (!is_connection_lost(e))
+    {
+        return false;
+    }
+    if (!broken_)
+    {
+        LOG_RATE_LIMITED(spdlog::level::warn, "Dropping pooled MySQL connection after error {}: {}",
+                         e.getErrorCode(), e.what());
+    }
+    invalidate();
+    return true;
+}
+
+sql::PreparedStatement *PooledConnection::prepare(const std::string &sql)
+{
+    auto &statements = slot_->statements;
+    auto it = statements.find(sql);
+    if (it != statements.end())
+    {
+        if (owner_)
+        {
+            owner_->statement_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+        }
+        it->second->clearParameters();
+        return it->second.get();
+    }
+
+    // prepare 失败时抛出 SQLException；连接已断开时连同缓存一起作废，否则缓存保持不变
+    std::unique_ptr<sql::PreparedStatement> stmt;
+    try
+    {
+        stmt.reset(slot_->connection->prepareStatement(sql));
+    }
+    catch (const sql::SQLException &e)
+    {
+        invalidate_if_lost(e);
+        throw;
+    }
+    if (owner_)
+    {
+        owner_->statement_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (statements.size() >= PooledSlot::MAX_CACHED_STATEMENTS)
+    {
+        statements.clear();
+    }
+    return statements.emplace(sql, std::move(stmt)).first->second.get();
+}
 
 DatabaseManager &DatabaseManager::get_instance()
 {
@@ -7,33 +126,59 @@ DatabaseManager &DatabaseManager::get_instance()
     return instance;
 }
 
-bool DatabaseManager::initialize(const std::string &host,
-                                 const std::string &user,
-                                 const std::string &password,
-                                 const std::string &database)
+bool DatabaseManager::initialize(const Config::DatabaseConfig &config)
 {
-    std::lock_guard<std::mutex> lock(connection_mutex_);
+    std::lock_guard<std::mutex> init_lock(init_mutex_);
+    if (initialized_)
+    {
+        return true;
+    }
 
     try
     {
-        spdlog::info("Initializing database connection to {}", host);
+        spdlog::info("Initializing database connection pool to {} (min={}, max={})",
+                     config.host, config.pool_min_size, config.pool_max_size);
 
         // 获取MySQL驱动实例
         driver_ = get_driver_instance();
 
-        connection_url_ = host;
-        username_ = user;
-        password_ = password;
-        database_name_ = database;
+        config_ = config;
+        config_.pool_max_size = std::max(1, config_.pool_max_size);
+        config_.pool_min_size = std::clamp(config_.pool_min_size, 0, config_.pool_max_size);
 
-        // 测试连接 - 直接创建而不调用get_connection()以避免循环依赖
-        std::unique_ptr<sql::Connection> test_conn(
-            driver_->connect(connection_url_, username_, password_));
-        test_conn->setSchema(database_name_);
+        // 预建最小连接数，同时用第一个连接验证配置是否正确
+        std::vector<std::unique_ptr<PooledSlot>> warm_slots;
+        for (int i = 0; i < std::max(1, config_.pool_min_size); ++i)
+        {
+            auto slot = create_slot();
+            if (!slot)
+            {
+                spdlog::error("Failed to create initial database connection {}/{}", i + 1, config_.pool_min_size);
+                return false;
+            }
+            warm_slots.push_back(std::move(slot));
+        }
         spdlog::debug("Test database connection successful");
 
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            for (auto &slot : warm_slots)
+            {
+                idle_slots_.push_back(std::move(slot));
+                ++total_slots_;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(maintenance_mutex_);
+            stop_maintenance_ = false;
+        }
+        last_created_snapshot_ = created_total_.load();
+        maintenance_thread_ = std::thread(&DatabaseManager::maintenance_loop, this);
+
         initialized_ = true;
-        spdlog::info("Database connection initialized successfully");
+        spdlog::info("Database connection pool initialized successfully with {} connections",
+                     warm_slots.size());
         return true;
     }
     catch (sql::SQLException &e)
@@ -49,25 +194,132 @@ bool DatabaseManager::initialize(const std::string &host,
     }
 }
 
-std::unique_ptr<sql::Connection> DatabaseManager::get_connection()
+/**
+ * @brief 从连接池借用连接
+ *
+ * 流程：
+ * 1. 有空闲连接 -> 取最近归还的一个（LIFO，连接更"热"，也让旧连接自然老化被回收）
+ * 2. 无空闲但未达上限 -> 先占位 total_slots_，释放锁后再建连，避免握手期间阻塞其他线程
+ * 3. 已达上限 -> 在 pool_cv_ 上等待，最多 borrow_timeout_ms
+ *
+ * 空闲时间超过巡检周期的连接在交出前用 isValid() 校验，失效的直接丢弃并重试。
+ */
+PooledConnection DatabaseManager::get_connection()
 {
     if (!initialized_)
     {
         spdlog::error("DatabaseManager not initialized");
-        return nullptr;
+        return PooledConnection();
+    }
+
+    const auto wait_start = std::chrono::steady_clock::now();
+    const auto deadline = wait_start + std::chrono::milliseconds(config_.borrow_timeout_ms);
+    const auto validate_after = std::chrono::seconds(config_.health_check_interval_sec);
+
+    while (true)
+    {
+        std::unique_ptr<PooledSlot> slot;
+        bool need_create = false;
+
+        {
+            std::unique_lock<std::mutex> lock(pool_mutex_);
+            bool ready = pool_cv_.wait_until(lock, deadline, [this]()
+                                             { return !initialized_ || !idle_slots_.empty() ||
+                                                      total_slots_ < static_cast<size_t>(config_.pool_max_size); });
+            if (!initialized_)
+            {
+                return PooledConnection();
+            }
+            if (!ready)
+            {
+                borrow_timeouts_++;
+                LOG_RATE_LIMITED(spdlog::level::warn, "Timed out after {} ms waiting for a database connection ({} in use)",
+                                 config_.borrow_timeout_ms, in_use_slots_);
+                return PooledConnection();
+            }
+
+            if (!idle_slots_.empty())
+            {
+                slot = std::move(idle_slots_.back());
+                idle_slots_.pop_back();
+            }
+            else
+            {
+                need_create = true;
+                ++total_slots_; // 先占位，建连失败时再归还
+                ++creating_slots_;
+            }
+            ++in_use_slots_;
+        }
+
+        if (need_create)
+        {
+            slot = create_slot();
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            --creating_slots_;
+            if (!slot)
+            {
+                --total_slots_;
+                --in_use_slots_;
+            }
+            // 可能有 shutdown() 在等建连结束，不能只唤醒一个
+            pool_cv_.notify_all();
+            if (!slot)
+            {
+                return PooledConnection();
+            }
+        }
+        else if (std::chrono::steady_clock::now() - slot->last_used > validate_after)
+        {
+            bool valid = false;
+            try
+            {
+                valid = slot->connection->isValid();
+            }
+            catch (sql::SQLException &e)
+            {
+                spdlog::debug("Connection validation failed: {}", e.what());
+            }
+
+            if (!valid)
+            {
+                spdlog::warn("Discarding stale database connection");
+                return_slot(std::move(slot), true);
+                continue;
+            }
+        }
+
+        auto waited_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                   std::chrono::steady_clock::now() - wait_start)
+                                                   .count());
+        borrow_total_++;
+        wait_time_us_total_ += waited_us;
+        uint64_t current_max = max_wait_us_.load();
+        while (waited_us > current_max && !max_wait_us_.compare_exchange_weak(current_max, waited_us))
+        {
+        }
+
+        slot->last_used = std::chrono::steady_clock::now();
+        return PooledConnection(this, std::move(slot));
     }
+}
 
+std::unique_ptr<PooledSlot> DatabaseManager::create_slot()
+{
     try
     {
-        // 创建新的连接
-        std::unique_ptr<sql::Connection> conn(
-            driver_->connect(connection_url_, username_, password_));
+        auto slot = std::make_unique<PooledSlot>();
+        slot->connection.reset(driver_->connect(config_.host, config_.user, config_.password));
 
         // 选择数据库
-        conn->setSchema(database_name_);
+        slot->connection->setSchema(config_.database);
+
+        slot->created_at = std::chrono::steady_clock::now();
+        slot->last_used = slot->created_at;
+        created_total_++;
 
         spdlog::debug("Created new database connection");
-        return conn;
+        return slot;
     }
     catch (sql::SQLException &e)
     {
@@ -82,16 +334,213 @@ std::unique_ptr<sql::Connection> DatabaseManager::get_connection()
     }
 }
 
+void DatabaseManager::return_slot(std::unique_ptr<PooledSlot> slot, bool broken)
+{
+    std::unique_ptr<PooledSlot> discard;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        --in_use_slots_;
+
+        if (broken || !initialized_)
+        {
+            --total_slots_;
+            discard = std::move(slot);
+        }
+        else
+        {
+            slot->last_used = std::chrono::steady_clock::now();
+            idle_slots_.push_back(std::move(slot));
+        }
+    }
+    pool_cv_.notify_one();
+
+    if (discard)
+    {
+        // 在锁外关闭物理连接，避免 close 的网络往返阻塞其他借用者
+        discard.reset();
+        destroyed_total_++;
+    }
+}
+
+void DatabaseManager::maintenance_loop()
+{
+    const auto interval = std::chrono::seconds(std::max(1, config_.health_check_interval_sec));
+
+    std::unique_lock<std::mutex> lock(maintenance_mutex_);
+    while (!stop_maintenance_)
+    {
+        if (maintenance_cv_.wait_for(lock, interval, [this]()
+                                     { return stop_maintenance_; }))
+        {
+            break;
+        }
+
+        lock.unlock();
+        try
+        {
+            evict_idle_slots();
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::warn("Database pool maintenance error: {}", e.what());
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * @brief 回收超时空闲连接，补足最小连接数
+ *
+ * 空闲队列头部是最久未使用的连接，超过 idle_timeout_sec 且总数高于 min_size 时回收。
+ * 这里不再对剩余空闲连接逐个 isValid()：批量取出期间它们都算作借出，池满时借用者要等整轮检查结束，
+ * 一个卡到 socket 超时的坏连接就能让所有数据库请求停顿。空闲超过巡检周期的连接由 get_connection()
+ * 在借出时单独校验，坏连接只影响拿到它的那一次借用。
+ */
+void DatabaseManager::evict_idle_slots()
+{
+    const auto now = std::chrono::steady_clock::now();
+    const auto idle_timeout = std::chrono::seconds(config_.idle_timeout_sec);
+
+    std::vector<std::unique_ptr<PooledSlot>> evicted;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        while (!idle_slots_.empty() &&
+               total_slots_ > static_cast<size_t>(config_.pool_min_size) &&
+               now - idle_slots_.front()->last_used > idle_timeout)
+        {
+            evicted.push_back(std::move(idle_slots_.front()));
+            idle_slots_.pop_front();
+            --total_slots_;
+        }
+    }
+
+    // 在锁外关闭物理连接
+    destroyed_total_ += evicted.size();
+    if (!evicted.empty())
+    {
+        spdlog::debug("Evicted {} idle database connections", evicted.size());
+    }
+    evicted.clear();
+
+    // 补足最小连接数
+    while (initialized_)
+    {
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            if (total_slots_ >= static_cast<size_t>(config_.pool_min_size))
+            {
+                break;
+            }
+            ++total_slots_;
+        }
+
+        auto slot = create_slot();
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (!slot)
+        {
+            --total_slots_;
+            break;
+        }
+        idle_slots_.push_back(std::move(slot));
+        pool_cv_.notify_one();
+    }
+
+    // 计算最近一个巡检周期的建连速率
+    uint64_t created_now = created_total_.load();
+    double interval_sec = std::max(1, config_.health_check_interval_sec);
+    creation_rate_per_sec_ = static_cast<double>(created_now - last_created_snapshot_) / interval_sec;
+    last_created_snapshot_ = created_now;
+
+    spdlog::debug("{}", get_pool_stats_string());
+}
+
+DatabaseManager::PoolStats DatabaseManager::get_pool_stats() const
+{
+    PoolStats stats;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        stats.total = total_slots_;
+        stats.idle = idle_slots_.size();
+        stats.in_use = in_use_slots_;
+    }
+    stats.max_size = static_cast<size_t>(config_.pool_max_size);
+    stats.created_total = created_total_.load();
+    stats.destroyed_total = destroyed_total_.load();
+    stats.borrow_total = borrow_total_.load();
+    stats.borrow_timeouts = borrow_timeouts_.load();
+    stats.wait_time_us_total = wait_time_us_total_.load();
+    stats.max_wait_us = max_wait_us_.load();
+    stats.creation_rate_per_sec = creation_rate_per_sec_.load();
+    stats.statement_cache_hits = statement_cache_hits_.load();
+    stats.statement_cache_misses = statement_cache_misses_.load();
+    return stats;
+}
+
+std::string DatabaseManager::get_pool_stats_string() const
+{
+    auto stats = get_pool_stats();
+    double avg_wait_us = stats.borrow_total > 0
+                             ? static_cast<double>(stats.wait_time_us_total) / stats.borrow_total
+                             : 0.0;
+
+    std::ostringstream oss;
+    oss << "DatabasePool Stats: "
+        << "Total=" << stats.total << "/" << stats.max_size
+        << ", Idle=" << stats.idle
+        << ", InUse=" << stats.in_use
+        << ", Created=" << stats.created_total
+        << ", Destroyed=" << stats.destroyed_total
+        << ", CreateRate=" << stats.creation_rate_per_sec << "/s"
+        << ", Borrows=" << stats.borrow_total
+        << ", Timeouts=" << stats.borrow_timeouts
+        << ", AvgWait=" << avg_wait_us << "us"
+        << ", MaxWait=" << stats.max_wait_us << "us"
+        << ", StmtCache=" << stats.statement_cache_hits << "/"
+        << (stats.statement_cache_hits + stats.statement_cache_misses);
+    return oss.str();
+}
+
 bool DatabaseManager::is_connected() const
 {
     return initialized_;
 }
 
+/**
+ * 先停维护线程（它会在锁外建连），再等借用者正在进行的建连结束，之后才能清空 driver_：
+ * create_slot() 不持有 pool_mutex_ 读 driver_。借出中的连接不等，归还时看到 initialized_ == false 直接关闭
+ */
 void DatabaseManager::shutdown()
 {
-    std::lock_guard<std::mutex> lock(connection_mutex_);
+    std::lock_guard<std::mutex> init_lock(init_mutex_);
+    if (!initialized_.exchange(false))
+    {
+        return;
+    }
 
-    initialized_ = false;
+    {
+        std::lock_guard<std::mutex> lock(maintenance_mutex_);
+        stop_maintenance_ = true;
+    }
+    maintenance_cv_.notify_all();
+    if (maintenance_thread_.joinable())
+    {
+        maintenance_thread_.join();
+    }
+
+    // 唤醒所有等待者，让它们看到 initialized_ == false 后返回空句柄
+    pool_cv_.notify_all();
+
+    std::deque<std::unique_ptr<PooledSlot>> closing;
+    {
+        std::unique_lock<std::mutex> lock(pool_mutex_);
+        pool_cv_.wait(lock, [this]()
+                      { return creating_slots_ == 0; });
+        closing.swap(idle_slots_);
+        total_slots_ -= closing.size();
+    }
+
+    destroyed_total_ += closing.size();
+    closing.clear();
     driver_ = nullptr;
 
     spdlog::info("Database manager shutdown complete");
@@ -100,4 +549,4 @@ void DatabaseManager::shutdown()
 DatabaseManager::~DatabaseManager()
 {
     shutdown();
-}
\ No newline at end of file
+}
@@ -2,35 +2,153 @@
 
 #include <mysql/jdbc.h>
 #include <memory>
+#include <unordered_map>
 #include <string>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <spdlog/spdlog.h>
+#include "../config/config.h"
+
+class DatabaseManager;
+
+/**
+ * @brief 连接池中的一个槽位
+ *
+ * 持有真正的 sql::Connection 以及池管理所需的时间戳。
+ * 槽位在借出期间由 PooledConnection 独占，归还后回到空闲队列。
+ *
+ * statements 是这条连接上已经准备好的语句（服务端 prepare），按 SQL 文本索引，随连接一起复用；
+ * 声明在 connection 之后，析构时先于连接释放。
+ */
+struct PooledSlot
+{
+    // 单条连接缓存的语句数上限，超出时整体清空（正常只有十几条固定 SQL）
+    static constexpr size_t MAX_CACHED_STATEMENTS = 64;
+
+    std::unique_ptr<sql::Connection> connection;
+    std::chrono::steady_clock::time_point created_at;
+    std::chrono::steady_clock::time_point last_used;
+    std::unordered_map<std::string, std::unique_ptr<sql::PreparedStatement>> statements;
+};
+
+/**
+ * @brief 从连接池借出的连接句柄（RAII）
+ *
+ * 用法与之前的 std::unique_ptr<sql::Connection> 保持一致：
+ * @code
+ * auto conn = DatabaseManager::get_instance().get_connection();
+ * if (!conn) { ... }
+ * conn->prepareStatement(...);
+ * @endcode
+ * 固定 SQL 的热点查询用 prepare() / Query（query.h）取连接上缓存的语句，省掉每次的 prepare 往返。
+ * 析构时自动归还给连接池；调用 invalidate() 后析构会直接丢弃该连接（连同缓存的语句）。
+ */
+class PooledConnection
+{
+public:
+    PooledConnection() = default;
+    PooledConnection(DatabaseManager *owner, std::unique_ptr<PooledSlot> slot);
+    ~PooledConnection();
+
+    PooledConnection(PooledConnection &&other) noexcept;
+    PooledConnection &operator=(PooledConnection &&other) noexcept;
+    PooledConnection(const PooledConnection &) = delete;
+    PooledConnection &operator=(const PooledConnection &) = delete;
+
+    sql::Connection *get() const { return slot_ ? slot_->connection.get() : nullptr; }
+    sql::Connection *operator->() const { return get(); }
+    explicit operator bool() const { return get() != nullptr; }
+
+    // 标记连接已损坏（例如遇到 "MySQL server has gone away"），归还时不再放回池中；
+    // 缓存的语句句柄随连接一起失效，立即清空，之后的 prepare() 不会再拿到旧句柄
+    void invalidate();
+
+    /**
+     * @brief 连接已断开类的错误（MySQL 重启、wait_timeout 后被服务器关闭）
+     * 这样的连接放回池中会被下一个借用者立刻拿到（刚用过，借用时不做 isValid），必须丢弃
+     */
+    static bool is_connection_lost(const sql::SQLException &e);
+
+    // 遇到连接断开类错误时 invalidate()，返回是否已标记；Query 在执行失败时统一调用
+    bool invalidate_if_lost(const sql::SQLException &e);
+
+    /**
+     * @brief 取这条连接上缓存的预处理语句，第一次使用时才向服务器 prepare
+     * 返回的语句归连接所有，参数已清空；不要 delete，也不要在归还连接之后继续使用。
+     * 同一时刻只能有一个调用方使用同一条语句（连接本来就是独占借出的）。
+     * 每次 SQL 文本都不同的语句（如行数不定的多行 INSERT）应直接用 prepareStatement()。
+     * prepare 遇到连接断开类错误时先 invalidate() 再抛出。
+     */
+    sql::PreparedStatement *prepare(const std::string &sql);
+
+private:
+    void release();
+
+    DatabaseManager *owner_ = nullptr;
+    std::unique_ptr<PooledSlot> slot_;
+    bool broken_ = false;
+};
 
 /**
  * DatabaseManager类负责管理MySQL连接和数据库操作
  * 提供线程安全的数据库访问接口
+ *
+ * 内部维护一个有界连接池：
+ * - 启动时预建 pool_min_size 个连接，总数不超过 pool_max_size
+ * - 池满时 get_connection() 最多等待 borrow_timeout_ms，超时返回空句柄
+ * - 后台维护线程按 health_check_interval_sec 回收超时空闲连接、补足 pool_min_size
+ * - 借用时若连接空闲时间超过巡检周期，先用 isValid() 校验再交给调用方（可用性只在这里校验：
+ *   维护线程不批量取出空闲连接做 isValid()，一个卡到 socket 超时的坏连接不会让其他借用者一起等待）
  */
 class DatabaseManager
 {
 public:
+    /**
+     * @brief 连接池统计信息快照
+     */
+    struct PoolStats
+    {
+        size_t total = 0;                // 当前连接总数（空闲 + 借出 + 正在创建）
+        size_t idle = 0;                 // 空闲连接数
+        size_t in_use = 0;               // 借出中的连接数
+        size_t max_size = 0;             // 连接池上限
+        uint64_t created_total = 0;      // 累计创建的物理连接数
+        uint64_t destroyed_total = 0;    // 累计销毁的物理连接数
+        uint64_t borrow_total = 0;       // 累计成功借用次数
+        uint64_t borrow_timeouts = 0;    // 累计借用超时次数
+        uint64_t wait_time_us_total = 0; // 累计等待时间（微秒）
+        uint64_t max_wait_us = 0;        // 单次最长等待时间（微秒）
+        double creation_rate_per_sec = 0; // 最近一个巡检周期内的建连速率
+        uint64_t statement_cache_hits = 0;   // prepare() 命中连接上已准备好的语句
+        uint64_t statement_cache_misses = 0; // prepare() 需要向服务器 prepare
+    };
+
     static DatabaseManager &get_instance();
 
-    // 初始化数据库连接
-    bool initialize(const std::string &host = "tcp://127.0.0.1:3306",
-                    const std::string &user = "will",
-                    const std::string &password = "abcd1234",
-                    const std::string &database = "testdb");
+    // 初始化数据库连接池
+    bool initialize(const Config::DatabaseConfig &config);
 
-    // 获取数据库连接
-    std::unique_ptr<sql::Connection> get_connection();
+    // 从连接池借用一个连接，池满且等待超时或建连失败时返回空句柄
+    PooledConnection get_connection();
 
     // 检查数据库连接状态
     bool is_connected() const;
 
-    // 关闭数据库连接
+    // 关闭连接池
     void shutdown();
 
+    // 获取连接池统计信息
+    PoolStats get_pool_stats() const;
+    std::string get_pool_stats_string() const;
+
 private:
+    friend class PooledConnection;
+
     DatabaseManager() = default;
     ~DatabaseManager();
 
@@ -38,11 +156,45 @@ private:
     DatabaseManager(const DatabaseManager &) = delete;
     DatabaseManager &operator=(const DatabaseManager &) = delete;
 
+    // 创建一个新的物理连接（不持有 pool_mutex_ 时调用）
+    std::unique_ptr<PooledSlot> create_slot();
+
+    // PooledConnection 析构时归还连接
+    void return_slot(std::unique_ptr<PooledSlot> slot, bool broken);
+
+    // 后台维护：空闲回收 + 补足最小连接数
+    void maintenance_loop();
+    void evict_idle_slots();
+
     sql::Driver *driver_ = nullptr;
-    std::string connection_url_;
-    std::string username_;
-    std::string password_;
-    std::string database_name_;
-    bool initialized_ = false;
-    mutable std::mutex connection_mutex_;
-};
\ No newline at end of file
+    Config::DatabaseConfig config_;
+    std::atomic<bool> initialized_{false};
+    // 串行化 initialize() / shutdown()：并发的第二次 initialize() 等第一次完成后直接返回，不会重复建池
+    std::mutex init_mutex_;
+
+    // 连接池状态，均由 pool_mutex_ 保护
+    mutable std::mutex pool_mutex_;
+    std::condition_variable pool_cv_;
+    std::deque<std::unique_ptr<PooledSlot>> idle_slots_; // 尾部为最近归还的连接
+    size_t total_slots_ = 0;
+    size_t in_use_slots_ = 0;
+    size_t creating_slots_ = 0; // 借用者在锁外建连的数量，shutdown() 等它归零后才清空 driver_
+
+    // 维护线程
+    std::thread maintenance_thread_;
+    std::mutex maintenance_mutex_;
+    std::condition_variable maintenance_cv_;
+    bool stop_maintenance_ = false;
+
+    // 统计信息
+    std::atomic<uint64_t> created_total_{0};
+    std::atomic<uint64_t> destroyed_total_{0};
+    std::atomic<uint64_t> borrow_total_{0};
+    std::atomic<uint64_t> borrow_timeouts_{0};
+    std::atomic<uint64_t> wait_time_us_total_{0};
+    std::atomic<uint64_t> max_wait_us_{0};
+    std::atomic<double> creation_rate_per_sec_{0};
+    std::atomic<uint64_t> statement_cache_hits_{0};
+    std::atomic<uint64_t> statement_cache_misses_{0};
+    uint64_t last_created_snapshot_ = 0;
+};
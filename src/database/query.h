@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "database_manager.h"
+
+/**
+ * @brief 类型化查询：在借出的连接上取缓存的预处理语句，按参数的 C++ 类型绑定
+ *
+ * 热点查询第一次在某条连接上执行时 prepare 一次，之后每次只有一次 execute 往返：
+ * @code
+ * auto conn = DatabaseManager::get_instance().get_connection();
+ * auto rs = Query(conn, "SELECT ... WHERE username = ?").bind(username).execute_query();
+ * int rows = Query(conn, "UPDATE ... WHERE user_id = ?").bind(hash, user_id).execute_update();
+ * @endcode
+ * 参数按顺序从 1 开始绑定；语句属于连接，Query 只在该连接借出期间有效。
+ * prepare 或执行遇到连接断开类错误时先 invalidate() 再原样抛出：连接和它缓存的服务端语句句柄一起丢弃，
+ * 调用方只需要处理 SQLException，坏连接和失效的语句都不会回到池中。
+ */
+class Query
+{
+public:
+    Query(PooledConnection &conn, const std::string &sql) : conn_(conn), stmt_(conn.prepare(sql)) {}
+
+    template <typename... Args>
+    Query &bind(const Args &...args)
+    {
+        (set(args), ...);
+        return *this;
+    }
+
+    std::unique_ptr<sql::ResultSet> execute_query()
+    {
+        try
+        {
+            return std::unique_ptr<sql::ResultSet>(stmt_->executeQuery());
+        }
+        catch (const sql::SQLException &e)
+        {
+            conn_.invalidate_if_lost(e);
+            throw;
+        }
+    }
+
+    int execute_update()
+    {
+        try
+        {
+            return stmt_->executeUpdate();
+        }
+        catch (const sql::SQLException &e)
+        {
+            conn_.invalidate_if_lost(e);
+            throw;
+        }
+    }
+
+private:
+    void set(const std::string &value) { stmt_->setString(next_index_++, value); }
+    void set(const char *value) { stmt_->setString(next_index_++, value); }
+    void set(int value) { stmt_->setInt(next_index_++, value); }
+    void set(int64_t value) { stmt_->setInt64(next_index_++, value); }
+    void set(uint64_t value) { stmt_->setUInt64(next_index_++, value); }
+
+    PooledConnection &conn_;
+    sql::PreparedStatement *stmt_;
+    unsigned next_index_ = 1;
+};
@@ -0,0 +1,188 @@
+#include "blocking_executor.h"
+#include "../metrics/metrics_registry.h"
+#include <spdlog/spdlog.h>
+#include <sstream>
+
+BlockingExecutor::BlockingExecutor(std::string name, size_t thread_count, size_t max_queue_size)
+    : name_(std::move(name)), thread_count_(thread_count == 0 ? 1 : thread_count), max_queue_size_(max_queue_size)
+{
+}
+
+BlockingExecutor::~BlockingExecutor()
+{
+    stop();
+}
+
+void BlockingExecutor::start()
+{
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    if (started_)
+    {
+        return;
+    }
+
+    started_ = true;
+    stopping_ = false;
+    for (size_t i = 0; i < thread_count_; ++i)
+    {
+        threads_.emplace_back(&BlockingExecutor::worker_loop, this);
+    }
+
+    spdlog::info("BlockingExecutor '{}' started with {} threads (queue limit: {})",
+                 name_, thread_count_, max_queue_size_);
+}
+
+void BlockingExecutor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (!started_ || stopping_)
+        {
+            return;
+        }
+        stopping_ = true;
+    }
+    queue_cv_.notify_all();
+
+    for (auto &thread : threads_)
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+    threads_.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        started_ = false;
+    }
+
+    spdlog::info("BlockingExecutor '{}' stopped. {}", name_, get_stats_string());
+}
+
+bool BlockingExecutor::submit(std::function<void()> task)
+{
+    size_t depth;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        if (!started_ || stopping_ || (max_queue_size_ > 0 && queue_.size() >= max_queue_size_))
+        {
+            rejected_++;
+            return false;
+        }
+
+        queue_.push_back(Task{std::move(task), std::chrono::steady_clock::now()});
+        depth = queue_.size();
+    }
+    queue_cv_.notify_one();
+    submitted_++;
+
+    size_t current_max = max_queue_depth_.load(std::memory_order_relaxed);
+    while (depth > current_max &&
+           !max_queue_depth_.compare_exchange_weak(current_max, depth, std::memory_order_relaxed))
+    {
+    }
+    return true;
+}
+
+size_t BlockingExecutor::queue_depth() const
+{
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    return queue_.size();
+}
+
+void BlockingExecutor::worker_loop()
+{
+    while (true)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, [this]()
+                           { return stopping_ || !queue_.empty(); });
+            if (queue_.empty())
+            {
+                return; // stopping_ 且队列已排空
+            }
+            task = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        auto started_at = std::chrono::steady_clock::now();
+        queue_wait_us_.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(started_at - task.enqueued_at).count()));
+
+        try
+        {
+            task.fn();
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::error("Exception in BlockingExecutor '{}' task: {}", name_, e.what());
+        }
+        catch (...)
+        {
+            spdlog::error("Unknown exception in BlockingExecutor '{}' task", name_);
+        }
+
+        run_time_us_.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started_at).count()));
+        completed_++;
+    }
+}
+
+BlockingExecutor::Stats BlockingExecutor::get_stats() const
+{
+    Stats stats;
+    stats.threads = thread_count_;
+    stats.queue_depth = queue_depth();
+    stats.max_queue_depth = max_queue_depth_.load();
+    stats.submitted = submitted_.load();
+    stats.rejected = rejected_.load();
+    stats.completed = completed_.load();
+    stats.queue_wait_p50_us = queue_wait_us_.percentile(0.50);
+    stats.queue_wait_p99_us = queue_wait_us_.percentile(0.99);
+    stats.run_time_p50_us = run_time_us_.percentile(0.50);
+    stats.run_time_p99_us = run_time_us_.percentile(0.99);
+    return stats;
+}
+
+void BlockingExecutor::register_metrics() const
+{
+    auto &registry = MetricsRegistry::get_instance();
+    std::string labels = MetricsRegistry::label("executor", name_);
+
+    registry.gauge("im_executor_queue_depth", "Tasks waiting in the blocking executor queue", labels,
+                   [this]()
+                   { return static_cast<double>(queue_depth()); });
+    registry.gauge("im_executor_threads", "Blocking executor worker threads", labels,
+                   [this]()
+                   { return static_cast<double>(thread_count_); });
+    registry.counter_callback("im_executor_submitted_total", "Tasks accepted by the blocking executor", labels,
+                              [this]()
+                              { return static_cast<double>(submitted_.load(std::memory_order_relaxed)); });
+    registry.counter_callback("im_executor_rejected_total", "Tasks rejected because the queue was full", labels,
+                              [this]()
+                              { return static_cast<double>(rejected_.load(std::memory_order_relaxed)); });
+    registry.attach_histogram("im_executor_queue_wait_seconds", "Time tasks spent waiting in the queue",
+                              labels, queue_wait_us_);
+    registry.attach_histogram("im_executor_run_seconds", "Time tasks spent running", labels, run_time_us_);
+}
+
+std::string BlockingExecutor::get_stats_string() const
+{
+    auto stats = get_stats();
+
+    std::ostringstream oss;
+    oss << "BlockingExecutor[" << name_ << "] Stats: "
+        << "Threads=" << stats.threads
+        << ", Queue=" << stats.queue_depth
+        << ", MaxQueue=" << stats.max_queue_depth
+        << ", Submitted=" << stats.submitted
+        << ", Rejected=" << stats.rejected
+        << ", Completed=" << stats.completed
+        << ", Wait(p50/p99)=" << stats.queue_wait_p50_us << "/" << stats.queue_wait_p99_us << "us"
+        << ", Run(p50/p99)=" << stats.run_time_p50_us << "/" << stats.run_time_p99_us << "us";
+    return oss.str();
+}
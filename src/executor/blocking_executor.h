@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../metrics/histogram.h"
+
+/**
+ * @brief 阻塞任务执行器
+ *
+ * 一个固定大小、队列有界的线程池，专门承载会阻塞的工作（MySQL 往返、crypt() 等），
+ * 让 io_context 的 worker 线程只做网络 I/O 和轻量级的消息处理。
+ *
+ * 典型流程：io 线程上的 MessageRouter 把任务 submit() 到这里 ->
+ * 执行器线程完成阻塞调用 -> 处理器调用 Session::send_packet()，响应被投递回会话所在的 io 线程。
+ *
+ * 队列满时 submit() 立即返回 false，由调用方决定如何拒绝请求，而不是无限堆积。
+ */
+class BlockingExecutor
+{
+public:
+    struct Stats
+    {
+        size_t threads = 0;
+        size_t queue_depth = 0;
+        size_t max_queue_depth = 0;
+        uint64_t submitted = 0;
+        uint64_t rejected = 0;
+        uint64_t completed = 0;
+        uint64_t queue_wait_p50_us = 0;
+        uint64_t queue_wait_p99_us = 0;
+        uint64_t run_time_p50_us = 0;
+        uint64_t run_time_p99_us = 0;
+    };
+
+    /**
+     * @param name 执行器名称，用于日志
+     * @param thread_count 线程数
+     * @param max_queue_size 等待队列上限，0 表示不限
+     */
+    BlockingExecutor(std::string name, size_t thread_count, size_t max_queue_size);
+    ~BlockingExecutor();
+
+    BlockingExecutor(const BlockingExecutor &) = delete;
+    BlockingExecutor &operator=(const BlockingExecutor &) = delete;
+
+    void start();
+
+    // 停止接收新任务，执行完已排队的任务后等待所有线程退出
+    void stop();
+
+    /**
+     * @brief 提交一个任务
+     * @return true 如果任务已入队，false 如果队列已满或执行器已停止
+     */
+    bool submit(std::function<void()> task);
+
+    size_t queue_depth() const;
+    const std::string &name() const { return name_; }
+
+    Stats get_stats() const;
+    std::string get_stats_string() const;
+
+    // 把队列深度、提交 / 拒绝计数和耗时直方图注册到 MetricsRegistry（标签 executor=name），执行器需比导出端活得久
+    void register_metrics() const;
+
+    // 任务在队列中的等待时间与执行时间（微秒）
+    const LatencyHistogram &queue_wait_histogram() const { return queue_wait_us_; }
+    const LatencyHistogram &run_time_histogram() const { return run_time_us_; }
+
+private:
+    struct Task
+    {
+        std::function<void()> fn;
+        std::chrono::steady_clock::time_point enqueued_at;
+    };
+
+    void worker_loop();
+
+    std::string name_;
+    size_t thread_count_;
+    size_t max_queue_size_;
+
+    mutable std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<Task> queue_;
+    bool stopping_ = false;
+    bool started_ = false;
+    std::vector<std::thread> threads_;
+
+    std::atomic<size_t> max_queue_depth_{0};
+    std::atomic<uint64_t> submitted_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> completed_{0};
+    LatencyHistogram queue_wait_us_;
+    LatencyHistogram run_time_us_;
+};
@@ -0,0 +1,47 @@
+#include "log_limiter.h"
+#include <chrono>
+
+std::atomic<uint32_t> LogRateLimiter::default_rate_{20};
+
+void LogRateLimiter::set_default_rate(uint32_t per_second)
+{
+    default_rate_.store(per_second, std::memory_order_relaxed);
+}
+
+int64_t LogRateLimiter::now_seconds()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * 固定一秒的窗口：进入新窗口的第一个调用方负责把计数清零
+ */
+bool LogRateLimiter::allow(uint64_t &suppressed_out)
+{
+    uint32_t limit = per_second_ != 0 ? per_second_ : default_rate_.load(std::memory_order_relaxed);
+    if (limit == 0)
+    {
+        return true;
+    }
+
+    int64_t now = now_seconds();
+    int64_t window = window_.load(std::memory_order_relaxed);
+    if (window != now && window_.compare_exchange_strong(window, now, std::memory_order_relaxed))
+    {
+        count_.store(0, std::memory_order_relaxed);
+    }
+
+    if (count_.fetch_add(1, std::memory_order_relaxed) >= limit)
+    {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (suppressed_.load(std::memory_order_relaxed) > 0)
+    {
+        suppressed_out = suppressed_.exchange(0, std::memory_order_relaxed);
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <spdlog/spdlog.h>
+
+/**
+ * @brief 按秒限流的日志闸门
+ *
+ * 用于每个连接、每个请求都会触发的日志（连接建立 / 断开、登录结果、繁忙拒绝等）：
+ * 每个调用点每秒最多放行 N 条，超出的计数，下一次放行时附带一条 "suppressed" 汇总。
+ * 重连风暴或压测时日志量被限制在 O(调用点数 × N)/秒，不会让日志 I/O 成为瓶颈。
+ *
+ * allow() 只有几次 relaxed 原子操作，可以在任意线程调用；窗口切换时的计数有少量误差，可以接受。
+ */
+class LogRateLimiter
+{
+public:
+    /**
+     * @param per_second 每秒最多放行的条数，0 表示跟随全局默认值（logging.rate_limit_per_sec）
+     */
+    explicit LogRateLimiter(uint32_t per_second = 0) : per_second_(per_second) {}
+
+    LogRateLimiter(const LogRateLimiter &) = delete;
+    LogRateLimiter &operator=(const LogRateLimiter &) = delete;
+
+    /**
+     * @param suppressed_out 放行时返回此前被丢弃的条数（未放行时不修改）
+     * @return true 如果这条日志可以输出
+     */
+    bool allow(uint64_t &suppressed_out);
+
+    // 全局默认限额，启动时由 setup_logging 按配置设置；0 表示不限流
+    static void set_default_rate(uint32_t per_second);
+    static uint32_t default_rate() { return default_rate_.load(std::memory_order_relaxed); }
+
+private:
+    static int64_t now_seconds();
+
+    uint32_t per_second_;
+    std::atomic<int64_t> window_{0};
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint64_t> suppressed_{0};
+
+    static std::atomic<uint32_t> default_rate_;
+};
+
+/**
+ * @brief 判断一条日志能否通过限流闸门
+ * 级别未开启时直接返回 false，不做限流计数；放行时先输出此前被丢弃条数的汇总
+ */
+inline bool log_gate(LogRateLimiter &limiter, spdlog::level::level_enum level)
+{
+    if (!spdlog::should_log(level))
+    {
+        return false;
+    }
+
+    uint64_t suppressed = 0;
+    if (!limiter.allow(suppressed))
+    {
+        return false;
+    }
+
+    if (suppressed > 0)
+    {
+        spdlog::log(level, "({} similar messages suppressed)", suppressed);
+    }
+    return true;
+}
+
+/**
+ * 每个调用点一个独立的限流器（函数内 static），用法与 spdlog::log 相同：
+ *   LOG_RATE_LIMITED(spdlog::level::info, "New client connected: {}", endpoint);
+ * 参数只在日志真正输出时才求值，可以放 remote_endpoint() 这类有开销的表达式
+ */
+#define LOG_RATE_LIMITED(level, ...)                          \
+    do                                                        \
+    {                                                         \
+        static LogRateLimiter log_rate_limiter_;              \
+        if (log_gate(log_rate_limiter_, level))               \
+        {                                                     \
+            spdlog::log(level, __VA_ARGS__);                  \
+        }                                                     \
+    } while (0)
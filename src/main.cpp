@@ -4,23 +4,26 @@
 #include <chrono>
 #include <signal.h>
 #include <atomic>
+#include <algorithm>
 #include <spdlog/spdlog.h>
+#include <spdlog/async.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 
 #include "config/config.h"
 #include "server/server.h"
+#include "logging/log_limiter.h"
 
 std::unique_ptr<Server> g_server;
 std::atomic<bool> g_running{true};
 
+/**
+ * 信号处理函数只设置退出标志，真正的 stop() 由主线程执行：
+ * 信号可能落在任意 worker 线程上，在那里 join 其他线程（甚至自己）会死锁
+ */
 void signal_handler(int signal)
 {
-    spdlog::info("Received signal {}, shutting down gracefully...", signal);
-    if (g_server)
-    {
-        g_server->stop();
-    }
+    (void)signal;
     g_running = false;
 }
 
@@ -39,7 +42,26 @@ void setup_logging(const Config::LoggingConfig &logging_config)
 
         // Combine sinks
         std::vector<spdlog::sink_ptr> sinks = {console_sink, file_sink};
-        auto combined_logger = std::make_shared<spdlog::logger>("combined", sinks.begin(), sinks.end());
+        std::shared_ptr<spdlog::logger> combined_logger;
+
+        if (logging_config.async)
+        {
+            // 异步模式：格式化后的消息进入有界队列，由后台线程写控制台和文件，worker 线程不再等待磁盘 I/O
+            auto policy = logging_config.overflow_policy == "block"
+                              ? spdlog::async_overflow_policy::block
+                              : spdlog::async_overflow_policy::overrun_oldest;
+            spdlog::init_thread_pool(static_cast<size_t>(std::max(1, logging_config.async_queue_size)),
+                                     static_cast<size_t>(std::max(1, logging_config.async_threads)));
+            combined_logger = std::make_shared<spdlog::async_logger>(
+                "combined", sinks.begin(), sinks.end(), spdlog::thread_pool(), policy);
+        }
+        else
+        {
+            combined_logger = std::make_shared<spdlog::logger>("combined", sinks.begin(), sinks.end());
+        }
+
+        // 警告及以上立即刷盘，崩溃前的关键日志不会留在缓冲区里
+        combined_logger->flush_on(spdlog::level::warn);
 
         // Set as default logger
         spdlog::set_default_logger(combined_logger);
@@ -65,7 +87,11 @@ void setup_logging(const Config::LoggingConfig &logging_config)
         // Set pattern
         spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] %v");
 
-        spdlog::info("Logging initialized successfully");
+        LogRateLimiter::set_default_rate(static_cast<uint32_t>(std::max(0, logging_config.rate_limit_per_sec)));
+
+        spdlog::info("Logging initialized successfully (level={}, async={}, queue={}, overflow={}, rate_limit={}/s)",
+                     logging_config.level, logging_config.async, logging_config.async_queue_size,
+                     logging_config.overflow_policy, logging_config.rate_limit_per_sec);
     }
     catch (const std::exception &e)
     {
@@ -118,12 +144,18 @@ int main(int argc, char *argv[])
         {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
+
+        spdlog::info("Shutdown requested, stopping server gracefully...");
+        g_server->stop();
     }
     catch (const std::exception &e)
     {
         spdlog::error("Server error: {}", e.what());
+        spdlog::shutdown();
         return 1;
     }
 
+    // 异步模式下把队列中剩余的日志写完再退出
+    spdlog::shutdown();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "histogram.h"
+#include <algorithm>
+#include <cmath>
+
+size_t LatencyHistogram::bucket_index(uint64_t value)
+{
+    if (value < LINEAR_BUCKETS)
+    {
+        return static_cast<size_t>(value);
+    }
+
+    // msb >= 4，取最高位之后的 3 位作为子桶
+    size_t msb = 63 - static_cast<size_t>(__builtin_clzll(value));
+    size_t sub = static_cast<size_t>((value >> (msb - 3)) & (SUB_BUCKETS - 1));
+    return LINEAR_BUCKETS + (msb - 4) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index)
+{
+    if (index < LINEAR_BUCKETS)
+    {
+        return index;
+    }
+
+    size_t msb = (index - LINEAR_BUCKETS) / SUB_BUCKETS + 4;
+    uint64_t sub = (index - LINEAR_BUCKETS) % SUB_BUCKETS;
+    uint64_t lower = (uint64_t{1} << msb) | (sub << (msb - 3));
+    return lower + (uint64_t{1} << (msb - 3)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    buckets_[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t current_max = max_.load(std::memory_order_relaxed);
+    while (value > current_max &&
+           !max_.compare_exchange_weak(current_max, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t LatencyHistogram::percentile(double q) const
+{
+    uint64_t total = count();
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    q = std::clamp(q, 0.0, 1.0);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += bucket_count(i);
+        if (seen >= rank)
+        {
+            return std::min(bucket_upper_bound(i), max());
+        }
+    }
+    return max();
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : buckets_)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
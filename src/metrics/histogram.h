@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief 无锁的对数-线性延迟直方图
+ *
+ * 数值（通常是微秒）按 "最高位 + 3 个次高位" 分桶：0-15 每个值一个桶，
+ * 之后每个 2 的幂区间再均分 8 个桶，相对误差不超过 12.5%。
+ * record() 只有一次 relaxed fetch_add，可以在任意线程的热路径上调用。
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr size_t LINEAR_BUCKETS = 16;
+    static constexpr size_t SUB_BUCKETS = 8;
+    static constexpr size_t BUCKET_COUNT = LINEAR_BUCKETS + (64 - 4) * SUB_BUCKETS;
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    // 记录一个样本
+    void record(uint64_t value);
+
+    // 样本总数与总和
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // 近似分位值，q 取值 [0, 1]，无样本时返回 0
+    uint64_t percentile(double q) const;
+
+    // 清空所有样本（非原子快照，仅用于测试或基准工具的分段统计）
+    void reset();
+
+    // 桶序号与取值范围之间的换算，供导出使用
+    static size_t bucket_index(uint64_t value);
+    static uint64_t bucket_upper_bound(size_t index);
+    uint64_t bucket_count(size_t index) const { return buckets_[index].load(std::memory_order_relaxed); }
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
@@ -0,0 +1,161 @@
+#include "metrics_http_server.h"
+#include "metrics_registry.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+
+namespace
+{
+
+constexpr size_t MAX_REQUEST_SIZE = 8 * 1024;
+constexpr auto REQUEST_TIMEOUT = std::chrono::seconds(5);
+
+std::string make_response(const std::string &status, const std::string &content_type, const std::string &body)
+{
+    std::string response = "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: " + content_type + "\r\n";
+    response += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+    return response;
+}
+
+} // namespace
+
+/**
+ * 一次抓取请求：读请求头 -> 写响应 -> 关闭，超时定时器兜底
+ */
+class MetricsHttpServer::Connection : public std::enable_shared_from_this<Connection>
+{
+public:
+    Connection(asio::ip::tcp::socket socket, std::string path)
+        : socket_(std::move(socket)), timer_(socket_.get_executor()), request_(MAX_REQUEST_SIZE), path_(std::move(path))
+    {
+    }
+
+    void start()
+    {
+        auto self = shared_from_this();
+        timer_.expires_after(REQUEST_TIMEOUT);
+        timer_.async_wait([self](const asio::error_code &ec)
+                          {
+                              if (!ec)
+                              {
+                                  self->close();
+                              } });
+
+        asio::async_read_until(socket_, request_, "\r\n\r\n",
+                               [self](const asio::error_code &ec, size_t /*bytes*/)
+                               {
+                                   if (ec)
+                                   {
+                                       self->close();
+                                       return;
+                                   }
+                                   self->respond();
+                               });
+    }
+
+private:
+    void respond()
+    {
+        // 只看请求行：METHOD SP PATH SP VERSION
+        std::istream stream(&request_);
+        std::string method, target;
+        stream >> method >> target;
+
+        std::string path = target.substr(0, target.find('?'));
+        if (method == "GET" && path == path_)
+        {
+            response_ = make_response("200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                                      MetricsRegistry::get_instance().render_prometheus());
+        }
+        else
+        {
+            response_ = make_response("404 Not Found", "text/plain", "not found\n");
+        }
+
+        auto self = shared_from_this();
+        asio::async_write(socket_, asio::buffer(response_),
+                          [self](const asio::error_code & /*ec*/, size_t /*bytes*/)
+                          {
+                              self->close();
+                          });
+    }
+
+    void close()
+    {
+        asio::error_code ignored;
+        timer_.cancel();
+        socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ignored);
+        socket_.close(ignored);
+    }
+
+    asio::ip::tcp::socket socket_;
+    asio::steady_timer timer_;
+    asio::streambuf request_;
+    std::string response_;
+    std::string path_;
+};
+
+MetricsHttpServer::MetricsHttpServer(asio::io_context &io_context, const Config::MetricsConfig &config)
+    : io_context_(io_context), config_(config), acceptor_(io_context)
+{
+}
+
+MetricsHttpServer::~MetricsHttpServer()
+{
+    stop();
+}
+
+bool MetricsHttpServer::start()
+{
+    try
+    {
+        asio::ip::tcp::endpoint endpoint(asio::ip::address::from_string(config_.host),
+                                         static_cast<unsigned short>(config_.port));
+        acceptor_.open(endpoint.protocol());
+        acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true));
+        acceptor_.bind(endpoint);
+        acceptor_.listen();
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("Failed to start metrics endpoint on {}:{}: {}", config_.host, config_.port, e.what());
+        return false;
+    }
+
+    running_ = true;
+    do_accept();
+    spdlog::info("Metrics endpoint listening on http://{}:{}{}", config_.host, config_.port, config_.path);
+    return true;
+}
+
+void MetricsHttpServer::stop()
+{
+    if (running_.exchange(false))
+    {
+        // acceptor 不是线程安全的，关闭操作投递到它所在的 io_context
+        asio::post(io_context_, [this]()
+                   {
+                       asio::error_code ignored;
+                       acceptor_.close(ignored); });
+    }
+}
+
+void MetricsHttpServer::do_accept()
+{
+    acceptor_.async_accept(
+        [this](const asio::error_code &ec, asio::ip::tcp::socket socket)
+        {
+            if (!running_)
+            {
+                return;
+            }
+
+            if (!ec)
+            {
+                std::make_shared<Connection>(std::move(socket), config_.path)->start();
+            }
+            do_accept();
+        });
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#define ASIO_STANDALONE
+#include <asio.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+#include "../config/config.h"
+
+/**
+ * @brief Prometheus 抓取端点
+ *
+ * 在已有的 io_context 上监听一个独立端口，只处理 GET <path>：每个请求渲染一次 MetricsRegistry，
+ * 以 HTTP/1.1 + Connection: close 返回后关闭连接。不是通用 HTTP 服务器：
+ * 请求头超过 8KB 或 5 秒内没有发完的连接直接关闭，其他路径返回 404。
+ *
+ * 抓取通常每 10~15 秒一次，渲染在 io 线程上执行，耗时与指标数量成正比（几十微秒级）。
+ */
+class MetricsHttpServer
+{
+public:
+    MetricsHttpServer(asio::io_context &io_context, const Config::MetricsConfig &config);
+    ~MetricsHttpServer();
+
+    MetricsHttpServer(const MetricsHttpServer &) = delete;
+    MetricsHttpServer &operator=(const MetricsHttpServer &) = delete;
+
+    // 绑定并开始监听；失败时记录日志并返回 false（不影响 IM 服务本身）
+    bool start();
+
+    // 关闭监听 socket，可以从任意线程调用
+    void stop();
+
+private:
+    class Connection;
+
+    void do_accept();
+
+    asio::io_context &io_context_;
+    Config::MetricsConfig config_;
+    asio::ip::tcp::acceptor acceptor_;
+    std::atomic<bool> running_{false};
+};
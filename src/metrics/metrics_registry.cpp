@@ -0,0 +1,241 @@
+#include "metrics_registry.h"
+#include <spdlog/spdlog.h>
+#include <cstdio>
+
+namespace
+{
+
+// 导出的 histogram 边界（微秒）：50us ~ 10s，覆盖 echo 到 DB + crypt 的请求
+constexpr uint64_t EXPORT_BOUNDS_US[] = {
+    50, 100, 250, 500,
+    1000, 2500, 5000, 10000, 25000, 50000,
+    100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000};
+
+std::string format_double(double value)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.15g", value);
+    return buf;
+}
+
+std::string series_name(const std::string &name, const std::string &labels)
+{
+    return labels.empty() ? name : name + "{" + labels + "}";
+}
+
+} // namespace
+
+uint64_t Counter::value() const
+{
+    uint64_t total = 0;
+    for (const auto &cell : cells_)
+    {
+        total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t Counter::stripe_index()
+{
+    static std::atomic<size_t> next_stripe{0};
+    thread_local size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % STRIPES;
+    return stripe;
+}
+
+MetricsRegistry &MetricsRegistry::get_instance()
+{
+    static MetricsRegistry instance;
+    return instance;
+}
+
+MetricsRegistry::Series &MetricsRegistry::get_series(const std::string &name, const std::string &help,
+                                                      Type type, const std::string &labels)
+{
+    Family *family;
+    auto it = families_by_name_.find(name);
+    if (it == families_by_name_.end())
+    {
+        auto created = std::make_unique<Family>();
+        created->name = name;
+        created->help = help;
+        created->type = type;
+        family = created.get();
+        families_by_name_.emplace(name, family);
+        families_.push_back(std::move(created));
+    }
+    else
+    {
+        family = it->second;
+        if (family->type != type)
+        {
+            spdlog::error("Metric {} registered with conflicting types", name);
+        }
+    }
+
+    for (auto &series : family->series)
+    {
+        if (series->labels == labels)
+        {
+            return *series;
+        }
+    }
+
+    family->series.push_back(std::make_unique<Series>());
+    family->series.back()->labels = labels;
+    return *family->series.back();
+}
+
+Counter &MetricsRegistry::counter(const std::string &name, const std::string &help, const std::string &labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series &series = get_series(name, help, Type::COUNTER, labels);
+    if (!series.counter)
+    {
+        series.counter = std::make_unique<Counter>();
+    }
+    return *series.counter;
+}
+
+LatencyHistogram &MetricsRegistry::histogram(const std::string &name, const std::string &help,
+                                             const std::string &labels)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series &series = get_series(name, help, Type::HISTOGRAM, labels);
+    if (!series.owned_histogram)
+    {
+        series.owned_histogram = std::make_unique<LatencyHistogram>();
+        series.histogram = series.owned_histogram.get();
+    }
+    return *series.owned_histogram;
+}
+
+void MetricsRegistry::attach_histogram(const std::string &name, const std::string &help,
+                                       const std::string &labels, const LatencyHistogram &histogram)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 已经通过 histogram() 创建的不释放（别处可能持有引用），只改变导出来源
+    get_series(name, help, Type::HISTOGRAM, labels).histogram = &histogram;
+}
+
+void MetricsRegistry::gauge(const std::string &name, const std::string &help, const std::string &labels,
+                            std::function<double()> callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    get_series(name, help, Type::GAUGE, labels).callback = std::move(callback);
+}
+
+void MetricsRegistry::counter_callback(const std::string &name, const std::string &help,
+                                       const std::string &labels, std::function<double()> callback)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 回调优先于同名的 Counter 对象导出
+    get_series(name, help, Type::COUNTER, labels).callback = std::move(callback);
+}
+
+std::string MetricsRegistry::render_prometheus() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::string out;
+    out.reserve(16 * 1024);
+    for (const auto &family : families_)
+    {
+        out += "# HELP " + family->name + " " + family->help + "\n";
+        out += "# TYPE " + family->name + " " + type_to_string(family->type) + "\n";
+
+        for (const auto &series : family->series)
+        {
+            if (family->type == Type::HISTOGRAM)
+            {
+                if (series->histogram)
+                {
+                    render_histogram(out, family->name, series->labels, *series->histogram);
+                }
+                continue;
+            }
+
+            double value = 0;
+            if (series->callback)
+            {
+                value = series->callback();
+            }
+            else if (series->counter)
+            {
+                value = static_cast<double>(series->counter->value());
+            }
+            out += series_name(family->name, series->labels) + " " + format_double(value) + "\n";
+        }
+    }
+    return out;
+}
+
+/**
+ * LatencyHistogram 有约 500 个对数桶，导出时折算到固定的秒级边界上（累计计数），
+ * 桶的上界不超过边界的样本计入该边界，误差与直方图本身的相对误差相同
+ */
+void MetricsRegistry::render_histogram(std::string &out, const std::string &name, const std::string &labels,
+                                       const LatencyHistogram &histogram)
+{
+    std::string prefix = labels.empty() ? "" : labels + ",";
+
+    uint64_t cumulative = 0;
+    size_t bucket = 0;
+    for (uint64_t bound : EXPORT_BOUNDS_US)
+    {
+        while (bucket < LatencyHistogram::BUCKET_COUNT && LatencyHistogram::bucket_upper_bound(bucket) <= bound)
+        {
+            cumulative += histogram.bucket_count(bucket);
+            ++bucket;
+        }
+        out += name + "_bucket{" + prefix + "le=\"" + format_double(static_cast<double>(bound) / 1e6) + "\"} " +
+               std::to_string(cumulative) + "\n";
+    }
+
+    // +Inf 与 _count 用同一次读取的总数，保证单调
+    uint64_t total = cumulative;
+    for (; bucket < LatencyHistogram::BUCKET_COUNT; ++bucket)
+    {
+        total += histogram.bucket_count(bucket);
+    }
+    out += name + "_bucket{" + prefix + "le=\"+Inf\"} " + std::to_string(total) + "\n";
+    out += series_name(name + "_sum", labels) + " " + format_double(static_cast<double>(histogram.sum()) / 1e6) + "\n";
+    out += series_name(name + "_count", labels) + " " + std::to_string(total) + "\n";
+}
+
+std::string MetricsRegistry::label(const std::string &key, const std::string &value)
+{
+    std::string out = key + "=\"";
+    for (char c : value)
+    {
+        switch (c)
+        {
+        case '\\':
+            out += "\\\\";
+            break;
+        case '"':
+            out += "\\\"";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        default:
+            out += c;
+        }
+    }
+    out += "\"";
+    return out;
+}
+
+const char *MetricsRegistry::type_to_string(Type type)
+{
+    switch (type)
+    {
+    case Type::COUNTER:
+        return "counter";
+    case Type::GAUGE:
+        return "gauge";
+    case Type::HISTOGRAM:
+        return "histogram";
+    }
+    return "untyped";
+}
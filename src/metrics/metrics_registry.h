@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "histogram.h"
+
+/**
+ * @brief 分条带的计数器
+ *
+ * 每个线程固定落在其中一个条带（按线程首次使用时轮流分配），条带之间按缓存行对齐，
+ * 多个 io 线程同时 add() 不会争用同一条缓存行；value() 在抓取时把所有条带相加。
+ */
+class Counter
+{
+public:
+    static constexpr size_t STRIPES = 16;
+
+    Counter() = default;
+    Counter(const Counter &) = delete;
+    Counter &operator=(const Counter &) = delete;
+
+    void add(uint64_t delta = 1)
+    {
+        cells_[stripe_index()].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Cell
+    {
+        std::atomic<uint64_t> value{0};
+    };
+
+    static size_t stripe_index();
+
+    std::array<Cell, STRIPES> cells_{};
+};
+
+/**
+ * @brief 从 start 到现在经过的微秒数
+ */
+inline uint64_t elapsed_us(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+/**
+ * @brief 作用域计时：析构时把经过的微秒数记入直方图，异常退出也会记录
+ */
+class ScopedLatency
+{
+public:
+    explicit ScopedLatency(LatencyHistogram &histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedLatency() { histogram_.record(elapsed_us(start_)); }
+
+    ScopedLatency(const ScopedLatency &) = delete;
+    ScopedLatency &operator=(const ScopedLatency &) = delete;
+
+private:
+    LatencyHistogram &histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief 进程内的指标注册表（Prometheus 文本格式导出）
+ *
+ * 三类指标：
+ * - counter()：Counter 对象，热路径上直接持有引用调用 add()
+ * - histogram()：LatencyHistogram（微秒），导出为以秒为单位的 Prometheus histogram
+ * - gauge() / counter_callback()：抓取时调用的回调，用于队列深度、连接数等已有的统计
+ *
+ * 注册（首次按 名称 + 标签 获取）需要加锁，通常在启动时或函数内 static 初始化时完成；
+ * 之后的记录只是原子操作，不经过注册表。同一 名称 + 标签 重复注册返回同一个对象。
+ *
+ * 回调捕获的对象必须比导出端（MetricsHttpServer）活得久，Server 停止时会先关闭导出端。
+ */
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry &get_instance();
+
+    Counter &counter(const std::string &name, const std::string &help, const std::string &labels = "");
+    LatencyHistogram &histogram(const std::string &name, const std::string &help, const std::string &labels = "");
+
+    // 导出一个由别处拥有的直方图（如 BlockingExecutor 的排队 / 执行耗时）
+    void attach_histogram(const std::string &name, const std::string &help, const std::string &labels,
+                          const LatencyHistogram &histogram);
+
+    void gauge(const std::string &name, const std::string &help, const std::string &labels,
+               std::function<double()> callback);
+    void counter_callback(const std::string &name, const std::string &help, const std::string &labels,
+                          std::function<double()> callback);
+
+    // 渲染为 Prometheus text exposition format (version 0.0.4)
+    std::string render_prometheus() const;
+
+    // 生成 key="value" 形式的标签，对值做转义；多个标签用逗号拼接
+    static std::string label(const std::string &key, const std::string &value);
+
+private:
+    MetricsRegistry() = default;
+    ~MetricsRegistry() = default;
+
+    MetricsRegistry(const MetricsRegistry &) = delete;
+    MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+    enum class Type
+    {
+        COUNTER,
+        GAUGE,
+        HISTOGRAM
+    };
+
+    struct Series
+    {
+        std::string labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<LatencyHistogram> owned_histogram;
+        const LatencyHistogram *histogram = nullptr;
+        std::function<double()> callback;
+    };
+
+    struct Family
+    {
+        std::string name;
+        std::string help;
+        Type type;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    Series &get_series(const std::string &name, const std::string &help, Type type, const std::string &labels);
+
+    static void render_histogram(std::string &out, const std::string &name, const std::string &labels,
+                                 const LatencyHistogram &histogram);
+    static const char *type_to_string(Type type);
+
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Family>> families_; // 按注册顺序导出
+    std::unordered_map<std::string, Family *> families_by_name_;
+};
@@ -0,0 +1,167 @@
+#include "frame_compression.h"
+#include "protocol_handler.h"
+#include <lz4.h>
+#include <spdlog/spdlog.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // LZ4 加速系数，1 为默认压缩比；数值越大越快、压缩比越低
+    constexpr int LZ4_ACCELERATION = 1;
+
+    // 每线程一份 LZ4 压缩状态，第一次使用时分配，之后每帧复用
+    void *lz4_state()
+    {
+        thread_local std::unique_ptr<char[]> state(new char[LZ4_sizeofState()]);
+        return state.get();
+    }
+
+    std::vector<uint8_t> &scratch_buffer()
+    {
+        thread_local std::vector<uint8_t> buffer;
+        return buffer;
+    }
+
+    std::vector<uint8_t> &decompress_buffer()
+    {
+        thread_local std::vector<uint8_t> buffer;
+        return buffer;
+    }
+}
+
+size_t FrameCompression::max_compressed_frame_size(size_t body_size)
+{
+    return 8 + static_cast<size_t>(LZ4_compressBound(static_cast<int>(body_size)));
+}
+
+size_t FrameCompression::compress_frame(const uint8_t *body, size_t body_size, uint8_t *out, size_t capacity)
+{
+    if (body_size <= 8 || body_size > ProtocolHandler::MAX_FRAME_SIZE || capacity <= 8)
+    {
+        return 0;
+    }
+
+    // 压缩帧（多 4 字节原始长度）必须比普通帧短，否则不值得；输出放不下时 LZ4 直接返回 0
+    int limit = static_cast<int>(std::min(capacity - 8, body_size - 5));
+    int compressed = LZ4_compress_fast_extState(lz4_state(), reinterpret_cast<const char *>(body),
+                                                reinterpret_cast<char *>(out + 8), static_cast<int>(body_size),
+                                                limit, LZ4_ACCELERATION);
+    if (compressed <= 0)
+    {
+        return 0;
+    }
+
+    uint32_t length = htonl((static_cast<uint32_t>(compressed) + 4) | ProtocolHandler::FLAG_COMPRESSED);
+    uint32_t raw_size = htonl(static_cast<uint32_t>(body_size));
+    std::memcpy(out, &length, 4);
+    std::memcpy(out + 4, &raw_size, 4);
+    return 8 + static_cast<size_t>(compressed);
+}
+
+bool FrameCompression::serialize_frame_into(const Packet &packet, size_t threshold, std::string &out)
+{
+    size_t frame_size = ProtocolHandler::prepare_frame(packet);
+    if (frame_size == 0)
+    {
+        return false;
+    }
+
+    size_t body_size = frame_size - 4;
+    if (body_size >= threshold)
+    {
+        auto &scratch = scratch_buffer();
+        scratch.resize(body_size);
+        packet.SerializeWithCachedSizesToArray(scratch.data());
+
+        size_t offset = out.size();
+        size_t capacity = max_compressed_frame_size(body_size);
+        out.resize(offset + capacity);
+        size_t written = compress_frame(scratch.data(), body_size, reinterpret_cast<uint8_t *>(&out[offset]), capacity);
+        if (written > 0)
+        {
+            out.resize(offset + written);
+            return true;
+        }
+        out.resize(offset);
+    }
+
+    // 不压缩：按普通帧写，Packet 的大小已经缓存过
+    size_t offset = out.size();
+    out.resize(offset + frame_size);
+    if (!ProtocolHandler::write_frame(packet, reinterpret_cast<uint8_t *>(&out[offset]), frame_size))
+    {
+        out.resize(offset);
+        return false;
+    }
+    return true;
+}
+
+bool FrameCompression::decompress_body(const uint8_t *data, size_t size, const uint8_t *&out, size_t &out_size)
+{
+    if (size < 4)
+    {
+        return false;
+    }
+
+    uint32_t raw_size;
+    std::memcpy(&raw_size, data, 4);
+    raw_size = ntohl(raw_size);
+    if (raw_size == 0 || raw_size > ProtocolHandler::MAX_FRAME_SIZE)
+    {
+        spdlog::error("Compressed frame declares invalid size {}", raw_size);
+        return false;
+    }
+
+    auto &buffer = decompress_buffer();
+    if (buffer.size() < raw_size)
+    {
+        buffer.resize(raw_size);
+    }
+
+    int result = LZ4_decompress_safe(reinterpret_cast<const char *>(data + 4), reinterpret_cast<char *>(buffer.data()),
+                                     static_cast<int>(size - 4), static_cast<int>(raw_size));
+    if (result != static_cast<int>(raw_size))
+    {
+        spdlog::error("LZ4 decompression failed ({} of {} bytes)", result, raw_size);
+        return false;
+    }
+
+    out = buffer.data();
+    out_size = raw_size;
+    return true;
+}
+
+uint32_t FrameCompression::choose(uint32_t client_codecs, uint32_t server_codecs)
+{
+    uint32_t common = client_codecs & server_codecs & SUPPORTED_CODECS;
+    return (common & LZ4) ? LZ4 : NONE;
+}
+
+uint32_t FrameCompression::parse_codecs(const std::string &value)
+{
+    if (value == "lz4")
+    {
+        return LZ4;
+    }
+    if (value != "none" && !value.empty())
+    {
+        spdlog::warn("Unknown compression '{}', compression disabled", value);
+    }
+    return NONE;
+}
+
+const char *FrameCompression::codec_name(uint32_t codec)
+{
+    switch (codec)
+    {
+    case LZ4:
+        return "lz4";
+    case NONE:
+        return "none";
+    }
+    return "unknown";
+}
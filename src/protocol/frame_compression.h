@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Packet;
+
+/**
+ * @brief 帧压缩（协商后启用）
+ *
+ * 压缩帧在长度头的最高位（ProtocolHandler::FLAG_COMPRESSED）置 1，长度头其余 31 位仍是帧体字节数：
+ *   [4 字节 长度|FLAG][4 字节 原始长度（网络字节序）][LZ4 block 数据]
+ * 最高位在未压缩帧里永远是 0（MAX_FRAME_SIZE 只有 1MB），不认识压缩的老客户端不受影响；
+ * 服务器只在客户端通过 CapabilityRequest 声明支持之后才发送压缩帧，也只在之后接受压缩帧。
+ *
+ * 帧体小于阈值时不压缩（小包压缩省不了几个字节，CPU 和延迟不划算），
+ * 压缩后没有变小的帧也按原样发送，因此同一连接上压缩帧和普通帧可以混合出现。
+ *
+ * LZ4 的压缩状态（LZ4_sizeofState() 字节）和解压缓冲区是每线程一份（thread_local），
+ * 每帧只调用一次 LZ4_compress_fast_extState / LZ4_decompress_safe，没有分配和初始化开销。
+ */
+class FrameCompression
+{
+public:
+    // 编解码器位掩码，CapabilityRequest / CapabilityResponse 中使用
+    enum Codec : uint32_t
+    {
+        NONE = 0,
+        LZ4 = 1u << 0,
+    };
+
+    static constexpr uint32_t SUPPORTED_CODECS = LZ4;
+
+    // 压缩帧最多占用的字节数（长度头 + 原始长度 + LZ4 最坏情况）
+    static size_t max_compressed_frame_size(size_t body_size);
+
+    /**
+     * @brief 把帧体压缩成一个完整的压缩帧写到 out
+     * @param capacity out 的可用字节数，至少 max_compressed_frame_size(body_size)
+     * @return 写入的帧字节数；压缩失败或没有变小时返回 0（调用方改发未压缩帧）
+     */
+    static size_t compress_frame(const uint8_t *body, size_t body_size, uint8_t *out, size_t capacity);
+
+    /**
+     * @brief 编码 Packet 并压缩，追加到 out 末尾；帧体小于 threshold 或压缩不划算时追加普通帧
+     * 跨线程发送（send_packet 的收件箱路径）使用，压缩在调用线程上完成
+     */
+    static bool serialize_frame_into(const Packet &packet, size_t threshold, std::string &out);
+
+    /**
+     * @brief 解压压缩帧的帧体（不含长度头）
+     * 结果写在本线程的缓冲区里，下一次在同一线程上调用之前有效
+     * @return false 如果数据损坏或原始长度超过 MAX_FRAME_SIZE
+     */
+    static bool decompress_body(const uint8_t *data, size_t size, const uint8_t *&out, size_t &out_size);
+
+    // 选出双方都支持的编解码器（目前只有 LZ4）
+    static uint32_t choose(uint32_t client_codecs, uint32_t server_codecs);
+
+    static uint32_t parse_codecs(const std::string &value);
+    static const char *codec_name(uint32_t codec);
+};
@@ -0,0 +1,35 @@
+#include "packet_arena.h"
+#include <algorithm>
+
+PacketArena::PacketArena()
+    : arena_(initial_block_, sizeof(initial_block_))
+{
+}
+
+PacketArena &PacketArena::local()
+{
+    thread_local PacketArena instance;
+    return instance;
+}
+
+void PacketArena::leave()
+{
+    if (--depth_ > 0)
+    {
+        return;
+    }
+
+    peak_space_used_ = std::max(peak_space_used_, arena_.SpaceUsed());
+    arena_.Reset();
+    ++reset_count_;
+}
+
+PacketArena::Scope::Scope() : owner_(PacketArena::local())
+{
+    owner_.enter();
+}
+
+PacketArena::Scope::~Scope()
+{
+    owner_.leave();
+}
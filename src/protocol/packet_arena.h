@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <google/protobuf/arena.h>
+#include <messages.pb.h>
+
+/**
+ * @brief 每个 worker 线程一个的 Packet 分配区
+ *
+ * 收到一帧后，请求 Packet 和处理器创建的响应 Packet（包括嵌套的子消息）都分配在当前线程的
+ * google::protobuf::Arena 上，处理完这一帧后整体 Reset()，不再逐个 new/delete。
+ * Arena 的第一块内存是线程里预留的 INITIAL_BLOCK_SIZE 字节，Reset() 会保留它，
+ * 常规大小的请求 / 响应在稳定状态下不再调用 malloc。
+ *
+ * 响应在 Session::send_packet() 中同步序列化进出站缓冲区，返回后 Packet 本身就不再被引用，
+ * 所以帧处理结束时即可 Reset()，不必等异步写完成。
+ *
+ * 用法（Scope 可以嵌套，最外层 Scope 结束时才重置）：
+ * @code
+ *   PacketArena::Scope scope;
+ *   Packet *packet = scope.new_packet();
+ *   // ... 解析、处理、send_packet(*response)
+ * @endcode
+ */
+class PacketArena
+{
+public:
+    // 预留的首块大小，覆盖绝大多数请求 + 响应；更大的帧由 Arena 按需追加内存块，Reset() 时释放
+    static constexpr size_t INITIAL_BLOCK_SIZE = 16 * 1024;
+
+    class Scope
+    {
+    public:
+        Scope();
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        google::protobuf::Arena *arena() { return owner_.arena(); }
+        Packet *new_packet() { return google::protobuf::Arena::CreateMessage<Packet>(owner_.arena()); }
+
+    private:
+        PacketArena &owner_;
+    };
+
+    // 当前线程的实例
+    static PacketArena &local();
+
+    google::protobuf::Arena *arena() { return &arena_; }
+
+    // 当前线程累计的重置次数与单帧最大占用（字节），用于观察首块大小是否合适
+    uint64_t reset_count() const { return reset_count_; }
+    uint64_t peak_space_used() const { return peak_space_used_; }
+
+private:
+    PacketArena();
+
+    PacketArena(const PacketArena &) = delete;
+    PacketArena &operator=(const PacketArena &) = delete;
+
+    void enter() { ++depth_; }
+    void leave();
+
+    alignas(std::max_align_t) char initial_block_[INITIAL_BLOCK_SIZE];
+    google::protobuf::Arena arena_;
+    int depth_ = 0;
+    uint64_t reset_count_ = 0;
+    uint64_t peak_space_used_ = 0;
+};
@@ -1,89 +1,116 @@
 #include "protocol_handler.h"
+#include "../logging/log_limiter.h"
 #include <spdlog/spdlog.h>
 #include <arpa/inet.h>
 #include <cstring>
 
 /**
- * @brief 将 protobuf 的 Packet 序列化为网络帧字符串
- *
- * 该函数将一个 `Packet` 对象（protobuf 消息）序列化为字符串，见messages.proto
- * 并加上网络帧长度前缀，生成可直接发送到网络的帧数据。
+ * @brief 计算 Packet 编码成帧后的总字节数
  *
  * 帧格式如下：
  * [4 字节长度（网络字节序）][protobuf 序列化数据]
  *
- * 函数执行流程：
- * 1. 使用 `SerializeToString()` 将 protobuf Packet 序列化为字符串。
- *    - 如果序列化失败，会记录错误并返回空字符串。
- * 2. 检查序列化后的数据是否超过 `MAX_FRAME_SIZE`。
- *    - 如果超过，会记录错误并返回空字符串。
- * 3. 将 protobuf 数据长度转换为网络字节序（大端）使用 `host_to_network()`。
- * 4. 构造最终帧字符串：
- *    - 前 4 字节：protobuf 数据的长度（网络字节序），因为TCP是流式的
- *    - 后续字节：protobuf 序列化数据
- * 5. 返回构造好的帧字符串，可直接用于 socket 发送。
+ * 调用 ByteSizeLong() 的同时会把各级子消息的大小缓存在 Packet 内部，
+ * 紧接着的 write_frame() 用 SerializeWithCachedSizesToArray 直接写入目标内存，不再重新计算。
  *
- * @param packet 待序列化的 protobuf `Packet` 对象
+ * @return 4 + protobuf 数据长度；数据超过 MAX_FRAME_SIZE 时返回 0
+ */
+size_t ProtocolHandler::prepare_frame(const Packet &packet)
+{
+    size_t body_size = packet.ByteSizeLong();
+    if (body_size > MAX_FRAME_SIZE)
+    {
+        spdlog::error("Frame size {} exceeds maximum {}", body_size, MAX_FRAME_SIZE);
+        return 0;
+    }
+    return 4 + body_size;
+}
+
+/**
+ * @brief 把帧直接写入调用方提供的内存 [out, out + frame_size)
  *
- * @return std::string 返回序列化后的帧字符串。
- *         如果序列化失败或帧超长，则返回空字符串。
+ * 先写 4 字节长度头（网络字节序，因为 TCP 是流式的），再把 protobuf 数据序列化在它后面，
+ * 没有任何中间缓冲区。必须在 prepare_frame() 之后、Packet 未被修改时调用。
  *
- * @note 调用者负责将返回的帧发送到网络。
- * @note 长度前缀为网络字节序（大端），保证跨平台兼容。
- * @note 本函数内部会使用 `spdlog` 打印错误，但不会抛出异常。
+ * @param frame_size prepare_frame() 的返回值
+ * @return true 如果写入的字节数与 frame_size 一致
  */
-std::string ProtocolHandler::serialize_frame(const Packet &packet)
+bool ProtocolHandler::write_frame(const Packet &packet, uint8_t *out, size_t frame_size)
 {
-    try
+    if (frame_size < 4)
     {
-        // Serialize protobuf to string
-        std::string protobuf_data;
-        if (!packet.SerializeToString(&protobuf_data))
-        {
-            spdlog::error("Failed to serialize packet to protobuf");
-            return "";
-        }
-
-        // Check frame size limit
-        if (protobuf_data.size() > MAX_FRAME_SIZE)
-        {
-            spdlog::error("Frame size {} exceeds maximum {}", protobuf_data.size(), MAX_FRAME_SIZE);
-            return "";
-        }
-
-        // Create frame: [4-byte length][protobuf data]
-        uint32_t length = static_cast<uint32_t>(protobuf_data.size());
-        uint32_t network_length = host_to_network(length);
+        return false;
+    }
 
-        std::string frame;
-        frame.reserve(4 + protobuf_data.size());
+    uint32_t network_length = host_to_network(static_cast<uint32_t>(frame_size - 4));
+    std::memcpy(out, &network_length, 4);
 
-        // Append length in network byte order
-        /**
-         * std::string& append(const char* s, size_t n); 需要一个const char* 和数据长度n
-         * 但是 network_length 是一个整数类型 (uint32_t)，不是 char*。
-         */
-        frame.append(reinterpret_cast<const char *>(&network_length), 4);
+    uint8_t *end = packet.SerializeWithCachedSizesToArray(out + 4);
+    if (end != out + frame_size)
+    {
+        spdlog::error("Packet size changed during serialization ({} != {})", end - out, frame_size);
+        return false;
+    }
+    return true;
+}
 
-        // Append protobuf data
-        frame.append(protobuf_data);
+/**
+ * @brief 把帧追加到 out 的末尾，只在 out 容量不足时分配一次
+ */
+bool ProtocolHandler::serialize_frame_into(const Packet &packet, std::string &out)
+{
+    size_t frame_size = prepare_frame(packet);
+    if (frame_size == 0)
+    {
+        return false;
+    }
 
-        return frame;
+    size_t offset = out.size();
+    out.resize(offset + frame_size);
+    if (!write_frame(packet, reinterpret_cast<uint8_t *>(&out[offset]), frame_size))
+    {
+        out.resize(offset);
+        return false;
     }
-    catch (const std::exception &e)
+    return true;
+}
+
+/**
+ * @brief 将 protobuf 的 Packet 序列化为网络帧字符串
+ *
+ * 按 prepare_frame() 算出的大小一次分配，长度头和数据直接写进结果字符串。
+ *
+ * @return std::string 返回序列化后的帧字符串。
+ *         如果序列化失败或帧超长，则返回空字符串。
+ *
+ * @note 调用者负责将返回的帧发送到网络。
+ * @note 本函数内部会使用 `spdlog` 打印错误，但不会抛出异常。
+ */
+std::string ProtocolHandler::serialize_frame(const Packet &packet)
+{
+    std::string frame;
+    if (!serialize_frame_into(packet, frame))
     {
-        spdlog::error("Exception in serialize_frame: {}", e.what());
         return "";
     }
+    return frame;
 }
 
 bool ProtocolHandler::deserialize_frame(const std::string &frame_data, Packet &packet)
+{
+    return deserialize_frame(reinterpret_cast<const uint8_t *>(frame_data.data()), frame_data.size(), packet);
+}
+
+/**
+ * 直接从接收缓冲区中的字节区间反序列化，帧体不需要先拷贝成 std::string
+ */
+bool ProtocolHandler::deserialize_frame(const uint8_t *data, size_t size, Packet &packet)
 {
     try
     {
-        if (!packet.ParseFromString(frame_data))
+        if (!packet.ParseFromArray(data, static_cast<int>(size)))
         {
-            spdlog::error("Failed to parse protobuf data");
+            LOG_RATE_LIMITED(spdlog::level::err, "Failed to parse protobuf data");
             return false;
         }
 
@@ -91,7 +118,7 @@ bool ProtocolHandler::deserialize_frame(const std::string &frame_data, Packet &p
     }
     catch (const std::exception &e)
     {
-        spdlog::error("Exception in deserialize_frame: {}", e.what());
+        LOG_RATE_LIMITED(spdlog::level::err, "Exception in deserialize_frame: {}", e.what());
         return false;
     }
 }
@@ -102,6 +129,7 @@ bool ProtocolHandler::deserialize_frame(const std::string &frame_data, Packet &p
  * 该函数用于从接收到的字节缓冲区中解析一个完整的网络帧。
  * 网络帧的格式为：
  * [4 字节长度（网络字节序）][长度为 N 的数据]
+ * 长度头的最高位是压缩标志（FLAG_COMPRESSED），只取低 31 位作为长度，标志放在 frame.compressed 中
  *
  * 功能：
  * 1. 检查缓冲区是否至少包含 4 个字节的长度头；
@@ -124,37 +152,59 @@ bool ProtocolHandler::deserialize_frame(const std::string &frame_data, Packet &p
  * - 解析后的 frame.data 是一个长度为 length 的字节向量，frame.length = length。
  */
 bool ProtocolHandler::parse_frame(const std::vector<uint8_t> &buffer, Frame &frame, size_t &consumed_bytes)
+{
+    FrameView view;
+    if (!parse_frame(buffer.data(), buffer.size(), view, consumed_bytes))
+    {
+        return false;
+    }
+
+    // Extract frame data
+    frame.length = view.length;
+    frame.data.assign(reinterpret_cast<const char *>(view.data), view.length);
+    frame.compressed = view.compressed;
+    return true;
+}
+
+/**
+ * @brief 零拷贝地解析一个网络帧
+ *
+ * 与上面的版本规则相同，但 frame.data 直接指向输入区间内的帧体，
+ * 调用方在消费（consume）这段字节之前完成反序列化即可，全程不复制帧体。
+ */
+bool ProtocolHandler::parse_frame(const uint8_t *data, size_t size, FrameView &frame, size_t &consumed_bytes)
 {
     consumed_bytes = 0;
 
     // Need at least 4 bytes for length header
-    if (buffer.size() < 4)
+    if (size < 4)
     {
         return false;
     }
 
     // Read length from first 4 bytes (network byte order)
     uint32_t network_length;
-    std::memcpy(&network_length, buffer.data(), 4);
-    uint32_t length = network_to_host(network_length);
+    std::memcpy(&network_length, data, 4);
+    uint32_t header = network_to_host(network_length);
+    uint32_t length = header & LENGTH_MASK;
 
     // Validate frame length
     if (length > MAX_FRAME_SIZE)
     {
-        spdlog::error("Frame length {} exceeds maximum {}", length, MAX_FRAME_SIZE);
+        LOG_RATE_LIMITED(spdlog::level::err, "Frame length {} exceeds maximum {}", length, MAX_FRAME_SIZE);
         consumed_bytes = 4; // Skip the invalid length header
         return false;
     }
 
     // Check if we have complete frame
-    if (buffer.size() < 4 + length)
+    if (size < 4 + static_cast<size_t>(length))
     {
         return false; // Need more data
     }
 
-    // Extract frame data
     frame.length = length;
-    frame.data.assign(buffer.begin() + 4, buffer.begin() + 4 + length);
+    frame.data = data + 4;
+    frame.compressed = (header & FLAG_COMPRESSED) != 0;
     consumed_bytes = 4 + length;
 
     return true;
@@ -189,26 +239,66 @@ Packet ProtocolHandler::create_echo_response(const std::string &content, uint32_
     return packet;
 }
 
+Packet *ProtocolHandler::create_error_response(google::protobuf::Arena *arena, uint32_t error_code,
+                                              const std::string &message, uint32_t sequence)
+{
+    Packet *packet = create_packet(arena, PROTOCOL_VERSION, sequence);
+    ErrorResponse *error = packet->mutable_error();
+    error->set_error_code(error_code);
+    error->set_message(message);
+    return packet;
+}
+
+Packet *ProtocolHandler::create_echo_response(google::protobuf::Arena *arena, const std::string &content,
+                                             uint32_t sequence)
+{
+    Packet *packet = create_packet(arena, PROTOCOL_VERSION, sequence);
+    // 子消息由 mutable_* 分配在 packet 所在的 arena 上
+    packet->mutable_echo_response()->set_content(content);
+    return packet;
+}
+
+Packet *ProtocolHandler::create_ping(google::protobuf::Arena *arena, int64_t timestamp_ms, uint32_t sequence)
+{
+    Packet *packet = create_packet(arena, PROTOCOL_VERSION, sequence);
+    packet->mutable_ping()->set_timestamp_ms(timestamp_ms);
+    return packet;
+}
+
+Packet *ProtocolHandler::create_pong(google::protobuf::Arena *arena, int64_t timestamp_ms, uint32_t sequence)
+{
+    Packet *packet = create_packet(arena, PROTOCOL_VERSION, sequence);
+    packet->mutable_pong()->set_timestamp_ms(timestamp_ms);
+    return packet;
+}
+
+Packet *ProtocolHandler::create_packet(google::protobuf::Arena *arena, uint32_t version, uint32_t sequence)
+{
+    Packet *packet = google::protobuf::Arena::CreateMessage<Packet>(arena);
+    packet->set_version(version);
+    packet->set_sequence(sequence);
+    return packet;
+}
+
 /**
  * 判断Version不要使用旧版的协议
- * 检查echo_request, echo_response, error这三个字段要有一个
+ * 检查 payload 中要有一个字段
  */
 bool ProtocolHandler::validate_packet(const Packet &packet)
 {
     // Check protocol version
     if (packet.version() != PROTOCOL_VERSION)
     {
-        spdlog::warn("Invalid protocol version: {}, expected: {}", packet.version(), PROTOCOL_VERSION);
+        LOG_RATE_LIMITED(spdlog::level::warn, "Invalid protocol version: {}, expected: {}",
+                         packet.version(), PROTOCOL_VERSION);
         return false;
     }
 
     // Check if packet has valid payload
-    if (!packet.has_echo_request() && !packet.has_echo_response() &&
-        !packet.has_register_request() && !packet.has_register_response() &&
-        !packet.has_login_request() && !packet.has_login_response() &&
-        !packet.has_error())
+    // 只判断 oneof 是否已设置：具体类型由 MessageRouter 按 payload_case() 分发，新增 payload 不必改这里
+    if (packet.payload_case() == Packet::PAYLOAD_NOT_SET)
     {
-        spdlog::warn("Packet has no valid payload");
+        LOG_RATE_LIMITED(spdlog::level::warn, "Packet has no valid payload");
         return false;
     }
 
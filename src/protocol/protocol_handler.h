@@ -4,6 +4,7 @@
 #include <memory>
 #include <vector>
 #include <cstdint>
+#include <google/protobuf/arena.h>
 #include <messages.pb.h>
 
 class ProtocolHandler
@@ -11,22 +12,50 @@ class ProtocolHandler
 public:
     static constexpr uint32_t PROTOCOL_VERSION = 1;
     static constexpr uint32_t MAX_FRAME_SIZE = 1024 * 1024; // 1MB max frame size
+    static constexpr int MAX_BATCH_PACKETS = 256;           // 一个 PacketBatch 最多携带的子包数
+
+    // 长度头最高位：帧体经过压缩（见 FrameCompression），其余 31 位是帧体字节数
+    static constexpr uint32_t FLAG_COMPRESSED = 0x80000000u;
+    static constexpr uint32_t LENGTH_MASK = 0x7fffffffu;
 
     struct Frame
     {
         uint32_t length;
         std::string data;
+        bool compressed = false;
+    };
+
+    // 指向接收缓冲区内帧体的只读视图，不拥有数据，缓冲区被 consume 之前有效
+    struct FrameView
+    {
+        uint32_t length = 0;
+        const uint8_t *data = nullptr;
+        bool compressed = false; // 帧体需要先用 FrameCompression::decompress_body 解压
     };
 
     // Serialize a Packet to frame format [4-byte length][protobuf data]
     static std::string serialize_frame(const Packet &packet);
 
+    // Append the frame to the end of out (single resize, no temporary string)
+    static bool serialize_frame_into(const Packet &packet, std::string &out);
+
+    // 原地编码：prepare_frame 返回帧总长（并缓存 Packet 的大小，超长时返回 0），
+    // write_frame 把长度头和数据直接写进调用方预留的 frame_size 字节
+    static size_t prepare_frame(const Packet &packet);
+    static bool write_frame(const Packet &packet, uint8_t *out, size_t frame_size);
+
     // Deserialize frame data to Packet
     static bool deserialize_frame(const std::string &frame_data, Packet &packet);
 
+    // Deserialize frame body directly from a byte span (ParseFromArray, no intermediate copy)
+    static bool deserialize_frame(const uint8_t *data, size_t size, Packet &packet);
+
     // Parse frame from binary data, returns true if complete frame found
     static bool parse_frame(const std::vector<uint8_t> &buffer, Frame &frame, size_t &consumed_bytes);
 
+    // Zero-copy variant: frame.data points into [data, data + size)
+    static bool parse_frame(const uint8_t *data, size_t size, FrameView &frame, size_t &consumed_bytes);
+
     // Create error response packet
     static Packet create_error_response(uint32_t error_code, const std::string &message, uint32_t sequence = 0);
 
@@ -36,6 +65,16 @@ public:
     // Create basic packet with version and sequence
     static Packet create_packet(uint32_t version = PROTOCOL_VERSION, uint32_t sequence = 0);
 
+    // Arena 版本：在 arena 上创建响应（通常传入请求的 packet.GetArena()），随 arena 一起释放
+    // arena 为空时对象分配在堆上，由调用方 delete
+    static Packet *create_error_response(google::protobuf::Arena *arena, uint32_t error_code,
+                                         const std::string &message, uint32_t sequence = 0);
+    static Packet *create_echo_response(google::protobuf::Arena *arena, const std::string &content,
+                                        uint32_t sequence = 0);
+    static Packet *create_ping(google::protobuf::Arena *arena, int64_t timestamp_ms, uint32_t sequence = 0);
+    static Packet *create_pong(google::protobuf::Arena *arena, int64_t timestamp_ms, uint32_t sequence = 0);
+    static Packet *create_packet(google::protobuf::Arena *arena, uint32_t version, uint32_t sequence);
+
     // Validate packet (version check, etc.)
     static bool validate_packet(const Packet &packet);
 
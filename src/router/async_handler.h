@@ -0,0 +1,202 @@
+#pragma once
+
+#define ASIO_STANDALONE
+#include <asio.hpp>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "message_handler.h"
+#include "../executor/blocking_executor.h"
+
+/**
+ * @brief run_blocking() 的结果状态
+ */
+enum class AwaitStatus
+{
+    OK,      // fn 已执行完，value 有效
+    BUSY,    // 阻塞线程池队列已满，fn 没有执行
+    TIMEOUT  // 请求截止时间已到，fn 可能仍在线程池中执行，结果被丢弃
+};
+
+template <typename T>
+struct BlockingResult
+{
+    AwaitStatus status = AwaitStatus::OK;
+    T value{};
+
+    bool ok() const { return status == AwaitStatus::OK; }
+};
+
+namespace detail
+{
+
+/**
+ * 一次 run_blocking 调用的共享状态：线程池完成、超时定时器、提交失败三条路径都经 strand 串行，
+ * 谁先到谁恢复协程，其余的直接忽略
+ */
+template <typename R, typename Handler>
+struct BlockingCall
+{
+    BlockingCall(const asio::any_io_executor &executor, Handler handler)
+        : resume_executor(executor), strand(asio::make_strand(executor)), timer(strand),
+          handler(std::move(handler))
+    {
+    }
+
+    // 只在 strand 上调用
+    void complete(std::exception_ptr error, BlockingResult<R> result)
+    {
+        if (!handler)
+        {
+            return;
+        }
+        asio::error_code ignored;
+        timer.cancel(ignored);
+
+        // 协程在它自己的 executor 上恢复，不在 strand 上
+        asio::post(resume_executor,
+                   [handler = std::move(*handler), error, result = std::move(result)]() mutable
+                   { std::move(handler)(error, std::move(result)); });
+        this->handler.reset();
+    }
+
+    asio::any_io_executor resume_executor;
+    asio::strand<asio::any_io_executor> strand;
+    asio::steady_timer timer;
+    std::optional<Handler> handler;
+};
+
+/**
+ * 发起一次 run_blocking：普通函数（不是协程），返回 use_awaitable 的 awaitable，由调用方 co_await
+ * 协程在 handler 关联的 executor（协程自己的 executor）上恢复
+ */
+template <typename R, typename Fn>
+asio::awaitable<BlockingResult<R>> async_run_blocking(BlockingExecutor *blocking,
+                                                      std::chrono::steady_clock::time_point deadline, Fn fn)
+{
+    auto fn_ptr = std::make_shared<Fn>(std::move(fn));
+    auto initiation = [blocking, deadline, fn_ptr](auto handler)
+    {
+        using Call = BlockingCall<R, std::decay_t<decltype(handler)>>;
+        asio::any_io_executor executor = asio::get_associated_executor(handler);
+        auto call = std::make_shared<Call>(executor, std::move(handler));
+
+        call->timer.expires_at(deadline);
+        call->timer.async_wait([call](const asio::error_code &ec)
+                               {
+                                   if (!ec)
+                                   {
+                                       call->complete(nullptr, BlockingResult<R>{AwaitStatus::TIMEOUT, R{}});
+                                   }
+                               });
+
+        bool submitted = blocking->submit(
+            [call, fn_ptr]()
+            {
+                std::exception_ptr error;
+                BlockingResult<R> result;
+                try
+                {
+                    result.value = (*fn_ptr)();
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                asio::post(call->strand, [call, error, result = std::move(result)]() mutable
+                           { call->complete(error, std::move(result)); });
+            });
+
+        if (!submitted)
+        {
+            asio::post(call->strand, [call]()
+                       { call->complete(nullptr, BlockingResult<R>{AwaitStatus::BUSY, R{}}); });
+        }
+    };
+    return asio::async_initiate<const asio::use_awaitable_t<> &, void(std::exception_ptr, BlockingResult<R>)>(
+        std::move(initiation), asio::use_awaitable);
+}
+
+} // namespace detail
+
+/**
+ * @brief 协程处理器的请求上下文，由 MessageRouter 为每个请求构造
+ *
+ * 持有阻塞线程池和请求的截止时间（路由时间 + request_timeout_ms），同一请求里的多次 run_blocking
+ * 共用这一个截止时间，整个请求不会因为分多步等待而超时变长。
+ * 响应发出之后的后续工作（例如登录后的离线投递）用 renewed() 取一个重新计时的上下文。
+ */
+class RequestContext
+{
+public:
+    RequestContext(BlockingExecutor *blocking, std::chrono::steady_clock::time_point start,
+                   std::chrono::milliseconds timeout)
+        : blocking_(blocking), deadline_(start + timeout), timeout_(timeout)
+    {
+    }
+
+    std::chrono::steady_clock::time_point deadline() const { return deadline_; }
+
+    // 同一个线程池、从现在起重新计时 request_timeout_ms 的上下文
+    RequestContext renewed() const { return RequestContext(blocking_, std::chrono::steady_clock::now(), timeout_); }
+
+    /**
+     * @brief 把阻塞调用（DB、crypt）交给阻塞线程池执行，协程挂起等待结果，io 线程不阻塞
+     *
+     * fn 必须按值捕获它用到的数据：超时后协程会先恢复并可能结束，fn 仍在线程池中运行。
+     * fn 抛出的异常在协程中重新抛出。未配置阻塞线程池时在当前线程直接执行（与同步处理器一致）。
+     *
+     *   auto call = co_await ctx.run_blocking([name = request.username()]() { return lookup(name); });
+     *   if (!call.ok()) { ... 繁忙 / 超时 ... }
+     */
+    template <typename Fn, typename R = std::invoke_result_t<Fn &>>
+    asio::awaitable<BlockingResult<R>> run_blocking(Fn fn) const
+    {
+        static_assert(!std::is_void_v<R>, "run_blocking needs a result value");
+
+        if (!blocking_)
+        {
+            co_return BlockingResult<R>{AwaitStatus::OK, fn()};
+        }
+        if (std::chrono::steady_clock::now() >= deadline_)
+        {
+            co_return BlockingResult<R>{AwaitStatus::TIMEOUT, R{}};
+        }
+
+        co_return co_await detail::async_run_blocking<R>(blocking_, deadline_, std::move(fn));
+    }
+
+private:
+    BlockingExecutor *blocking_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::chrono::milliseconds timeout_;
+};
+
+/**
+ * @brief 协程处理器接口
+ *
+ * 需要 I/O 的处理器（登录、注册，以后的跨节点调用）继承它并实现 handle_async：
+ * 代码按顺序写，每次 co_await ctx.run_blocking(...) 只挂起当前请求，既不占 io 线程，也不占一个线程池线程等待。
+ *
+ * MessageRouter 注册时识别出协程处理器，把请求复制到协程自己的 Arena 上，在会话的 executor 上 co_spawn；
+ * 请求耗时 / 失败计数在协程结束时记录，处理器抛出的异常与同步处理器一样回复 3002。
+ * 协程在会话的 executor 上运行，但不在帧处理过程中，send_packet 走跨线程投递路径。
+ */
+class AsyncMessageHandler : public MessageHandler
+{
+public:
+    /**
+     * @param packet 分配在协程自己的 Arena 上，整个协程期间有效；响应可以用 packet.GetArena() 分配
+     * @param session 协程持有引用，期间会话不会被销毁（可能已经关闭，send_packet 会直接丢弃）
+     * @param ctx 阻塞线程池与请求截止时间
+     * @return true 如果请求处理成功
+     */
+    virtual asio::awaitable<bool> handle_async(const Packet &packet, std::shared_ptr<Session> session,
+                                               const RequestContext &ctx) = 0;
+
+    // 协程处理器只能经 MessageRouter 调度，同步入口不会被调用
+    bool handle(const Packet &, Session &) override final { return false; }
+};
@@ -0,0 +1,35 @@
+#include "capability_handler.h"
+#include "../server/session.h"
+#include "../protocol/protocol_handler.h"
+#include "../protocol/frame_compression.h"
+#include "../logging/log_limiter.h"
+#include <spdlog/spdlog.h>
+
+bool CapabilityHandler::handle(const Packet &packet, Session &session)
+{
+    if (!packet.has_capability_request())
+    {
+        spdlog::warn("CapabilityHandler received packet without capability_request");
+        return false;
+    }
+
+    uint32_t codec = session.select_compression(packet.capability_request().compression());
+
+    Packet *response_packet = ProtocolHandler::create_packet(packet.GetArena(), packet.version(), packet.sequence());
+    auto *response = response_packet->mutable_capability_response();
+    response->set_compression(codec);
+    response->set_compression_threshold(static_cast<uint32_t>(session.compression_threshold()));
+    if (packet.capability_request().offline_ack())
+    {
+        session.enable_offline_ack();
+        response->set_offline_ack(true);
+    }
+
+    // 同步处理器里 send_packet 直接编码进出站队列，回复一定以未压缩的形式排在启用压缩之前；
+    // 批次里的回复要到批次结束才写出，所以 MessageRouter 不允许把 CapabilityRequest 放进 PacketBatch
+    session.send_packet(*response_packet);
+    session.enable_compression(codec);
+
+    LOG_RATE_LIMITED(spdlog::level::debug, "Session negotiated compression: {}", FrameCompression::codec_name(codec));
+    return true;
+}
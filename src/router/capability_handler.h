@@ -0,0 +1,18 @@
+#pragma once
+
+#include "message_handler.h"
+
+/**
+ * CapabilityHandler 处理能力协商
+ *
+ * 客户端在 CapabilityRequest 中声明自己能解码的压缩编解码器，服务器选出双方都支持的一个，
+ * 先用未压缩的帧回复 CapabilityResponse，再把编解码器设置到会话上，之后的大帧才开始压缩。
+ * 不发送 CapabilityRequest 的客户端永远只收到未压缩的帧。
+ * 声明 offline_ack 的客户端收到的离线消息要用 OfflineAck 确认，服务器确认后才删除。
+ */
+class CapabilityHandler : public MessageHandler
+{
+public:
+    bool handle(const Packet &packet, Session &session) override;
+    std::string get_handler_name() const override { return "CapabilityHandler"; }
+};
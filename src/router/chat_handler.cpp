@@ -0,0 +1,135 @@
+#include "chat_handler.h"
+#include "../chat/message_id.h"
+#include "../chat/offline_store.h"
+#include "../cluster/cluster_node.h"
+#include "../protocol/protocol_handler.h"
+#include "../server/session.h"
+#include "../server/session_manager.h"
+#include "../logging/log_limiter.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+
+ChatHandler::ChatHandler(ClusterNode *cluster)
+    : cluster_(cluster),
+      delivered_(MetricsRegistry::get_instance().counter("im_chat_messages_total", "Chat messages by outcome",
+                                                         MetricsRegistry::label("result", "delivered"))),
+      offline_(MetricsRegistry::get_instance().counter("im_chat_messages_total", "Chat messages by outcome",
+                                                       MetricsRegistry::label("result", "offline"))),
+      rejected_(MetricsRegistry::get_instance().counter("im_chat_messages_total", "Chat messages by outcome",
+                                                        MetricsRegistry::label("result", "rejected"))),
+      dropped_sessions_(MetricsRegistry::get_instance().counter(
+          "im_chat_dropped_sessions_total", "Recipient sessions that refused a chat message because their backlog was full"))
+{
+}
+
+bool ChatHandler::handle(const Packet &packet, Session &session)
+{
+    if (!packet.has_chat_message())
+    {
+        spdlog::error("ChatHandler received packet without chat_message");
+        return false;
+    }
+
+    const auto &request = packet.chat_message();
+    Packet *ack_packet = ProtocolHandler::create_packet(packet.GetArena(), packet.version(), packet.sequence());
+    auto *ack = ack_packet->mutable_chat_ack();
+    ack->set_client_msg_id(request.client_msg_id());
+
+    const char *error = nullptr;
+    if (!session.is_authenticated())
+    {
+        error = "Not authenticated";
+    }
+    else if (request.recipient_id() <= 0)
+    {
+        error = "Invalid recipient";
+    }
+    else if (request.content().empty() || request.content().size() > MAX_CONTENT_BYTES)
+    {
+        error = "Message content must be 1-16384 bytes";
+    }
+
+    if (error)
+    {
+        rejected_.add();
+        ack->set_success(false);
+        ack->set_message(error);
+        session.send_packet(*ack_packet);
+        return true;
+    }
+
+    uint64_t msg_id = MessageIdGenerator::get_instance().next();
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+
+    // 投递给接收方的消息：不带 client_msg_id，服务器字段补齐，整个帧只编码一次
+    Packet *delivery = ProtocolHandler::create_packet(packet.GetArena(), ProtocolHandler::PROTOCOL_VERSION, 0);
+    auto *message = delivery->mutable_chat_message();
+    message->set_recipient_id(request.recipient_id());
+    message->set_content(request.content());
+    message->set_sender_id(session.get_user_id());
+    message->set_msg_id(msg_id);
+    message->set_timestamp_ms(now_ms);
+
+    std::string frame = ProtocolHandler::serialize_frame(*delivery);
+    uint32_t delivered = 0;
+    uint32_t dropped = 0;
+    uint32_t forwarded = 0;
+    if (!frame.empty())
+    {
+        // 先转发（复制一份进 ClusterDelivery），下面本节点的最后一个会话会拿走 frame
+        if (cluster_)
+        {
+            forwarded = static_cast<uint32_t>(cluster_->forward_to_user(request.recipient_id(), frame));
+        }
+
+        auto recipients = SessionManager::get_instance().find_sessions_by_user(request.recipient_id());
+        for (size_t i = 0; i < recipients.size(); ++i)
+        {
+            // 最后一个会话直接拿走这份 frame，其余的复制；积压满的会话拒收，不算投递
+            if (recipients[i]->send_frame(i + 1 == recipients.size() ? std::move(frame) : frame))
+            {
+                ++delivered;
+            }
+            else
+            {
+                ++dropped;
+            }
+        }
+        if (dropped > 0)
+        {
+            dropped_sessions_.add(dropped);
+        }
+    }
+
+    // 接收方不在线，或在线的会话都因积压拒收：交给离线存储（只追加到内存日志，由后台线程批量写库）
+    bool stored_offline = false;
+    if (delivered == 0 && forwarded == 0)
+    {
+        OfflineMessage offline;
+        offline.recipient_id = request.recipient_id();
+        offline.msg_id = msg_id;
+        offline.sender_id = session.get_user_id();
+        offline.timestamp_ms = now_ms;
+        offline.content = request.content();
+        stored_offline = OfflineMessageStore::get_instance().append(std::move(offline));
+    }
+
+    (delivered > 0 || forwarded > 0 ? delivered_ : offline_).add();
+    if (spdlog::should_log(spdlog::level::debug))
+    {
+        spdlog::debug("Chat message {} from {} to {} handed to {} session(s), dropped by {}, forwarded to {} node(s)",
+                      msg_id, session.get_user_id(), request.recipient_id(), delivered, dropped, forwarded);
+    }
+
+    ack->set_success(true);
+    ack->set_msg_id(msg_id);
+    ack->set_timestamp_ms(now_ms);
+    ack->set_delivered_sessions(delivered);
+    ack->set_forwarded_nodes(forwarded);
+    ack->set_dropped_sessions(dropped);
+    ack->set_stored_offline(stored_offline);
+    session.send_packet(*ack_packet);
+    return true;
+}
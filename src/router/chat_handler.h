@@ -0,0 +1,39 @@
+#pragma once
+
+#include "message_handler.h"
+#include "../metrics/metrics_registry.h"
+
+class ClusterNode;
+
+/**
+ * ChatHandler 处理点对点聊天消息
+ *
+ * 发送方必须已登录。处理器在发送方的 io 线程上同步执行，不访问数据库：
+ * 1. 分配消息 ID，补上 sender_id / timestamp_ms，编码成一个帧（只序列化一次）
+ * 2. 通过 SessionManager 的 user_id 索引找到接收方的所有在线会话（多端登录）
+ * 3. 对每个会话调用 send_frame：接收方在其他 io_context 上时经无锁收件箱交接，发送方线程不等待；
+ *    接收方积压超过硬上限时 send_frame 拒收，这样的会话不计入投递数
+ * 4. 集群模式下，接收方在其他节点上线时把同一个帧经 ClusterNode 转发过去（每个节点一次）
+ * 5. 本节点和其他节点都没有会话收下消息时（不在线或全部拒收）交给 OfflineMessageStore（追加到内存日志，后台批量写库），登录时再投递
+ * 6. 回复发送方 ChatAck（消息 ID、本节点投递到 / 被拒收的会话数、转发到的节点数，以及是否已离线保存）
+ */
+class ChatHandler : public MessageHandler
+{
+public:
+    // 单条消息内容上限（字节）
+    static constexpr size_t MAX_CONTENT_BYTES = 16 * 1024;
+
+    // cluster 为空表示单机模式
+    explicit ChatHandler(ClusterNode *cluster = nullptr);
+    ~ChatHandler() override = default;
+
+    bool handle(const Packet &packet, Session &session) override;
+    std::string get_handler_name() const override { return "ChatHandler"; }
+
+private:
+    ClusterNode *cluster_;
+    Counter &delivered_;
+    Counter &offline_;
+    Counter &rejected_;
+    Counter &dropped_sessions_;
+};
@@ -0,0 +1,195 @@
+#include "group_handler.h"
+#include "../chat/fanout_dispatcher.h"
+#include "../chat/group_manager.h"
+#include "../chat/message_id.h"
+#include "../cluster/cluster_node.h"
+#include "../protocol/protocol_handler.h"
+#include "../server/session.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    // 与 ChatHandler::MAX_CONTENT_BYTES 相同
+    constexpr size_t MAX_GROUP_CONTENT_BYTES = 16 * 1024;
+    constexpr size_t MAX_GROUP_NAME_BYTES = 64;
+}
+
+GroupHandler::GroupHandler(FanoutDispatcher &fanout, ClusterNode *cluster)
+    : fanout_(fanout), cluster_(cluster),
+      messages_(MetricsRegistry::get_instance().counter("im_group_messages_total", "Group messages by outcome",
+                                                        MetricsRegistry::label("result", "delivered"))),
+      rejected_(MetricsRegistry::get_instance().counter("im_group_messages_total", "Group messages by outcome",
+                                                        MetricsRegistry::label("result", "rejected"))),
+      fanout_latency_(MetricsRegistry::get_instance().histogram("im_group_fanout_seconds",
+                                                                "Time to encode and hand a group message to all member sessions"))
+{
+}
+
+bool GroupHandler::handle(const Packet &packet, Session &session)
+{
+    switch (packet.payload_case())
+    {
+    case Packet::kCreateGroupRequest:
+        handle_create(packet, session);
+        return true;
+    case Packet::kJoinGroupRequest:
+        handle_join(packet, session);
+        return true;
+    case Packet::kLeaveGroupRequest:
+        handle_leave(packet, session);
+        return true;
+    case Packet::kGroupMessage:
+        handle_message(packet, session);
+        return true;
+    default:
+        spdlog::error("GroupHandler received unexpected payload type {}", static_cast<int>(packet.payload_case()));
+        return false;
+    }
+}
+
+void GroupHandler::send_group_response(const Packet &request, Session &session, bool success,
+                                       const std::string &message, int64_t group_id, uint32_t member_count)
+{
+    Packet *response = ProtocolHandler::create_packet(request.GetArena(), request.version(), request.sequence());
+    auto *group = response->mutable_group_response();
+    group->set_success(success);
+    group->set_message(message);
+    group->set_group_id(group_id);
+    group->set_member_count(member_count);
+    session.send_packet(*response);
+}
+
+void GroupHandler::handle_create(const Packet &packet, Session &session)
+{
+    const auto &request = packet.create_group_request();
+    if (!session.is_authenticated())
+    {
+        send_group_response(packet, session, false, "Not authenticated", 0, 0);
+        return;
+    }
+    if (request.name().empty() || request.name().size() > MAX_GROUP_NAME_BYTES)
+    {
+        send_group_response(packet, session, false, "Group name must be 1-64 bytes", 0, 0);
+        return;
+    }
+
+    auto &groups = GroupManager::get_instance();
+    std::vector<int64_t> member_ids(request.member_ids().begin(), request.member_ids().end());
+    int64_t group_id = groups.create_group(session.get_user_id(), request.name(), member_ids);
+    auto members = groups.members(group_id);
+    uint32_t member_count = members ? static_cast<uint32_t>(members->size()) : 0;
+
+    spdlog::info("User {} created group {} '{}' with {} member(s)",
+                 session.get_user_id(), group_id, request.name(), member_count);
+    send_group_response(packet, session, true, "Group created", group_id, member_count);
+}
+
+void GroupHandler::handle_join(const Packet &packet, Session &session)
+{
+    int64_t group_id = packet.join_group_request().group_id();
+    if (!session.is_authenticated())
+    {
+        send_group_response(packet, session, false, "Not authenticated", group_id, 0);
+        return;
+    }
+
+    auto &groups = GroupManager::get_instance();
+    auto result = groups.join(group_id, session.get_user_id());
+    auto members = groups.members(group_id);
+    send_group_response(packet, session, result == GroupManager::Result::OK,
+                        GroupManager::result_to_string(result), group_id,
+                        members ? static_cast<uint32_t>(members->size()) : 0);
+}
+
+void GroupHandler::handle_leave(const Packet &packet, Session &session)
+{
+    int64_t group_id = packet.leave_group_request().group_id();
+    if (!session.is_authenticated())
+    {
+        send_group_response(packet, session, false, "Not authenticated", group_id, 0);
+        return;
+    }
+
+    auto &groups = GroupManager::get_instance();
+    auto result = groups.leave(group_id, session.get_user_id());
+    auto members = groups.members(group_id);
+    send_group_response(packet, session, result == GroupManager::Result::OK,
+                        GroupManager::result_to_string(result), group_id,
+                        members ? static_cast<uint32_t>(members->size()) : 0);
+}
+
+void GroupHandler::handle_message(const Packet &packet, Session &session)
+{
+    const auto &request = packet.group_message();
+    Packet *ack_packet = ProtocolHandler::create_packet(packet.GetArena(), packet.version(), packet.sequence());
+    auto *ack = ack_packet->mutable_chat_ack();
+    ack->set_client_msg_id(request.client_msg_id());
+
+    GroupManager::MemberList members;
+    const char *error = nullptr;
+    if (!session.is_authenticated())
+    {
+        error = "Not authenticated";
+    }
+    else if (request.content().empty() || request.content().size() > MAX_GROUP_CONTENT_BYTES)
+    {
+        error = "Message content must be 1-16384 bytes";
+    }
+    else
+    {
+        members = GroupManager::get_instance().members(request.group_id());
+        if (!members)
+        {
+            error = "Group not found";
+        }
+        else if (!std::binary_search(members->begin(), members->end(), session.get_user_id()))
+        {
+            error = "Not a member of this group";
+        }
+    }
+
+    if (error)
+    {
+        rejected_.add();
+        ack->set_success(false);
+        ack->set_message(error);
+        session.send_packet(*ack_packet);
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t msg_id = MessageIdGenerator::get_instance().next();
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+
+    Packet *delivery = ProtocolHandler::create_packet(packet.GetArena(), ProtocolHandler::PROTOCOL_VERSION, 0);
+    auto *message = delivery->mutable_group_message();
+    message->set_group_id(request.group_id());
+    message->set_content(request.content());
+    message->set_sender_id(session.get_user_id());
+    message->set_msg_id(msg_id);
+    message->set_timestamp_ms(now_ms);
+
+    // 整个群共用一个帧；发送方的其他端也会收到，当前会话只收 ack
+    SharedFrame frame = FanoutDispatcher::make_shared_frame(*delivery);
+    size_t delivered = fanout_.deliver_to_users(*members, frame, &session);
+    size_t forwarded = cluster_ && frame ? cluster_->forward_to_users(*members, *frame) : 0;
+    fanout_latency_.record(elapsed_us(start));
+    messages_.add();
+
+    if (spdlog::should_log(spdlog::level::debug))
+    {
+        spdlog::debug("Group message {} from {} to group {} ({} members) handed to {} session(s), {} node(s)",
+                      msg_id, session.get_user_id(), request.group_id(), members->size(), delivered, forwarded);
+    }
+
+    ack->set_success(true);
+    ack->set_msg_id(msg_id);
+    ack->set_timestamp_ms(now_ms);
+    ack->set_delivered_sessions(static_cast<uint32_t>(delivered));
+    ack->set_forwarded_nodes(static_cast<uint32_t>(forwarded));
+    session.send_packet(*ack_packet);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "message_handler.h"
+#include "../metrics/metrics_registry.h"
+
+class FanoutDispatcher;
+class ClusterNode;
+
+/**
+ * GroupHandler 处理群组管理（创建 / 加入 / 退出）和群消息，同一个实例注册到四种消息类型上
+ *
+ * 群管理请求回复 GroupResponse。群消息的处理流程：
+ * 1. 发送方必须已登录且是群成员
+ * 2. 分配消息 ID，补上 sender_id / timestamp_ms，编码成一个共享帧（只序列化一次）
+ * 3. 取成员列表快照，交给 FanoutDispatcher 找出在线会话并按 io_context 分批投递，发送方的当前会话除外
+ * 4. 集群模式下再把同一个帧按节点合并转发给在其他节点上线的成员
+ * 5. 回复发送方 ChatAck，delivered_sessions 为本节点交出去的会话数，forwarded_nodes 为转发到的节点数
+ *
+ * 群组本身只保存在创建它的节点上，其他节点上的成员能收到群消息，但要连到该节点才能发言和管理群。
+ */
+class GroupHandler : public MessageHandler
+{
+public:
+    // cluster 为空表示单机模式
+    explicit GroupHandler(FanoutDispatcher &fanout, ClusterNode *cluster = nullptr);
+    ~GroupHandler() override = default;
+
+    bool handle(const Packet &packet, Session &session) override;
+    std::string get_handler_name() const override { return "GroupHandler"; }
+
+private:
+    void handle_create(const Packet &packet, Session &session);
+    void handle_join(const Packet &packet, Session &session);
+    void handle_leave(const Packet &packet, Session &session);
+    void handle_message(const Packet &packet, Session &session);
+
+    void send_group_response(const Packet &request, Session &session, bool success,
+                             const std::string &message, int64_t group_id, uint32_t member_count);
+
+    FanoutDispatcher &fanout_;
+    ClusterNode *cluster_;
+    Counter &messages_;
+    Counter &rejected_;
+    LatencyHistogram &fanout_latency_;
+};
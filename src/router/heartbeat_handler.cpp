@@ -0,0 +1,22 @@
+#include "heartbeat_handler.h"
+#include "../server/session.h"
+#include "../protocol/protocol_handler.h"
+#include <spdlog/spdlog.h>
+
+bool PingHandler::handle(const Packet &packet, Session &session)
+{
+    if (!packet.has_ping())
+    {
+        spdlog::warn("PingHandler received packet without ping");
+        return false;
+    }
+
+    Packet *response = ProtocolHandler::create_pong(packet.GetArena(), packet.ping().timestamp_ms(), packet.sequence());
+    session.send_packet(*response);
+    return true;
+}
+
+bool PongHandler::handle(const Packet &packet, Session & /*session*/)
+{
+    return packet.has_pong();
+}
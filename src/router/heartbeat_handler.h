@@ -0,0 +1,25 @@
+#pragma once
+
+#include "message_handler.h"
+
+/**
+ * PingHandler 回应客户端的心跳：原样带回 timestamp_ms 和 sequence，客户端可以据此计算 RTT
+ * 收到数据本身已经刷新了会话的最后活跃时间，这里不需要再做别的
+ */
+class PingHandler : public MessageHandler
+{
+public:
+    bool handle(const Packet &packet, Session &session) override;
+    std::string get_handler_name() const override { return "PingHandler"; }
+};
+
+/**
+ * PongHandler 接收客户端对服务器 Ping 的回应
+ * 活跃时间在读回调里已经更新，注册它只是为了不把 Pong 当成不支持的消息类型回错误
+ */
+class PongHandler : public MessageHandler
+{
+public:
+    bool handle(const Packet &packet, Session &session) override;
+    std::string get_handler_name() const override { return "PongHandler"; }
+};
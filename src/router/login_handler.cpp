@@ -2,32 +2,59 @@
 #include "../protocol/protocol_handler.h"
 #include "../server/session.h"
 #include "../server/session_manager.h"
+#include "../user/resume_token.h"
+#include "offline_delivery.h"
+#include "../logging/log_limiter.h"
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
 
 LoginHandler::LoginHandler() : user_manager_(UserManager::get_instance())
 {
 }
 
-bool LoginHandler::handle(const Packet &packet, std::shared_ptr<Session> session)
+asio::awaitable<bool> LoginHandler::handle_async(const Packet &packet, std::shared_ptr<Session> session,
+                                                 const RequestContext &ctx)
 {
     if (!packet.has_login_request())
     {
         spdlog::error("LoginHandler received packet without login_request");
-        return false;
+        co_return false;
     }
 
     const auto &request = packet.login_request();
-    spdlog::info("Processing login request for user: {}", request.username());
+    spdlog::debug("Processing login request for user: {}", request.username());
 
-    // 调用UserManager进行身份验证
-    User user;
-    auto result = user_manager_.authenticate_user(request.username(), request.password(), user);
+    // 调用UserManager进行身份验证；超时后线程池里的调用可能仍在执行，所以用户名和密码按值捕获
+    struct Outcome
+    {
+        UserManager::LoginResult result = UserManager::LoginResult::DATABASE_ERROR;
+        User user{};
+    };
+    auto call = co_await ctx.run_blocking(
+        [this, username = request.username(), password = request.password()]()
+        {
+            Outcome outcome;
+            outcome.result = user_manager_.authenticate_user(username, password, outcome.user);
+            return outcome;
+        });
 
     // 创建响应
-    auto response_packet = ProtocolHandler::create_packet(packet.version(), packet.sequence());
-    auto *response = response_packet.mutable_login_response();
+    Packet *response_packet = ProtocolHandler::create_packet(packet.GetArena(), packet.version(), packet.sequence());
+    auto *response = response_packet->mutable_login_response();
 
-    switch (result)
+    if (!call.ok())
+    {
+        response->set_success(false);
+        response->set_message(call.status == AwaitStatus::BUSY ? "Server busy, please retry" : "Request timed out");
+        LOG_RATE_LIMITED(spdlog::level::warn, "Login failed - {} for user: {}",
+                         call.status == AwaitStatus::BUSY ? "server busy" : "timed out", request.username());
+        session->send_packet(*response_packet);
+        co_return true;
+    }
+
+    const User &user = call.value.user;
+    switch (call.value.result)
     {
     case UserManager::LoginResult::SUCCESS:
         response->set_success(true);
@@ -38,29 +65,49 @@ bool LoginHandler::handle(const Packet &packet, std::shared_ptr<Session> session
         // 在Session中标记用户已登录
         session->set_authenticated_user(user.user_id, user.username);
 
-        spdlog::info("User login successful: {} (ID: {})", user.username, user.user_id);
+        // 签发会话恢复令牌，断线重连时用 ResumeRequest 代替密码登录
+        {
+            ResumeTokenService::Claims claims;
+            response->set_resume_token(
+                ResumeTokenService::get_instance().issue(user.user_id, user.username, &claims));
+            response->set_resume_expires_at(claims.expires_at);
+        }
+
+        LOG_RATE_LIMITED(spdlog::level::info, "User login successful: {} (ID: {})", user.username, user.user_id);
         break;
 
     case UserManager::LoginResult::USER_NOT_FOUND:
         response->set_success(false);
         response->set_message("User not found");
-        spdlog::info("Login failed - user not found: {}", request.username());
+        LOG_RATE_LIMITED(spdlog::level::info, "Login failed - user not found: {}", request.username());
         break;
 
     case UserManager::LoginResult::WRONG_PASSWORD:
         response->set_success(false);
         response->set_message("Wrong password");
-        spdlog::info("Login failed - wrong password for user: {}", request.username());
+        LOG_RATE_LIMITED(spdlog::level::info, "Login failed - wrong password for user: {}", request.username());
+        break;
+
+    case UserManager::LoginResult::SERVER_BUSY:
+        response->set_success(false);
+        response->set_message("Server busy, please retry");
+        LOG_RATE_LIMITED(spdlog::level::warn, "Login failed - server busy for user: {}", request.username());
         break;
 
     case UserManager::LoginResult::DATABASE_ERROR:
         response->set_success(false);
         response->set_message("Internal server error");
-        spdlog::error("Login failed - database error for user: {}", request.username());
+        LOG_RATE_LIMITED(spdlog::level::err, "Login failed - database error for user: {}", request.username());
         break;
     }
 
     // 发送响应
-    session->send_packet(response_packet);
-    return true;
-}
\ No newline at end of file
+    session->send_packet(*response_packet);
+
+    // 离线消息排在登录响应之后
+    if (call.value.result == UserManager::LoginResult::SUCCESS)
+    {
+        co_await drain_offline_messages(session, user.user_id, ctx);
+    }
+    co_return true;
+}
@@ -1,20 +1,23 @@
 #pragma once
 
-#include "message_handler.h"
+#include "async_handler.h"
 #include "../user/user_manager.h"
 
 /**
  * LoginHandler 处理用户登录请求
+ * 数据库查询、crypt() 和离线消息投递（drain_offline_messages）都经 run_blocking 交给阻塞线程池，协程在会话的 executor 上等待
  */
-class LoginHandler : public MessageHandler
+class LoginHandler : public AsyncMessageHandler
 {
 public:
     LoginHandler();
     ~LoginHandler() override = default;
 
-    bool handle(const Packet &packet, std::shared_ptr<Session> session) override;
+    asio::awaitable<bool> handle_async(const Packet &packet, std::shared_ptr<Session> session,
+                                       const RequestContext &ctx) override;
     std::string get_handler_name() const override { return "LoginHandler"; }
 
 private:
+
     UserManager &user_manager_;
 };
\ No newline at end of file
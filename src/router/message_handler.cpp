@@ -12,7 +12,7 @@
  * 3. 创建EchoResponse响应
  * 4. 通过session发送响应
  */
-bool EchoHandler::handle(const Packet &packet, std::shared_ptr<Session> session)
+bool EchoHandler::handle(const Packet &packet, Session &session)
 {
     if (!packet.has_echo_request())
     {
@@ -21,15 +21,16 @@ bool EchoHandler::handle(const Packet &packet, std::shared_ptr<Session> session)
     }
 
     const auto &echo_req = packet.echo_request();
-    spdlog::info("EchoHandler processing: '{}'", echo_req.content());
+    spdlog::debug("EchoHandler processing: '{}'", echo_req.content());
 
-    // 创建Echo响应
-    auto response = ProtocolHandler::create_echo_response(
+    // 创建Echo响应，和请求共用同一个 arena
+    Packet *response = ProtocolHandler::create_echo_response(
+        packet.GetArena(),
         echo_req.content(),
         packet.sequence());
 
     // 通过session发送响应
-    session->send_packet(response);
+    session.send_packet(*response);
 
     return true;
 }
\ No newline at end of file
@@ -19,17 +19,29 @@ public:
 
     /**
      * @brief 处理消息
-     * @param packet 要处理的protobuf消息包
-     * @param session 发送消息的会话，用于发送响应
+     * @param packet 要处理的protobuf消息包，总是分配在 Arena 上，
+     *        响应用 ProtocolHandler::create_*(packet.GetArena(), ...) 创建即可与请求一起释放
+     * @param session 发送消息的会话，用于发送响应。
+     *        只在本次调用期间有效；阻塞型处理器由 MessageRouter 保证调用期间会话不被销毁，
+     *        需要在调用结束后继续使用时自行 session.shared_from_this()
      * @return true 如果消息处理成功，false 如果处理失败
      */
-    virtual bool handle(const Packet &packet, std::shared_ptr<Session> session) = 0;
+    virtual bool handle(const Packet &packet, Session &session) = 0;
 
     /**
      * @brief 获取处理器名称，用于日志和调试
      * @return 处理器名称
      */
     virtual std::string get_handler_name() const = 0;
+
+    /**
+     * @brief 处理过程中是否会阻塞（数据库访问、密码哈希等）
+     *
+     * 返回 true 的处理器由 MessageRouter 交给 BlockingExecutor 执行，
+     * 不占用 io_context 的 worker 线程；响应通过 Session::send_packet 投递回会话。
+     * @return true 如果处理器需要在阻塞线程池中执行
+     */
+    virtual bool is_blocking() const { return false; }
 };
 
 /**
@@ -40,6 +52,6 @@ public:
 class EchoHandler : public MessageHandler
 {
 public:
-    bool handle(const Packet &packet, std::shared_ptr<Session> session) override;
+    bool handle(const Packet &packet, Session &session) override;
     std::string get_handler_name() const override { return "EchoHandler"; }
 };
\ No newline at end of file
@@ -1,107 +1,304 @@
 #include "message_router.h"
 #include "../server/session.h"
 #include "../protocol/protocol_handler.h"
+#include "../executor/blocking_executor.h"
+#include "../protocol/packet_arena.h"
+#include "../logging/log_limiter.h"
 #include <spdlog/spdlog.h>
+#include <algorithm>
 
 MessageRouter::MessageRouter()
 {
-    spdlog::info("MessageRouter initialized");
+    // 按 oneof 中最大的字段编号分配路由表，payload_case() 的取值就是字段编号
+    int max_case = 0;
+    const auto *payload = Packet::descriptor()->FindOneofByName("payload");
+    for (int i = 0; payload && i < payload->field_count(); ++i)
+    {
+        max_case = std::max(max_case, payload->field(i)->number());
+    }
+    routes_.resize(static_cast<size_t>(max_case) + 1);
+
+    unsupported_ = &MetricsRegistry::get_instance().counter(
+        "im_requests_unsupported_total", "Requests whose payload type has no registered handler");
+    batches_ = &MetricsRegistry::get_instance().counter(
+        "im_request_batches_total", "PacketBatch frames received");
+    batched_packets_ = &MetricsRegistry::get_instance().counter(
+        "im_batched_packets_total", "Sub-packets carried in PacketBatch frames");
+
+    spdlog::info("MessageRouter initialized ({} route slots)", routes_.size());
 }
 
-void MessageRouter::register_handler(MessageType type, std::shared_ptr<MessageHandler> handler)
+void MessageRouter::register_handler(Packet::PayloadCase payload_case, std::shared_ptr<MessageHandler> handler)
 {
     if (!handler)
     {
-        spdlog::error("Cannot register null handler for type {}", message_type_to_string(type));
+        spdlog::error("Cannot register null handler for type {}", payload_case_to_string(payload_case));
         return;
     }
 
-    handlers_[type] = handler;
+    size_t index = static_cast<size_t>(payload_case);
+    if (payload_case == Packet::PAYLOAD_NOT_SET || index >= routes_.size())
+    {
+        spdlog::error("Cannot register handler '{}' for invalid payload case {}",
+                      handler->get_handler_name(), index);
+        return;
+    }
+
+    Route &route = routes_[index];
+    if (!route.handler)
+    {
+        ++handler_count_;
+    }
+    route.handler = handler.get();
+    route.blocking = handler->is_blocking();
+    route.async_handler = dynamic_cast<AsyncMessageHandler *>(handler.get());
+    if (!route.requests)
+    {
+        auto &registry = MetricsRegistry::get_instance();
+        std::string labels = MetricsRegistry::label("type", payload_case_to_string(payload_case));
+        route.requests = &registry.counter("im_requests_total", "Requests routed to a handler", labels);
+        route.failures = &registry.counter("im_request_failures_total",
+                                           "Requests that failed, threw or were rejected as busy", labels);
+        route.latency = &registry.histogram("im_request_duration_seconds",
+                                            "Time from routing to handler completion", labels);
+    }
+    owned_handlers_.push_back(handler);
+
     spdlog::info("Registered handler '{}' for message type {}",
-                 handler->get_handler_name(), message_type_to_string(type));
+                 handler->get_handler_name(), payload_case_to_string(payload_case));
 }
 
-bool MessageRouter::route_message(const Packet &packet, std::shared_ptr<Session> session)
+bool MessageRouter::route_message(const Packet &packet, Session &session)
 {
-    if (!session)
+    auto start = std::chrono::steady_clock::now();
+
+    // 处理器默认请求在 arena 上，用 packet.GetArena() 分配响应；堆上的 Packet 先复制到本线程 arena
+    if (packet.GetArena() == nullptr)
     {
-        spdlog::error("Cannot route message with null session");
-        return false;
+        PacketArena::Scope arena_scope;
+        Packet *copy = arena_scope.new_packet();
+        copy->CopyFrom(packet);
+        return route_message(*copy, session);
     }
 
-    // 确定消息类型
-    MessageType type = determine_message_type(packet);
-    spdlog::debug("Routing message type: {}", message_type_to_string(type));
+    if (packet.payload_case() == Packet::kBatch)
+    {
+        return route_batch(packet, session);
+    }
 
-    // 查找对应的处理器, it指向一个pair：std::pair<const MessageType, std::shared_ptr<MessageHandler>>
-    auto it = handlers_.find(type);
-    if (it == handlers_.end())
+    size_t index = static_cast<size_t>(packet.payload_case());
+    const Route *route = index < routes_.size() ? &routes_[index] : nullptr;
+    if (!route || !route->handler)
     {
-        spdlog::warn("No handler found for message type: {}", message_type_to_string(type));
+        std::string type = payload_case_to_string(packet.payload_case());
+        LOG_RATE_LIMITED(spdlog::level::warn, "No handler found for message type: {}", type);
+        unsupported_->add();
 
         // 发送错误响应
-        send_error_response(3001,
-                            "Unsupported message type: " + message_type_to_string(type),
-                            packet.sequence(),
-                            session);
+        send_error_response(3001, "Unsupported message type: " + type, packet.sequence(), session);
         return false;
     }
 
+    route->requests->add();
+
+    // 协程处理器在会话的 executor 上 co_spawn，等待 I/O 时挂起，不占 io 线程也不占线程池线程
+    if (route->async_handler)
+    {
+        return dispatch_async(*route, packet, session, start);
+    }
+
+    // 阻塞型处理器交给阻塞线程池，避免占住 io 线程
+    if (route->blocking && blocking_executor_)
+    {
+        return dispatch_blocking(*route, packet, session, start);
+    }
+
     // 调用处理器处理消息
+    return invoke_handler(*route, packet, session, start);
+}
+
+/**
+ * 子包已经和批次一起反序列化在同一个 arena 上，直接按引用分发，不再复制
+ * 每个子包仍然各自计入 im_requests_total / 耗时，批次本身只计入批次计数
+ */
+bool MessageRouter::route_batch(const Packet &packet, Session &session)
+{
+    const auto &packets = packet.batch().packets();
+    batches_->add();
+    if (packets.empty() || packets.size() > ProtocolHandler::MAX_BATCH_PACKETS)
+    {
+        LOG_RATE_LIMITED(spdlog::level::warn, "Rejecting batch with {} packets", packets.size());
+        send_error_response(1002, "Invalid batch size: " + std::to_string(packets.size()), packet.sequence(), session);
+        return false;
+    }
+    batched_packets_->add(static_cast<uint64_t>(packets.size()));
+
+    bool all_ok = true;
+    for (const Packet &sub_packet : packets)
+    {
+        if (sub_packet.payload_case() == Packet::kBatch)
+        {
+            send_error_response(1002, "Nested batch is not allowed", sub_packet.sequence(), session);
+            all_ok = false;
+            continue;
+        }
+        // 协商在处理器里立即启用压缩，而批量回复要到批次结束才写出：CapabilityResponse 会被压缩，客户端无法识别
+        if (sub_packet.payload_case() == Packet::kCapabilityRequest)
+        {
+            send_error_response(1002, "Capability negotiation is not allowed inside a batch", sub_packet.sequence(),
+                                session);
+            all_ok = false;
+            continue;
+        }
+        if (!ProtocolHandler::validate_packet(sub_packet))
+        {
+            send_error_response(1001, "Invalid packet format", sub_packet.sequence(), session);
+            all_ok = false;
+            continue;
+        }
+        all_ok = route_message(sub_packet, session) && all_ok;
+    }
+    return all_ok;
+}
+
+bool MessageRouter::invoke_handler(const Route &route, const Packet &packet, Session &session,
+                                   std::chrono::steady_clock::time_point start)
+{
+    MessageHandler &handler = *route.handler;
+    bool result = false;
     try
     {
-        bool result = it->second->handle(packet, session);
+        result = handler.handle(packet, session);
         if (result)
         {
-            spdlog::debug("Message handled successfully by {}", it->second->get_handler_name());
+            // get_handler_name() 返回 std::string，级别未开启时不构造
+            if (spdlog::should_log(spdlog::level::debug))
+            {
+                spdlog::debug("Message handled successfully by {}", handler.get_handler_name());
+            }
         }
         else
         {
-            spdlog::warn("Handler {} failed to process message", it->second->get_handler_name());
+            LOG_RATE_LIMITED(spdlog::level::warn, "Handler {} failed to process message", handler.get_handler_name());
         }
-        return result;
     }
     catch (const std::exception &e)
     {
-        spdlog::error("Exception in handler {}: {}", it->second->get_handler_name(), e.what());
+        spdlog::error("Exception in handler {}: {}", handler.get_handler_name(), e.what());
 
         // 发送错误响应
         send_error_response(3002,
                             "Internal handler error: " + std::string(e.what()),
                             packet.sequence(),
                             session);
-        return false;
+        result = false;
+    }
+
+    route.latency->record(elapsed_us(start));
+    if (!result)
+    {
+        route.failures->add();
     }
+    return result;
 }
 
-MessageRouter::MessageType MessageRouter::determine_message_type(const Packet &packet) const
+/**
+ * 阻塞型处理器的异步路径：
+ * io 线程复制 Packet 后提交任务 -> 阻塞线程池执行 handle() -> 处理器调用 send_packet()，
+ * Session 会把写操作投递回自己的 io 线程。
+ * 队列满时直接返回 3003 繁忙错误，让客户端退避重试，而不是让排队时间无限增长。
+ * 耗时在任务里记录，包含在线程池中的排队时间，反映客户端实际等待的时长。
+ */
+bool MessageRouter::dispatch_blocking(const Route &route, const Packet &packet, Session &session,
+                                      std::chrono::steady_clock::time_point start)
 {
-    // 根据oneof字段确定消息类型
-    if (packet.has_echo_request())
+    // io 线程的 arena 在本帧结束时就会重置，请求复制到任务自己的 arena 上，响应也分配在那里
+    // 只有这里需要延长会话的生命周期
+    auto arena = std::make_shared<google::protobuf::Arena>();
+    Packet *packet_copy = google::protobuf::Arena::CreateMessage<Packet>(arena.get());
+    packet_copy->CopyFrom(packet);
+    auto self = session.shared_from_this();
+    const Route *route_ptr = &route;
+    bool submitted = blocking_executor_->submit(
+        [this, route_ptr, arena, packet_copy, self, start]()
+        {
+            invoke_handler(*route_ptr, *packet_copy, *self, start);
+        });
+
+    if (!submitted)
     {
-        return MessageType::ECHO_REQUEST;
+        LOG_RATE_LIMITED(spdlog::level::warn, "BlockingExecutor '{}' is saturated, rejecting {} request",
+                         blocking_executor_->name(), route.handler->get_handler_name());
+        send_error_response(3003, "Server busy, please retry", packet.sequence(), session);
+        route.failures->add();
+        route.latency->record(elapsed_us(start));
+        return false;
     }
 
-    if (packet.has_register_request())
+    if (spdlog::should_log(spdlog::level::debug))
     {
-        return MessageType::USER_REGISTER;
+        spdlog::debug("Dispatched message to {} on blocking executor", route.handler->get_handler_name());
     }
+    return true;
+}
 
-    if (packet.has_login_request())
+/**
+ * 协程处理器的路径：
+ * 与阻塞路径一样先把请求复制到协程自己的 Arena 上（io 线程的 Arena 在本帧结束时就会重置），
+ * 然后在会话的 executor 上 co_spawn；协程第一次运行时本帧已经处理完，handle_async 里的 send_packet 走收件箱。
+ * 请求截止时间从路由时刻算起，同一请求里的多次 run_blocking 共用。
+ */
+bool MessageRouter::dispatch_async(const Route &route, const Packet &packet, Session &session,
+                                   std::chrono::steady_clock::time_point start)
+{
+    auto arena = std::make_shared<google::protobuf::Arena>();
+    Packet *packet_copy = google::protobuf::Arena::CreateMessage<Packet>(arena.get());
+    packet_copy->CopyFrom(packet);
+
+    RequestContext ctx(blocking_executor_, start, request_timeout_);
+    asio::co_spawn(session.socket_.get_executor(),
+                   run_async(&route, std::move(arena), packet_copy, session.shared_from_this(), ctx, start),
+                   asio::detached);
+    return true;
+}
+
+// arena 不直接使用：它作为协程参数留在协程帧里，packet 在整个协程期间有效
+asio::awaitable<void> MessageRouter::run_async(const Route *route,
+                                               [[maybe_unused]] std::shared_ptr<google::protobuf::Arena> arena,
+                                               Packet *packet, std::shared_ptr<Session> session, RequestContext ctx,
+                                               std::chrono::steady_clock::time_point start)
+{
+    AsyncMessageHandler &handler = *route->async_handler;
+    bool result = false;
+    try
     {
-        return MessageType::USER_LOGIN;
+        result = co_await handler.handle_async(*packet, session, ctx);
+        if (!result)
+        {
+            LOG_RATE_LIMITED(spdlog::level::warn, "Handler {} failed to process message", handler.get_handler_name());
+        }
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("Exception in handler {}: {}", handler.get_handler_name(), e.what());
+        send_error_response(3002, "Internal handler error: " + std::string(e.what()), packet->sequence(), *session);
+        result = false;
     }
 
-    return MessageType::UNKNOWN;
+    route->latency->record(elapsed_us(start));
+    if (!result)
+    {
+        route->failures->add();
+    }
 }
 
 void MessageRouter::send_error_response(uint32_t error_code, const std::string &message,
-                                        uint32_t sequence, std::shared_ptr<Session> session)
+                                        uint32_t sequence, Session &session)
 {
     try
     {
         auto error_packet = ProtocolHandler::create_error_response(error_code, message, sequence);
-        session->send_packet(error_packet);
+        session.send_packet(error_packet);
         spdlog::debug("Sent error response: code={}, message='{}'", error_code, message);
     }
     catch (const std::exception &e)
@@ -110,19 +307,13 @@ void MessageRouter::send_error_response(uint32_t error_code, const std::string &
     }
 }
 
-std::string MessageRouter::message_type_to_string(MessageType type) const
+std::string MessageRouter::payload_case_to_string(Packet::PayloadCase payload_case)
 {
-    switch (type)
-    {
-    case MessageType::ECHO_REQUEST:
-        return "ECHO_REQUEST";
-    case MessageType::USER_REGISTER:
-        return "USER_REGISTER";
-    case MessageType::USER_LOGIN:
-        return "USER_LOGIN";
-    case MessageType::UNKNOWN:
-        return "UNKNOWN";
-    default:
-        return "UNDEFINED";
-    }
-}
\ No newline at end of file
+    if (payload_case == Packet::PAYLOAD_NOT_SET)
+    {
+        return "PAYLOAD_NOT_SET";
+    }
+
+    const auto *field = Packet::descriptor()->FindFieldByNumber(static_cast<int>(payload_case));
+    return field ? field->name() : "UNKNOWN(" + std::to_string(static_cast<int>(payload_case)) + ")";
+}
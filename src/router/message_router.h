@@ -1,58 +1,45 @@
 #pragma once
 
 #include "message_handler.h"
-#include <unordered_map>
+#include "async_handler.h"
+#include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 #include <messages.pb.h>
+#include "../metrics/metrics_registry.h"
 
 // Forward declarations
 class Session;
+class BlockingExecutor;
 
 /**
  * @brief 消息路由器
  *
  * 负责将接收到的消息根据类型分发到相应的处理器。
  * 支持动态注册处理器，提供统一的错误处理和日志记录。
+ *
+ * 路由直接以 Packet::payload_case()（oneof 字段编号）为下标查一张稠密数组：
+ * 启动时按 Packet 的 oneof 描述符算出最大字段编号并分配好表，热路径上只有一次数组访问，
+ * 没有 if 链、没有哈希查找；proto 里新增 payload 后只需注册处理器，分发代价不变。
+ * 处理器以 Session& 接收会话，同步路径上不产生 shared_ptr 引用计数的原子操作；
+ * 只有提交到阻塞线程池或启动协程处理器时才 shared_from_this() 延长会话生命周期。
+ *
+ * PacketBatch 在这里拆开：子包逐个校验后按顺序走同样的分发，整批只有一次帧解析；
+ * 把同步响应合并成一个批量回复由 Session 负责。
  */
 class MessageRouter
 {
 public:
-    /**
-     * @brief 消息类型枚举
-     * 用于标识不同的消息类型，便于路由分发
-     * enum class是C++11 引入的强类型枚举和传统的 enum 相比，它有几个好处：
-     * 1. 作用域明确：enum class 的枚举成员必须通过作用域解析符来访问，例如：MessageType::ECHO_REQUEST;避免了和其他枚举或全局常量冲突的问题。
-     * 2. 普通的 enum 会被隐式转换成 int，可能引发 bug。enum class 不会自动转换，需要显式的 static_cast，保证了类型安全。
-     * 3. 可指定底层类型：可以明确枚举底层类型，比如：enum class Color : uint8_t { Red, Green, Blue };
-     *
-     * MessageType 枚举类用来 区分消息的类型，方便 MessageRouter 选择正确的 MessageHandler 去处理。
-     * MessageRouter::MessageType type = MessageRouter::MessageType::ECHO_REQUEST;
-
-        if (type == MessageRouter::MessageType::ECHO_REQUEST) {
-        // 调用对应的处理器
-       }
-     *
-     */
-    enum class MessageType
-    {
-        ECHO_REQUEST,
-        USER_REGISTER,
-        USER_LOGIN,
-        // 未来可以添加更多消息类型
-        // CHAT_MESSAGE,
-        UNKNOWN
-    };
-
     MessageRouter();
     ~MessageRouter() = default;
 
     /**
      * @brief 注册消息处理器
-     * @param type 消息类型
+     * @param payload_case 请求对应的 oneof 字段，如 Packet::kEchoRequest
      * @param handler 处理器实例
      */
-    void register_handler(MessageType type, std::shared_ptr<MessageHandler> handler);
+    void register_handler(Packet::PayloadCase payload_case, std::shared_ptr<MessageHandler> handler);
 
     /**
      * @brief 路由消息到对应处理器
@@ -60,21 +47,49 @@ public:
      * @param session 发送消息的会话
      * @return true 如果消息处理成功，false 如果失败
      */
-    bool route_message(const Packet &packet, std::shared_ptr<Session> session);
+    bool route_message(const Packet &packet, Session &session);
 
     /**
      * @brief 获取注册的处理器数量
      * @return 处理器数量
      */
-    size_t get_handler_count() const { return handlers_.size(); }
+    size_t get_handler_count() const { return handler_count_; }
+
+    /**
+     * @brief payload 类型到字符串的转换（oneof 字段名，用于日志）
+     */
+    static std::string payload_case_to_string(Packet::PayloadCase payload_case);
+
+    /**
+     * @brief 设置阻塞任务执行器
+     *
+     * 设置后，is_blocking() 为 true 的处理器会被提交到该执行器，
+     * 未设置时所有处理器都在当前 io 线程上同步执行。
+     * @param executor 执行器（生命周期由 Server 管理，需长于 MessageRouter 的使用期）
+     */
+    void set_blocking_executor(BlockingExecutor *executor) { blocking_executor_ = executor; }
+
+    /**
+     * @brief 设置协程处理器的请求超时（从路由时刻算起），超时后 run_blocking 返回 TIMEOUT
+     */
+    void set_request_timeout(std::chrono::milliseconds timeout) { request_timeout_ = timeout; }
 
 private:
     /**
-     * @brief 从Packet确定消息类型
-     * @param packet protobuf消息包
-     * @return 消息类型
+     * @brief 路由表的一项
+     * handler 只是裸指针，所有权在 owned_handlers_ 中；blocking 在注册时缓存，避免每条消息一次虚调用
+     * async_handler 在注册时 dynamic_cast 一次，非空表示协程处理器
+     * 指标在注册时按 type=<oneof 字段名> 取出，替换处理器时沿用同一组指标
      */
-    MessageType determine_message_type(const Packet &packet) const;
+    struct Route
+    {
+        MessageHandler *handler = nullptr;
+        bool blocking = false;
+        AsyncMessageHandler *async_handler = nullptr;
+        Counter *requests = nullptr;
+        Counter *failures = nullptr;
+        LatencyHistogram *latency = nullptr;
+    };
 
     /**
      * @brief 发送错误响应
@@ -84,14 +99,48 @@ private:
      * @param session 会话
      */
     void send_error_response(uint32_t error_code, const std::string &message,
-                             uint32_t sequence, std::shared_ptr<Session> session);
+                             uint32_t sequence, Session &session);
 
     /**
-     * @brief 消息类型到字符串的转换（用于日志）
-     * @param type 消息类型
-     * @return 类型字符串
+     * @brief 按顺序分发 PacketBatch 中的子包
+     * 子包单独校验（外层帧只校验了批次本身），非法子包回复 1001、嵌套的批次回复 1002，跳过它们不影响其余子包；
+     * 批次为空或超过 MAX_BATCH_PACKETS 时整批回复 1002
+     * @return true 如果所有子包都处理成功
+     */
+    bool route_batch(const Packet &packet, Session &session);
+
+    /**
+     * @brief 在当前线程调用处理器，统一处理返回值和异常，并记录该类型的耗时 / 失败数
+     * @param route 路由表项
+     * @param packet 消息包
+     * @param session 会话
+     * @param start route_message 收到请求的时间（阻塞路径上包含排队时间）
+     * @return 处理器的返回值，异常时为 false
+     */
+    bool invoke_handler(const Route &route, const Packet &packet, Session &session,
+                        std::chrono::steady_clock::time_point start);
+
+    /**
+     * @brief 把阻塞型处理器提交到阻塞线程池
+     * @return true 如果已成功提交，false 如果队列已满（此时已向客户端发送繁忙错误）
+     */
+    bool dispatch_blocking(const Route &route, const Packet &packet, Session &session,
+                           std::chrono::steady_clock::time_point start);
+
+    /**
+     * @brief 在会话的 executor 上启动协程处理器
+     * @return 总是 true：结果在协程结束时才知道，耗时 / 失败数也在那时记录
+     */
+    bool dispatch_async(const Route &route, const Packet &packet, Session &session,
+                        std::chrono::steady_clock::time_point start);
+
+    /**
+     * @brief 协程处理器的外壳：调用 handle_async，处理异常并记录该类型的耗时 / 失败数
+     * 参数都按值传入，协程帧持有请求的 Arena 和会话
      */
-    std::string message_type_to_string(MessageType type) const;
+    asio::awaitable<void> run_async(const Route *route, std::shared_ptr<google::protobuf::Arena> arena,
+                                    Packet *packet, std::shared_ptr<Session> session, RequestContext ctx,
+                                    std::chrono::steady_clock::time_point start);
 
     /**
      * @brief 注册消息处理器
@@ -109,7 +158,7 @@ private:
      *
      *    @code
      *    auto handler = std::make_shared<EchoHandler>();
-     *    router.register_handler(MessageType::ECHO_REQUEST, handler);
+     *    router.register_handler(Packet::kEchoRequest, handler);
      *    monitor.track_handler(handler);
      *    @endcode
      *
@@ -119,22 +168,35 @@ private:
      *    - 使用 shared_ptr<MessageHandler> 可以保持子类的多态行为。
      *
      *    @code
-     *    handlers_[MessageType::ECHO_REQUEST] = std::make_shared<EchoHandler>();
-     *    handlers_[MessageType::USER_LOGIN]   = std::make_shared<LoginHandler>();
+     *    router.register_handler(Packet::kEchoRequest, std::make_shared<EchoHandler>());
+     *    router.register_handler(Packet::kLoginRequest, std::make_shared<LoginHandler>());
      *    @endcode
      *
      * 3. **支持动态替换**
      *    - register_handler() 可以随时更新某个消息类型对应的处理器。
-     *    - 使用 shared_ptr 时，旧对象若没人引用会被安全销毁。
+     *    - 旧处理器继续由 owned_handlers_ 持有到 MessageRouter 析构：路由表里存的是裸指针，
+     *      阻塞线程池中可能还有引用它的任务，不能在替换时立即销毁。
      *
      *    @code
-     *    router.register_handler(MessageType::ECHO_REQUEST, std::make_shared<EchoHandler>());
-     *    router.register_handler(MessageType::ECHO_REQUEST, std::make_shared<NewEchoHandler>());
-     *    // 旧 EchoHandler 如果没人引用，会自动释放
+     *    router.register_handler(Packet::kEchoRequest, std::make_shared<EchoHandler>());
+     *    router.register_handler(Packet::kEchoRequest, std::make_shared<NewEchoHandler>());
      *    @endcode
      *
      * @param type 消息类型
      * @param handler 处理器实例（非空）
      */
-    std::unordered_map<MessageType, std::shared_ptr<MessageHandler>> handlers_;
+    std::vector<std::shared_ptr<MessageHandler>> owned_handlers_;
+
+    // 以 payload_case 为下标的路由表，大小为 oneof 最大字段编号 + 1，构造时分配，之后不再扩容（Route 地址稳定）
+    std::vector<Route> routes_;
+    Counter *unsupported_ = nullptr;
+    Counter *batches_ = nullptr;
+    Counter *batched_packets_ = nullptr;
+    size_t handler_count_ = 0;
+
+    // 阻塞任务执行器，为空时阻塞处理器也同步执行
+    BlockingExecutor *blocking_executor_ = nullptr;
+
+    // 协程处理器的请求超时
+    std::chrono::milliseconds request_timeout_{5000};
 };
\ No newline at end of file
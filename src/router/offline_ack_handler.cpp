@@ -0,0 +1,45 @@
+#include "offline_ack_handler.h"
+#include "../server/session.h"
+#include "../chat/offline_store.h"
+#include "../logging/log_limiter.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <vector>
+
+asio::awaitable<bool> OfflineAckHandler::handle_async(const Packet &packet, std::shared_ptr<Session> session,
+                                                      const RequestContext &ctx)
+{
+    if (!packet.has_offline_ack())
+    {
+        spdlog::error("OfflineAckHandler received packet without offline_ack");
+        co_return false;
+    }
+    if (!session->is_authenticated())
+    {
+        LOG_RATE_LIMITED(spdlog::level::warn, "Ignoring OfflineAck from unauthenticated session");
+        co_return false;
+    }
+
+    auto &store = OfflineMessageStore::get_instance();
+    const auto &acked = packet.offline_ack().msg_ids();
+    if (!store.is_enabled() || acked.empty())
+    {
+        co_return true;
+    }
+
+    // 一次确认最多删除一次登录能投递的条数，超出的部分下次登录再投递、再确认
+    size_t count = std::min(static_cast<size_t>(acked.size()), store.max_drain_messages());
+    std::vector<uint64_t> msg_ids(acked.begin(), acked.begin() + static_cast<std::ptrdiff_t>(count));
+    int64_t user_id = session->get_user_id();
+
+    auto call = co_await ctx.run_blocking(
+        [&store, user_id, msg_ids = std::move(msg_ids)]()
+        { return store.remove_messages(user_id, msg_ids); });
+    if (!call.ok() || !call.value)
+    {
+        LOG_RATE_LIMITED(spdlog::level::warn, "Failed to remove {} acknowledged offline message(s) for user {}",
+                         count, user_id);
+        co_return false;
+    }
+    co_return true;
+}
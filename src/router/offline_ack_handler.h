@@ -0,0 +1,18 @@
+#pragma once
+
+#include "async_handler.h"
+
+/**
+ * OfflineAckHandler 处理离线消息确认
+ *
+ * 协商了 offline_ack 的客户端在保存好登录 / 恢复后收到的离线消息之后发送 OfflineAck，
+ * 这里按消息 ID 精确删除（只删当前登录用户自己的消息）。没有回复：确认丢失或删除失败时，
+ * 消息在下次登录时再投递一次，客户端按 msg_id 去重。
+ */
+class OfflineAckHandler : public AsyncMessageHandler
+{
+public:
+    asio::awaitable<bool> handle_async(const Packet &packet, std::shared_ptr<Session> session,
+                                       const RequestContext &ctx) override;
+    std::string get_handler_name() const override { return "OfflineAckHandler"; }
+};
@@ -0,0 +1,116 @@
+#include "offline_delivery.h"
+#include "../protocol/protocol_handler.h"
+#include "../server/session.h"
+#include "../chat/offline_store.h"
+#include "../logging/log_limiter.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+size_t deliver_offline_messages(Session &session, int64_t user_id)
+{
+    auto &store = OfflineMessageStore::get_instance();
+    if (!store.is_enabled())
+    {
+        return 0;
+    }
+
+    // 等写后日志落盘，刚离线写入、尚未提交的消息也在这次取到；超时只是少取几条，下次登录还在
+    if (!store.flush(std::chrono::milliseconds(500)))
+    {
+        LOG_RATE_LIMITED(spdlog::level::warn, "Offline store flush timed out before draining user {}", user_id);
+    }
+
+    // 同一个 Packet 逐条复用，不在请求的 Arena 上堆积几千条消息
+    Packet packet;
+    packet.set_version(ProtocolHandler::PROTOCOL_VERSION);
+    auto *message = packet.mutable_chat_message();
+    message->set_recipient_id(user_id);
+
+    // 协商了 offline_ack 的客户端确认后才删除（OfflineAckHandler），否则每页交给出站队列后删除
+    bool delete_on_send = !session.offline_ack();
+
+    std::vector<OfflineMessage> page;
+    std::vector<uint64_t> page_ids;
+    uint64_t after = 0;
+    size_t delivered = 0;
+    while (delivered < store.max_drain_messages())
+    {
+        // 会话关闭后 send_packet 直接丢弃，剩下的消息留在表里等下次登录
+        if (session.is_closed())
+        {
+            break;
+        }
+
+        size_t limit = std::min(store.page_size(), store.max_drain_messages() - delivered);
+        if (!store.fetch_page(user_id, after, limit, page) || page.empty())
+        {
+            break;
+        }
+
+        for (const auto &offline : page)
+        {
+            message->set_content(offline.content);
+            message->set_sender_id(offline.sender_id);
+            message->set_msg_id(offline.msg_id);
+            message->set_timestamp_ms(offline.timestamp_ms);
+            session.send_packet(packet);
+        }
+
+        after = page.back().msg_id;
+        if (delete_on_send)
+        {
+            // 投递期间会话关闭的话这一页可能没有写出去，不删除
+            if (session.is_closed())
+            {
+                break;
+            }
+            // 只删除这一页的 ID：页取出之后才提交的、ID 更小的消息要留到下次投递
+            // 删除失败时下次登录会重复投递（客户端按 msg_id 去重）
+            page_ids.clear();
+            for (const auto &offline : page)
+            {
+                page_ids.push_back(offline.msg_id);
+            }
+            store.remove_messages(user_id, page_ids);
+        }
+        delivered += page.size();
+        if (page.size() < limit)
+        {
+            break;
+        }
+    }
+
+    if (delivered > 0)
+    {
+        LOG_RATE_LIMITED(spdlog::level::info, "Delivered {} offline message(s) to user {}", delivered, user_id);
+    }
+    return delivered;
+}
+
+asio::awaitable<void> drain_offline_messages(std::shared_ptr<Session> session, int64_t user_id,
+                                             const RequestContext &ctx)
+{
+    if (!OfflineMessageStore::get_instance().is_enabled())
+    {
+        co_return;
+    }
+
+    // 响应已经发出，投递不再占用请求剩下的时间：登录时 crypt() 可能已经用掉了大半个 request_timeout_ms
+    RequestContext drain_ctx = ctx.renewed();
+    auto drained = co_await drain_ctx.run_blocking(
+        [session, user_id]()
+        { return deliver_offline_messages(*session, user_id); });
+
+    // 两种情况下消息都还在离线表里：繁忙时没有执行，下次登录 / 恢复再取；超时时投递仍在线程池中继续
+    if (drained.status == AwaitStatus::BUSY)
+    {
+        LOG_RATE_LIMITED(spdlog::level::warn, "Skipped offline drain for user {}: server busy", user_id);
+    }
+    else if (drained.status == AwaitStatus::TIMEOUT)
+    {
+        LOG_RATE_LIMITED(spdlog::level::warn, "Offline drain for user {} timed out, still running in background",
+                         user_id);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "async_handler.h"
+#include <cstdint>
+#include <memory>
+
+class Session;
+
+/**
+ * 登录（LoginHandler）和会话恢复（ResumeHandler）成功后投递离线消息的公共部分
+ */
+
+/**
+ * @brief 按页投递离线消息，一次最多 max_drain_messages 条；阻塞调用，只能在阻塞线程池中执行
+ *
+ * 未协商 offline_ack 时每页交给出站队列后按消息 ID 删除，协商了的由 OfflineAckHandler 在确认后删除。
+ * 会话关闭后立即停止且不再删除，剩下的消息留到下次登录。
+ * @return 投递的条数
+ */
+size_t deliver_offline_messages(Session &session, int64_t user_id);
+
+/**
+ * @brief 在协程处理器中调用：经 run_blocking 执行 deliver_offline_messages
+ * 使用 ctx.renewed() 重新计时，不和前面的认证步骤共用截止时间；繁忙和超时都记日志
+ */
+asio::awaitable<void> drain_offline_messages(std::shared_ptr<Session> session, int64_t user_id,
+                                             const RequestContext &ctx);
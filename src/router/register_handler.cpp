@@ -1,76 +1,110 @@
 #include "register_handler.h"
 #include "../protocol/protocol_handler.h"
 #include "../server/session.h"
+#include "../logging/log_limiter.h"
 #include <spdlog/spdlog.h>
+#include <optional>
 
 RegisterHandler::RegisterHandler() : user_manager_(UserManager::get_instance())
 {
 }
 
-bool RegisterHandler::handle(const Packet &packet, std::shared_ptr<Session> session)
+asio::awaitable<bool> RegisterHandler::handle_async(const Packet &packet, std::shared_ptr<Session> session,
+                                                    const RequestContext &ctx)
 {
     if (!packet.has_register_request())
     {
         spdlog::error("RegisterHandler received packet without register_request");
-        return false;
+        co_return false;
     }
 
     const auto &request = packet.register_request();
-    spdlog::info("Processing register request for user: {}", request.username());
+    spdlog::debug("Processing register request for user: {}", request.username());
 
-    // 调用UserManager进行注册
-    auto result = user_manager_.register_user(request.username(), request.password());
+    // 调用UserManager进行注册，成功后在同一次阻塞调用里查出新用户的 ID
+    struct Outcome
+    {
+        UserManager::RegisterResult result = UserManager::RegisterResult::DATABASE_ERROR;
+        std::optional<User> user;
+    };
+    auto call = co_await ctx.run_blocking(
+        [this, username = request.username(), password = request.password()]()
+        {
+            Outcome outcome;
+            outcome.result = user_manager_.register_user(username, password);
+            if (outcome.result == UserManager::RegisterResult::SUCCESS)
+            {
+                outcome.user = user_manager_.find_user_by_username(username);
+            }
+            return outcome;
+        });
 
     // 创建响应
-    auto response_packet = ProtocolHandler::create_packet(packet.version(), packet.sequence());
+    Packet *response_packet = ProtocolHandler::create_packet(packet.GetArena(), packet.version(), packet.sequence());
     // 返回 RegisterResponse*（指针），可以直接设置它的字段（如 success、message、user_id）。
     // 如果 Packet 内部还没有 RegisterResponse，这个函数会 创建一个新的 RegisterResponse 并返回指针。
-    auto *response = response_packet.mutable_register_response();
+    auto *response = response_packet->mutable_register_response();
 
-    switch (result)
+    if (!call.ok())
+    {
+        // 超时时注册可能仍在线程池中完成，客户端重试会得到"用户名已存在"
+        response->set_success(false);
+        response->set_message(call.status == AwaitStatus::BUSY ? "Server busy, please retry" : "Request timed out");
+        LOG_RATE_LIMITED(spdlog::level::warn, "Registration failed - {} for user: {}",
+                         call.status == AwaitStatus::BUSY ? "server busy" : "timed out", request.username());
+        session->send_packet(*response_packet);
+        co_return true;
+    }
+
+    switch (call.value.result)
     {
     case UserManager::RegisterResult::SUCCESS:
     {
         response->set_success(true);
         response->set_message("User registered successfully");
 
-        // 获取新创建的用户ID
-        auto user_opt = user_manager_.find_user_by_username(request.username());
-        if (user_opt.has_value())
+        // 新创建的用户ID
+        if (call.value.user.has_value())
         {
-            response->set_user_id(user_opt->user_id);
+            response->set_user_id(call.value.user->user_id);
         }
 
-        spdlog::info("User registration successful: {}", request.username());
+        LOG_RATE_LIMITED(spdlog::level::info, "User registration successful: {}", request.username());
         break;
     }
 
     case UserManager::RegisterResult::USERNAME_EXISTS:
         response->set_success(false);
         response->set_message("Username already exists");
-        spdlog::info("Registration failed - username exists: {}", request.username());
+        LOG_RATE_LIMITED(spdlog::level::info, "Registration failed - username exists: {}", request.username());
         break;
 
     case UserManager::RegisterResult::INVALID_USERNAME:
         response->set_success(false);
         response->set_message("Invalid username format");
-        spdlog::info("Registration failed - invalid username: {}", request.username());
+        LOG_RATE_LIMITED(spdlog::level::info, "Registration failed - invalid username: {}", request.username());
         break;
 
     case UserManager::RegisterResult::INVALID_PASSWORD:
         response->set_success(false);
         response->set_message("Invalid password format");
-        spdlog::info("Registration failed - invalid password for user: {}", request.username());
+        LOG_RATE_LIMITED(spdlog::level::info, "Registration failed - invalid password for user: {}", request.username());
+        break;
+
+    case UserManager::RegisterResult::SERVER_BUSY:
+        response->set_success(false);
+        response->set_message("Server busy, please retry");
+        LOG_RATE_LIMITED(spdlog::level::warn, "Registration failed - server busy for user: {}", request.username());
         break;
 
     case UserManager::RegisterResult::DATABASE_ERROR:
         response->set_success(false);
         response->set_message("Internal server error");
-        spdlog::error("Registration failed - database error for user: {}", request.username());
+        LOG_RATE_LIMITED(spdlog::level::err, "Registration failed - database error for user: {}", request.username());
         break;
     }
 
     // 发送响应
-    session->send_packet(response_packet);
-    return true;
+    session->send_packet(*response_packet);
+    co_return true;
 }
\ No newline at end of file
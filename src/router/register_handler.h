@@ -1,18 +1,20 @@
 #pragma once
 
-#include "message_handler.h"
+#include "async_handler.h"
 #include "../user/user_manager.h"
 
 /**
  * RegisterHandler 处理用户注册请求
+ * 数据库写入和 crypt() 经 run_blocking 交给阻塞线程池，协程在会话的 executor 上等待
  */
-class RegisterHandler : public MessageHandler
+class RegisterHandler : public AsyncMessageHandler
 {
 public:
     RegisterHandler();
     ~RegisterHandler() override = default;
 
-    bool handle(const Packet &packet, std::shared_ptr<Session> session) override;
+    asio::awaitable<bool> handle_async(const Packet &packet, std::shared_ptr<Session> session,
+                                       const RequestContext &ctx) override;
     std::string get_handler_name() const override { return "RegisterHandler"; }
 
 private:
@@ -0,0 +1,63 @@
+#include "resume_handler.h"
+#include "offline_delivery.h"
+#include "../protocol/protocol_handler.h"
+#include "../server/session.h"
+#include "../logging/log_limiter.h"
+#include <spdlog/spdlog.h>
+
+ResumeHandler::ResumeHandler() : token_service_(ResumeTokenService::get_instance())
+{
+}
+
+asio::awaitable<bool> ResumeHandler::handle_async(const Packet &packet, std::shared_ptr<Session> session,
+                                                  const RequestContext &ctx)
+{
+    if (!packet.has_resume_request())
+    {
+        spdlog::error("ResumeHandler received packet without resume_request");
+        co_return false;
+    }
+
+    Packet *response_packet = ProtocolHandler::create_packet(packet.GetArena(), packet.version(), packet.sequence());
+    auto *response = response_packet->mutable_resume_response();
+
+    ResumeTokenService::Claims claims;
+    auto result = token_service_.verify(packet.resume_request().resume_token(), claims);
+
+    // 令牌一次性使用：作废成功的那个请求才算恢复成功，并发重放的同一令牌只有一个能通过
+    if (result == ResumeTokenService::VerifyResult::VALID && !token_service_.revoke_token(claims))
+    {
+        result = ResumeTokenService::VerifyResult::REVOKED;
+    }
+
+    if (result == ResumeTokenService::VerifyResult::VALID)
+    {
+        session->set_authenticated_user(claims.user_id, claims.username);
+
+        ResumeTokenService::Claims rotated;
+        response->set_resume_token(token_service_.issue(claims.user_id, claims.username, &rotated));
+        response->set_resume_expires_at(rotated.expires_at);
+        response->set_success(true);
+        response->set_message("Session resumed");
+        response->set_user_id(claims.user_id);
+        response->set_username(claims.username);
+
+        LOG_RATE_LIMITED(spdlog::level::info, "Session resumed for user {} (ID: {})", claims.username, claims.user_id);
+    }
+    else
+    {
+        response->set_success(false);
+        response->set_message(std::string("Resume failed: token ") +
+                              ResumeTokenService::verify_result_to_string(result));
+        LOG_RATE_LIMITED(spdlog::level::info, "Session resume rejected: token {}", ResumeTokenService::verify_result_to_string(result));
+    }
+
+    session->send_packet(*response_packet);
+
+    // 离线消息排在恢复响应之后
+    if (result == ResumeTokenService::VerifyResult::VALID)
+    {
+        co_await drain_offline_messages(session, claims.user_id, ctx);
+    }
+    co_return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "async_handler.h"
+#include "../user/resume_token.h"
+
+/**
+ * ResumeHandler 处理会话恢复请求
+ *
+ * 客户端重连时带上登录（或上一次恢复）时拿到的令牌，校验通过后直接恢复 Session 的登录状态。
+ * 令牌校验只有一次 HMAC 计算和一次内存查表，不访问数据库也不计算密码哈希，直接在会话的 executor 上完成。
+ * 旧令牌在恢复成功时作废并换发新令牌。
+ * 恢复成功后和登录一样投递离线消息（drain_offline_messages），这一步经 run_blocking 交给阻塞线程池，
+ * 所以它是协程处理器；移动端断线重连走的正是这条路径。
+ */
+class ResumeHandler : public AsyncMessageHandler
+{
+public:
+    ResumeHandler();
+    ~ResumeHandler() override = default;
+
+    asio::awaitable<bool> handle_async(const Packet &packet, std::shared_ptr<Session> session,
+                                       const RequestContext &ctx) override;
+    std::string get_handler_name() const override { return "ResumeHandler"; }
+
+private:
+    ResumeTokenService &token_service_;
+};
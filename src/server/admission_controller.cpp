@@ -0,0 +1,143 @@
+#include "admission_controller.h"
+#include "session_manager.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <sstream>
+
+AdmissionController::AdmissionController(int max_connections, double per_ip_rate, double per_ip_burst)
+    : max_connections_(max_connections > 0 ? static_cast<size_t>(max_connections) : 0),
+      per_ip_rate_(per_ip_rate > 0 ? per_ip_rate : 0.0),
+      per_ip_burst_(std::max(1.0, per_ip_burst))
+{
+    spdlog::info("AdmissionController: max_connections={}, per_ip_rate={}/s, per_ip_burst={}",
+                 max_connections_ == 0 ? std::string("unlimited") : std::to_string(max_connections_),
+                 per_ip_rate_, per_ip_burst_);
+}
+
+/**
+ * 先抢占连接槽位（一次原子操作，最便宜），再检查该 IP 的令牌桶；
+ * 限速拒绝时把刚抢到的槽位还回去
+ */
+AdmissionController::Decision AdmissionController::admit(const asio::ip::address &remote_address)
+{
+    auto &manager = SessionManager::get_instance();
+
+    if (!manager.try_acquire_connection_slot(max_connections_))
+    {
+        rejected_capacity_.fetch_add(1, std::memory_order_relaxed);
+        return Decision::REJECT_CAPACITY;
+    }
+
+    if (per_ip_rate_ > 0 && !consume_token(remote_address))
+    {
+        manager.release_connection_slot();
+        rejected_rate_.fetch_add(1, std::memory_order_relaxed);
+        return Decision::REJECT_RATE;
+    }
+
+    accepted_.fetch_add(1, std::memory_order_relaxed);
+    return Decision::ACCEPT;
+}
+
+/**
+ * IPv4（包括 IPv4 映射的 IPv6 地址）按单个地址计；IPv6 只取 /64 前缀，
+ * 同一个 /64 内换地址不会拿到新的令牌桶
+ */
+std::string AdmissionController::address_key(const asio::ip::address &address)
+{
+    if (address.is_v4())
+    {
+        auto bytes = address.to_v4().to_bytes();
+        return std::string(bytes.begin(), bytes.end());
+    }
+    auto v6 = address.to_v6();
+    if (v6.is_v4_mapped())
+    {
+        auto bytes = asio::ip::make_address_v4(asio::ip::v4_mapped, v6).to_bytes();
+        return std::string(bytes.begin(), bytes.end());
+    }
+    auto bytes = v6.to_bytes();
+    return std::string(bytes.begin(), bytes.begin() + IPV6_PREFIX_BYTES);
+}
+
+bool AdmissionController::consume_token(const asio::ip::address &remote_address)
+{
+    auto now = Clock::now();
+    auto key = address_key(remote_address);
+    auto &shard = shards_[std::hash<std::string>{}(key) & (SHARD_COUNT - 1)];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it != shard.index.end())
+    {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    }
+    else
+    {
+        if (shard.lru.size() >= MAX_BUCKETS_PER_SHARD)
+        {
+            // 淘汰最久没有新连接的地址：它的桶大概率已经回满，和新建一个没有区别
+            shard.index.erase(shard.lru.back().key);
+            shard.lru.pop_back();
+        }
+        // 新地址从满桶开始
+        shard.lru.push_front(TokenBucket{key, per_ip_burst_, now});
+        shard.index.emplace(std::move(key), shard.lru.begin());
+    }
+
+    auto &bucket = shard.lru.front();
+    double elapsed = std::chrono::duration<double>(now - bucket.last_refill).count();
+    bucket.tokens = std::min(per_ip_burst_, bucket.tokens + elapsed * per_ip_rate_);
+    bucket.last_refill = now;
+
+    if (bucket.tokens < 1.0)
+    {
+        return false;
+    }
+
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+AdmissionController::Stats AdmissionController::get_stats() const
+{
+    Stats stats;
+    stats.accepted = accepted_.load(std::memory_order_relaxed);
+    stats.rejected_capacity = rejected_capacity_.load(std::memory_order_relaxed);
+    stats.rejected_rate = rejected_rate_.load(std::memory_order_relaxed);
+
+    for (const auto &shard : shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.tracked_ips += shard.lru.size();
+    }
+    return stats;
+}
+
+std::string AdmissionController::get_stats_string() const
+{
+    auto stats = get_stats();
+    std::ostringstream oss;
+    oss << "Admission Stats: "
+        << "Accepted=" << stats.accepted
+        << ", RejectedCapacity=" << stats.rejected_capacity
+        << ", RejectedRate=" << stats.rejected_rate
+        << ", TrackedIPs=" << stats.tracked_ips
+        << ", Slots=" << SessionManager::get_instance().get_connection_slot_count();
+    return oss.str();
+}
+
+const char *AdmissionController::decision_to_string(Decision decision)
+{
+    switch (decision)
+    {
+    case Decision::ACCEPT:
+        return "accept";
+    case Decision::REJECT_CAPACITY:
+        return "capacity";
+    case Decision::REJECT_RATE:
+        return "rate";
+    }
+    return "unknown";
+}
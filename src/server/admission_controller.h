@@ -0,0 +1,103 @@
+#pragma once
+
+#define ASIO_STANDALONE
+#include <asio.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief 连接准入控制
+ *
+ * 在 accept 之后、创建 Session 之前做两道检查，都不分配 Session 也不解析任何数据：
+ * 1. 按来源 IP 的令牌桶限速：每个 IP 每秒最多 per_ip_rate 个新连接，允许 per_ip_burst 的突发。
+ *    重连风暴中单个 NAT 出口或异常客户端无法占满 accept 队列。IPv6 按 /64 前缀计（一个客户端通常拥有整个 /64），
+ *    令牌桶表是定长的分片 LRU：大量不同来源地址涌入时每次 accept 仍是 O(1)，最久没有新连接的地址先被淘汰
+ * 2. 全局连接数上限：通过 SessionManager 的原子槽位计数实现，槽位由 Session 在析构时归还
+ *
+ * 被拒绝的 socket 由 Server 直接关闭（可选先写一个预先序列化好的错误帧），
+ * 开销只有一次 getpeername、一次哈希查找和一次 close，远低于一次完整的 Session 构造和注册。
+ */
+class AdmissionController
+{
+public:
+    enum class Decision
+    {
+        ACCEPT,
+        REJECT_CAPACITY, // 超过 max_connections
+        REJECT_RATE      // 该 IP 新建连接过快
+    };
+
+    struct Stats
+    {
+        uint64_t accepted = 0;
+        uint64_t rejected_capacity = 0;
+        uint64_t rejected_rate = 0;
+        size_t tracked_ips = 0;
+    };
+
+    /**
+     * @param max_connections 同时在线连接上限，<= 0 表示不限
+     * @param per_ip_rate 每个 IP 每秒允许的新连接数，<= 0 表示不限速
+     * @param per_ip_burst 令牌桶容量（允许的突发连接数）
+     */
+    AdmissionController(int max_connections, double per_ip_rate, double per_ip_burst);
+
+    AdmissionController(const AdmissionController &) = delete;
+    AdmissionController &operator=(const AdmissionController &) = delete;
+
+    /**
+     * @brief 判断新连接是否放行
+     * 返回 ACCEPT 时已经占用了一个连接槽位，调用方必须把它交给 Session（Session::hold_connection_slot），
+     * 或者在放弃该连接时调用 SessionManager::release_connection_slot 归还
+     */
+    Decision admit(const asio::ip::address &remote_address);
+
+    Stats get_stats() const;
+    std::string get_stats_string() const;
+
+    static const char *decision_to_string(Decision decision);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct TokenBucket
+    {
+        std::string key;
+        double tokens = 0.0;
+        Clock::time_point last_refill;
+    };
+
+    // 分片数量，2 的幂
+    static constexpr size_t SHARD_COUNT = 16;
+    // 单个分片最多记录的地址数，满了淘汰 LRU 尾部（最久没有新连接的地址），防止扫描式连接撑大内存
+    static constexpr size_t MAX_BUCKETS_PER_SHARD = 4096;
+    // IPv6 地址按前缀聚合的字节数（/64）
+    static constexpr size_t IPV6_PREFIX_BYTES = 8;
+
+    struct alignas(64) BucketShard
+    {
+        mutable std::mutex mutex;
+        // 按最近一次新连接排序，头部最新；key 是地址的原始字节（IPv4 4 字节，IPv6 /64 前缀 8 字节）
+        std::list<TokenBucket> lru;
+        std::unordered_map<std::string, std::list<TokenBucket>::iterator> index;
+    };
+
+    static std::string address_key(const asio::ip::address &address);
+    bool consume_token(const asio::ip::address &remote_address);
+
+    const size_t max_connections_;
+    const double per_ip_rate_;
+    const double per_ip_burst_;
+
+    std::array<BucketShard, SHARD_COUNT> shards_;
+
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<uint64_t> rejected_capacity_{0};
+    std::atomic<uint64_t> rejected_rate_{0};
+};
@@ -0,0 +1,125 @@
+#include "buffer_pool.h"
+#include <algorithm>
+
+// 线程退出时把本地缓存整体还给全局缓存
+struct BufferPool::LocalCache
+{
+    std::vector<uint8_t *> slabs;
+
+    ~LocalCache()
+    {
+        BufferPool::get_instance().spill(slabs, 0);
+    }
+};
+
+BufferPool &BufferPool::get_instance()
+{
+    static BufferPool instance;
+    return instance;
+}
+
+BufferPool::~BufferPool()
+{
+    for (uint8_t *slab : shared_)
+    {
+        delete[] slab;
+    }
+}
+
+BufferPool::LocalCache &BufferPool::local()
+{
+    thread_local LocalCache cache;
+    return cache;
+}
+
+uint8_t *BufferPool::acquire(size_t &capacity)
+{
+    if (capacity > SLAB_SIZE)
+    {
+        heap_bytes_.fetch_add(capacity, std::memory_order_relaxed);
+        return new uint8_t[capacity];
+    }
+
+    capacity = SLAB_SIZE;
+    slabs_in_use_.fetch_add(1, std::memory_order_relaxed);
+
+    auto &slabs = local().slabs;
+    if (slabs.empty())
+    {
+        refill(slabs);
+    }
+    if (slabs.empty())
+    {
+        return new uint8_t[SLAB_SIZE];
+    }
+
+    uint8_t *slab = slabs.back();
+    slabs.pop_back();
+    slabs_cached_.fetch_sub(1, std::memory_order_relaxed);
+    return slab;
+}
+
+void BufferPool::release(uint8_t *buffer, size_t capacity)
+{
+    if (capacity != SLAB_SIZE)
+    {
+        heap_bytes_.fetch_sub(capacity, std::memory_order_relaxed);
+        delete[] buffer;
+        return;
+    }
+
+    slabs_in_use_.fetch_sub(1, std::memory_order_relaxed);
+
+    auto &slabs = local().slabs;
+    if (slabs.size() >= LOCAL_CACHE_SLABS)
+    {
+        spill(slabs, LOCAL_CACHE_SLABS / 2);
+    }
+    if (slabs.capacity() < LOCAL_CACHE_SLABS)
+    {
+        slabs.reserve(LOCAL_CACHE_SLABS);
+    }
+    slabs.push_back(buffer);
+    slabs_cached_.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * 从全局缓存取至多半批到本地
+ */
+void BufferPool::refill(std::vector<uint8_t *> &slabs)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = std::min(shared_.size(), LOCAL_CACHE_SLABS / 2);
+    slabs.insert(slabs.end(), shared_.end() - count, shared_.end());
+    shared_.resize(shared_.size() - count);
+}
+
+/**
+ * 本地缓存只留 keep 个，其余放回全局缓存；全局缓存放不下的直接释放
+ */
+void BufferPool::spill(std::vector<uint8_t *> &slabs, size_t keep)
+{
+    if (slabs.size() <= keep)
+    {
+        return;
+    }
+
+    size_t freed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (slabs.size() > keep)
+        {
+            if (shared_.size() < SHARED_CACHE_SLABS)
+            {
+                shared_.push_back(slabs.back());
+            }
+            else
+            {
+                delete[] slabs.back();
+                ++freed;
+            }
+            slabs.pop_back();
+        }
+    }
+    slabs_cached_.fetch_sub(freed, std::memory_order_relaxed);
+}
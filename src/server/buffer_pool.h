@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief 接收缓冲区的共享 slab 池
+ *
+ * 会话只在有数据在途（读到了一部分帧、或者正在处理一批帧）时才持有接收缓冲区，处理完就还回来，
+ * 空闲连接不占缓冲区。所有缓冲区是同一尺寸的 slab（SLAB_SIZE），可以在会话之间任意复用；
+ * 超过一个 slab 的大帧临时从堆上分配，用完直接释放，缓冲区不会一直停在最大尺寸。
+ *
+ * 两级缓存：每个线程先用自己的本地缓存（无锁），本地空了从全局缓存一次取半批，
+ * 本地满了一次还半批，全局缓存的锁只在批量搬运时才会碰到。全局缓存也满了才真正 free。
+ */
+class BufferPool
+{
+public:
+    static constexpr size_t SLAB_SIZE = 16 * 1024;
+    // 每个线程本地最多缓存的 slab 数（1 MB）
+    static constexpr size_t LOCAL_CACHE_SLABS = 64;
+    // 全局缓存上限（64 MB），突发过后多出来的 slab 还给系统
+    static constexpr size_t SHARED_CACHE_SLABS = 4096;
+
+    static BufferPool &get_instance();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    /**
+     * @brief 取一块至少 capacity 字节的缓冲区
+     * @param capacity 输入所需字节数，输出实际容量（不超过 SLAB_SIZE 时为 SLAB_SIZE）
+     */
+    uint8_t *acquire(size_t &capacity);
+
+    // 归还 acquire() 得到的缓冲区，capacity 为 acquire() 输出的容量；可以在任意线程调用
+    void release(uint8_t *buffer, size_t capacity);
+
+    // 会话当前持有的 slab 数 / 各级缓存中空闲的 slab 数 / 大帧临时占用的堆内存
+    size_t slabs_in_use() const { return slabs_in_use_.load(std::memory_order_relaxed); }
+    size_t slabs_cached() const { return slabs_cached_.load(std::memory_order_relaxed); }
+    size_t heap_bytes() const { return heap_bytes_.load(std::memory_order_relaxed); }
+
+    // 会话持有的接收缓冲区总字节数
+    size_t bytes_in_use() const { return slabs_in_use() * SLAB_SIZE + heap_bytes(); }
+
+private:
+    struct LocalCache;
+
+    BufferPool() = default;
+    ~BufferPool();
+
+    static LocalCache &local();
+
+    // 本地缓存与全局缓存之间批量搬运
+    void refill(std::vector<uint8_t *> &slabs);
+    void spill(std::vector<uint8_t *> &slabs, size_t keep);
+
+    std::mutex mutex_;
+    std::vector<uint8_t *> shared_;
+
+    std::atomic<size_t> slabs_in_use_{0};
+    std::atomic<size_t> slabs_cached_{0};
+    std::atomic<size_t> heap_bytes_{0};
+};
@@ -0,0 +1,224 @@
+#include "io_context_pool.h"
+#include <spdlog/spdlog.h>
+#include <pthread.h>
+#include <sched.h>
+
+IoContextPool::IoContextPool(Mode mode, size_t thread_count, bool pin_threads, Balancing balancing)
+    : mode_(mode), thread_count_(thread_count == 0 ? 1 : thread_count), pin_threads_(pin_threads), balancing_(balancing)
+{
+    // PER_CORE 每个线程一个 io_context，其余模式所有线程共享一个
+    size_t context_count = mode_ == Mode::PER_CORE ? thread_count_ : 1;
+
+    for (size_t i = 0; i < context_count; ++i)
+    {
+        // 单线程 run 的 io_context 可以告诉 asio 不需要内部加锁
+        int concurrency_hint = mode_ == Mode::PER_CORE ? 1 : static_cast<int>(thread_count_);
+        contexts_.push_back(std::make_unique<asio::io_context>(concurrency_hint));
+        loads_.push_back(std::make_shared<std::atomic<size_t>>(0));
+
+        // work guard 防止没有连接的 io_context 在 run() 中立即返回
+        work_guards_.emplace_back(asio::make_work_guard(*contexts_.back()));
+    }
+}
+
+IoContextPool::~IoContextPool()
+{
+    stop();
+}
+
+void IoContextPool::run()
+{
+    for (size_t i = 0; i < thread_count_; ++i)
+    {
+        asio::io_context &ctx = mode_ == Mode::PER_CORE ? *contexts_[i] : *contexts_.front();
+
+        threads_.emplace_back([this, &ctx, i]()
+                              {
+            if (pin_threads_)
+            {
+                pin_current_thread(i);
+            }
+
+            try {
+                ctx.run();
+            } catch (const std::exception& e) {
+                spdlog::error("Worker thread error: {}", e.what());
+            } });
+    }
+
+    spdlog::info("IoContextPool running: mode={}, threads={}, io_contexts={}, cpu_affinity={}",
+                 mode_to_string(mode_), thread_count_, contexts_.size(), pin_threads_);
+    if (mode_ == Mode::SHARED && thread_count_ > 1)
+    {
+        spdlog::info("threading_mode 'shared' with {} threads binds each connection to a strand (same as 'strand')",
+                     thread_count_);
+    }
+}
+
+void IoContextPool::stop()
+{
+    for (auto &guard : work_guards_)
+    {
+        guard.reset();
+    }
+    for (auto &ctx : contexts_)
+    {
+        ctx->stop();
+    }
+    join();
+}
+
+void IoContextPool::join()
+{
+    std::lock_guard<std::mutex> lock(join_mutex_);
+    for (auto &thread : threads_)
+    {
+        if (thread.joinable() && thread.get_id() != std::this_thread::get_id())
+        {
+            thread.join();
+        }
+    }
+}
+
+IoContextPool::Assignment IoContextPool::assign()
+{
+    Assignment assignment;
+
+    switch (mode_)
+    {
+    case Mode::SHARED:
+        // Session 的读、写、收件箱回调都假定在串行的 executor 上执行：多个线程 run 同一个 io_context 时也要套一层 strand
+        if (thread_count_ > 1)
+        {
+            assignment.executor = asio::make_strand(*contexts_.front());
+        }
+        else
+        {
+            assignment.executor = contexts_.front()->get_executor();
+        }
+        break;
+    case Mode::STRAND:
+        // 每个连接一个 strand：同一会话的回调不会在多个线程上并发执行
+        assignment.executor = asio::make_strand(*contexts_.front());
+        break;
+    case Mode::PER_CORE:
+        assignment.index = pick_index();
+        assignment.executor = contexts_[assignment.index]->get_executor();
+        break;
+    }
+
+    assignment.load = loads_[assignment.index];
+    return assignment;
+}
+
+IoContextPool::Assignment IoContextPool::assign_to(size_t index)
+{
+    if (mode_ != Mode::PER_CORE)
+    {
+        return assign();
+    }
+
+    Assignment assignment;
+    assignment.index = index % contexts_.size();
+    assignment.executor = contexts_[assignment.index]->get_executor();
+    assignment.load = loads_[assignment.index];
+    return assignment;
+}
+
+size_t IoContextPool::pick_index()
+{
+    if (balancing_ == Balancing::ROUND_ROBIN || contexts_.size() == 1)
+    {
+        return next_index_.fetch_add(1, std::memory_order_relaxed) % contexts_.size();
+    }
+
+    // 最少连接数；从轮询位置开始扫描，负载相同时不会总是落在第一个
+    size_t start = next_index_.fetch_add(1, std::memory_order_relaxed);
+    size_t best = start % contexts_.size();
+    size_t best_load = loads_[best]->load(std::memory_order_relaxed);
+    for (size_t n = 1; n < contexts_.size(); ++n)
+    {
+        size_t i = (start + n) % contexts_.size();
+        size_t load = loads_[i]->load(std::memory_order_relaxed);
+        if (load < best_load)
+        {
+            best = i;
+            best_load = load;
+        }
+    }
+    return best;
+}
+
+std::vector<size_t> IoContextPool::loads() const
+{
+    std::vector<size_t> result;
+    result.reserve(loads_.size());
+    for (const auto &load : loads_)
+    {
+        result.push_back(load->load(std::memory_order_relaxed));
+    }
+    return result;
+}
+
+void IoContextPool::pin_current_thread(size_t cpu_index)
+{
+    unsigned int cpu_count = std::thread::hardware_concurrency();
+    if (cpu_count == 0)
+    {
+        return;
+    }
+
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu_index % cpu_count, &cpuset);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+    if (rc != 0)
+    {
+        spdlog::warn("Failed to pin worker thread {} to CPU {}: error {}", cpu_index, cpu_index % cpu_count, rc);
+    }
+}
+
+IoContextPool::Mode IoContextPool::parse_mode(const std::string &value)
+{
+    if (value == "strand")
+    {
+        return Mode::STRAND;
+    }
+    if (value == "per_core")
+    {
+        return Mode::PER_CORE;
+    }
+    if (value == "shared")
+    {
+        return Mode::SHARED;
+    }
+    spdlog::warn("Unknown threading_mode '{}', falling back to 'strand'", value);
+    return Mode::STRAND;
+}
+
+IoContextPool::Balancing IoContextPool::parse_balancing(const std::string &value)
+{
+    if (value == "least_load")
+    {
+        return Balancing::LEAST_LOAD;
+    }
+    if (value != "round_robin")
+    {
+        spdlog::warn("Unknown accept_balancing '{}', falling back to 'round_robin'", value);
+    }
+    return Balancing::ROUND_ROBIN;
+}
+
+const char *IoContextPool::mode_to_string(Mode mode)
+{
+    switch (mode)
+    {
+    case Mode::SHARED:
+        return "shared";
+    case Mode::STRAND:
+        return "strand";
+    case Mode::PER_CORE:
+        return "per_core";
+    }
+    return "unknown";
+}
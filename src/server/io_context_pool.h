@@ -0,0 +1,108 @@
+#pragma once
+
+#define ASIO_STANDALONE
+#include <asio.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief io_context 线程模型
+ *
+ * 三种模式可以通过配置切换，便于用压测工具对比：
+ * - SHARED：一个 io_context 被所有 worker 线程同时 run()（原有模型）；多于一个线程时会话同样绑定 strand，
+ *   Session 的读写状态没有加锁，必须串行访问
+ * - STRAND：仍然共享一个 io_context，但每个会话的 socket 绑定到自己的 strand，回调串行化
+ * - PER_CORE：每个 worker 线程独占一个 io_context（one loop per thread），可选绑定 CPU，
+ *   新连接按轮询或最少连接数分配到某个 io_context，会话的所有回调都在同一线程上执行
+ */
+class IoContextPool
+{
+public:
+    enum class Mode
+    {
+        SHARED,
+        STRAND,
+        PER_CORE
+    };
+
+    enum class Balancing
+    {
+        ROUND_ROBIN,
+        LEAST_LOAD
+    };
+
+    // 分配给新连接的 executor，以及用于统计负载的计数器
+    struct Assignment
+    {
+        asio::any_io_executor executor;
+        std::shared_ptr<std::atomic<size_t>> load;
+        size_t index = 0;
+    };
+
+    IoContextPool(Mode mode, size_t thread_count, bool pin_threads, Balancing balancing);
+    ~IoContextPool();
+
+    IoContextPool(const IoContextPool &) = delete;
+    IoContextPool &operator=(const IoContextPool &) = delete;
+
+    // 启动所有 worker 线程（不阻塞）
+    void run();
+
+    // 停止所有 io_context，并等待 worker 线程退出
+    void stop();
+
+    // 等待 worker 线程退出
+    void join();
+
+    // acceptor 等全局对象使用的 io_context（PER_CORE 模式下是第一个）
+    asio::io_context &primary_context() { return *contexts_.front(); }
+
+    // 按序号访问 io_context，供每个事件循环各自持有的组件（定时器轮等）使用
+    asio::io_context &context(size_t index) { return *contexts_[index]; }
+    size_t context_count() const { return contexts_.size(); }
+
+    /**
+     * @brief 为新连接选择 executor
+     * STRAND（以及多线程的 SHARED）返回一个新 strand，单线程的 SHARED 直接返回共享 io_context 的 executor，
+     * PER_CORE 按负载均衡策略选择一个 io_context。连接建立后由 Session 持有 load 计数器，构造时加一、析构时减一。
+     */
+    Assignment assign();
+
+    /**
+     * @brief 把新连接留在指定的 io_context 上
+     * 供 SO_REUSEPORT 多 acceptor 使用：内核已经在各个 acceptor 之间做了均衡，
+     * PER_CORE 模式下连接直接留在接受它的那个 io_context 上；其余模式与 assign() 相同
+     */
+    Assignment assign_to(size_t index);
+
+    Mode mode() const { return mode_; }
+    size_t thread_count() const { return thread_count_; }
+
+    // 每个 io_context 当前承载的连接数
+    std::vector<size_t> loads() const;
+
+    static Mode parse_mode(const std::string &value);
+    static Balancing parse_balancing(const std::string &value);
+    static const char *mode_to_string(Mode mode);
+
+private:
+    size_t pick_index();
+    void pin_current_thread(size_t cpu_index);
+
+    Mode mode_;
+    size_t thread_count_;
+    bool pin_threads_;
+    Balancing balancing_;
+
+    // 负载计数器在 contexts_ 之前声明：析构时 io_context 先销毁，挂起的会话随之释放
+    std::vector<std::shared_ptr<std::atomic<size_t>>> loads_;
+    std::vector<std::unique_ptr<asio::io_context>> contexts_;
+    std::vector<asio::executor_work_guard<asio::io_context::executor_type>> work_guards_;
+    std::vector<std::thread> threads_;
+    std::mutex join_mutex_; // start() 和 stop() 可能在不同线程同时等待 worker 退出
+    std::atomic<size_t> next_index_{0};
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief 无锁多生产者单消费者队列
+ *
+ * 生产者（任意线程）用 CAS 把节点压到链表头部，消费者一次 exchange 摘下整条链表再反转成 FIFO 顺序。
+ * 没有互斥锁，生产者之间只在同一个原子指针上竞争，消费者取走一批只需要一次原子操作；
+ * 消费者整批取走、从不单独弹出节点，因此不存在 ABA 问题。
+ *
+ * push() 返回队列在压入前是否为空，调用方据此只在 空 -> 非空 时调度一次消费者，
+ * 之后的生产者只挂节点，不再额外投递。
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() = default;
+    ~MpscQueue() { clear(); }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    /**
+     * @brief 压入一个元素，可以从任意线程调用
+     * @return true 如果压入前队列为空（需要调度消费者）
+     */
+    bool push(T value)
+    {
+        Node *node = new Node{std::move(value), nullptr};
+        Node *head = head_.load(std::memory_order_relaxed);
+        do
+        {
+            node->next = head;
+        } while (!head_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+        return head == nullptr;
+    }
+
+    /**
+     * @brief 取走当前所有元素，按压入顺序依次调用 fn，只能由消费者调用
+     * @return 处理的元素个数
+     */
+    template <typename Fn>
+    size_t consume_all(Fn &&fn)
+    {
+        Node *list = reverse(head_.exchange(nullptr, std::memory_order_acquire));
+        size_t count = 0;
+        while (list)
+        {
+            Node *next = list->next;
+            fn(std::move(list->value));
+            delete list;
+            list = next;
+            ++count;
+        }
+        return count;
+    }
+
+    // 丢弃所有元素，只能由消费者调用
+    void clear()
+    {
+        consume_all([](T &&) {});
+    }
+
+    bool empty() const { return head_.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    struct Node
+    {
+        T value;
+        Node *next;
+    };
+
+    static Node *reverse(Node *list)
+    {
+        Node *reversed = nullptr;
+        while (list)
+        {
+            Node *next = list->next;
+            list->next = reversed;
+            reversed = list;
+            list = next;
+        }
+        return reversed;
+    }
+
+    std::atomic<Node *> head_{nullptr};
+};
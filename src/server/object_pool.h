@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+/**
+ * @brief 所有对象池共享的统计
+ */
+struct ObjectPoolStats
+{
+    static ObjectPoolStats &get()
+    {
+        static ObjectPoolStats stats;
+        return stats;
+    }
+
+    std::atomic<size_t> bytes_in_use{0}; // 已分配给对象的块
+    std::atomic<size_t> bytes_cached{0}; // 各线程空闲链表中的块
+};
+
+/**
+ * @brief 固定大小内存块的每线程空闲链表
+ *
+ * 块释放时挂到当前线程的链表上（侵入式，不额外分配），下次同一线程分配同样大小时直接取走，
+ * 不经过 malloc；每个线程最多缓存 LOCAL_LIMIT 块，超出的还给系统。
+ * 对象可以在别的线程上释放（例如最后一个引用落在阻塞线程池），块就留在那个线程的链表里。
+ */
+template <size_t BlockSize, size_t Align>
+class BlockPool
+{
+public:
+    static constexpr size_t LOCAL_LIMIT = 1024;
+
+    static void *allocate()
+    {
+        auto &stats = ObjectPoolStats::get();
+        stats.bytes_in_use.fetch_add(BlockSize, std::memory_order_relaxed);
+
+        FreeList &list = local();
+        if (!list.head)
+        {
+            return ::operator new(BlockSize, std::align_val_t(Align));
+        }
+        FreeBlock *block = list.head;
+        list.head = block->next;
+        --list.count;
+        stats.bytes_cached.fetch_sub(BlockSize, std::memory_order_relaxed);
+        return block;
+    }
+
+    static void deallocate(void *pointer)
+    {
+        auto &stats = ObjectPoolStats::get();
+        stats.bytes_in_use.fetch_sub(BlockSize, std::memory_order_relaxed);
+
+        FreeList &list = local();
+        if (list.count >= LOCAL_LIMIT)
+        {
+            ::operator delete(pointer, std::align_val_t(Align));
+            return;
+        }
+        list.head = new (pointer) FreeBlock{list.head};
+        ++list.count;
+        stats.bytes_cached.fetch_add(BlockSize, std::memory_order_relaxed);
+    }
+
+private:
+    static_assert(BlockSize >= sizeof(void *), "block must hold a free-list link");
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    struct FreeList
+    {
+        FreeBlock *head = nullptr;
+        size_t count = 0;
+
+        ~FreeList()
+        {
+            while (head)
+            {
+                FreeBlock *next = head->next;
+                ::operator delete(head, std::align_val_t(Align));
+                head = next;
+            }
+            ObjectPoolStats::get().bytes_cached.fetch_sub(count * BlockSize, std::memory_order_relaxed);
+        }
+    };
+
+    static FreeList &local()
+    {
+        thread_local FreeList list;
+        return list;
+    }
+};
+
+/**
+ * @brief 从 BlockPool 分配单个对象的标准分配器
+ *
+ * 配合 std::allocate_shared 使用：shared_ptr 把对象和控制块放在同一块内存里，
+ * 分配器被 rebind 成控制块类型，所以每个对象只需要一个池化块。
+ *   auto session = std::allocate_shared<Session>(PoolAllocator<Session>(), ...);
+ */
+template <typename T>
+struct PoolAllocator
+{
+    using value_type = T;
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) {}
+
+    T *allocate(size_t n)
+    {
+        if (n != 1)
+        {
+            return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        }
+        return static_cast<T *>(BlockPool<sizeof(T), alignof(T)>::allocate());
+    }
+
+    void deallocate(T *pointer, size_t n)
+    {
+        if (n != 1)
+        {
+            ::operator delete(pointer, std::align_val_t(alignof(T)));
+            return;
+        }
+        BlockPool<sizeof(T), alignof(T)>::deallocate(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &) const { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> &) const { return false; }
+};
@@ -0,0 +1,86 @@
+#include "outbound_queue.h"
+#include <algorithm>
+
+void OutboundQueue::push(OutboundFrame frame)
+{
+    pending_bytes_ += frame.size();
+    frames_.push_back(std::move(frame));
+}
+
+/**
+ * 队尾缓冲区还没有交给 async_write 且合并后不超过 COALESCE_LIMIT 时直接追加在它后面，
+ * 否则新开一块；in-flight 的缓冲区和共享帧一律不动，保证正在进行的写操作引用的内存有效
+ */
+char *OutboundQueue::append(size_t size)
+{
+    if (frames_.size() > in_flight_frames_ && !frames_.back().shared &&
+        frames_.back().owned.size() + size <= COALESCE_LIMIT)
+    {
+        auto &tail = frames_.back().owned;
+        size_t offset = tail.size();
+        tail.resize(offset + size);
+        pending_bytes_ += size;
+        return &tail[offset];
+    }
+
+    frames_.emplace_back();
+    auto &chunk = frames_.back().owned;
+    chunk.reserve(std::max(size, MIN_CHUNK_CAPACITY));
+    chunk.resize(size);
+    pending_bytes_ += size;
+    return &chunk[0];
+}
+
+void OutboundQueue::discard_back(size_t size)
+{
+    auto &tail = frames_.back().owned;
+    tail.resize(tail.size() - size);
+    pending_bytes_ -= size;
+    if (tail.empty())
+    {
+        frames_.pop_back();
+    }
+}
+
+const std::vector<asio::const_buffer> &OutboundQueue::prepare_write()
+{
+    buffers_.clear();
+    in_flight_bytes_ = 0;
+    in_flight_frames_ = std::min(frames_.size(), MAX_BUFFERS_PER_WRITE);
+
+    buffers_.reserve(in_flight_frames_);
+    for (size_t i = 0; i < in_flight_frames_; ++i)
+    {
+        const auto &frame = frames_[i];
+        buffers_.emplace_back(frame.data(), frame.size());
+        in_flight_bytes_ += frame.size();
+    }
+    return buffers_;
+}
+
+void OutboundQueue::consume_in_flight()
+{
+    for (size_t i = 0; i < in_flight_frames_; ++i)
+    {
+        frames_.pop_front();
+    }
+    pending_bytes_ -= in_flight_bytes_;
+    in_flight_frames_ = 0;
+    in_flight_bytes_ = 0;
+    buffers_.clear();
+
+    // 队列排空后不保留大批量写留下的 iovec 数组，空闲连接只剩空队列本身
+    if (frames_.empty() && buffers_.capacity() > IDLE_BUFFER_CAPACITY)
+    {
+        std::vector<asio::const_buffer>().swap(buffers_);
+    }
+}
+
+void OutboundQueue::clear()
+{
+    frames_.clear();
+    std::vector<asio::const_buffer>().swap(buffers_);
+    in_flight_frames_ = 0;
+    in_flight_bytes_ = 0;
+    pending_bytes_ = 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#define ASIO_STANDALONE
+#include <asio.hpp>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 编码好的只读帧，广播 / 群消息只序列化一次，所有接收方的出站队列共享同一块内存
+using SharedFrame = std::shared_ptr<const std::string>;
+
+/**
+ * @brief 出站队列里的一块缓冲区：会话独占的 string（可以继续追加帧），或多个会话共享的只读帧
+ */
+struct OutboundFrame
+{
+    std::string owned;
+    SharedFrame shared;
+
+    OutboundFrame() = default;
+    OutboundFrame(std::string frame) : owned(std::move(frame)) {}
+    OutboundFrame(SharedFrame frame) : shared(std::move(frame)) {}
+
+    const char *data() const { return shared ? shared->data() : owned.data(); }
+    size_t size() const { return shared ? shared->size() : owned.size(); }
+};
+
+/**
+ * @brief 会话的出站帧队列
+ *
+ * Session 产生的每个响应帧都追加到队列尾部；写操作空闲时，
+ * 一次性把队首的多个帧收集成 asio::const_buffer 数组，用一次 scatter/gather async_write 发出。
+ *
+ * 线程模型：只能在会话所属的 executor 上访问（Session 负责保证）。
+ * 写操作进行中的帧（in-flight）不会被移动或修改：std::deque 的 push_back 不会使已有元素的引用失效，
+ * 所以可以在写的同时继续追加新帧。
+ *
+ * 队列里的每个元素是一块连续的出站缓冲区，可以容纳多个帧：append() 在队尾未在写的缓冲区后面
+ * 直接预留空间，调用方把帧原地编码进去，同一批次的多个响应合并成一个缓冲区、一个 iovec。
+ * 共享帧（SharedFrame）只持有引用计数，不复制、也不会被追加，写出时直接作为一个 iovec。
+ */
+class OutboundQueue
+{
+public:
+    // 单次 gather 写最多携带的帧数，避免超过系统 IOV_MAX
+    static constexpr size_t MAX_BUFFERS_PER_WRITE = 256;
+
+    // 单块缓冲区合并到该大小后不再继续追加，新开一块
+    static constexpr size_t COALESCE_LIMIT = 64 * 1024;
+    // 新开缓冲区时至少预留的容量，后续小帧追加不必再分配
+    static constexpr size_t MIN_CHUNK_CAPACITY = 4096;
+    // 排空后 iovec 数组超过该容量就释放
+    static constexpr size_t IDLE_BUFFER_CAPACITY = 16;
+
+    // 追加一个已经编码好的帧（独占或共享）
+    void push(OutboundFrame frame);
+
+    /**
+     * @brief 在队尾预留 size 字节并返回可写指针，供调用方原地编码一个帧
+     * 指针在下一次修改队列之前有效；编码失败时用 discard_back(size) 撤销
+     */
+    char *append(size_t size);
+    void discard_back(size_t size);
+
+    /**
+     * @brief 收集待发送的帧，并标记为 in-flight
+     * @return 供 async_write 使用的 buffer 序列，在 consume_in_flight() 之前保持有效
+     */
+    const std::vector<asio::const_buffer> &prepare_write();
+
+    // 写完成后弹出所有 in-flight 帧
+    void consume_in_flight();
+
+    bool empty() const { return frames_.empty(); }
+    bool has_pending() const { return frames_.size() > in_flight_frames_; }
+
+    // 队列中尚未写出的字节数（包括 in-flight 部分）
+    size_t pending_bytes() const { return pending_bytes_; }
+    size_t pending_frames() const { return frames_.size(); }
+
+    void clear();
+
+private:
+    std::deque<OutboundFrame> frames_;
+    std::vector<asio::const_buffer> buffers_;
+    size_t in_flight_frames_ = 0;
+    size_t in_flight_bytes_ = 0;
+    size_t pending_bytes_ = 0;
+};
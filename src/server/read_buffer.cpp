@@ -0,0 +1,66 @@
+#include "read_buffer.h"
+#include "buffer_pool.h"
+#include <cstring>
+
+asio::mutable_buffer ReadBuffer::prepare(size_t min_free)
+{
+    if (!storage_)
+    {
+        size_t capacity = min_free;
+        storage_ = BufferPool::get_instance().acquire(capacity);
+        capacity_ = capacity;
+    }
+    else if (capacity_ - write_pos_ < min_free)
+    {
+        size_t pending = size();
+
+        if (capacity_ - pending >= min_free)
+        {
+            // 头部有足够的已消费空间，把剩余数据搬到开头即可
+            std::memmove(storage_, storage_ + read_pos_, pending);
+        }
+        else
+        {
+            // 容量不足（通常是一个大帧正在到达），按倍数扩容；超过一个 slab 的部分从堆上分配，释放时直接还给系统
+            size_t new_capacity = capacity_ * 2;
+            while (new_capacity - pending < min_free)
+            {
+                new_capacity *= 2;
+            }
+
+            uint8_t *new_storage = BufferPool::get_instance().acquire(new_capacity);
+            std::memcpy(new_storage, storage_ + read_pos_, pending);
+            BufferPool::get_instance().release(storage_, capacity_);
+            storage_ = new_storage;
+            capacity_ = new_capacity;
+        }
+
+        read_pos_ = 0;
+        write_pos_ = pending;
+    }
+
+    return asio::buffer(storage_ + write_pos_, capacity_ - write_pos_);
+}
+
+void ReadBuffer::consume(size_t bytes)
+{
+    read_pos_ += bytes;
+    if (read_pos_ >= write_pos_)
+    {
+        // 全部消费完，直接复位，下次读从头开始，无需搬移
+        read_pos_ = 0;
+        write_pos_ = 0;
+    }
+}
+
+void ReadBuffer::release()
+{
+    if (storage_)
+    {
+        BufferPool::get_instance().release(storage_, capacity_);
+        storage_ = nullptr;
+        capacity_ = 0;
+        read_pos_ = 0;
+        write_pos_ = 0;
+    }
+}
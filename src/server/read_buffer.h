@@ -0,0 +1,66 @@
+#pragma once
+
+#define ASIO_STANDALONE
+#include <asio.hpp>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 会话的接收缓冲区
+ *
+ * 一块连续内存，维护 [read_pos_, write_pos_) 为未消费数据：
+ * - asio 通过 prepare() 直接读进尾部空闲区，不再先读到临时数组再 insert 拷贝
+ * - 处理完一帧只移动 read_pos_（consume），O(1)，不像 vector::erase 每帧 memmove 剩余数据
+ * - 只有在尾部空间不足时才把剩余的半帧数据搬到头部（compact），每个字节最多被搬一次
+ *
+ * 帧解析直接在 data()/size() 视图上进行，帧体不做拷贝。
+ *
+ * 内存来自 BufferPool：构造时不分配，第一次 prepare() 才取一个 slab，数据全部处理完后
+ * 由所有者调用 release_if_empty() 还回去。空闲连接因此不占接收缓冲区，为大帧扩容的内存也随之释放。
+ */
+class ReadBuffer
+{
+public:
+    ReadBuffer() = default;
+    ~ReadBuffer() { release(); }
+
+    ReadBuffer(const ReadBuffer &) = delete;
+    ReadBuffer &operator=(const ReadBuffer &) = delete;
+
+    /**
+     * @brief 确保尾部至少有 min_free 字节可写，还没有缓冲区时从 BufferPool 取
+     * @return 指向尾部可写区域的 buffer，供 async_read_some 使用
+     */
+    asio::mutable_buffer prepare(size_t min_free);
+
+    /**
+     * @brief 没有未消费的数据时把缓冲区还给 BufferPool
+     * 不能在读操作进行中调用（asio 还持有 prepare() 返回的 buffer）
+     */
+    void release_if_empty()
+    {
+        if (empty())
+        {
+            release();
+        }
+    }
+
+    // async_read_some 完成后提交实际读到的字节数
+    void commit(size_t bytes) { write_pos_ += bytes; }
+
+    // 丢弃头部已处理的字节
+    void consume(size_t bytes);
+
+    const uint8_t *data() const { return storage_ + read_pos_; }
+    size_t size() const { return write_pos_ - read_pos_; }
+    bool empty() const { return read_pos_ == write_pos_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    void release();
+
+    uint8_t *storage_ = nullptr;
+    size_t capacity_ = 0;
+    size_t read_pos_ = 0;
+    size_t write_pos_ = 0;
+};
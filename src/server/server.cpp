@@ -1,25 +1,88 @@
 #include "server.h"
 #include "session_manager.h"
+#include "timer_wheel.h"
+#include "buffer_pool.h"
+#include "object_pool.h"
 #include "../router/message_router.h"
 #include "../router/message_handler.h"
 #include "../router/register_handler.h"
 #include "../router/login_handler.h"
+#include "../router/resume_handler.h"
+#include "../router/heartbeat_handler.h"
+#include "../router/capability_handler.h"
+#include "../router/offline_ack_handler.h"
+#include "../protocol/frame_compression.h"
+#include "../router/chat_handler.h"
+#include "../router/group_handler.h"
+#include "../chat/fanout_dispatcher.h"
+#include "../chat/group_manager.h"
+#include "../chat/offline_store.h"
+#include "../cluster/cluster_node.h"
 #include "../database/database_manager.h"
 #include "../user/user_manager.h"
+#include "../user/resume_token.h"
+#include "../executor/blocking_executor.h"
+#include "../logging/log_limiter.h"
+#include "../metrics/metrics_registry.h"
+#include "../metrics/metrics_http_server.h"
 #include <spdlog/spdlog.h>
 #include <iostream>
 #include <algorithm>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+// 编译期选定的网络后端（CMake 选项 IM_IO_URING），启动日志和指标里标出来，方便 A/B 对比
+#if defined(ASIO_HAS_IO_URING_AS_DEFAULT)
+static constexpr const char *NETWORK_BACKEND = "io_uring";
+#else
+static constexpr const char *NETWORK_BACKEND = "epoll";
+#endif
+
+/**
+ * 按 threading_mode 创建 io_context 线程池
+ */
+static std::unique_ptr<IoContextPool> make_io_pool(const Config::ServerConfig &server_config)
+{
+    return std::make_unique<IoContextPool>(
+        IoContextPool::parse_mode(server_config.threading_mode),
+        static_cast<size_t>(std::max(1, server_config.worker_threads)),
+        server_config.cpu_affinity,
+        IoContextPool::parse_balancing(server_config.accept_balancing));
+}
 
 /**
  * Server通过config类创建
- * 初始化event loop负责监听和dispatch
- * 初始化acceptor负责创建新的socket
+ * 初始化event loop（IoContextPool）负责监听和dispatch
+ * acceptor 在 start() 中按 reuse_port 配置创建
  * 初始化running flag为false
  */
 Server::Server(const Config &config)
-    : config_(config), io_context_(), acceptor_(io_context_), running_(false), message_router_(nullptr)
+    : config_(config), io_pool_(make_io_pool(config.get_server_config())), running_(false),
+      admission_(config.get_server_config().max_connections,
+                 config.get_server_config().per_ip_accept_rate,
+                 config.get_server_config().per_ip_accept_burst),
+      message_router_(nullptr)
 {
     spdlog::info("=== Server Constructor ===");
+    session_options_.write_high_water_mark =
+        static_cast<size_t>(std::max(1, config_.get_server_config().write_high_water_mark_bytes));
+    session_options_.compression_codecs = FrameCompression::parse_codecs(config_.get_server_config().compression);
+    session_options_.compression_threshold =
+        static_cast<size_t>(std::max(0, config_.get_server_config().compression_threshold_bytes));
+    create_timer_wheels();
+    fanout_ = std::make_unique<FanoutDispatcher>(*io_pool_);
+    if (config_.get_cluster_config().enabled)
+    {
+        cluster_ = std::make_unique<ClusterNode>(io_pool_->primary_context(), config_.get_cluster_config(), *fanout_);
+    }
+
+    // 拒绝帧只序列化一次，拒绝路径上不再构造 protobuf 对象
+    capacity_reject_frame_ = ProtocolHandler::serialize_frame(
+        ProtocolHandler::create_error_response(3004, "Too many connections, please retry later"));
+    rate_reject_frame_ = ProtocolHandler::serialize_frame(
+        ProtocolHandler::create_error_response(3005, "Connection rate limit exceeded"));
+
     spdlog::info("Calling initialize_message_router()...");
     initialize_message_router();
 
@@ -44,8 +107,8 @@ Server::~Server()
 /**
  * 启动Server
  * 1. 读取server config
- * 2. 把acceptor和端口绑定起来，然后设置为监听端口
- * 3. do_accept
+ * 2. 创建 acceptor（一个，或 reuse_port 时每个 io_context / worker 一个），绑定端口并监听
+ * 3. 每个 acceptor 各自一条 do_accept 链
  * 4. 根据线程数run_worker_threads
  * acceptor在io_context上异步accept->产生socket绑定到同一个io_context->Session使用改socket发起异步读写，所有回调函数由io_context.run()执行
  *
@@ -58,23 +121,44 @@ bool Server::start()
     {
         const auto &server_config = config_.get_server_config();
 
-        // Setup acceptor
-        asio::ip::tcp::endpoint endpoint(
-            asio::ip::address::from_string(server_config.host),
-            server_config.port);
+        open_acceptors();
 
-        acceptor_.open(endpoint.protocol());
-        acceptor_.set_option(asio::ip::tcp::acceptor::reuse_address(true));
-        acceptor_.bind(endpoint);
-        acceptor_.listen();
+        spdlog::info("Server started on {}:{} ({} acceptor(s), backlog {})",
+                     server_config.host, server_config.port, acceptors_.size(), server_config.listen_backlog);
+        spdlog::info("Max connections: {}, Worker threads: {}, Threading mode: {}, Network backend: {}",
+                     server_config.max_connections, server_config.worker_threads,
+                     IoContextPool::mode_to_string(io_pool_->mode()), NETWORK_BACKEND);
+
+        if (blocking_executor_)
+        {
+            blocking_executor_->start();
+        }
+
+        for (auto &wheel : timer_wheels_)
+        {
+            wheel->start();
+        }
+
+        // 在接受客户端连接之前加入集群：在线状态回调要先于第一次登录挂上
+        if (cluster_ && !cluster_->start())
+        {
+            spdlog::error("Failed to start cluster node");
+            return false;
+        }
 
-        spdlog::info("Server started on {}:{}",
-                     server_config.host, server_config.port);
-        spdlog::info("Max connections: {}, Worker threads: {}",
-                     server_config.max_connections, server_config.worker_threads);
+        const auto &metrics_config = config_.get_metrics_config();
+        if (metrics_config.enabled)
+        {
+            register_metrics();
+            metrics_server_ = std::make_unique<MetricsHttpServer>(io_pool_->primary_context(), metrics_config);
+            metrics_server_->start();
+        }
 
         running_ = true;
-        do_accept();
+        for (size_t i = 0; i < acceptors_.size(); ++i)
+        {
+            do_accept(i);
+        }
         run_worker_threads();
 
         return true;
@@ -88,87 +172,406 @@ bool Server::start()
 
 void Server::stop()
 {
-    if (running_)
+    if (running_.exchange(false))
     {
         spdlog::info("Stopping server...");
-        running_ = false;
+        spdlog::info("{}", admission_.get_stats_string());
+        spdlog::info("{}", UserManager::get_instance().get_cache_stats_string());
+
+        // 先停导出端，之后不再有抓取回调访问下面要停止的组件
+        if (metrics_server_)
+        {
+            metrics_server_->stop();
+        }
 
-        acceptor_.close();
-        io_context_.stop();
+        asio::error_code ignored;
+        for (auto &acceptor : acceptors_)
+        {
+            acceptor->close(ignored);
+        }
+
+        for (auto &wheel : timer_wheels_)
+        {
+            wheel->stop();
+        }
+
+        if (cluster_)
+        {
+            cluster_->stop();
+        }
 
         // Wait for all worker threads to finish
-        for (auto &thread : worker_threads_)
+        io_pool_->stop();
+
+        // io 线程全部退出后再关闭剩余会话，避免与回调并发访问 socket
+        SessionManager::get_instance().shutdown_all_sessions();
+
+        if (blocking_executor_)
         {
-            if (thread.joinable())
-            {
-                thread.join();
-            }
+            blocking_executor_->stop();
         }
-        worker_threads_.clear();
+
+        // 阻塞线程池里排队的登录 / 注册可能还在等密码哈希，必须在它之后停止
+        UserManager::get_instance().shutdown();
+
+        // io 线程和登录都已停止，不再有新的离线消息；写完内存日志后退出
+        OfflineMessageStore::get_instance().shutdown();
 
         spdlog::info("Server stopped");
     }
 }
 
+/**
+ * 每个 io_context 一个时间轮，会话挂在它所在 io_context 的时间轮上
+ * shared / strand 模式只有一个 io_context，所有会话共用一个时间轮
+ * idle_timeout_sec <= 0 时不创建，会话不做空闲检测
+ */
+void Server::create_timer_wheels()
+{
+    const auto &server_config = config_.get_server_config();
+    if (server_config.idle_timeout_sec <= 0)
+    {
+        return;
+    }
+
+    auto tick = std::chrono::milliseconds(std::max(1, server_config.timer_wheel_tick_ms));
+    for (size_t i = 0; i < io_pool_->context_count(); ++i)
+    {
+        timer_wheels_.push_back(std::make_unique<TimerWheel>(io_pool_->context(i), tick));
+    }
+
+    const TimerWheel &wheel = *timer_wheels_.front();
+    session_options_.idle_timeout_ticks = wheel.to_ticks(std::chrono::seconds(server_config.idle_timeout_sec));
+    session_options_.heartbeat_ticks = wheel.to_ticks(std::chrono::seconds(std::max(0, server_config.heartbeat_interval_sec)));
+    spdlog::info("Idle timeout {}s, heartbeat {}s ({} timer wheel(s), tick {}ms)",
+                 server_config.idle_timeout_sec, server_config.heartbeat_interval_sec,
+                 timer_wheels_.size(), tick.count());
+}
+
+/**
+ * 创建监听 socket
+ * reuse_port 关闭时只有一个 acceptor，挂在第一个 io_context 上；
+ * 开启时每个 io_context（PER_CORE）或每个 worker 线程（SHARED / STRAND）一个 acceptor，
+ * 全部设置 SO_REUSEPORT 绑定同一端口，内核按四元组哈希把新连接分给其中一个，accept 不再串行经过同一个队列
+ */
+void Server::open_acceptors()
+{
+    const auto &server_config = config_.get_server_config();
+
+    asio::ip::tcp::endpoint endpoint(
+        asio::ip::address::from_string(server_config.host),
+        server_config.port);
+
+    size_t acceptor_count = 1;
+    if (server_config.reuse_port)
+    {
+#ifdef SO_REUSEPORT
+        acceptor_count = io_pool_->mode() == IoContextPool::Mode::PER_CORE
+                             ? io_pool_->context_count()
+                             : io_pool_->thread_count();
+#else
+        spdlog::warn("SO_REUSEPORT is not supported on this platform, using a single acceptor");
+#endif
+    }
+
+    int backlog = server_config.listen_backlog > 0
+                      ? server_config.listen_backlog
+                      : static_cast<int>(asio::socket_base::max_listen_connections);
+
+    acceptors_.clear();
+    for (size_t i = 0; i < acceptor_count; ++i)
+    {
+        auto acceptor = std::make_unique<asio::ip::tcp::acceptor>(
+            io_pool_->context(i % io_pool_->context_count()));
+
+        acceptor->open(endpoint.protocol());
+        acceptor->set_option(asio::ip::tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+        if (acceptor_count > 1)
+        {
+            using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+            acceptor->set_option(reuse_port(true));
+        }
+#endif
+        acceptor->bind(endpoint);
+        acceptor->listen(backlog);
+
+        acceptors_.push_back(std::move(acceptor));
+    }
+}
+
+/**
+ * 设置已接受连接的 socket 选项，只对通过准入控制的连接执行
+ * 各项失败只记录 debug 日志，不影响连接本身
+ */
+void Server::configure_socket(asio::ip::tcp::socket &socket) const
+{
+    const auto &server_config = config_.get_server_config();
+    asio::error_code ec;
+
+    if (server_config.tcp_nodelay)
+    {
+        socket.set_option(asio::ip::tcp::no_delay(true), ec);
+    }
+
+    if (server_config.tcp_keepalive)
+    {
+        socket.set_option(asio::socket_base::keep_alive(true), ec);
+
+        // 默认 2 小时后才开始探测，对移动网络没有意义，这里按配置缩短
+        using keep_idle = asio::detail::socket_option::integer<IPPROTO_TCP, TCP_KEEPIDLE>;
+        using keep_interval = asio::detail::socket_option::integer<IPPROTO_TCP, TCP_KEEPINTVL>;
+        using keep_count = asio::detail::socket_option::integer<IPPROTO_TCP, TCP_KEEPCNT>;
+
+        if (server_config.keepalive_idle_sec > 0)
+        {
+            socket.set_option(keep_idle(server_config.keepalive_idle_sec), ec);
+        }
+        if (server_config.keepalive_interval_sec > 0)
+        {
+            socket.set_option(keep_interval(server_config.keepalive_interval_sec), ec);
+        }
+        if (server_config.keepalive_probes > 0)
+        {
+            socket.set_option(keep_count(server_config.keepalive_probes), ec);
+        }
+    }
+
+    if (ec)
+    {
+        spdlog::debug("Failed to set socket options: {}", ec.message());
+    }
+}
+
 /**
  * 接收新的链接
- * 1. 创建一个Session对象，其内部的socket和某个Eventloop绑定
+ * 1. 由 IoContextPool 为新连接选择 executor（共享 io_context / 新 strand / 某个 per-core io_context）；
+ *    多 acceptor 时连接留在接受它的 io_context 上（assign_to），均衡已经由内核完成
  * 2. 异步调用async_accept，立即返回不会阻塞，如果有新的连接就会调用callback 函数
- * 3. 接受的连接填入new_session->socket_中，回调函数由new_session->start封装。异步循环的意思是，如果没有新的连接，就递归调用自己
+ * 3. 先经过准入控制（admit_connection），被拒绝的 socket 直接关闭，不构造 Session
+ * 4. accept 出来的 socket 已经绑定在选定的 executor 上，用它构造 Session 并 start。异步循环的意思是，如果没有新的连接，就递归调用自己
  * 简称do_accept->session start->异步读写->do_accept
  */
-void Server::do_accept()
+void Server::do_accept(size_t acceptor_index)
 {
-    auto new_session = std::make_shared<Session>(
-        asio::ip::tcp::socket(io_context_), message_router_);
+    auto assignment = acceptors_.size() > 1 ? io_pool_->assign_to(acceptor_index) : io_pool_->assign();
 
-    acceptor_.async_accept(
-        new_session->socket_,
-        [this, new_session](std::error_code ec)
+    acceptors_[acceptor_index]->async_accept(
+        assignment.executor,
+        [this, acceptor_index, context_index = assignment.index, load = std::move(assignment.load)](
+            std::error_code ec, asio::ip::tcp::socket socket)
         {
-            if (!ec)
+            if (!ec && admit_connection(socket))
             {
-                new_session->start();
+                configure_socket(socket);
+
+                // Session 和 shared_ptr 控制块在同一个池化块里，从本线程的空闲链表分配
+                auto new_session = std::allocate_shared<Session>(
+                    PoolAllocator<Session>(), std::move(socket), message_router_, session_options_);
+                new_session->hold_connection_slot();
+                new_session->attach_load_counter(load);
+                new_session->set_io_index(context_index);
+                if (!timer_wheels_.empty())
+                {
+                    new_session->attach_timer_wheel(timer_wheels_[context_index % timer_wheels_.size()].get());
+                }
+
+                // 在会话自己的 executor 上启动，保证之后的回调都在同一个 strand / io_context 上
+                asio::dispatch(new_session->socket_.get_executor(),
+                               [new_session]()
+                               { new_session->start(); });
             }
-            else
+            else if (ec != asio::error::operation_aborted)
             {
-                spdlog::error("Accept failed: {}", ec.message());
+                LOG_RATE_LIMITED(spdlog::level::err, "Accept failed: {}", ec.message());
             }
 
             if (running_)
             {
-                do_accept(); // Continue accepting new connections
+                do_accept(acceptor_index); // Continue accepting new connections
             }
         });
 }
 
 /**
- * 核心函数io_context_.run(),回调函数是由io_context执行的
- * 创建多个worker threads可以并发执行io_context_.run()
+ * 准入检查：成功时已经占用一个连接槽位，由随后构造的 Session 接管
  */
-void Server::run_worker_threads()
+bool Server::admit_connection(asio::ip::tcp::socket &socket)
 {
-    const auto &server_config = config_.get_server_config();
+    asio::error_code ec;
+    auto remote = socket.remote_endpoint(ec);
+    if (ec)
+    {
+        // 对端在 accept 之后立刻断开
+        socket.close(ec);
+        return false;
+    }
 
-    // Create worker threads
-    for (int i = 0; i < server_config.worker_threads; ++i)
+    auto decision = admission_.admit(remote.address());
+    if (decision == AdmissionController::Decision::ACCEPT)
     {
-        worker_threads_.emplace_back([this]()
-                                     {
-            try {
-                io_context_.run();
-            } catch (const std::exception& e) {
-                spdlog::error("Worker thread error: {}", e.what());
-            } });
+        return true;
     }
 
-    spdlog::info("Started {} worker threads", server_config.worker_threads);
+    spdlog::debug("Connection from {} rejected ({})", remote.address().to_string(),
+                  AdmissionController::decision_to_string(decision));
+    reject_connection(socket, decision);
+    return false;
+}
 
-    // Wait for all worker threads
-    for (auto &thread : worker_threads_)
+/**
+ * 拒绝连接：不分配 Session、不进入 io 循环
+ * reject_with_error_frame 为 true 时以非阻塞方式写一次预先序列化好的错误帧（几十字节，必然能进入发送缓冲区），
+ * 然后正常关闭；否则设置 SO_LINGER=0 直接 RST，不占用 TIME_WAIT
+ */
+void Server::reject_connection(asio::ip::tcp::socket &socket, AdmissionController::Decision decision)
+{
+    asio::error_code ignored;
+
+    if (config_.get_server_config().reject_with_error_frame)
+    {
+        const std::string &frame = decision == AdmissionController::Decision::REJECT_RATE
+                                       ? rate_reject_frame_
+                                       : capacity_reject_frame_;
+        socket.non_blocking(true, ignored);
+        socket.write_some(asio::buffer(frame), ignored);
+        socket.shutdown(asio::ip::tcp::socket::shutdown_both, ignored);
+    }
+    else
     {
-        thread.join();
+        socket.set_option(asio::socket_base::linger(true, 0), ignored);
     }
+
+    socket.close(ignored);
+}
+
+/**
+ * 把已有的运行统计注册为 gauge / counter 回调，抓取时直接读原子计数
+ * 回调只捕获单例和 Server 自身的成员，它们都比 metrics_server_ 活得久
+ */
+void Server::register_metrics()
+{
+    auto &registry = MetricsRegistry::get_instance();
+    auto &sessions = SessionManager::get_instance();
+
+    registry.gauge("im_sessions_active", "Sessions currently registered", "",
+                   [&sessions]()
+                   { return static_cast<double>(sessions.get_active_session_count()); });
+    registry.gauge("im_users_online", "Authenticated users currently online", "",
+                   [&sessions]()
+                   { return static_cast<double>(sessions.get_online_user_count()); });
+    registry.gauge("im_connection_slots", "Connection slots held (admitted but not yet closed)", "",
+                   [&sessions]()
+                   { return static_cast<double>(sessions.get_connection_slot_count()); });
+
+    registry.gauge("im_network_backend", "Socket I/O backend the server was built with (always 1)",
+                   MetricsRegistry::label("backend", NETWORK_BACKEND),
+                   []()
+                   { return 1.0; });
+
+    // 每连接内存：Session 对象（含控制块）+ 正在使用的接收缓冲区，除以当前连接数；空闲连接只有前一项
+    auto &buffers = BufferPool::get_instance();
+    auto &objects = ObjectPoolStats::get();
+    registry.gauge("im_read_buffer_slabs", "Read buffer slabs by state", MetricsRegistry::label("state", "in_use"),
+                   [&buffers]()
+                   { return static_cast<double>(buffers.slabs_in_use()); });
+    registry.gauge("im_read_buffer_slabs", "Read buffer slabs by state", MetricsRegistry::label("state", "cached"),
+                   [&buffers]()
+                   { return static_cast<double>(buffers.slabs_cached()); });
+    registry.gauge("im_read_buffer_heap_bytes", "Heap bytes held by read buffers grown past one slab", "",
+                   [&buffers]()
+                   { return static_cast<double>(buffers.heap_bytes()); });
+    registry.gauge("im_session_pool_bytes", "Pooled Session object memory by state", MetricsRegistry::label("state", "in_use"),
+                   [&objects]()
+                   { return static_cast<double>(objects.bytes_in_use.load(std::memory_order_relaxed)); });
+    registry.gauge("im_session_pool_bytes", "Pooled Session object memory by state", MetricsRegistry::label("state", "cached"),
+                   [&objects]()
+                   { return static_cast<double>(objects.bytes_cached.load(std::memory_order_relaxed)); });
+    registry.gauge("im_session_memory_bytes_per_connection",
+                   "Session object plus read buffer bytes per open connection (excludes kernel socket buffers)", "",
+                   [&sessions, &buffers, &objects]()
+                   {
+                       size_t active = sessions.get_active_session_count();
+                       if (active == 0)
+                       {
+                           return 0.0;
+                       }
+                       size_t bytes = objects.bytes_in_use.load(std::memory_order_relaxed) + buffers.bytes_in_use();
+                       return static_cast<double>(bytes) / static_cast<double>(active);
+                   });
+
+    registry.gauge("im_offline_store_pending", "Offline messages waiting in the write-behind log", "",
+                   []()
+                   { return static_cast<double>(OfflineMessageStore::get_instance().pending()); });
+    registry.gauge("im_groups", "Groups currently held in memory", "",
+                   []()
+                   { return static_cast<double>(GroupManager::get_instance().group_count()); });
+
+    registry.counter_callback("im_connections_accepted_total", "Connections admitted", "",
+                              [this]()
+                              { return static_cast<double>(admission_.get_stats().accepted); });
+    registry.counter_callback("im_connections_rejected_total", "Connections rejected by admission control",
+                              MetricsRegistry::label("reason", "capacity"),
+                              [this]()
+                              { return static_cast<double>(admission_.get_stats().rejected_capacity); });
+    registry.counter_callback("im_connections_rejected_total", "Connections rejected by admission control",
+                              MetricsRegistry::label("reason", "rate"),
+                              [this]()
+                              { return static_cast<double>(admission_.get_stats().rejected_rate); });
+
+    auto &database = DatabaseManager::get_instance();
+    registry.gauge("im_db_pool_connections", "Database pool connections", MetricsRegistry::label("state", "idle"),
+                   [&database]()
+                   { return static_cast<double>(database.get_pool_stats().idle); });
+    registry.gauge("im_db_pool_connections", "Database pool connections", MetricsRegistry::label("state", "in_use"),
+                   [&database]()
+                   { return static_cast<double>(database.get_pool_stats().in_use); });
+    registry.gauge("im_db_pool_max_connections", "Database pool size limit", "",
+                   [&database]()
+                   { return static_cast<double>(database.get_pool_stats().max_size); });
+    registry.counter_callback("im_db_pool_borrow_timeouts_total", "Database connection borrows that timed out", "",
+                              [&database]()
+                              { return static_cast<double>(database.get_pool_stats().borrow_timeouts); });
+    registry.counter_callback("im_db_statement_cache_total", "Prepared statement lookups on pooled connections",
+                              MetricsRegistry::label("result", "hit"),
+                              [&database]()
+                              { return static_cast<double>(database.get_pool_stats().statement_cache_hits); });
+    registry.counter_callback("im_db_statement_cache_total", "Prepared statement lookups on pooled connections",
+                              MetricsRegistry::label("result", "miss"),
+                              [&database]()
+                              { return static_cast<double>(database.get_pool_stats().statement_cache_misses); });
+
+    if (blocking_executor_)
+    {
+        blocking_executor_->register_metrics();
+    }
+
+    if (cluster_)
+    {
+        cluster_->register_metrics();
+    }
+
+    for (size_t i = 0; i < timer_wheels_.size(); ++i)
+    {
+        const TimerWheel *wheel = timer_wheels_[i].get();
+        registry.gauge("im_timer_wheel_entries", "Sessions scheduled on the idle timer wheel",
+                       MetricsRegistry::label("wheel", std::to_string(i)),
+                       [wheel]()
+                       { return static_cast<double>(wheel->size()); });
+    }
+}
+
+/**
+ * 核心函数io_context.run(),回调函数是由io_context执行的
+ * IoContextPool 按 threading_mode 创建 worker threads：共享模式下多个线程并发执行同一个 io_context.run()，
+ * per_core 模式下每个线程各自 run 自己的 io_context
+ * 不在这里 join：start() 立即返回，主线程负责等待退出信号后调用 stop()
+ */
+void Server::run_worker_threads()
+{
+    io_pool_->run();
+
+    spdlog::info("Started {} worker threads", io_pool_->thread_count());
 }
 
 /**
@@ -198,6 +601,16 @@ void Server::initialize_message_router()
         }
         spdlog::info("MessageRouter instance created successfully");
 
+        // 创建阻塞任务线程池，登录/注册等处理器在这里执行
+        const auto &server_config = config_.get_server_config();
+        blocking_executor_ = std::make_unique<BlockingExecutor>(
+            "blocking",
+            static_cast<size_t>(std::max(1, server_config.blocking_threads)),
+            static_cast<size_t>(std::max(0, server_config.blocking_queue_limit)));
+        message_router_->set_blocking_executor(blocking_executor_.get());
+        message_router_->set_request_timeout(
+            std::chrono::milliseconds(std::max(1, server_config.request_timeout_ms)));
+
         // 注册默认处理器
         spdlog::info("Creating EchoHandler instance...");
         auto echo_handler = std::make_shared<EchoHandler>();
@@ -210,22 +623,37 @@ void Server::initialize_message_router()
         spdlog::info("EchoHandler instance created successfully");
 
         spdlog::info("Registering EchoHandler with MessageRouter...");
-        message_router_->register_handler(MessageRouter::MessageType::ECHO_REQUEST, echo_handler);
+        message_router_->register_handler(Packet::kEchoRequest, echo_handler);
+
+        // 心跳不依赖数据库，和 Echo 一样在 io 线程上同步处理
+        message_router_->register_handler(Packet::kPing, std::make_shared<PingHandler>());
+        message_router_->register_handler(Packet::kPong, std::make_shared<PongHandler>());
+
+        // 能力协商（帧压缩），只改会话自身的状态，在 io 线程上同步处理
+        message_router_->register_handler(Packet::kCapabilityRequest, std::make_shared<CapabilityHandler>());
 
         // 初始化数据库连接
         spdlog::info("Initializing database connection...");
-        if (!DatabaseManager::get_instance().initialize()) {
+        if (!DatabaseManager::get_instance().initialize(config_.get_database_config())) {
             spdlog::error("Failed to initialize database connection");
             return;
         }
         
         // 初始化用户管理器
         spdlog::info("Initializing UserManager...");
-        if (!UserManager::get_instance().initialize()) {
+        if (!UserManager::get_instance().initialize(config_.get_user_cache_config(),
+                                                      config_.get_password_config())) {
             spdlog::error("Failed to initialize UserManager");
             return;
         }
 
+        // 离线消息存储：ChatHandler 追加，后台线程组提交，登录 / 会话恢复成功后分页投递
+        spdlog::info("Initializing OfflineMessageStore...");
+        if (!OfflineMessageStore::get_instance().initialize(config_.get_offline_store_config())) {
+            spdlog::error("Failed to initialize OfflineMessageStore");
+            return;
+        }
+
         // 创建并注册用户注册处理器
         spdlog::info("Creating RegisterHandler instance...");
         auto register_handler = std::make_shared<RegisterHandler>();
@@ -234,7 +662,7 @@ void Server::initialize_message_router()
             return;
         }
         spdlog::info("Registering RegisterHandler with MessageRouter...");
-        message_router_->register_handler(MessageRouter::MessageType::USER_REGISTER, register_handler);
+        message_router_->register_handler(Packet::kRegisterRequest, register_handler);
 
         // 创建并注册用户登录处理器
         spdlog::info("Creating LoginHandler instance...");
@@ -244,7 +672,32 @@ void Server::initialize_message_router()
             return;
         }
         spdlog::info("Registering LoginHandler with MessageRouter...");
-        message_router_->register_handler(MessageRouter::MessageType::USER_LOGIN, login_handler);
+        message_router_->register_handler(Packet::kLoginRequest, login_handler);
+
+        // 离线消息确认：协商了 offline_ack 的客户端确认后才删除
+        spdlog::info("Registering OfflineAckHandler with MessageRouter...");
+        message_router_->register_handler(Packet::kOfflineAck, std::make_shared<OfflineAckHandler>());
+
+        // 会话恢复令牌与处理器
+        spdlog::info("Initializing ResumeTokenService...");
+        if (!ResumeTokenService::get_instance().initialize(config_.get_auth_config())) {
+            spdlog::error("Failed to initialize ResumeTokenService");
+            return;
+        }
+        spdlog::info("Registering ResumeHandler with MessageRouter...");
+        message_router_->register_handler(Packet::kResumeRequest, std::make_shared<ResumeHandler>());
+
+        // 点对点聊天：按 user_id 索引查找接收方会话，在发送方 io 线程上同步投递；集群模式下转发给其他节点
+        spdlog::info("Registering ChatHandler with MessageRouter...");
+        message_router_->register_handler(Packet::kChatMessage, std::make_shared<ChatHandler>(cluster_.get()));
+
+        // 群组：同一个处理器负责群管理和群消息，群消息只编码一次，经 FanoutDispatcher 分批投递
+        spdlog::info("Registering GroupHandler with MessageRouter...");
+        auto group_handler = std::make_shared<GroupHandler>(*fanout_, cluster_.get());
+        message_router_->register_handler(Packet::kCreateGroupRequest, group_handler);
+        message_router_->register_handler(Packet::kJoinGroupRequest, group_handler);
+        message_router_->register_handler(Packet::kLeaveGroupRequest, group_handler);
+        message_router_->register_handler(Packet::kGroupMessage, group_handler);
 
         spdlog::info("MessageRouter initialized successfully with {} handlers",
                      message_router_->get_handler_count());
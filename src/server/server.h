@@ -5,11 +5,19 @@
 #include <memory>
 #include <thread>
 #include <vector>
+#include <atomic>
 #include "session.h"
+#include "io_context_pool.h"
+#include "admission_controller.h"
 #include "../config/config.h"
 
 // Forward declarations
 class MessageRouter;
+class BlockingExecutor;
+class MetricsHttpServer;
+class TimerWheel;
+class FanoutDispatcher;
+class ClusterNode;
 
 class Server {
 public:
@@ -20,16 +28,44 @@ public:
     void stop();
 
 private:
-    void do_accept();
+    void create_timer_wheels();
+    void open_acceptors();
+    void do_accept(size_t acceptor_index);
+    void configure_socket(asio::ip::tcp::socket &socket) const;
+    bool admit_connection(asio::ip::tcp::socket &socket);
+    void reject_connection(asio::ip::tcp::socket &socket, AdmissionController::Decision decision);
     void run_worker_threads();
     void initialize_message_router();
+    void register_metrics();
 
     const Config& config_;
-    asio::io_context io_context_;
-    asio::ip::tcp::acceptor acceptor_;
-    std::vector<std::thread> worker_threads_;
-    bool running_;
+
+    // worker 线程与 io_context，按 threading_mode 组织；必须在 acceptors_ 之前构造、之后析构
+    std::unique_ptr<IoContextPool> io_pool_;
+    // 每个 io_context 一个时间轮（心跳 / 空闲超时）；声明在 io_pool_ 之后，保证先于 io_context 析构
+    std::vector<std::unique_ptr<TimerWheel>> timer_wheels_;
+    // 群消息 / 广播的扇出：按接收方所在 io_context 分批投递共享帧
+    std::unique_ptr<FanoutDispatcher> fanout_;
+    // 集群模式：在线目录 + 节点间连接，挂在第一个 io_context 上；未启用时为空
+    std::unique_ptr<ClusterNode> cluster_;
+    // 默认只有一个 acceptor；reuse_port 时每个 io_context / worker 线程一个，由内核在它们之间分配新连接
+    std::vector<std::unique_ptr<asio::ip::tcp::acceptor>> acceptors_;
+    std::atomic<bool> running_;
     
+    // 所有会话共享的运行参数
+    SessionOptions session_options_;
+
+    // 准入控制（max_connections + 按 IP 限速），以及拒绝时发送的预序列化错误帧
+    AdmissionController admission_;
+    std::string capacity_reject_frame_;
+    std::string rate_reject_frame_;
+
     // Message routing system
     std::shared_ptr<MessageRouter> message_router_;
+
+    // 承载 DB / crypt 等阻塞调用的线程池，与 io worker 线程隔离
+    std::unique_ptr<BlockingExecutor> blocking_executor_;
+
+    // Prometheus 抓取端点，挂在第一个 io_context 上；未启用时为空
+    std::unique_ptr<MetricsHttpServer> metrics_server_;
 };
\ No newline at end of file
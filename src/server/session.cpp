@@ -1,15 +1,90 @@
 #include "session.h"
 #include "session_manager.h"
+#include "timer_wheel.h"
 #include "../router/message_router.h"
+#include "../protocol/packet_arena.h"
+#include "../protocol/frame_compression.h"
+#include "../logging/log_limiter.h"
+#include "../metrics/metrics_registry.h"
 #include <iostream>
 #include <algorithm>
 
+namespace
+{
+
+/**
+ * 空闲连接的读法
+ * epoll 后端：零字节读（async_wait 等可读 + 非阻塞 read_some），本来就是"就绪通知 + 一次 recv"，
+ * 只是把取缓冲区推迟到数据真正到达，空闲连接不占 slab。
+ * io_uring 后端：同样的写法会变成一次 poll 提交再加一次同步 recv 系统调用，抵消了 io_uring 一次提交完成读的好处，
+ * 所以直接用 async_read_some 读进从 BufferPool 借来的 slab：每个空闲连接在等待时持有一个 slab（16KB）。
+ */
+#if defined(ASIO_HAS_IO_URING_AS_DEFAULT)
+constexpr bool ZERO_BYTE_READS = false;
+#else
+constexpr bool ZERO_BYTE_READS = true;
+#endif
+
+// 当前线程正在 process_frame_buffer() 中处理的会话：此时一定在它的 executor 上，send_packet 可以直接写出站队列
+thread_local const Session *t_processing_session = nullptr;
+
+class ProcessingScope
+{
+public:
+    explicit ProcessingScope(const Session *session) : previous_(t_processing_session)
+    {
+        t_processing_session = session;
+    }
+    ~ProcessingScope() { t_processing_session = previous_; }
+
+private:
+    const Session *previous_;
+};
+
+// 所有会话共享的计数器：按会话打标签会让序列数随连接数增长，这里只统计全局总量
+struct SessionMetrics
+{
+    Counter &bytes_received;
+    Counter &bytes_sent;
+    Counter &header_errors;
+    Counter &payload_errors;
+    Counter &idle_closed;
+    Counter &pings_sent;
+    Counter &frames_compressed;
+    Counter &compressed_saved_bytes;
+    Counter &frames_decompressed;
+    Counter &frames_dropped;
+
+    static SessionMetrics &get()
+    {
+        static SessionMetrics metrics{
+            MetricsRegistry::get_instance().counter("im_session_bytes_received_total", "Bytes read from client sockets"),
+            MetricsRegistry::get_instance().counter("im_session_bytes_sent_total", "Bytes written to client sockets"),
+            MetricsRegistry::get_instance().counter("im_frame_parse_errors_total", "Frames that could not be parsed",
+                                                    MetricsRegistry::label("reason", "header")),
+            MetricsRegistry::get_instance().counter("im_frame_parse_errors_total", "Frames that could not be parsed",
+                                                    MetricsRegistry::label("reason", "payload")),
+            MetricsRegistry::get_instance().counter("im_sessions_idle_closed_total", "Sessions closed by the idle timeout"),
+            MetricsRegistry::get_instance().counter("im_heartbeat_pings_sent_total", "Pings sent to quiet connections"),
+            MetricsRegistry::get_instance().counter("im_frames_compressed_total", "Outbound frames sent compressed"),
+            MetricsRegistry::get_instance().counter("im_compression_saved_bytes_total",
+                                                    "Bytes saved by compressing outbound frames"),
+            MetricsRegistry::get_instance().counter("im_frames_decompressed_total", "Compressed frames received"),
+            MetricsRegistry::get_instance().counter("im_session_frames_dropped_total",
+                                                    "Pushed frames dropped because the recipient's backlog hit the hard limit")};
+        return metrics;
+    }
+};
+
+} // namespace
+
 /**
  * Session持有socker并封装连接socket上所有事件的异步读写逻辑（callback函数）
  * 拥有一个socket_对象，封装对单个客户端的异步读写
  */
-Session::Session(asio::ip::tcp::socket socket, std::shared_ptr<MessageRouter> router)
-    : socket_(std::move(socket)), message_router_(router)
+Session::Session(asio::ip::tcp::socket socket, std::shared_ptr<MessageRouter> router,
+                 const SessionOptions &options)
+    : socket_(std::move(socket)), options_(options), message_router_(router)
 {
     if (!message_router_)
     {
@@ -23,26 +98,31 @@ Session::Session(asio::ip::tcp::socket socket, std::shared_ptr<MessageRouter> ro
     }
 }
 
+/**
+ * 注销在 close() 中完成：析构函数里 shared_from_this() 已经失效，
+ * 而 SessionManager 持有 shared_ptr，不先注销的话析构函数根本不会被调用
+ */
 Session::~Session()
 {
-    try
+    if (load_counter_)
     {
-        // 从SessionManager中注销
-        SessionManager::get_instance().unregister_session(shared_from_this());
-
-        if (socket_.is_open())
-        {
-            spdlog::info("Session destroyed for client: {}",
-                         socket_.remote_endpoint().address().to_string());
-        }
-        else
-        {
-            spdlog::info("Session destroyed (socket already closed)");
-        }
+        load_counter_->fetch_sub(1, std::memory_order_relaxed);
     }
-    catch (const std::exception &e)
+    if (holds_connection_slot_)
     {
-        spdlog::warn("Exception in Session destructor: {}", e.what());
+        SessionManager::get_instance().release_connection_slot();
+    }
+
+    // 每个连接一条，只在 debug 级别输出；close() 之后 socket 已关闭，不再查询对端地址
+    spdlog::debug("Session destroyed (user_id={})", user_id_.load());
+}
+
+void Session::attach_load_counter(std::shared_ptr<std::atomic<size_t>> counter)
+{
+    load_counter_ = std::move(counter);
+    if (load_counter_)
+    {
+        load_counter_->fetch_add(1, std::memory_order_relaxed);
     }
 }
 
@@ -55,14 +135,29 @@ void Session::start()
 {
     try
     {
-        auto remote_endpoint = socket_.remote_endpoint();
-        spdlog::info("New client connected: {}:{}",
-                     remote_endpoint.address().to_string(),
-                     remote_endpoint.port());
+        // 连接级日志限流；对端地址只在真正输出时才查询
+        LOG_RATE_LIMITED(spdlog::level::info, "New client connected: {}:{}",
+                         socket_.remote_endpoint().address().to_string(),
+                         socket_.remote_endpoint().port());
+
+        // 零字节读：可读事件之后用同步 read_some 取数据，socket 必须是非阻塞的
+        if (ZERO_BYTE_READS)
+        {
+            socket_.non_blocking(true);
+        }
 
         // 注册到SessionManager
         SessionManager::get_instance().register_session(shared_from_this());
 
+        if (timer_wheel_ && options_.idle_timeout_ticks > 0)
+        {
+            last_activity_tick_.store(timer_wheel_->now(), std::memory_order_relaxed);
+            uint64_t first_check = options_.heartbeat_ticks > 0
+                                       ? std::min(options_.heartbeat_ticks, options_.idle_timeout_ticks)
+                                       : options_.idle_timeout_ticks;
+            timer_wheel_->schedule(shared_from_this(), first_check);
+        }
+
         do_read();
     }
     catch (const std::exception &e)
@@ -72,108 +167,402 @@ void Session::start()
 }
 
 /**
- * 流程：创建一个自己的副本传到lambda中->调用async_read_some->读到的数据在buffer中->handle_message(message)->把Echo写到write_buffer中等待do_write的时候发出去
- * 简称：do_read->handle_message->do_write->do_read
+ * 读写是全双工的两个独立循环：
+ * - 读循环：do_read->process_frame_buffer(处理缓冲区里所有完整帧)->do_read，任何时刻最多一个 async_read_some
+ * - 写循环：write_packet_in_place / drain_inbox->do_write->(队列非空)do_write，任何时刻最多一个 async_write
+ * 写完成不会再发起读，读也不等待响应写完，客户端可以用 Packet.sequence 连续发送多个请求（pipelining），
+ * 响应在写循环中批量发出。唯一的耦合是背压：出站队列超过高水位时读循环暂停，回落后由写循环恢复。
+ *
+ * 流程：创建一个自己的副本传到lambda中->调用async_read_some->读到的数据在buffer中->process_frame_buffer->handler把响应放进出站队列
+ * 简称：do_read->process_frame_buffer->do_read
  * shared_from_this生成一个std::shared_ptr<Session>并持有当前对象的共享所有权，然后在后面的异步回调里把 self 捕获（按值），以保证在回调执行期间 Session 对象不会被销毁。它是防止异步回调中使用悬空 this 导致未定义行为的常见手法。
  * 异步操作（像 socket_.async_read_some(...)）的回调会在未来某个时刻由 io_context 调用（也即注册）若在这期间 Session 被外部释放（shared_ptr 引用计数降为 0），this 会变成悬空指针，回调里访问成员会产生未定义行为。
  * 通过在进入异步调用前做 auto self = shared_from_this();，并把 self 捕获到 lambda 中，能延长 Session 的生存期直到 lambda 完成，从而避免悬空。
  * ession 必须继承自 std::enable_shared_from_this<Session>，且该 Session 对象必须是由 std::shared_ptr 管理（例如 std::make_shared<Session>(...)）。
- * async_read_some(asio::buffer对象，我在 data_ 地址处有 data_.size() 字节的可写空间，请把读到的数据写到这里)
- * handler 会通过 socket 的 executor 调度（通常是 io_context 的 executor）。因此，执行 handler 的是调用 io_context.run() 的线程之一
+ * async_read_some(asio::buffer对象，我在 read_buffer_ 尾部有至少 READ_CHUNK_SIZE 字节的可写空间，请把读到的数据写到这里)
+ * handler 会通过 socket 的 executor 调度：strand 模式（以及多线程的 shared 模式）下经由本会话的 strand 串行执行，
+ * per_core 模式下固定在会话所属 io_context 的那个线程上。读完成、写完成、drain_inbox 可能交错，但不会并发，
+ * 所以 outbound_、writing_、read_paused_ 不加锁。执行 handler 的是调用 io_context.run() 的线程之一
  * 因此，若你没有调用任何 io_context.run()，异步操作完成后 handler 不会被执行
  */
 void Session::do_read()
 {
+    if (reading_ || read_paused_ || closed_)
+    {
+        // 已有读操作在进行，或因背压暂停（由 do_write 恢复），或会话已关闭
+        return;
+    }
+
+    reading_ = true;
     auto self(shared_from_this());
+
+    if (ZERO_BYTE_READS && read_buffer_.empty())
+    {
+        // 没有半帧数据：零字节读，只等可读事件，不占用接收缓冲区；数据到了再从 BufferPool 取 slab
+        socket_.async_wait(
+            asio::ip::tcp::socket::wait_read,
+            [this, self](std::error_code ec)
+            {
+                reading_ = false;
+                if (ec)
+                {
+                    on_read_error(ec);
+                    return;
+                }
+                read_available();
+            });
+        return;
+    }
+
+    // 缓冲区里有半帧（io_uring 后端下也包括空闲等待）：asio 直接读进接收缓冲区尾部的空闲区
     socket_.async_read_some(
-        asio::buffer(data_, data_.size()),
+        read_buffer_.prepare(READ_CHUNK_SIZE),
         [this, self](std::error_code ec, std::size_t length)
         {
-            if (!ec)
-            {
-                // Append received data to read buffer
-                read_buffer_.insert(read_buffer_.end(), data_.begin(), data_.begin() + length);
-
-                spdlog::debug("Received {} bytes, buffer size: {}", length, read_buffer_.size());
-
-                // Process any complete frames in the buffer
-                process_frame_buffer();
-            }
-            else
+            reading_ = false;
+            if (ec)
             {
-                spdlog::info("Client disconnected: {}", ec.message());
+                on_read_error(ec);
+                return;
             }
+            on_bytes_read(length);
         });
 }
 
 /**
- * 流程：创建Session的副本->调用async_write->发出buffer中的数据->继续异步读开始下一轮（不然只有一轮）
- * 简称：do_write->do_read
- * start->do_read->do_write->do_read
- * 封装异步写，和do_read类似，需要一块写Buffer
+ * 可读事件之后同步读一次（socket 是非阻塞的）；被别的线程抢先读走或虚假唤醒时还回缓冲区继续等
+ */
+void Session::read_available()
+{
+    asio::error_code ec;
+    size_t length = socket_.read_some(read_buffer_.prepare(READ_CHUNK_SIZE), ec);
+    if (ec == asio::error::would_block || ec == asio::error::try_again)
+    {
+        read_buffer_.release_if_empty();
+        do_read();
+        return;
+    }
+    if (ec)
+    {
+        read_buffer_.release_if_empty();
+        on_read_error(ec);
+        return;
+    }
+    on_bytes_read(length);
+}
+
+void Session::on_bytes_read(size_t length)
+{
+    // Commit received data to read buffer
+    read_buffer_.commit(length);
+    SessionMetrics::get().bytes_received.add(length);
+    if (timer_wheel_)
+    {
+        last_activity_tick_.store(timer_wheel_->now(), std::memory_order_relaxed);
+    }
+
+    spdlog::debug("Received {} bytes, buffer size: {}", length, read_buffer_.size());
+
+    // Process any complete frames in the buffer, then keep reading
+    // 全部处理完时把 slab 还给 BufferPool，空闲连接不持有接收缓冲区
+    process_frame_buffer();
+    read_buffer_.release_if_empty();
+    do_read();
+}
+
+void Session::on_read_error(const std::error_code &ec)
+{
+    if (ec != asio::error::operation_aborted)
+    {
+        LOG_RATE_LIMITED(spdlog::level::info, "Client disconnected: {}", ec.message());
+    }
+    close();
+}
+
+/**
+ * 流程：创建Session的副本->把出站队列中所有待发帧收集成buffer序列->一次gather async_write->
+ * 写完后如果队列里又有新帧就继续写，否则写操作进入空闲
+ * 简称：drain_inbox->do_write->(队列非空)do_write
+ * 同一时刻最多只有一个 async_write 在进行，避免多个响应交错写入同一个socket
  * 第一个参数是socket，因为是写到一个指定的socket连接上
  */
 void Session::do_write()
 {
+    writing_ = true;
     auto self(shared_from_this());
     asio::async_write(
         socket_,
-        asio::buffer(write_buffer_),
-        [this, self](std::error_code ec, std::size_t /*length*/)
+        outbound_.prepare_write(),
+        [this, self](std::error_code ec, std::size_t length)
         {
-            if (!ec)
+            outbound_.consume_in_flight();
+            outbound_bytes_.store(outbound_.pending_bytes(), std::memory_order_relaxed);
+            SessionMetrics::get().bytes_sent.add(length);
+
+            if (ec)
+            {
+                if (ec != asio::error::operation_aborted)
+                {
+                    spdlog::error("Write failed: {}", ec.message());
+                }
+                writing_ = false;
+                close();
+                return;
+            }
+
+            if (!outbound_.empty() && !closed_)
             {
-                write_buffer_.clear();
-                do_read(); // Continue reading after write
+                do_write();
             }
             else
             {
-                spdlog::error("Write failed: {}", ec.message());
+                writing_ = false;
+            }
+
+            // 积压回落到高水位一半以下时恢复读循环
+            if (read_paused_ && outbound_.pending_bytes() <= options_.write_high_water_mark / 2)
+            {
+                spdlog::debug("Outbound queue drained to {} bytes, resuming reads", outbound_.pending_bytes());
+                read_paused_ = false;
+                do_read();
             }
         });
 }
 
+void Session::check_high_water_mark()
+{
+    outbound_bytes_.store(outbound_.pending_bytes(), std::memory_order_relaxed);
+    if (!read_paused_ && outbound_.pending_bytes() > options_.write_high_water_mark)
+    {
+        LOG_RATE_LIMITED(spdlog::level::warn, "Outbound queue {} bytes exceeds high water mark {}, pausing reads",
+                         outbound_.pending_bytes(), options_.write_high_water_mark);
+        read_paused_ = true;
+    }
+}
+
+/**
+ * 在 executor 上把 Packet 直接编码进出站队列尾部：ByteSizeLong() 预留空间，长度头和数据原地写入，
+ * 没有中间 string。写操作留到 process_frame_buffer() 结束时统一发起，同一批请求的响应合并成一次写
+ */
+void Session::write_packet_in_place(const Packet &packet)
+{
+    if (closed_)
+    {
+        return;
+    }
+
+    size_t frame_size = ProtocolHandler::prepare_frame(packet);
+    if (frame_size == 0)
+    {
+        spdlog::error("Failed to serialize packet");
+        return;
+    }
+
+    size_t body_size = frame_size - 4;
+    if (compression() != FrameCompression::NONE && body_size >= options_.compression_threshold &&
+        write_compressed_in_place(packet, body_size))
+    {
+        check_high_water_mark();
+        return;
+    }
+
+    char *dst = outbound_.append(frame_size);
+    if (!ProtocolHandler::write_frame(packet, reinterpret_cast<uint8_t *>(dst), frame_size))
+    {
+        outbound_.discard_back(frame_size);
+        spdlog::error("Failed to serialize packet");
+        return;
+    }
+    check_high_water_mark();
+}
+
+/**
+ * 大帧压缩后写入出站队列：帧体先编码到本线程的暂存区，再按 LZ4 最坏情况在队列尾部预留空间、
+ * 压缩结果直接写进去，多出的部分退回。压缩不划算时返回 false，由调用方写普通帧
+ */
+bool Session::write_compressed_in_place(const Packet &packet, size_t body_size)
+{
+    thread_local std::vector<uint8_t> body;
+    body.resize(body_size);
+    packet.SerializeWithCachedSizesToArray(body.data());
+
+    size_t capacity = FrameCompression::max_compressed_frame_size(body_size);
+    char *dst = outbound_.append(capacity);
+    size_t written = FrameCompression::compress_frame(body.data(), body_size, reinterpret_cast<uint8_t *>(dst), capacity);
+    if (written == 0)
+    {
+        outbound_.discard_back(capacity);
+        return false;
+    }
+    outbound_.discard_back(capacity - written);
+
+    auto &metrics = SessionMetrics::get();
+    metrics.frames_compressed.add();
+    metrics.compressed_saved_bytes.add(body_size + 4 - written);
+    return true;
+}
+
+uint32_t Session::select_compression(uint32_t client_codecs) const
+{
+    return FrameCompression::choose(client_codecs, options_.compression_codecs);
+}
+
 /**
  * Process complete frames from read buffer
+ * 一次读可能带来多个流水线请求，这里把缓冲区中的完整帧全部处理完；读循环的续读由 do_read 负责
  */
 void Session::process_frame_buffer()
 {
-    while (true)
+    ProcessingScope processing(this);
+
+    while (!closed_)
     {
-        ProtocolHandler::Frame frame;
+        // frame 只是指向 read_buffer_ 内部的视图，必须在 consume 之前完成反序列化
+        ProtocolHandler::FrameView frame;
         size_t consumed_bytes;
 
-        if (!ProtocolHandler::parse_frame(read_buffer_, frame, consumed_bytes))
+        if (!ProtocolHandler::parse_frame(read_buffer_.data(), read_buffer_.size(), frame, consumed_bytes))
         {
+            if (consumed_bytes > 0)
+            {
+                // 长度头非法，后续字节已无法重新对齐帧边界，只能断开连接
+                LOG_RATE_LIMITED(spdlog::level::warn, "Invalid frame header, closing session");
+                SessionMetrics::get().header_errors.add();
+                close();
+            }
             // No complete frame available
             break;
         }
 
-        // Remove consumed bytes from buffer
-        read_buffer_.erase(read_buffer_.begin(), read_buffer_.begin() + consumed_bytes);
-
         if (consumed_bytes > 4)
         { // Valid frame found
-            spdlog::info("Received frame with {} bytes of data", frame.length);
+            spdlog::debug("Received frame with {} bytes of data", frame.length);
+
+            // 请求和响应都分配在本线程的 arena 上，这一帧处理完（响应已序列化进出站队列）后整体重置
+            PacketArena::Scope arena_scope;
+
+            // Deserialize protobuf packet straight from the receive buffer
+            // 压缩帧先解压到本线程的缓冲区；只有协商过压缩的连接才接受压缩帧
+            const uint8_t *body = frame.data;
+            size_t body_size = frame.length;
+            bool parsed = true;
+            if (frame.compressed)
+            {
+                parsed = compression() != FrameCompression::NONE &&
+                         FrameCompression::decompress_body(frame.data, frame.length, body, body_size);
+                if (parsed)
+                {
+                    SessionMetrics::get().frames_decompressed.add();
+                }
+            }
 
-            // Deserialize protobuf packet
-            Packet packet;
-            if (ProtocolHandler::deserialize_frame(frame.data, packet))
+            Packet *packet = arena_scope.new_packet();
+            parsed = parsed && ProtocolHandler::deserialize_frame(body, body_size, *packet);
+
+            // Remove consumed bytes from buffer (O(1), only moves the read offset)
+            read_buffer_.consume(consumed_bytes);
+
+            if (parsed)
             {
-                handle_packet(packet);
+                handle_packet(*packet);
             }
             else
             {
-                spdlog::error("Failed to deserialize packet");
+                LOG_RATE_LIMITED(spdlog::level::err, "Failed to deserialize packet");
+                SessionMetrics::get().payload_errors.add();
                 // Send error response
-                auto error_packet = ProtocolHandler::create_error_response(1001, "Invalid packet format");
-                send_packet(error_packet);
+                send_packet(*ProtocolHandler::create_error_response(arena_scope.arena(), 1001, "Invalid packet format"));
             }
         }
+        else
+        {
+            read_buffer_.consume(consumed_bytes);
+        }
     }
 
-    // Continue reading
-    do_read();
+    // 本批次处理器同步产生的响应都已编码进出站队列，一次写发出
+    if (!writing_ && !closed_ && !outbound_.empty())
+    {
+        do_write();
+    }
+}
+
+/**
+ * 关闭会话，可以重复调用
+ * 关闭socket会让挂起的读写以 operation_aborted 完成，回调释放 self 后 Session 析构
+ */
+void Session::close()
+{
+    if (closed_)
+    {
+        return;
+    }
+    closed_ = true;
+    read_paused_ = false;
+
+    asio::error_code ignored;
+    socket_.shutdown(asio::ip::tcp::socket::shutdown_both, ignored);
+    socket_.close(ignored);
+
+    if (!writing_)
+    {
+        outbound_.clear();
+    }
+
+    auto &manager = SessionManager::get_instance();
+    if (authenticated_)
+    {
+        manager.unbind_user(user_id_, this);
+    }
+    manager.unregister_session(shared_from_this());
+}
+
+/**
+ * 空闲检测，由时间轮在刻度回调中调用
+ * 任何入站数据（包括客户端的 Ping / Pong）都算活跃；只发不收的连接同样会超时。
+ * 每段空闲只发一次 Ping：last_ping_tick_ 晚于最后活跃时间说明这段空闲已经发过了
+ */
+uint64_t Session::check_idle(uint64_t now_tick)
+{
+    if (closed_)
+    {
+        return 0;
+    }
+
+    uint64_t last_activity = last_activity_tick_.load(std::memory_order_relaxed);
+    uint64_t idle = now_tick > last_activity ? now_tick - last_activity : 0;
+
+    if (idle >= options_.idle_timeout_ticks)
+    {
+        LOG_RATE_LIMITED(spdlog::level::info, "Closing idle session (user_id={}, idle {} ticks)",
+                         user_id_.load(), idle);
+        SessionMetrics::get().idle_closed.add();
+        auto self(shared_from_this());
+        asio::dispatch(socket_.get_executor(), [self]()
+                       { self->close(); });
+        return 0;
+    }
+
+    bool ping_pending = options_.heartbeat_ticks > 0 && last_ping_tick_ <= last_activity;
+    if (ping_pending && idle >= options_.heartbeat_ticks)
+    {
+        PacketArena::Scope arena_scope;
+        auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count();
+        send_packet(*ProtocolHandler::create_ping(arena_scope.arena(), now_ms));
+        SessionMetrics::get().pings_sent.add();
+        last_ping_tick_ = now_tick;
+        ping_pending = false;
+    }
+
+    // 下一个要关心的时间点：还没发 Ping 时是心跳时刻（不晚于超时时刻），否则是超时时刻
+    uint64_t next = last_activity + options_.idle_timeout_ticks;
+    if (ping_pending)
+    {
+        next = std::min(next, last_activity + options_.heartbeat_ticks);
+    }
+    return next > now_tick ? next - now_tick : 1;
 }
 
 /**
@@ -191,32 +580,217 @@ void Session::handle_packet(const Packet &packet)
         return;
     }
 
+    if (packet.payload_case() == Packet::kBatch)
+    {
+        // 子包由 MessageRouter 拆开分发，期间同步产生的响应合并成一个 PacketBatch 回复
+        batch_reply_ = ProtocolHandler::create_packet(packet.GetArena(), packet.version(), packet.sequence());
+        batch_reply_->mutable_batch();
+        message_router_->route_message(packet, *this);
+        flush_batch_reply();
+        batch_reply_ = nullptr;
+        return;
+    }
+
     // 委托给MessageRouter处理
-    message_router_->route_message(packet, shared_from_this());
+    message_router_->route_message(packet, *this);
+}
+
+/**
+ * 批次处理中的同步响应：复制进批量回复（同一个 arena，不额外分配堆内存），攒够 BATCH_REPLY_FLUSH_BYTES
+ * 或 MAX_BATCH_PACKETS 个就先写出一帧
+ */
+void Session::append_batch_reply(const Packet &packet)
+{
+    batch_reply_bytes_ += packet.ByteSizeLong();
+    auto *batch = batch_reply_->mutable_batch();
+    batch->add_packets()->CopyFrom(packet);
+    if (batch_reply_bytes_ >= BATCH_REPLY_FLUSH_BYTES || batch->packets_size() >= ProtocolHandler::MAX_BATCH_PACKETS)
+    {
+        flush_batch_reply();
+    }
+}
+
+/**
+ * 只有一个响应时按普通包发出，客户端不必为单个回复拆批次
+ */
+void Session::flush_batch_reply()
+{
+    auto *packets = batch_reply_->mutable_batch()->mutable_packets();
+    if (packets->size() == 1)
+    {
+        write_packet_in_place(packets->Get(0));
+    }
+    else if (packets->size() > 1)
+    {
+        write_packet_in_place(*batch_reply_);
+    }
+    packets->Clear();
+    batch_reply_bytes_ = 0;
 }
 
 /**
  * Send protobuf packet to client
+ *
+ * 可以从任意线程调用（例如阻塞线程池中的 LoginHandler、其他会话上的 ChatHandler）：
+ * - 在本会话的帧处理过程中（同步处理器）直接编码进出站队列，零中间拷贝；处理 PacketBatch 时先攒进批量回复
+ * - 其他情况在调用线程编码成一个 string（一次分配），经 send_frame 的无锁收件箱交回 socket 所在的 executor
  */
 void Session::send_packet(const Packet &packet)
 {
-    std::string frame_data = ProtocolHandler::serialize_frame(packet);
-    if (frame_data.empty())
+    if (t_processing_session == this)
+    {
+        if (batch_reply_)
+        {
+            append_batch_reply(packet);
+            return;
+        }
+        write_packet_in_place(packet);
+        return;
+    }
+
+    // 压缩（如果协商过）在调用线程上完成，不占 socket 所在的 io 线程
+    std::string frame_data;
+    bool encoded = compression() != FrameCompression::NONE
+                       ? FrameCompression::serialize_frame_into(packet, options_.compression_threshold, frame_data)
+                       : ProtocolHandler::serialize_frame_into(packet, frame_data);
+    if (!encoded)
     {
         spdlog::error("Failed to serialize packet");
         return;
     }
 
-    write_buffer_ = frame_data;
-    do_write();
+    send_frame(std::move(frame_data));
+}
+
+/**
+ * 高水位只暂停本会话的读，挡不住别的会话推过来的帧；这里给推送帧一个硬上限，
+ * 接收方长期不读时丢弃新帧并返回 false，由调用方决定转离线存储还是报告失败
+ */
+bool Session::send_frame(OutboundFrame frame)
+{
+    if (t_processing_session == this)
+    {
+        // 写操作留到 process_frame_buffer() 结束时统一发起
+        if (closed_)
+        {
+            return false;
+        }
+        if (outbound_.pending_bytes() + frame.size() > outbound_limit())
+        {
+            SessionMetrics::get().frames_dropped.add();
+            return false;
+        }
+        outbound_.push(std::move(frame));
+        check_high_water_mark();
+        return true;
+    }
+
+    if (closed_)
+    {
+        return false;
+    }
+
+    if (!reserve_inbox_bytes(frame.size()))
+    {
+        SessionMetrics::get().frames_dropped.add();
+        LOG_RATE_LIMITED(spdlog::level::warn, "Session (user_id={}) backlog over {} bytes, dropping pushed frame",
+                         user_id_.load(), outbound_limit());
+        return false;
+    }
+
+    // 只有把收件箱从空变为非空的生产者负责唤醒消费者
+    if (inbox_.push(std::move(frame)))
+    {
+        auto self(shared_from_this());
+        asio::post(socket_.get_executor(), [self]()
+                   { self->drain_inbox(); });
+    }
+    return true;
 }
 
+/**
+ * 生产者先预留字节再入队：并发投递时收件箱的总量也不会越过上限
+ */
+bool Session::reserve_inbox_bytes(size_t size)
+{
+    size_t queued = inbox_bytes_.fetch_add(size, std::memory_order_relaxed) + size;
+    if (queued + outbound_bytes_.load(std::memory_order_relaxed) > outbound_limit())
+    {
+        inbox_bytes_.fetch_sub(size, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * 在 socket 的 executor 上把收件箱里的所有帧按投递顺序移入出站队列
+ * 写空闲时立即发起写；写进行中时这些帧会在当前写完成后的下一批一起发出。
+ * 预留之后本会话自己的响应可能又占了出站队列，这里按实际队列长度再检查一次硬上限
+ */
+void Session::drain_inbox()
+{
+    if (closed_)
+    {
+        inbox_.clear();
+        inbox_bytes_.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    size_t dropped = 0;
+    inbox_.consume_all([this, &dropped](OutboundFrame &&frame)
+                       {
+                           inbox_bytes_.fetch_sub(frame.size(), std::memory_order_relaxed);
+                           if (outbound_.pending_bytes() + frame.size() > outbound_limit())
+                           {
+                               ++dropped;
+                               return;
+                           }
+                           outbound_.push(std::move(frame)); });
+    if (dropped > 0)
+    {
+        SessionMetrics::get().frames_dropped.add(dropped);
+        LOG_RATE_LIMITED(spdlog::level::warn, "Session (user_id={}) dropped {} inbox frame(s) over the {} byte limit",
+                         user_id_.load(), dropped, outbound_limit());
+    }
+    check_high_water_mark();
+
+    if (!writing_ && !outbound_.empty())
+    {
+        do_write();
+    }
+}
+
+/**
+ * 登录成功后由 LoginHandler 调用（可能在阻塞线程池中），同时把会话加入 SessionManager 的 user_id 索引
+ * 同一会话切换账号时先从旧用户的索引中移除
+ */
 void Session::set_authenticated_user(int64_t user_id, const std::string &username)
 {
-    authenticated_ = true;
-    user_id_ = user_id;
-    username_ = username;
-    spdlog::info("Session authenticated for user: {} (ID: {})", username, user_id);
+    int64_t previous_user_id = 0;
+    bool was_authenticated;
+    {
+        std::lock_guard<std::mutex> lock(auth_mutex_);
+        was_authenticated = authenticated_;
+        previous_user_id = user_id_;
+        authenticated_ = true;
+        user_id_ = user_id;
+        username_ = username;
+    }
+
+    auto &manager = SessionManager::get_instance();
+    if (was_authenticated && previous_user_id != user_id)
+    {
+        manager.unbind_user(previous_user_id, this);
+    }
+    manager.bind_user(user_id, shared_from_this());
+
+    // 登录期间连接已经断开：close() 可能先于 bind 执行，这里补一次解绑，避免索引中残留
+    if (closed_)
+    {
+        manager.unbind_user(user_id, this);
+    }
+
+    spdlog::debug("Session authenticated for user: {} (ID: {})", username, user_id);
 }
 
 bool Session::is_authenticated() const
@@ -229,7 +803,8 @@ int64_t Session::get_user_id() const
     return user_id_;
 }
 
-const std::string &Session::get_username() const
+std::string Session::get_username() const
 {
+    std::lock_guard<std::mutex> lock(auth_mutex_);
     return username_;
 }
\ No newline at end of file
@@ -5,47 +5,173 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include <atomic>
+#include <mutex>
 #include <cstdint>
 #include <spdlog/spdlog.h>
 #include <messages.pb.h>
 #include "../protocol/protocol_handler.h"
+#include "outbound_queue.h"
+#include "read_buffer.h"
+#include "mpsc_queue.h"
 
 // Forward declarations
 class MessageRouter;
+class TimerWheel;
+
+/**
+ * @brief 每个会话共享的运行参数，由 Server 根据配置构造一次
+ */
+struct SessionOptions
+{
+    // 出站队列高水位（字节），超过后暂停读取，回落到一半以下再恢复；
+    // 暂停读取挡不住其他会话推送的帧，积压达到 OUTBOUND_LIMIT_FACTOR 倍高水位后 send_frame 直接丢弃
+    size_t write_high_water_mark = 4 * 1024 * 1024;
+
+    // 心跳与空闲超时，单位是时间轮刻度，0 表示关闭
+    uint64_t idle_timeout_ticks = 0; // 这么久没有收到任何数据就关闭连接
+    uint64_t heartbeat_ticks = 0;    // 这么久没有收到数据时主动发一次 Ping
+
+    // 帧压缩：服务器允许的编解码器（FrameCompression::Codec 位掩码），以及不压缩的帧体大小下限
+    uint32_t compression_codecs = 0;
+    size_t compression_threshold = 1024;
+};
 
 class Session : public std::enable_shared_from_this<Session>
 {
 public:
-    Session(asio::ip::tcp::socket socket, std::shared_ptr<MessageRouter> router);
+    Session(asio::ip::tcp::socket socket, std::shared_ptr<MessageRouter> router,
+            const SessionOptions &options = SessionOptions());
     ~Session();
 
     void start();
     void send_packet(const Packet &packet);
 
+    /**
+     * @brief 投递一个已经编码好的帧（长度头 + 数据），可以从任意线程调用；共享帧（SharedFrame）只增加引用计数
+     * 在本会话的帧处理中直接进入出站队列；其他线程经无锁收件箱交给会话的 executor，
+     * 收件箱由空变为非空时才投递一次 drain，同一批投递只有一次跨线程唤醒
+     * @return false 表示帧被丢弃：会话已关闭，或收件箱加出站队列的积压超过硬上限（接收方读得太慢）
+     */
+    bool send_frame(OutboundFrame frame);
+
+    // 关闭连接并从 SessionManager 注销，必须在 socket 的 executor 上调用
+    void close();
+
+    // 会话已关闭：之后的 send_packet / send_frame 都会被丢弃，可以在任意线程调用
+    bool is_closed() const { return closed_.load(std::memory_order_acquire); }
+
+    // 绑定所属 io_context 的连接计数，构造后立即调用，析构时自动减一
+    void attach_load_counter(std::shared_ptr<std::atomic<size_t>> counter);
+
+    // 接管准入控制分配的连接槽位，析构时归还给 SessionManager
+    void hold_connection_slot() { holds_connection_slot_ = true; }
+
+    // 会话所在 io_context 的序号（IoContextPool::Assignment::index），扇出时按它分组
+    void set_io_index(size_t index) { io_index_ = index; }
+    size_t io_index() const { return io_index_; }
+
+    // 绑定所属 io_context 的时间轮，start() 之前调用；不绑定时没有空闲超时
+    void attach_timer_wheel(TimerWheel *wheel) { timer_wheel_ = wheel; }
+
+    /**
+     * @brief 时间轮到期时调用（时间轮所在的 io 线程）
+     * 空闲超过 idle_timeout_ticks 时关闭会话，超过 heartbeat_ticks 时发送一次 Ping
+     * @param now_tick 时间轮当前刻度
+     * @return 多少个刻度后再检查，0 表示不再检查（会话已关闭）
+     */
+    uint64_t check_idle(uint64_t now_tick);
+
+    /**
+     * @brief 能力协商（CapabilityHandler）：选出客户端与服务器都支持的压缩编解码器，没有时为 NONE
+     */
+    uint32_t select_compression(uint32_t client_codecs) const;
+
+    // 启用选定的编解码器：之后发出的、帧体不小于阈值的帧被压缩，也开始接受客户端的压缩帧
+    void enable_compression(uint32_t codec) { compression_.store(codec, std::memory_order_relaxed); }
+    uint32_t compression() const { return compression_.load(std::memory_order_relaxed); }
+    size_t compression_threshold() const { return options_.compression_threshold; }
+
+    // 客户端声明会用 OfflineAck 确认离线消息：投递后不删除，收到确认才删除
+    void enable_offline_ack() { offline_ack_.store(true, std::memory_order_relaxed); }
+    bool offline_ack() const { return offline_ack_.load(std::memory_order_relaxed); }
+
     // User authentication methods
     void set_authenticated_user(int64_t user_id, const std::string &username);
     bool is_authenticated() const;
     int64_t get_user_id() const;
-    const std::string &get_username() const;
+    std::string get_username() const;
 
     // Allow Server to access socket for async_accept
     asio::ip::tcp::socket socket_;
 
 private:
     void do_read();
+    void read_available();
+    void on_bytes_read(size_t length);
+    void on_read_error(const std::error_code &ec);
     void do_write();
     void handle_packet(const Packet &packet);
     void process_frame_buffer();
+    void drain_inbox();
+    void write_packet_in_place(const Packet &packet);
+    void append_batch_reply(const Packet &packet);
+    void flush_batch_reply();
+    bool write_compressed_in_place(const Packet &packet, size_t body_size);
+    void check_high_water_mark();
+
+    // 每次读至少预留的空闲空间
+    static constexpr size_t READ_CHUNK_SIZE = 4096;
+    // 批量回复攒到这么大就先写出一帧，远低于 MAX_FRAME_SIZE
+    static constexpr size_t BATCH_REPLY_FLUSH_BYTES = 256 * 1024;
+    // 推送帧的硬上限：收件箱加出站队列超过高水位的这么多倍后，新的推送帧被丢弃
+    static constexpr size_t OUTBOUND_LIMIT_FACTOR = 2;
+
+    size_t outbound_limit() const { return OUTBOUND_LIMIT_FACTOR * options_.write_high_water_mark; }
+    bool reserve_inbox_bytes(size_t size);
+
+    // 接收缓冲区：asio 直接读入，帧在原地解析；只在有未处理数据时持有 BufferPool 的 slab
+    ReadBuffer read_buffer_;
+
+    // 出站队列：所有待发帧在同一次 gather 写中发出
+    SessionOptions options_;
+    OutboundQueue outbound_;
+    // 其他线程投递给本会话的帧，在会话的 executor 上批量取出进入 outbound_
+    MpscQueue<OutboundFrame> inbox_;
+    // 跨线程的积压统计：inbox_bytes_ 由生产者预留、drain 时归还；outbound_bytes_ 是 executor 上发布的出站队列字节数
+    std::atomic<size_t> inbox_bytes_{0};
+    std::atomic<size_t> outbound_bytes_{0};
+    // 读写状态机：各自最多一个未完成的异步操作
+    bool reading_ = false;
+    bool writing_ = false;
+    bool read_paused_ = false; // 出站队列超过高水位时暂停读取（背压）
+    std::atomic<bool> closed_{false}; // 可能被阻塞线程池中的 set_authenticated_user 读取
+
+    // 正在处理 PacketBatch 时非空：同步处理器的响应攒在这里（分配在请求的 arena 上），批次结束时合并成一帧
+    Packet *batch_reply_ = nullptr;
+    size_t batch_reply_bytes_ = 0;
+
+    // 所属 io_context 的连接计数（per_core 模式的最少连接数均衡使用）
+    std::shared_ptr<std::atomic<size_t>> load_counter_;
+    bool holds_connection_slot_ = false;
+    size_t io_index_ = 0;
+    // 协商后的压缩编解码器；在 executor 上写，跨线程 send_packet 也会读
+    std::atomic<uint32_t> compression_{0};
+    // 协商后置位，登录 / 恢复后的离线投递在阻塞线程池中读取
+    std::atomic<bool> offline_ack_{false};
 
-    std::vector<uint8_t> read_buffer_;
-    std::string write_buffer_;
-    std::array<uint8_t, 4096> data_; // Larger buffer for binary data
+    // 空闲检测：读回调只写 last_activity_tick_，其余状态只在时间轮回调中访问
+    TimerWheel *timer_wheel_ = nullptr;
+    std::atomic<uint64_t> last_activity_tick_{0};
+    uint64_t last_ping_tick_ = 0;
 
     // Message router for handling packets
     std::shared_ptr<MessageRouter> message_router_;
 
     // User authentication state
-    bool authenticated_ = false;
-    int64_t user_id_ = 0;
+    // 认证在阻塞线程池中设置、在 io 线程上读取：标志和 ID 用原子变量，用户名由 auth_mutex_ 保护
+    mutable std::mutex auth_mutex_;
+    std::atomic<bool> authenticated_{false};
+    std::atomic<int64_t> user_id_{0};
     std::string username_;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "session_manager.h"
 #include <spdlog/spdlog.h>
 #include <sstream>
+#include <algorithm>
 
 SessionManager &SessionManager::get_instance()
 {
@@ -16,20 +17,20 @@ bool SessionManager::register_session(std::shared_ptr<Session> session)
         return false;
     }
 
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-
-    // 检查是否已经存在
-    if (active_sessions_.find(session) != active_sessions_.end())
+    auto &shard = session_shards_[shard_of(session.get())];
     {
-        spdlog::warn("Session already registered");
-        return false;
-    }
+        std::lock_guard<std::mutex> lock(shard.mutex);
 
-    // 注册新会话
-    active_sessions_.insert(session);
-    size_t current_count = active_sessions_.size();
+        // 检查是否已经存在，不存在时插入
+        if (!shard.sessions.emplace(session.get(), session).second)
+        {
+            spdlog::warn("Session already registered");
+            return false;
+        }
+    }
 
-    spdlog::info("Session registered, active sessions: {}", current_count);
+    size_t current_count = active_count_.fetch_add(1, std::memory_order_relaxed) + 1;
+    spdlog::debug("Session registered, active sessions: {}", current_count);
 
     // 更新最大会话数统计
     update_max_session_count(current_count);
@@ -45,20 +46,26 @@ bool SessionManager::unregister_session(std::shared_ptr<Session> session)
         return false;
     }
 
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-
-    auto it = active_sessions_.find(session);
-    if (it == active_sessions_.end())
+    // 在锁外释放 shared_ptr，避免 Session 析构发生在分片锁内
+    std::shared_ptr<Session> removed;
     {
-        spdlog::debug("Session not found for unregistration");
-        return false;
-    }
+        auto &shard = session_shards_[shard_of(session.get())];
+        std::lock_guard<std::mutex> lock(shard.mutex);
 
-    // 注销会话
-    active_sessions_.erase(it);
-    size_t current_count = active_sessions_.size();
+        auto it = shard.sessions.find(session.get());
+        if (it == shard.sessions.end())
+        {
+            spdlog::debug("Session not found for unregistration");
+            return false;
+        }
 
-    spdlog::info("Session unregistered, active sessions: {}", current_count);
+        // 注销会话
+        removed = std::move(it->second);
+        shard.sessions.erase(it);
+    }
+
+    size_t current_count = active_count_.fetch_sub(1, std::memory_order_relaxed) - 1;
+    spdlog::debug("Session unregistered, active sessions: {}", current_count);
 
     return true;
 }
@@ -70,58 +77,269 @@ bool SessionManager::is_session_registered(std::shared_ptr<Session> session) con
         return false;
     }
 
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    return active_sessions_.find(session) != active_sessions_.end();
+    const auto &shard = session_shards_[shard_of(session.get())];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.sessions.find(session.get()) != shard.sessions.end();
 }
 
-size_t SessionManager::get_active_session_count() const
+bool SessionManager::try_acquire_connection_slot(size_t limit)
 {
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-    return active_sessions_.size();
+    if (limit == 0)
+    {
+        connection_slots_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // CAS 循环：只有确定不超过上限时才把计数加一，不会出现短暂超限
+    size_t current = connection_slots_.load(std::memory_order_relaxed);
+    do
+    {
+        if (current >= limit)
+        {
+            return false;
+        }
+    } while (!connection_slots_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+
+    return true;
 }
 
-void SessionManager::shutdown_all_sessions()
+void SessionManager::release_connection_slot()
 {
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
+    connection_slots_.fetch_sub(1, std::memory_order_relaxed);
+}
 
-    if (active_sessions_.empty())
+void SessionManager::bind_user(int64_t user_id, const std::shared_ptr<Session> &session)
+{
+    if (!session)
+    {
+        return;
+    }
+
+    auto &shard = user_shards_[shard_of(user_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto [it, inserted] = shard.users.try_emplace(user_id);
+    if (inserted)
+    {
+        online_user_count_.fetch_add(1, std::memory_order_relaxed);
+        if (presence_listener_)
+        {
+            presence_listener_(user_id, true);
+        }
+    }
+
+    auto &sessions = it->second;
+    // 顺便清理已失效的弱引用，并避免同一会话重复绑定
+    sessions.erase(std::remove_if(sessions.begin(), sessions.end(),
+                                  [&session](const std::weak_ptr<Session> &weak)
+                                  {
+                                      auto locked = weak.lock();
+                                      return !locked || locked == session;
+                                  }),
+                   sessions.end());
+    sessions.push_back(session);
+
+    spdlog::debug("User {} bound to session, {} session(s) online for this user", user_id, sessions.size());
+}
+
+void SessionManager::unbind_user(int64_t user_id, const Session *session)
+{
+    auto &shard = user_shards_[shard_of(user_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.users.find(user_id);
+    if (it == shard.users.end())
     {
-        spdlog::info("No active sessions to shutdown");
         return;
     }
 
-    spdlog::info("Shutting down {} active sessions", active_sessions_.size());
+    auto &sessions = it->second;
+    sessions.erase(std::remove_if(sessions.begin(), sessions.end(),
+                                  [session](const std::weak_ptr<Session> &weak)
+                                  {
+                                      auto locked = weak.lock();
+                                      return !locked || locked.get() == session;
+                                  }),
+                   sessions.end());
+
+    if (sessions.empty())
+    {
+        shard.users.erase(it);
+        online_user_count_.fetch_sub(1, std::memory_order_relaxed);
+        if (presence_listener_)
+        {
+            presence_listener_(user_id, false);
+        }
+    }
+}
+
+std::vector<std::shared_ptr<Session>> SessionManager::find_sessions_by_user(int64_t user_id) const
+{
+    std::vector<std::shared_ptr<Session>> result;
+
+    const auto &shard = user_shards_[shard_of(user_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.users.find(user_id);
+    if (it == shard.users.end())
+    {
+        return result;
+    }
+
+    result.reserve(it->second.size());
+    for (const auto &weak : it->second)
+    {
+        if (auto session = weak.lock())
+        {
+            result.push_back(std::move(session));
+        }
+    }
+    return result;
+}
+
+void SessionManager::collect_user_sessions(const std::vector<int64_t> &user_ids,
+                                           std::vector<std::shared_ptr<Session>> &out,
+                                           const Session *exclude) const
+{
+    // 按分片归类的缓冲区在线程内复用，扇出路径上不重复分配
+    thread_local std::array<std::vector<int64_t>, SHARD_COUNT> by_shard;
+    for (auto &ids : by_shard)
+    {
+        ids.clear();
+    }
+    for (int64_t user_id : user_ids)
+    {
+        by_shard[shard_of(user_id)].push_back(user_id);
+    }
+
+    for (size_t i = 0; i < SHARD_COUNT; ++i)
+    {
+        if (by_shard[i].empty())
+        {
+            continue;
+        }
+
+        const auto &shard = user_shards_[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (int64_t user_id : by_shard[i])
+        {
+            auto it = shard.users.find(user_id);
+            if (it == shard.users.end())
+            {
+                continue;
+            }
+            for (const auto &weak : it->second)
+            {
+                auto session = weak.lock();
+                if (session && session.get() != exclude)
+                {
+                    out.push_back(std::move(session));
+                }
+            }
+        }
+    }
+}
+
+void SessionManager::collect_online_users(std::vector<int64_t> &out) const
+{
+    out.reserve(out.size() + get_online_user_count());
+    for (const auto &shard : user_shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto &entry : shard.users)
+        {
+            out.push_back(entry.first);
+        }
+    }
+}
+
+bool SessionManager::is_user_online(int64_t user_id) const
+{
+    const auto &shard = user_shards_[shard_of(user_id)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.users.find(user_id) != shard.users.end();
+}
 
-    // 遍历所有会话并优雅关闭
-    for (auto &session : active_sessions_)
+void SessionManager::for_each_session(const std::function<void(const std::shared_ptr<Session> &)> &fn) const
+{
+    std::vector<std::shared_ptr<Session>> snapshot;
+    for (const auto &shard : session_shards_)
     {
-        try
+        snapshot.clear();
         {
-            // 关闭socket连接
-            if (session->socket_.is_open())
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            snapshot.reserve(shard.sessions.size());
+            for (const auto &entry : shard.sessions)
             {
-                session->socket_.close();
+                snapshot.push_back(entry.second);
             }
         }
-        catch (const std::exception &e)
+
+        for (const auto &session : snapshot)
         {
-            spdlog::warn("Error closing session: {}", e.what());
+            fn(session);
         }
     }
+}
+
+void SessionManager::shutdown_all_sessions()
+{
+    size_t total = get_active_session_count();
+    if (total == 0)
+    {
+        spdlog::info("No active sessions to shutdown");
+        return;
+    }
+
+    spdlog::info("Shutting down {} active sessions", total);
+
+    // 逐个分片摘下会话，在锁外关闭 socket
+    for (auto &shard : session_shards_)
+    {
+        std::unordered_map<const Session *, std::shared_ptr<Session>> sessions;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            sessions.swap(shard.sessions);
+        }
+        active_count_.fetch_sub(sessions.size(), std::memory_order_relaxed);
+
+        // 遍历所有会话并优雅关闭
+        for (auto &entry : sessions)
+        {
+            try
+            {
+                // 关闭socket连接
+                if (entry.second->socket_.is_open())
+                {
+                    asio::error_code ignored;
+                    entry.second->socket_.close(ignored);
+                }
+            }
+            catch (const std::exception &e)
+            {
+                spdlog::warn("Error closing session: {}", e.what());
+            }
+        }
+    }
+
+    for (auto &shard : user_shards_)
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.users.clear();
+    }
+    online_user_count_.store(0, std::memory_order_relaxed);
 
-    // 清空会话列表
-    active_sessions_.clear();
     spdlog::info("All sessions shutdown completed");
 }
 
 std::string SessionManager::get_session_stats() const
 {
-    std::lock_guard<std::mutex> lock(sessions_mutex_);
-
     std::ostringstream oss;
     oss << "SessionManager Stats: "
-        << "Active=" << active_sessions_.size()
-        << ", MaxEver=" << max_session_count_.load();
+        << "Active=" << get_active_session_count()
+        << ", MaxEver=" << max_session_count_.load()
+        << ", OnlineUsers=" << get_online_user_count()
+        << ", ConnectionSlots=" << get_connection_slot_count();
 
     return oss.str();
 }
@@ -136,4 +354,4 @@ void SessionManager::update_max_session_count(size_t current_count)
             break;
         }
     }
-}
\ No newline at end of file
+}
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <memory>
-#include <unordered_set>
+#include <unordered_map>
+#include <vector>
+#include <array>
+#include <functional>
 #include <mutex>
 #include <atomic>
+#include <cstdint>
 #include "session.h"
 
 /**
@@ -12,6 +16,10 @@
  * 负责管理所有活跃的Session连接，提供线程安全的会话注册、注销和查找功能。
  * 使用单例模式确保全局只有一个SessionManager实例。
  *
+ * 并发设计：会话表和 user_id 索引都按哈希拆成 SHARD_COUNT 个分片，每个分片一把锁，
+ * 不同连接的注册/注销大概率落在不同分片上，互不阻塞；活跃数用原子计数，读取不加锁。
+ * 遍历（shutdown_all_sessions / for_each_session）逐个分片拷贝快照后在锁外处理，不会长时间阻塞新连接注册。
+ *
  * 没有SessionManager时，Server无法知道当前有多少活跃连接，历史最大并发连接数是多少，哪些客户端连接了多少时间
  * Server关闭的时候，无法主动关闭所有活跃连接，客户端长时间等待，无法限制最大的并发连接数，拒绝过多连接以保护服务器，无法向所有的客户端广播信息。
  * 
@@ -33,6 +41,9 @@
 class SessionManager
 {
 public:
+    // 分片数量，2 的幂，便于用位运算取模
+    static constexpr size_t SHARD_COUNT = 32;
+
     /**
      * @brief 获取SessionManager单例实例
      * @return SessionManager实例引用
@@ -68,7 +79,7 @@ public:
      * @brief 获取当前活跃会话数量
      * @return 活跃会话数量
      */
-    size_t get_active_session_count() const;
+    size_t get_active_session_count() const { return active_count_.load(std::memory_order_relaxed); }
 
     /**
      * @brief 获取最大会话数统计
@@ -76,6 +87,87 @@ public:
      */
     size_t get_max_session_count() const { return max_session_count_.load(); }
 
+    /**
+     * @brief 抢占一个连接槽位（准入控制）
+     * 槽位在 accept 之后、Session 构造之前占用，由 Session 析构时归还，
+     * 因此统计的是已接受的 socket 数，而不仅是已注册的会话数
+     * @param limit 槽位上限，0 表示不限
+     * @return true 抢占成功，false 已达上限
+     */
+    bool try_acquire_connection_slot(size_t limit);
+
+    /**
+     * @brief 归还一个连接槽位
+     */
+    void release_connection_slot();
+
+    /**
+     * @brief 当前占用的连接槽位数
+     */
+    size_t get_connection_slot_count() const { return connection_slots_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 把已登录的会话加入 user_id 索引
+     * 由 Session::set_authenticated_user 调用；同一用户可以有多个会话（多端登录）
+     * @param user_id 用户ID
+     * @param session 会话
+     */
+    void bind_user(int64_t user_id, const std::shared_ptr<Session> &session);
+
+    /**
+     * @brief 从 user_id 索引中移除会话
+     * @param user_id 用户ID
+     * @param session 会话指针（只用于比较，不解引用）
+     */
+    void unbind_user(int64_t user_id, const Session *session);
+
+    /**
+     * @brief 本节点用户上线（第一个会话绑定）/ 下线（最后一个会话解绑）的回调，集群模式用来发布在线状态
+     * 在 user_id 分片锁内调用，同一用户的变更顺序与实际一致；回调必须很轻（只入队）。
+     * 只能在 worker 线程启动之前设置
+     */
+    using PresenceListener = std::function<void(int64_t user_id, bool online)>;
+    void set_presence_listener(PresenceListener listener) { presence_listener_ = std::move(listener); }
+
+    /**
+     * @brief 追加所有在线用户的 user_id（集群全量同步）
+     */
+    void collect_online_users(std::vector<int64_t> &out) const;
+
+    /**
+     * @brief 按 user_id 查找在线会话，O(1)
+     * @param user_id 用户ID
+     * @return 该用户的所有在线会话，不在线时为空
+     */
+    std::vector<std::shared_ptr<Session>> find_sessions_by_user(int64_t user_id) const;
+
+    /**
+     * @brief 批量查找一组用户的在线会话（群消息扇出）
+     * 先把 user_id 按索引分片归类，每个分片只加一次锁，1 万成员的群最多 SHARD_COUNT 次加锁
+     * @param user_ids 用户ID列表
+     * @param out 追加找到的会话
+     * @param exclude 跳过的会话（通常是发送方当前的会话），可以为空
+     */
+    void collect_user_sessions(const std::vector<int64_t> &user_ids, std::vector<std::shared_ptr<Session>> &out,
+                               const Session *exclude = nullptr) const;
+
+    /**
+     * @brief 检查用户是否在线
+     */
+    bool is_user_online(int64_t user_id) const;
+
+    /**
+     * @brief 获取在线用户数（已登录的不同 user_id 数量）
+     */
+    size_t get_online_user_count() const { return online_user_count_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 遍历所有会话
+     * 每个分片先在锁内拷贝快照，回调在锁外执行，回调中可以安全地注册/注销会话
+     * @param fn 对每个会话调用的函数
+     */
+    void for_each_session(const std::function<void(const std::shared_ptr<Session> &)> &fn) const;
+
     /**
      * @brief 关闭所有会话
      * 在服务器关闭时调用，优雅地关闭所有活跃连接
@@ -98,15 +190,43 @@ private:
      */
     void update_max_session_count(size_t current_count);
 
-    // 线程安全的会话容器
+    // 会话分片：按 Session 地址哈希
     /**
      * mutable 的作用是：即使 SessionManager 的成员函数是 const（比如 is_session_registered），也允许修改这个 mutex，这样才能在 const 方法里加锁。
-     * 用于保证多个线程同时操作 active_sessions_ 时不会出错。
+     * alignas(64) 让每个分片独占缓存行，避免不同分片的锁互相造成伪共享。
      */
-    mutable std::mutex sessions_mutex_;
-    std::unordered_set<std::shared_ptr<Session>> active_sessions_;
+    struct alignas(64) SessionShard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<const Session *, std::shared_ptr<Session>> sessions;
+    };
+
+    // user_id 索引分片：按 user_id 哈希，值为弱引用，不延长会话生命周期
+    struct alignas(64) UserShard
+    {
+        mutable std::mutex mutex;
+        std::unordered_map<int64_t, std::vector<std::weak_ptr<Session>>> users;
+    };
+
+    static size_t shard_of(const Session *session)
+    {
+        // 对象地址低位是对齐产生的 0，右移后再取模
+        return (reinterpret_cast<uintptr_t>(session) >> 6) & (SHARD_COUNT - 1);
+    }
+    static size_t shard_of(int64_t user_id)
+    {
+        return std::hash<int64_t>{}(user_id) & (SHARD_COUNT - 1);
+    }
+
+    std::array<SessionShard, SHARD_COUNT> session_shards_;
+    std::array<UserShard, SHARD_COUNT> user_shards_;
+    PresenceListener presence_listener_;
 
     // 统计信息
+    std::atomic<size_t> active_count_{0};
+    std::atomic<size_t> online_user_count_{0};
+    std::atomic<size_t> connection_slots_{0};
+
     /**
      * @brief 这是一个 原子变量，用来统计 历史上同时在线的最大会话数。
      * 因为这个数可能在不同线程里同时更新（比如一个线程新注册会话，另一个线程也在注册），如果不用原子操作，就会有并发写入的竞态问题。
@@ -114,4 +234,4 @@ private:
      * 
      */
     std::atomic<size_t> max_session_count_{0};
-};
\ No newline at end of file
+};
@@ -0,0 +1,136 @@
+#include "timer_wheel.h"
+#include "session.h"
+#include <algorithm>
+
+TimerWheel::TimerWheel(asio::io_context &io_context, std::chrono::milliseconds tick_interval)
+    : io_context_(io_context), timer_(io_context),
+      tick_interval_(std::max(tick_interval, std::chrono::milliseconds(1))),
+      slots_(SLOT_COUNT)
+{
+}
+
+/**
+ * 只在所属 io_context 停止之后析构（Server 里声明在 io_pool_ 之后），
+ * timer_ 自己的析构会取消挂起的等待，这里不再投递任何操作
+ */
+TimerWheel::~TimerWheel()
+{
+    running_ = false;
+}
+
+void TimerWheel::start()
+{
+    if (running_.exchange(true))
+    {
+        return;
+    }
+
+    next_tick_at_ = std::chrono::steady_clock::now();
+    arm();
+}
+
+void TimerWheel::stop()
+{
+    if (running_.exchange(false))
+    {
+        // steady_timer 不是线程安全的，取消操作投递到它所在的 io_context
+        asio::post(io_context_, [this]()
+                   { timer_.cancel(); });
+    }
+}
+
+uint64_t TimerWheel::to_ticks(std::chrono::milliseconds duration) const
+{
+    if (duration.count() <= 0)
+    {
+        return 0;
+    }
+    return static_cast<uint64_t>((duration.count() + tick_interval_.count() - 1) / tick_interval_.count());
+}
+
+void TimerWheel::schedule(const std::shared_ptr<Session> &session, uint64_t delay_ticks)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t deadline = now_.load(std::memory_order_relaxed) + std::max<uint64_t>(delay_ticks, 1);
+    slots_[deadline % SLOT_COUNT].push_back(Entry{session, deadline});
+    size_.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * 按绝对时间排下一个刻度（expires_at 累加），回调偶尔延迟不会累积漂移；
+ * 落后多个刻度时会连续触发把刻度数追上，超时时长仍然按墙上时间计算
+ */
+void TimerWheel::arm()
+{
+    next_tick_at_ += tick_interval_;
+    timer_.expires_at(next_tick_at_);
+    timer_.async_wait([this](const asio::error_code &ec)
+                      {
+                          if (ec || !running_)
+                          {
+                              return;
+                          }
+                          on_tick();
+                          arm(); });
+}
+
+/**
+ * 一个刻度：
+ * 1. 持锁推进 now_，把当前槽位里 deadline 已到的条目摘到 due_（没转满圈数的留下）
+ * 2. 不持锁逐个调用 Session::check_idle()，它可能关闭会话或发送 Ping
+ * 3. 需要继续观察的会话一次性挂回时间轮
+ */
+void TimerWheel::on_tick()
+{
+    uint64_t now;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        now = now_.load(std::memory_order_relaxed) + 1;
+        now_.store(now, std::memory_order_relaxed);
+
+        auto &slot = slots_[now % SLOT_COUNT];
+        size_t kept = 0;
+        for (auto &entry : slot)
+        {
+            if (entry.deadline <= now)
+            {
+                due_.push_back(std::move(entry));
+            }
+            else
+            {
+                slot[kept++] = std::move(entry);
+            }
+        }
+        slot.resize(kept);
+        size_.fetch_sub(due_.size(), std::memory_order_relaxed);
+    }
+
+    for (auto &entry : due_)
+    {
+        auto session = entry.session.lock();
+        if (!session)
+        {
+            continue;
+        }
+
+        uint64_t delay = session->check_idle(now);
+        if (delay > 0)
+        {
+            rescheduled_.emplace_back(std::move(session), delay);
+        }
+    }
+    due_.clear();
+
+    if (!rescheduled_.empty())
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &item : rescheduled_)
+        {
+            uint64_t deadline = now + item.second;
+            slots_[deadline % SLOT_COUNT].push_back(Entry{item.first, deadline});
+        }
+        size_.fetch_add(rescheduled_.size(), std::memory_order_relaxed);
+    }
+    // 在锁外释放 shared_ptr：最后一个引用可能在这里析构会话
+    rescheduled_.clear();
+}
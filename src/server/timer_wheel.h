@@ -0,0 +1,84 @@
+#pragma once
+
+#define ASIO_STANDALONE
+#include <asio.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Session;
+
+/**
+ * @brief 哈希时间轮，每个 io_context 一个，驱动所属会话的心跳和空闲超时
+ *
+ * 整个时间轮只有一个 steady_timer，每个刻度（默认 1 秒）触发一次，处理当前槽位里到期的会话；
+ * 10 万个连接不需要 10 万个 asio 定时器，也没有每次收包时的 cancel / expires_after。
+ *
+ * 到期检查是惰性的：会话收到数据时只把 now() 记到自己的原子变量里，不动时间轮；
+ * 槽位到期时由 Session::check_idle() 根据最后活跃时间决定关闭、发 Ping，或返回新的延迟重新挂上。
+ * 活跃连接每个超时周期只被检查一两次，与收包频率无关。
+ *
+ * 槽位里只保存 weak_ptr：已经关闭并析构的会话不需要从时间轮中删除，到期时自然跳过。
+ * schedule() 可以从任意线程调用（shared / strand 模式下多个线程共用一个时间轮），内部一把锁只在挂入 / 摘出时持有。
+ */
+class TimerWheel
+{
+public:
+    static constexpr size_t SLOT_COUNT = 512;
+
+    TimerWheel(asio::io_context &io_context, std::chrono::milliseconds tick_interval);
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    void start();
+
+    // 停止刻度定时器，可以从任意线程调用；已挂入的会话不再检查
+    void stop();
+
+    /**
+     * @brief 在 delay_ticks 个刻度后检查会话（至少 1 个刻度）
+     * 超过一圈（SLOT_COUNT 个刻度）的延迟放在同一个槽位上多转几圈
+     */
+    void schedule(const std::shared_ptr<Session> &session, uint64_t delay_ticks);
+
+    // 当前刻度数，会话记录最后活跃时间用；只是一次 relaxed 读
+    uint64_t now() const { return now_.load(std::memory_order_relaxed); }
+
+    std::chrono::milliseconds tick_interval() const { return tick_interval_; }
+
+    // 按向上取整把时长换算成刻度数
+    uint64_t to_ticks(std::chrono::milliseconds duration) const;
+
+    // 当前挂在时间轮上的条目数（包括已析构、尚未到期清理的会话）
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<Session> session;
+        uint64_t deadline; // 到期刻度；槽位转到时 deadline 未到的留在原处
+    };
+
+    void arm();
+    void on_tick();
+
+    asio::io_context &io_context_;
+    asio::steady_timer timer_;
+    std::chrono::milliseconds tick_interval_;
+    std::chrono::steady_clock::time_point next_tick_at_;
+    std::atomic<bool> running_{false};
+
+    mutable std::mutex mutex_;
+    std::vector<std::vector<Entry>> slots_;
+    std::atomic<uint64_t> now_{0};
+    std::atomic<size_t> size_{0};
+
+    // on_tick 复用的缓冲区，只在刻度回调中使用
+    std::vector<Entry> due_;
+    std::vector<std::pair<std::shared_ptr<Session>, uint64_t>> rescheduled_;
+};
@@ -0,0 +1,201 @@
+#include "password_hasher.h"
+#include "../executor/blocking_executor.h"
+#include <spdlog/spdlog.h>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <crypt.h>
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+
+// crypt 盐值字母表（64 个字符）
+const char SALT_ALPHABET[] = "./0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+constexpr size_t SALT_LENGTH = 16;
+// SHA-512 crypt 不写 rounds= 时的默认轮数
+constexpr int DEFAULT_SHA512_ROUNDS = 5000;
+
+/**
+ * 每个线程一份 crypt_data（几十 KB），第一次使用时分配并清零，之后复用
+ */
+crypt_data &thread_crypt_data()
+{
+    thread_local std::unique_ptr<crypt_data> data = []()
+    {
+        auto d = std::make_unique<crypt_data>();
+        std::memset(d.get(), 0, sizeof(crypt_data));
+        return d;
+    }();
+    return *data;
+}
+
+} // namespace
+
+PasswordHasher::PasswordHasher(const Config::PasswordConfig &config)
+    : rounds_(std::clamp(config.rounds, MIN_ROUNDS, MAX_ROUNDS))
+{
+    size_t threads = config.hash_threads > 0 ? static_cast<size_t>(config.hash_threads)
+                                             : std::max(1u, std::thread::hardware_concurrency());
+    pool_ = std::make_unique<BlockingExecutor>(
+        "crypt", threads, static_cast<size_t>(std::max(0, config.hash_queue_limit)));
+
+    spdlog::info("PasswordHasher: sha512-crypt rounds={}, threads={}, queue_limit={}",
+                 rounds_, threads, config.hash_queue_limit);
+}
+
+PasswordHasher::~PasswordHasher()
+{
+    stop();
+}
+
+void PasswordHasher::start()
+{
+    if (!running_.exchange(true))
+    {
+        pool_->start();
+        pool_->register_metrics();
+    }
+}
+
+void PasswordHasher::stop()
+{
+    if (running_.exchange(false))
+    {
+        // BlockingExecutor::stop 会执行完已排队的任务，等待中的调用方都能拿到结果
+        pool_->stop();
+        spdlog::info("{}", get_stats_string());
+    }
+}
+
+/**
+ * 在 CPU 线程池上执行 fn 并等待结果
+ * 调用方本身在阻塞线程池里，等待不会占用 io 线程；线程池未运行时直接在当前线程计算
+ */
+template <typename Fn>
+PasswordHasher::Result PasswordHasher::run_on_pool(Fn &&fn)
+{
+    if (!running_.load(std::memory_order_acquire))
+    {
+        return fn();
+    }
+
+    auto promise = std::make_shared<std::promise<Result>>();
+    auto future = promise->get_future();
+
+    bool submitted = pool_->submit(
+        [promise, fn = std::forward<Fn>(fn)]() mutable
+        {
+            try
+            {
+                promise->set_value(fn());
+            }
+            catch (...)
+            {
+                promise->set_value(Result::FAILED);
+            }
+        });
+
+    if (!submitted)
+    {
+        busy_rejections_.fetch_add(1, std::memory_order_relaxed);
+        return Result::BUSY;
+    }
+    return future.get();
+}
+
+PasswordHasher::Result PasswordHasher::hash(const std::string &password, std::string &hash_out)
+{
+    hashes_.fetch_add(1, std::memory_order_relaxed);
+    std::string setting = make_setting();
+    if (setting.empty())
+    {
+        return Result::FAILED;
+    }
+
+    return run_on_pool([&password, &hash_out, setting]()
+                       { return crypt_hash(password, setting, hash_out) ? Result::OK : Result::FAILED; });
+}
+
+PasswordHasher::Result PasswordHasher::verify(const std::string &password, const std::string &stored_hash)
+{
+    verifies_.fetch_add(1, std::memory_order_relaxed);
+
+    return run_on_pool([&password, &stored_hash]()
+                       {
+                           std::string computed;
+                           if (!crypt_hash(password, stored_hash, computed))
+                           {
+                               return Result::FAILED;
+                           }
+                           if (computed.size() != stored_hash.size() ||
+                               CRYPTO_memcmp(computed.data(), stored_hash.data(), computed.size()) != 0)
+                           {
+                               return Result::MISMATCH;
+                           }
+                           return Result::OK; });
+}
+
+/**
+ * 存储格式 $6$rounds=N$salt$hash 或 $6$salt$hash（rounds 为默认的 5000）
+ */
+bool PasswordHasher::needs_rehash(const std::string &stored_hash) const
+{
+    if (stored_hash.compare(0, 3, "$6$") != 0)
+    {
+        return true;
+    }
+
+    int stored_rounds = DEFAULT_SHA512_ROUNDS;
+    static const std::string rounds_prefix = "$6$rounds=";
+    if (stored_hash.compare(0, rounds_prefix.size(), rounds_prefix) == 0)
+    {
+        stored_rounds = std::atoi(stored_hash.c_str() + rounds_prefix.size());
+    }
+    return stored_rounds != rounds_;
+}
+
+bool PasswordHasher::crypt_hash(const std::string &password, const std::string &setting, std::string &out)
+{
+    char *result = crypt_r(password.c_str(), setting.c_str(), &thread_crypt_data());
+    // 出错时 crypt_r 返回 NULL，或返回以 '*' 开头的失败标记
+    if (result == nullptr || result[0] == '*')
+    {
+        return false;
+    }
+    out.assign(result);
+    return true;
+}
+
+std::string PasswordHasher::make_setting() const
+{
+    unsigned char random[SALT_LENGTH];
+    if (RAND_bytes(random, sizeof(random)) != 1)
+    {
+        spdlog::error("Failed to generate password salt");
+        return "";
+    }
+
+    std::string setting = "$6$rounds=" + std::to_string(rounds_) + "$";
+    for (unsigned char byte : random)
+    {
+        setting.push_back(SALT_ALPHABET[byte & 0x3f]);
+    }
+    setting.push_back('$');
+    return setting;
+}
+
+std::string PasswordHasher::get_stats_string() const
+{
+    std::ostringstream oss;
+    oss << "PasswordHasher Stats: "
+        << "Rounds=" << rounds_
+        << ", Hashes=" << hashes_.load(std::memory_order_relaxed)
+        << ", Verifies=" << verifies_.load(std::memory_order_relaxed)
+        << ", BusyRejections=" << busy_rejections_.load(std::memory_order_relaxed)
+        << ", " << pool_->get_stats_string();
+    return oss.str();
+}
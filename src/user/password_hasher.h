@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "../config/config.h"
+
+class BlockingExecutor;
+
+/**
+ * @brief 密码哈希引擎
+ *
+ * 基于 crypt_r() 的 SHA-512 crypt（$6$rounds=N$salt$hash），替代 glibc 的 crypt()：
+ * - crypt() 把结果写在一个全局静态缓冲区里，多个线程同时调用会互相覆盖；
+ *   crypt_r() 使用调用方提供的 crypt_data，这里每个线程一份（thread_local），无锁并发
+ * - 盐值用 OpenSSL RAND_bytes 生成，不再每次构造 std::random_device + mt19937
+ * - 计算放在独立的、有界的 CPU 线程池（默认 CPU 核数个线程）中执行，
+ *   与承载 DB 往返的阻塞线程池分开：DB 线程可以多开以掩盖网络延迟，而同时进行的哈希计算不超过核数，
+ *   队列满时返回 BUSY，由上层回复"服务器繁忙"
+ * - rounds 可配置；登录成功时如果存储的哈希参数与当前配置不一致，needs_rehash() 返回 true，
+ *   UserManager 会用当前参数重新哈希并写回，调整代价参数后老用户在下次登录时自动迁移
+ */
+class PasswordHasher
+{
+public:
+    enum class Result
+    {
+        OK,       // hash 成功 / verify 匹配
+        MISMATCH, // verify 不匹配
+        BUSY,     // CPU 线程池队列已满
+        FAILED    // crypt_r 失败或哈希格式无效
+    };
+
+    // SHA-512 crypt 的 rounds 取值范围
+    static constexpr int MIN_ROUNDS = 1000;
+    static constexpr int MAX_ROUNDS = 999999999;
+
+    explicit PasswordHasher(const Config::PasswordConfig &config);
+    ~PasswordHasher();
+
+    PasswordHasher(const PasswordHasher &) = delete;
+    PasswordHasher &operator=(const PasswordHasher &) = delete;
+
+    // 启动 / 停止 CPU 线程池；未启动时在调用线程上直接计算
+    void start();
+    void stop();
+
+    // 用当前参数为密码生成哈希
+    Result hash(const std::string &password, std::string &hash_out);
+
+    // 校验密码（常数时间比较）
+    Result verify(const std::string &password, const std::string &stored_hash);
+
+    // 哈希的算法或 rounds 与当前配置不同，需要在登录成功后重新哈希
+    bool needs_rehash(const std::string &stored_hash) const;
+
+    int rounds() const { return rounds_; }
+    std::string get_stats_string() const;
+
+    // 在当前线程上同步计算，不经过线程池
+    static bool crypt_hash(const std::string &password, const std::string &setting, std::string &out);
+
+private:
+    template <typename Fn>
+    Result run_on_pool(Fn &&fn);
+
+    std::string make_setting() const;
+
+    int rounds_;
+    std::unique_ptr<BlockingExecutor> pool_;
+    std::atomic<bool> running_{false};
+
+    std::atomic<uint64_t> hashes_{0};
+    std::atomic<uint64_t> verifies_{0};
+    std::atomic<uint64_t> busy_rejections_{0};
+};
@@ -0,0 +1,300 @@
+#include "resume_token.h"
+#include <spdlog/spdlog.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+
+void append_u64(std::string &out, uint64_t value)
+{
+    // 大端，和帧长度头一致
+    for (int shift = 56; shift >= 0; shift -= 8)
+    {
+        out.push_back(static_cast<char>((value >> shift) & 0xff));
+    }
+}
+
+uint64_t read_u64(const std::string &in, size_t offset)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        value = (value << 8) | static_cast<uint8_t>(in[offset + i]);
+    }
+    return value;
+}
+
+std::string hex_encode(const uint8_t *data, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(size * 2);
+    for (size_t i = 0; i < size; ++i)
+    {
+        out.push_back(digits[data[i] >> 4]);
+        out.push_back(digits[data[i] & 0x0f]);
+    }
+    return out;
+}
+
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool hex_decode(const char *data, size_t size, std::string &out)
+{
+    if (size % 2 != 0)
+    {
+        return false;
+    }
+
+    out.clear();
+    out.reserve(size / 2);
+    for (size_t i = 0; i < size; i += 2)
+    {
+        int high = hex_value(data[i]);
+        int low = hex_value(data[i + 1]);
+        if (high < 0 || low < 0)
+        {
+            return false;
+        }
+        out.push_back(static_cast<char>((high << 4) | low));
+    }
+    return true;
+}
+
+// version(1) + user_id(8) + issued_at_ms(8) + expires_at(8) + token_id(8)
+constexpr size_t FIXED_PAYLOAD_SIZE = 1 + 8 * 4;
+// 用户名最长 50 字符，再加上一点余量，超出的一律按格式错误处理
+constexpr size_t MAX_TOKEN_SIZE = (FIXED_PAYLOAD_SIZE + 64) * 2 + 1 + 64;
+
+} // namespace
+
+ResumeTokenService &ResumeTokenService::get_instance()
+{
+    static ResumeTokenService instance;
+    return instance;
+}
+
+bool ResumeTokenService::initialize(const Config::AuthConfig &auth_config)
+{
+    ttl_ = std::chrono::seconds(std::max(60, auth_config.resume_token_ttl_sec));
+
+    if (!auth_config.resume_secret.empty())
+    {
+        secret_ = auth_config.resume_secret;
+        if (secret_.size() < 32)
+        {
+            spdlog::warn("auth.resume_secret is shorter than 32 bytes, consider a longer secret");
+        }
+    }
+    else
+    {
+        std::array<uint8_t, 32> random_secret{};
+        if (RAND_bytes(random_secret.data(), static_cast<int>(random_secret.size())) != 1)
+        {
+            spdlog::error("Failed to generate resume token secret");
+            return false;
+        }
+        secret_.assign(reinterpret_cast<const char *>(random_secret.data()), random_secret.size());
+        spdlog::warn("auth.resume_secret not configured, using a random secret: resume tokens will not survive a restart");
+    }
+
+    initialized_ = true;
+    spdlog::info("ResumeTokenService initialized (ttl={}s)", ttl_.count());
+    return true;
+}
+
+std::string ResumeTokenService::issue(int64_t user_id, const std::string &username, Claims *claims_out)
+{
+    if (!initialized_)
+    {
+        return "";
+    }
+
+    Claims claims;
+    claims.user_id = user_id;
+    claims.username = username;
+    claims.issued_at_ms = now_millis();
+    claims.expires_at = now_seconds() + ttl_.count();
+    if (RAND_bytes(reinterpret_cast<unsigned char *>(&claims.token_id), sizeof(claims.token_id)) != 1)
+    {
+        spdlog::error("Failed to generate resume token id");
+        return "";
+    }
+
+    std::string payload;
+    payload.reserve(FIXED_PAYLOAD_SIZE + username.size());
+    payload.push_back(static_cast<char>(TOKEN_VERSION));
+    append_u64(payload, static_cast<uint64_t>(claims.user_id));
+    append_u64(payload, static_cast<uint64_t>(claims.issued_at_ms));
+    append_u64(payload, static_cast<uint64_t>(claims.expires_at));
+    append_u64(payload, claims.token_id);
+    payload.append(username);
+
+    auto mac = sign(payload);
+
+    std::string token = hex_encode(reinterpret_cast<const uint8_t *>(payload.data()), payload.size());
+    token.push_back('.');
+    token.append(hex_encode(mac.data(), mac.size()));
+
+    if (claims_out)
+    {
+        *claims_out = std::move(claims);
+    }
+    return token;
+}
+
+/**
+ * 校验顺序：格式 -> 签名（常数时间比较）-> 过期 -> 吊销
+ * 签名不通过时不解析任何字段内容，伪造的令牌不会走到查表那一步
+ */
+ResumeTokenService::VerifyResult ResumeTokenService::verify(const std::string &token, Claims &claims_out) const
+{
+    if (!initialized_ || token.empty() || token.size() > MAX_TOKEN_SIZE)
+    {
+        return VerifyResult::MALFORMED;
+    }
+
+    auto dot = token.find('.');
+    if (dot == std::string::npos)
+    {
+        return VerifyResult::MALFORMED;
+    }
+
+    std::string payload;
+    std::string mac;
+    if (!hex_decode(token.data(), dot, payload) ||
+        !hex_decode(token.data() + dot + 1, token.size() - dot - 1, mac) ||
+        payload.size() < FIXED_PAYLOAD_SIZE || mac.size() != MAC_SIZE ||
+        static_cast<uint8_t>(payload[0]) != TOKEN_VERSION)
+    {
+        return VerifyResult::MALFORMED;
+    }
+
+    auto expected = sign(payload);
+    if (CRYPTO_memcmp(expected.data(), mac.data(), MAC_SIZE) != 0)
+    {
+        return VerifyResult::BAD_SIGNATURE;
+    }
+
+    Claims claims;
+    claims.user_id = static_cast<int64_t>(read_u64(payload, 1));
+    claims.issued_at_ms = static_cast<int64_t>(read_u64(payload, 9));
+    claims.expires_at = static_cast<int64_t>(read_u64(payload, 17));
+    claims.token_id = read_u64(payload, 25);
+    claims.username = payload.substr(FIXED_PAYLOAD_SIZE);
+
+    if (claims.expires_at <= now_seconds())
+    {
+        return VerifyResult::EXPIRED;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(revocation_mutex_);
+        if (revoked_tokens_.count(claims.token_id) > 0)
+        {
+            return VerifyResult::REVOKED;
+        }
+        auto it = revoked_users_before_.find(claims.user_id);
+        if (it != revoked_users_before_.end() && claims.issued_at_ms <= it->second)
+        {
+            return VerifyResult::REVOKED;
+        }
+    }
+
+    claims_out = std::move(claims);
+    return VerifyResult::VALID;
+}
+
+bool ResumeTokenService::revoke_token(const Claims &claims)
+{
+    std::lock_guard<std::mutex> lock(revocation_mutex_);
+    bool inserted = revoked_tokens_.emplace(claims.token_id, claims.expires_at).second;
+
+    if (revoked_tokens_.size() > purge_at_size_)
+    {
+        purge_expired_locked(now_seconds());
+        // 清理后仍然很多（大量未过期的吊销记录）时推迟下一次清理，避免每次插入都全表扫描
+        purge_at_size_ = std::max(REVOCATION_PURGE_THRESHOLD, revoked_tokens_.size() * 2);
+    }
+    return inserted;
+}
+
+void ResumeTokenService::revoke_user(int64_t user_id)
+{
+    std::lock_guard<std::mutex> lock(revocation_mutex_);
+    revoked_users_before_[user_id] = now_millis();
+    spdlog::info("Revoked all resume tokens of user {}", user_id);
+}
+
+/**
+ * 已过期的令牌本来就会被拒绝，对应的吊销记录可以删除
+ */
+void ResumeTokenService::purge_expired_locked(int64_t now)
+{
+    for (auto it = revoked_tokens_.begin(); it != revoked_tokens_.end();)
+    {
+        it = it->second <= now ? revoked_tokens_.erase(it) : std::next(it);
+    }
+
+    for (auto it = revoked_users_before_.begin(); it != revoked_users_before_.end();)
+    {
+        // 吊销时刻之前签发的令牌最晚在 吊销时刻 + ttl 过期
+        it = it->second / 1000 + ttl_.count() <= now ? revoked_users_before_.erase(it) : std::next(it);
+    }
+}
+
+std::array<uint8_t, ResumeTokenService::MAC_SIZE> ResumeTokenService::sign(const std::string &payload) const
+{
+    std::array<uint8_t, MAC_SIZE> mac{};
+    unsigned int mac_length = 0;
+    HMAC(EVP_sha256(), secret_.data(), static_cast<int>(secret_.size()),
+         reinterpret_cast<const unsigned char *>(payload.data()), payload.size(),
+         mac.data(), &mac_length);
+    return mac;
+}
+
+int64_t ResumeTokenService::now_seconds()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+int64_t ResumeTokenService::now_millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+const char *ResumeTokenService::verify_result_to_string(VerifyResult result)
+{
+    switch (result)
+    {
+    case VerifyResult::VALID:
+        return "valid";
+    case VerifyResult::MALFORMED:
+        return "malformed";
+    case VerifyResult::BAD_SIGNATURE:
+        return "bad signature";
+    case VerifyResult::EXPIRED:
+        return "expired";
+    case VerifyResult::REVOKED:
+        return "revoked";
+    }
+    return "unknown";
+}
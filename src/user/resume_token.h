@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "../config/config.h"
+
+/**
+ * @brief 会话恢复令牌服务
+ *
+ * 登录成功后签发一个 HMAC-SHA256 签名的令牌，客户端断线重连时用 ResumeRequest 带上它，
+ * 服务端只做一次 HMAC 校验和一次内存查表就能恢复登录状态，不查数据库、不跑 crypt()。
+ *
+ * 令牌格式（十六进制编码）：payload "." mac
+ *   payload = version(1) | user_id(8) | issued_at_ms(8) | expires_at(8) | token_id(8) | username
+ *   mac     = HMAC-SHA256(secret, payload)
+ *
+ * 吊销：
+ * - revoke_token()：单个令牌作废。恢复成功时旧令牌会被作废并换发新令牌（一次性使用），截获的旧令牌不能重放
+ * - revoke_user()：作废某个用户此前签发的所有令牌（改密码、封号等场景）
+ * 吊销记录只在内存中保存到令牌过期为止，重启后依靠密钥轮换或过期时间兜底。
+ */
+class ResumeTokenService
+{
+public:
+    struct Claims
+    {
+        int64_t user_id = 0;
+        std::string username;
+        int64_t issued_at_ms = 0; // unix 毫秒，吊销某用户全部令牌时按它比较
+        int64_t expires_at = 0; // unix 秒
+        uint64_t token_id = 0;
+    };
+
+    enum class VerifyResult
+    {
+        VALID,
+        MALFORMED,
+        BAD_SIGNATURE,
+        EXPIRED,
+        REVOKED
+    };
+
+    static ResumeTokenService &get_instance();
+
+    /**
+     * @brief 初始化密钥和有效期
+     * resume_secret 为空时随机生成，令牌在服务重启后全部失效
+     */
+    bool initialize(const Config::AuthConfig &auth_config);
+
+    // 为已认证的用户签发令牌，claims_out 可为空
+    std::string issue(int64_t user_id, const std::string &username, Claims *claims_out = nullptr);
+
+    // 校验签名、过期时间和吊销状态
+    VerifyResult verify(const std::string &token, Claims &claims_out) const;
+
+    /**
+     * @brief 作废单个令牌
+     * @return true 本次调用作废了它，false 它之前已经被作废。
+     *         恢复时用返回值保证同一个令牌只能被成功使用一次（两个并发的恢复请求只有一个成功）
+     */
+    bool revoke_token(const Claims &claims);
+    void revoke_user(int64_t user_id);
+
+    static const char *verify_result_to_string(VerifyResult result);
+
+private:
+    ResumeTokenService() = default;
+    ~ResumeTokenService() = default;
+
+    ResumeTokenService(const ResumeTokenService &) = delete;
+    ResumeTokenService &operator=(const ResumeTokenService &) = delete;
+
+    static constexpr uint8_t TOKEN_VERSION = 1;
+    static constexpr size_t MAC_SIZE = 32;
+    // 吊销记录超过该数量时清理已过期的条目
+    static constexpr size_t REVOCATION_PURGE_THRESHOLD = 4096;
+
+    std::array<uint8_t, MAC_SIZE> sign(const std::string &payload) const;
+    void purge_expired_locked(int64_t now);
+
+    static int64_t now_seconds();
+    static int64_t now_millis();
+
+    std::string secret_;
+    std::chrono::seconds ttl_{0};
+    bool initialized_ = false;
+
+    // 吊销集合：token_id -> 过期时间（秒）；user_id -> 在此时间（毫秒，含）之前签发的令牌全部无效
+    mutable std::mutex revocation_mutex_;
+    std::unordered_map<uint64_t, int64_t> revoked_tokens_;
+    std::unordered_map<int64_t, int64_t> revoked_users_before_;
+    size_t purge_at_size_ = REVOCATION_PURGE_THRESHOLD;
+};
@@ -0,0 +1,156 @@
+#include "user_cache.h"
+#include "user_manager.h"
+#include <spdlog/spdlog.h>
+#include <sstream>
+
+UserCache::UserCache(size_t capacity, std::chrono::seconds ttl,
+                     size_t negative_capacity, std::chrono::seconds negative_ttl)
+    : by_name_(capacity, ttl), by_id_(capacity, ttl), missing_(capacity == 0 ? 0 : negative_capacity, negative_ttl)
+{
+    spdlog::info("UserCache: capacity={}, ttl={}s, negative_capacity={}, negative_ttl={}s",
+                 capacity, ttl.count(), capacity == 0 ? 0 : negative_capacity, negative_ttl.count());
+}
+
+UserCache::Lookup UserCache::get_by_username(const std::string &username, std::shared_ptr<const User> &out)
+{
+    if (!enabled())
+    {
+        return Lookup::MISS;
+    }
+
+    auto now = Clock::now();
+    if (by_name_.get(username, out, now))
+    {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return Lookup::HIT;
+    }
+
+    std::shared_ptr<const User> ignored;
+    if (missing_.enabled() && missing_.get(username, ignored, now))
+    {
+        negative_hits_.fetch_add(1, std::memory_order_relaxed);
+        return Lookup::NEGATIVE_HIT;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return Lookup::MISS;
+}
+
+UserCache::Lookup UserCache::get_by_id(int64_t user_id, std::shared_ptr<const User> &out)
+{
+    if (!enabled())
+    {
+        return Lookup::MISS;
+    }
+
+    if (by_id_.get(user_id, out, Clock::now()))
+    {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return Lookup::HIT;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return Lookup::MISS;
+}
+
+void UserCache::put(const User &user, uint64_t fill_epoch)
+{
+    if (!enabled())
+    {
+        return;
+    }
+
+    // 两张表共享同一个不可变的 User 对象
+    auto value = std::make_shared<const User>(user);
+    auto now = Clock::now();
+
+    size_t evicted = by_name_.put(user.username, value, now, fill_epoch, write_epoch_);
+    evicted += by_id_.put(user.user_id, std::move(value), now, fill_epoch, write_epoch_);
+    if (evicted > 0)
+    {
+        evictions_.fetch_add(evicted, std::memory_order_relaxed);
+    }
+}
+
+void UserCache::put_missing(const std::string &username, uint64_t fill_epoch)
+{
+    if (!missing_.enabled())
+    {
+        return;
+    }
+
+    size_t evicted = missing_.put(username, nullptr, Clock::now(), fill_epoch, write_epoch_);
+    if (evicted > 0)
+    {
+        evictions_.fetch_add(evicted, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * 先推进 epoch 再删除：并发中的回填要么看到新 epoch 被丢弃，要么先写入、随后被这里删除
+ */
+void UserCache::invalidate(const std::string &username, int64_t user_id)
+{
+    if (!enabled())
+    {
+        return;
+    }
+
+    write_epoch_.fetch_add(1, std::memory_order_acq_rel);
+    by_name_.erase(username);
+    by_id_.erase(user_id);
+    missing_.erase(username);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void UserCache::invalidate_username(const std::string &username)
+{
+    if (!enabled())
+    {
+        return;
+    }
+
+    write_epoch_.fetch_add(1, std::memory_order_acq_rel);
+
+    // 按用户名失效时 by_id_ 中的对应条目也要删掉
+    std::shared_ptr<const User> cached;
+    if (by_name_.get(username, cached, Clock::now()) && cached)
+    {
+        by_id_.erase(cached->user_id);
+    }
+    by_name_.erase(username);
+    missing_.erase(username);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+UserCache::Stats UserCache::get_stats() const
+{
+    Stats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.negative_hits = negative_hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.evictions = evictions_.load(std::memory_order_relaxed);
+    stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+    stats.entries = by_name_.size();
+    stats.negative_entries = missing_.size();
+    return stats;
+}
+
+std::string UserCache::get_stats_string() const
+{
+    auto stats = get_stats();
+    uint64_t lookups = stats.hits + stats.negative_hits + stats.misses;
+    double hit_ratio = lookups == 0 ? 0.0 : static_cast<double>(stats.hits + stats.negative_hits) / lookups;
+
+    std::ostringstream oss;
+    oss << "UserCache Stats: "
+        << "Hits=" << stats.hits
+        << ", NegativeHits=" << stats.negative_hits
+        << ", Misses=" << stats.misses
+        << ", HitRatio=" << hit_ratio
+        << ", Evictions=" << stats.evictions
+        << ", Invalidations=" << stats.invalidations
+        << ", Entries=" << stats.entries
+        << ", NegativeEntries=" << stats.negative_entries;
+    return oss.str();
+}
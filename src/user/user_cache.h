@@ -0,0 +1,225 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct User;
+
+/**
+ * @brief 用户记录缓存
+ *
+ * 挡在 UserManager 的 MySQL 查询前面，三张分片 LRU 表：
+ * - by_name_：username -> User，登录路径使用
+ * - by_id_：user_id -> User，按 ID 查找（消息投递等）使用，与 by_name_ 共享同一个 User 对象
+ * - missing_：不存在的 username，负缓存，TTL 更短、容量独立，
+ *   撞库流量里大量的随机用户名不会把正常用户挤出 by_name_
+ *
+ * 每个分片一把锁 + 一条 LRU 链表，条目带过期时间，读到过期条目按未命中处理。
+ *
+ * 写入一致性：任何写操作（注册、改密码哈希）在数据库提交后调用 invalidate()，
+ * invalidate() 会推进 write_epoch_。查询未命中时先用 begin_fill() 取当前 epoch，查完数据库再带着它回填；
+ * 如果期间发生过 invalidate()，回填被丢弃，避免把写之前读到的旧结果（尤其是 "用户不存在"）放回缓存。
+ */
+class UserCache
+{
+public:
+    enum class Lookup
+    {
+        MISS,        // 缓存里没有，需要查数据库
+        HIT,         // 命中，out 为用户记录
+        NEGATIVE_HIT // 命中负缓存：最近确认过该用户名不存在
+    };
+
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t negative_hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t invalidations = 0;
+        size_t entries = 0;
+        size_t negative_entries = 0;
+    };
+
+    /**
+     * @param capacity 正向缓存容量（用户数），0 表示关闭缓存
+     * @param ttl 正向条目有效期
+     * @param negative_capacity 负缓存容量，0 表示关闭负缓存
+     * @param negative_ttl 负缓存条目有效期
+     */
+    UserCache(size_t capacity, std::chrono::seconds ttl,
+              size_t negative_capacity, std::chrono::seconds negative_ttl);
+
+    UserCache(const UserCache &) = delete;
+    UserCache &operator=(const UserCache &) = delete;
+
+    bool enabled() const { return by_name_.enabled(); }
+
+    Lookup get_by_username(const std::string &username, std::shared_ptr<const User> &out);
+    Lookup get_by_id(int64_t user_id, std::shared_ptr<const User> &out);
+
+    // 查询数据库之前调用，返回值传给 put / put_missing
+    uint64_t begin_fill() const { return write_epoch_.load(std::memory_order_acquire); }
+
+    // 用数据库查询结果回填；fill_epoch 之后发生过 invalidate 时丢弃
+    void put(const User &user, uint64_t fill_epoch);
+    void put_missing(const std::string &username, uint64_t fill_epoch);
+
+    // 写操作提交后调用，删除该用户的所有缓存条目（包括负缓存）
+    void invalidate(const std::string &username, int64_t user_id);
+    void invalidate_username(const std::string &username);
+
+    Stats get_stats() const;
+    std::string get_stats_string() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t SHARD_COUNT = 16;
+
+    /**
+     * 分片 LRU：每个分片一把锁、一条按最近使用排序的链表和一张索引表
+     */
+    template <typename Key>
+    class ShardedLru
+    {
+    public:
+        ShardedLru(size_t capacity, Clock::duration ttl)
+            : capacity_per_shard_(capacity == 0 ? 0 : (capacity + SHARD_COUNT - 1) / SHARD_COUNT), ttl_(ttl)
+        {
+        }
+
+        bool enabled() const { return capacity_per_shard_ > 0; }
+
+        // 命中返回 true；过期条目在这里顺便删除
+        bool get(const Key &key, std::shared_ptr<const User> &out, Clock::time_point now)
+        {
+            auto &shard = shard_of(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            auto it = shard.index.find(key);
+            if (it == shard.index.end())
+            {
+                return false;
+            }
+            if (it->second->expires_at <= now)
+            {
+                shard.lru.erase(it->second);
+                shard.index.erase(it);
+                return false;
+            }
+
+            // 移到链表头部（最近使用）
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            out = it->second->value;
+            return true;
+        }
+
+        // 返回因容量不足淘汰的条目数；epoch 与 current_epoch 不一致时不写入
+        size_t put(const Key &key, std::shared_ptr<const User> value, Clock::time_point now,
+                   uint64_t epoch, const std::atomic<uint64_t> &current_epoch)
+        {
+            if (!enabled())
+            {
+                return 0;
+            }
+
+            auto &shard = shard_of(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            if (current_epoch.load(std::memory_order_acquire) != epoch)
+            {
+                return 0;
+            }
+
+            auto it = shard.index.find(key);
+            if (it != shard.index.end())
+            {
+                it->second->value = std::move(value);
+                it->second->expires_at = now + ttl_;
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+                return 0;
+            }
+
+            shard.lru.push_front(Node{key, std::move(value), now + ttl_});
+            shard.index.emplace(key, shard.lru.begin());
+
+            size_t evicted = 0;
+            while (shard.lru.size() > capacity_per_shard_)
+            {
+                shard.index.erase(shard.lru.back().key);
+                shard.lru.pop_back();
+                ++evicted;
+            }
+            return evicted;
+        }
+
+        void erase(const Key &key)
+        {
+            auto &shard = shard_of(key);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+
+            auto it = shard.index.find(key);
+            if (it != shard.index.end())
+            {
+                shard.lru.erase(it->second);
+                shard.index.erase(it);
+            }
+        }
+
+        size_t size() const
+        {
+            size_t total = 0;
+            for (const auto &shard : shards_)
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                total += shard.lru.size();
+            }
+            return total;
+        }
+
+    private:
+        struct Node
+        {
+            Key key;
+            std::shared_ptr<const User> value; // 负缓存中为空
+            Clock::time_point expires_at;
+        };
+
+        struct alignas(64) Shard
+        {
+            mutable std::mutex mutex;
+            std::list<Node> lru;
+            std::unordered_map<Key, typename std::list<Node>::iterator> index;
+        };
+
+        Shard &shard_of(const Key &key)
+        {
+            return shards_[std::hash<Key>{}(key) & (SHARD_COUNT - 1)];
+        }
+
+        const size_t capacity_per_shard_;
+        const Clock::duration ttl_;
+        std::array<Shard, SHARD_COUNT> shards_;
+    };
+
+    ShardedLru<std::string> by_name_;
+    ShardedLru<int64_t> by_id_;
+    ShardedLru<std::string> missing_;
+
+    std::atomic<uint64_t> write_epoch_{0};
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> negative_hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> invalidations_{0};
+};
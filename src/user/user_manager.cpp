@@ -1,9 +1,31 @@
 #include "user_manager.h"
 #include <spdlog/spdlog.h>
-#include <crypt.h>
-#include <random>
-#include <regex>
+#include "../logging/log_limiter.h"
+#include "../metrics/metrics_registry.h"
+#include "../database/query.h"
 #include <ctime>
+#include <algorithm>
+
+namespace
+{
+
+// 热点 SQL：文本即语句缓存的键，每条连接上各 prepare 一次
+constexpr const char *SQL_INSERT_USER = "INSERT INTO users (username, password_hash) VALUES (?, ?)";
+constexpr const char *SQL_UPDATE_PASSWORD_HASH =
+    "UPDATE users SET password_hash = ? WHERE user_id = ? AND password_hash = ?";
+constexpr const char *SQL_SELECT_USER_BY_USERNAME =
+    "SELECT user_id, username, password_hash, created_at FROM users WHERE username = ?";
+constexpr const char *SQL_SELECT_USER_BY_ID =
+    "SELECT user_id, username, password_hash, created_at FROM users WHERE user_id = ?";
+
+// SQL 执行耗时（prepare + execute，不含借连接的等待，后者由连接池统计）
+LatencyHistogram &db_query_histogram(const char *query)
+{
+    return MetricsRegistry::get_instance().histogram("im_db_query_duration_seconds", "Time spent executing SQL statements",
+                                                     MetricsRegistry::label("query", query));
+}
+
+} // namespace
 
 UserManager &UserManager::get_instance()
 {
@@ -11,7 +33,8 @@ UserManager &UserManager::get_instance()
     return instance;
 }
 
-bool UserManager::initialize()
+bool UserManager::initialize(const Config::UserCacheConfig &cache_config,
+                             const Config::PasswordConfig &password_config)
 {
     if (initialized_)
     {
@@ -27,11 +50,28 @@ bool UserManager::initialize()
         return false;
     }
 
+    cache_ = std::make_unique<UserCache>(
+        static_cast<size_t>(std::max(0, cache_config.capacity)),
+        std::chrono::seconds(std::max(1, cache_config.ttl_sec)),
+        static_cast<size_t>(std::max(0, cache_config.negative_capacity)),
+        std::chrono::seconds(std::max(1, cache_config.negative_ttl_sec)));
+
+    hasher_ = std::make_unique<PasswordHasher>(password_config);
+    hasher_->start();
+
     initialized_ = true;
     spdlog::info("UserManager initialized successfully");
     return true;
 }
 
+void UserManager::shutdown()
+{
+    if (hasher_)
+    {
+        hasher_->stop();
+    }
+}
+
 UserManager::RegisterResult UserManager::register_user(const std::string &username, const std::string &password)
 {
     if (!initialized_)
@@ -43,47 +83,56 @@ UserManager::RegisterResult UserManager::register_user(const std::string &userna
     // 验证输入
     if (!is_valid_username(username))
     {
-        spdlog::warn("Invalid username: {}", username);
+        LOG_RATE_LIMITED(spdlog::level::warn, "Invalid username: {}", username);
         return RegisterResult::INVALID_USERNAME;
     }
 
     if (!is_valid_password(password))
     {
-        spdlog::warn("Invalid password for user: {}", username);
+        LOG_RATE_LIMITED(spdlog::level::warn, "Invalid password for user: {}", username);
         return RegisterResult::INVALID_PASSWORD;
     }
 
+    // 缓存里已有该用户，不必再花一次密码哈希和一次数据库往返
+    std::shared_ptr<const User> cached;
+    if (cache_->get_by_username(username, cached) == UserCache::Lookup::HIT)
+    {
+        spdlog::debug("Username already exists: {}", username);
+        return RegisterResult::USERNAME_EXISTS;
+    }
+
     try
     {
-        auto conn = DatabaseManager::get_instance().get_connection();
-        if (!conn)
+        // 先哈希再借连接，避免哈希期间占用连接池
+        std::string password_hash;
+        switch (hasher_->hash(password, password_hash))
         {
+        case PasswordHasher::Result::OK:
+            break;
+        case PasswordHasher::Result::BUSY:
+            LOG_RATE_LIMITED(spdlog::level::warn, "Password hasher busy, rejecting registration: {}", username);
+            return RegisterResult::SERVER_BUSY;
+        default:
+            spdlog::error("Password hashing failed for user: {}", username);
             return RegisterResult::DATABASE_ERROR;
         }
 
-        // 检查用户名是否已存在
-        std::unique_ptr<sql::PreparedStatement> check_stmt(
-            conn->prepareStatement("SELECT user_id FROM users WHERE username = ?"));
-        check_stmt->setString(1, username);
-
-        std::unique_ptr<sql::ResultSet> res(check_stmt->executeQuery());
-        if (res->next())
+        auto conn = DatabaseManager::get_instance().get_connection();
+        if (!conn)
         {
-            spdlog::info("Username already exists: {}", username);
-            return RegisterResult::USERNAME_EXISTS;
+            return RegisterResult::DATABASE_ERROR;
         }
 
-        // 创建新用户
-        std::string password_hash = hash_password(password);
-        std::unique_ptr<sql::PreparedStatement> insert_stmt(
-            conn->prepareStatement("INSERT INTO users (username, password_hash) VALUES (?, ?)"));
-        insert_stmt->setString(1, username);
-        insert_stmt->setString(2, password_hash);
-
-        int affected_rows = insert_stmt->executeUpdate();
+        // 直接 INSERT，用户名重复由 UNIQUE 约束报错（1062），不再先 SELECT 检查
+        // 先 SELECT 再 INSERT 本来就有竞态：两个并发注册都可能通过检查，最终还是要靠 UNIQUE 约束
+        static LatencyHistogram &insert_latency = db_query_histogram("insert_user");
+        ScopedLatency timer(insert_latency);
+        int affected_rows = Query(conn, SQL_INSERT_USER).bind(username, password_hash).execute_update();
         if (affected_rows > 0)
         {
-            spdlog::info("User registered successfully: {}", username);
+            // 清掉该用户名的负缓存（之前可能有人用它尝试登录过）
+            cache_->invalidate_username(username);
+            spdlog::debug("User registered successfully: {}", username);
             return RegisterResult::SUCCESS;
         }
         else
@@ -94,6 +143,11 @@ UserManager::RegisterResult UserManager::register_user(const std::string &userna
     }
     catch (sql::SQLException &e)
     {
+        if (e.getErrorCode() == MYSQL_DUPLICATE_ENTRY)
+        {
+            spdlog::debug("Username already exists: {}", username);
+            return RegisterResult::USERNAME_EXISTS;
+        }
         spdlog::error("Database error during user registration: {} (code: {}, state: {})",
                       e.what(), e.getErrorCode(), e.getSQLState());
         return RegisterResult::DATABASE_ERROR;
@@ -120,22 +174,37 @@ UserManager::LoginResult UserManager::authenticate_user(const std::string &usern
         auto user_opt = find_user_by_username(username);
         if (!user_opt.has_value())
         {
-            spdlog::info("User not found: {}", username);
+            spdlog::debug("User not found: {}", username);
             return LoginResult::USER_NOT_FOUND;
         }
 
         User &user = user_opt.value();
 
         // 验证密码
-        if (!verify_password(password, user.password_hash))
+        switch (hasher_->verify(password, user.password_hash))
         {
-            spdlog::info("Wrong password for user: {}", username);
+        case PasswordHasher::Result::OK:
+            break;
+        case PasswordHasher::Result::BUSY:
+            LOG_RATE_LIMITED(spdlog::level::warn, "Password hasher busy, rejecting login: {}", username);
+            return LoginResult::SERVER_BUSY;
+        case PasswordHasher::Result::MISMATCH:
+            spdlog::debug("Wrong password for user: {}", username);
             return LoginResult::WRONG_PASSWORD;
+        case PasswordHasher::Result::FAILED:
+            spdlog::error("Stored password hash is invalid for user: {}", username);
+            return LoginResult::WRONG_PASSWORD;
+        }
+
+        // 哈希参数已调整（如提高了 rounds），趁手上有明文密码时迁移
+        if (hasher_->needs_rehash(user.password_hash))
+        {
+            rehash_password(user, password);
         }
 
         // 返回用户信息
         user_out = user;
-        spdlog::info("User authenticated successfully: {}", username);
+        spdlog::debug("User authenticated successfully: {}", username);
         return LoginResult::SUCCESS;
     }
     catch (const std::exception &e)
@@ -147,108 +216,169 @@ UserManager::LoginResult UserManager::authenticate_user(const std::string &usern
 
 std::optional<User> UserManager::find_user_by_username(const std::string &username)
 {
+    if (!initialized_)
+    {
+        spdlog::error("UserManager not initialized");
+        return std::nullopt;
+    }
+
+    std::shared_ptr<const User> cached;
+    switch (cache_->get_by_username(username, cached))
+    {
+    case UserCache::Lookup::HIT:
+        return *cached;
+    case UserCache::Lookup::NEGATIVE_HIT:
+        return std::nullopt;
+    case UserCache::Lookup::MISS:
+        break;
+    }
+
+    uint64_t fill_epoch = cache_->begin_fill();
+    User user;
+    switch (query_user_by_username(username, user))
+    {
+    case QueryStatus::FOUND:
+        cache_->put(user, fill_epoch);
+        return user;
+    case QueryStatus::NOT_FOUND:
+        // 只有确认不存在时才写负缓存，数据库出错不缓存
+        cache_->put_missing(username, fill_epoch);
+        return std::nullopt;
+    case QueryStatus::ERROR:
+        break;
+    }
+    return std::nullopt;
+}
+
+std::optional<User> UserManager::find_user_by_id(int64_t user_id)
+{
+    if (!initialized_)
+    {
+        spdlog::error("UserManager not initialized");
+        return std::nullopt;
+    }
+
+    std::shared_ptr<const User> cached;
+    if (cache_->get_by_id(user_id, cached) == UserCache::Lookup::HIT)
+    {
+        return *cached;
+    }
+
+    uint64_t fill_epoch = cache_->begin_fill();
+    User user;
+    if (query_user_by_id(user_id, user) == QueryStatus::FOUND)
+    {
+        cache_->put(user, fill_epoch);
+        return user;
+    }
+    return std::nullopt;
+}
+
+std::string UserManager::get_cache_stats_string() const
+{
+    return cache_ ? cache_->get_stats_string() : "UserCache Stats: not initialized";
+}
+
+std::string UserManager::get_hasher_stats_string() const
+{
+    return hasher_ ? hasher_->get_stats_string() : "PasswordHasher Stats: not initialized";
+}
+
+void UserManager::rehash_password(const User &user, const std::string &password)
+{
+    std::string new_hash;
+    if (hasher_->hash(password, new_hash) != PasswordHasher::Result::OK)
+    {
+        // 繁忙或失败时保留旧哈希，下次登录再试
+        return;
+    }
+
     try
     {
         auto conn = DatabaseManager::get_instance().get_connection();
         if (!conn)
         {
-            return std::nullopt;
+            return;
         }
 
-        std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->prepareStatement("SELECT user_id, username, password_hash, created_at FROM users WHERE username = ?"));
-        stmt->setString(1, username);
-
-        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
-        if (res->next())
+        // 带上旧哈希作为条件：并发修改过密码时不覆盖
+        static LatencyHistogram &update_latency = db_query_histogram("rehash_update");
+        ScopedLatency timer(update_latency);
+        if (Query(conn, SQL_UPDATE_PASSWORD_HASH).bind(new_hash, user.user_id, user.password_hash).execute_update() > 0)
         {
-            User user;
-            user.user_id = res->getInt64("user_id");
-            user.username = res->getString("username");
-            user.password_hash = res->getString("password_hash");
-            user.created_at = res->getString("created_at");
-            return user;
+            cache_->invalidate(user.username, user.user_id);
+            LOG_RATE_LIMITED(spdlog::level::info, "Rehashed password for user: {} (rounds={})", user.username, hasher_->rounds());
         }
-
-        return std::nullopt;
     }
     catch (sql::SQLException &e)
     {
-        spdlog::error("Database error finding user by username: {} (code: {}, state: {})",
+        spdlog::error("Database error rehashing password: {} (code: {}, state: {})",
                       e.what(), e.getErrorCode(), e.getSQLState());
-        return std::nullopt;
     }
 }
 
-std::optional<User> UserManager::find_user_by_id(int64_t user_id)
+UserManager::QueryStatus UserManager::query_user_by_username(const std::string &username, User &user_out)
 {
     try
     {
         auto conn = DatabaseManager::get_instance().get_connection();
         if (!conn)
         {
-            return std::nullopt;
+            return QueryStatus::ERROR;
         }
 
-        std::unique_ptr<sql::PreparedStatement> stmt(
-            conn->prepareStatement("SELECT user_id, username, password_hash, created_at FROM users WHERE user_id = ?"));
-        stmt->setInt64(1, user_id);
-
-        std::unique_ptr<sql::ResultSet> res(stmt->executeQuery());
+        static LatencyHistogram &query_latency = db_query_histogram("user_by_username");
+        ScopedLatency timer(query_latency);
+        auto res = Query(conn, SQL_SELECT_USER_BY_USERNAME).bind(username).execute_query();
         if (res->next())
         {
-            User user;
-            user.user_id = res->getInt64("user_id");
-            user.username = res->getString("username");
-            user.password_hash = res->getString("password_hash");
-            user.created_at = res->getString("created_at");
-            return user;
+            user_out.user_id = res->getInt64("user_id");
+            user_out.username = res->getString("username");
+            user_out.password_hash = res->getString("password_hash");
+            user_out.created_at = res->getString("created_at");
+            return QueryStatus::FOUND;
         }
 
-        return std::nullopt;
+        return QueryStatus::NOT_FOUND;
     }
     catch (sql::SQLException &e)
     {
-        spdlog::error("Database error finding user by ID: {} (code: {}, state: {})",
+        spdlog::error("Database error finding user by username: {} (code: {}, state: {})",
                       e.what(), e.getErrorCode(), e.getSQLState());
-        return std::nullopt;
+        return QueryStatus::ERROR;
     }
 }
 
-std::string UserManager::hash_password(const std::string &password)
+UserManager::QueryStatus UserManager::query_user_by_id(int64_t user_id, User &user_out)
 {
-    // 生成随机salt
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 61); // 0-9, A-Z, a-z
-
-    const std::string chars = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-    std::string salt = "$6$rounds=5000$";
-    for (int i = 0; i < 16; ++i)
-    {
-        salt += chars[dis(gen)];
-    }
-    salt += "$";
-
-    // 使用crypt进行哈希
-    char *hashed = crypt(password.c_str(), salt.c_str());
-    if (hashed == nullptr)
+    try
     {
-        throw std::runtime_error("Password hashing failed");
-    }
+        auto conn = DatabaseManager::get_instance().get_connection();
+        if (!conn)
+        {
+            return QueryStatus::ERROR;
+        }
 
-    return std::string(hashed);
-}
+        static LatencyHistogram &query_latency = db_query_histogram("user_by_id");
+        ScopedLatency timer(query_latency);
+        auto res = Query(conn, SQL_SELECT_USER_BY_ID).bind(user_id).execute_query();
+        if (res->next())
+        {
+            user_out.user_id = res->getInt64("user_id");
+            user_out.username = res->getString("username");
+            user_out.password_hash = res->getString("password_hash");
+            user_out.created_at = res->getString("created_at");
+            return QueryStatus::FOUND;
+        }
 
-bool UserManager::verify_password(const std::string &password, const std::string &hash)
-{
-    char *verified = crypt(password.c_str(), hash.c_str());
-    if (verified == nullptr)
+        return QueryStatus::NOT_FOUND;
+    }
+    catch (sql::SQLException &e)
     {
-        return false;
+        spdlog::error("Database error finding user by ID: {} (code: {}, state: {})",
+                      e.what(), e.getErrorCode(), e.getSQLState());
+        return QueryStatus::ERROR;
     }
-
-    return hash == std::string(verified);
 }
 
 bool UserManager::is_valid_username(const std::string &username)
@@ -259,8 +389,16 @@ bool UserManager::is_valid_username(const std::string &username)
         return false;
     }
 
-    std::regex username_regex("^[a-zA-Z0-9_]+$");
-    return std::regex_match(username, username_regex);
+    // 逐字符检查，不再每次调用都构造 std::regex
+    for (char c : username)
+    {
+        bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        if (!allowed)
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
 bool UserManager::is_valid_password(const std::string &password)
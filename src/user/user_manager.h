@@ -5,6 +5,9 @@
 #include <optional>
 #include <cstdint>
 #include "../database/database_manager.h"
+#include "../config/config.h"
+#include "user_cache.h"
+#include "password_hasher.h"
 
 /**
  * 用户信息结构体
@@ -26,8 +29,12 @@ class UserManager
 public:
     static UserManager &get_instance();
 
-    // 初始化用户管理器
-    bool initialize();
+    // 初始化用户管理器，同时按配置创建用户缓存和密码哈希线程池
+    bool initialize(const Config::UserCacheConfig &cache_config = Config::UserCacheConfig(),
+                    const Config::PasswordConfig &password_config = Config::PasswordConfig());
+
+    // 停止密码哈希线程池（已排队的哈希会先执行完）
+    void shutdown();
 
     // 用户注册
     enum class RegisterResult
@@ -36,6 +43,7 @@ public:
         USERNAME_EXISTS,
         INVALID_USERNAME,
         INVALID_PASSWORD,
+        SERVER_BUSY, // 密码哈希队列已满
         DATABASE_ERROR
     };
     RegisterResult register_user(const std::string &username, const std::string &password);
@@ -46,16 +54,27 @@ public:
         SUCCESS,
         USER_NOT_FOUND,
         WRONG_PASSWORD,
+        SERVER_BUSY, // 密码哈希队列已满
         DATABASE_ERROR
     };
     LoginResult authenticate_user(const std::string &username, const std::string &password, User &user_out);
 
-    // 根据用户名查找用户
+    // 根据用户名查找用户（先查缓存，未命中再查数据库并回填）
     std::optional<User> find_user_by_username(const std::string &username);
 
-    // 根据用户ID查找用户
+    // 根据用户ID查找用户（先查缓存，未命中再查数据库并回填）
     std::optional<User> find_user_by_id(int64_t user_id);
 
+    // 输入验证：纯函数，不依赖数据库，微基准直接调用
+    static bool is_valid_username(const std::string &username);
+    static bool is_valid_password(const std::string &password);
+
+    // 用户缓存统计
+    std::string get_cache_stats_string() const;
+
+    // 密码哈希统计
+    std::string get_hasher_stats_string() const;
+
 private:
     UserManager() = default;
     ~UserManager() = default;
@@ -64,13 +83,23 @@ private:
     UserManager(const UserManager &) = delete;
     UserManager &operator=(const UserManager &) = delete;
 
-    // 密码哈希相关
-    std::string hash_password(const std::string &password);
-    bool verify_password(const std::string &password, const std::string &hash);
+    // 登录成功后用当前哈希参数重新哈希并写回，失败只记录日志
+    void rehash_password(const User &user, const std::string &password);
+
+    // 数据库查询，不经过缓存
+    enum class QueryStatus
+    {
+        FOUND,
+        NOT_FOUND,
+        ERROR
+    };
+    QueryStatus query_user_by_username(const std::string &username, User &user_out);
+    QueryStatus query_user_by_id(int64_t user_id, User &user_out);
 
-    // 输入验证
-    bool is_valid_username(const std::string &username);
-    bool is_valid_password(const std::string &password);
+    // MySQL ER_DUP_ENTRY：违反 UNIQUE 约束
+    static constexpr int MYSQL_DUPLICATE_ENTRY = 1062;
 
     bool initialized_ = false;
+    std::unique_ptr<UserCache> cache_;
+    std::unique_ptr<PasswordHasher> hasher_;
 };
\ No newline at end of file
@@ -0,0 +1,773 @@
+/**
+ * im_bench：IM 服务器压测工具
+ *
+ * 打开 N 条并发连接，每条连接最多 pipeline 个未完成请求，按比例混合发送 echo / login / register，
+ * 统计每种请求的 p50 / p99 / p999 延迟和实际达到的 QPS。帧的编解码直接复用服务器的
+ * ProtocolHandler::serialize_frame / parse_frame，延迟直方图复用 LatencyHistogram。
+ *
+ * 两种发压模式：
+ * - 闭环（--rate=0，默认）：每条连接始终保持 pipeline 个请求在途，测的是最大吞吐
+ * - 开环（--rate=R）：按总速率 R 均匀排定发送时间，延迟从 "计划发送时间" 开始计，
+ *   服务器变慢时排队时间也计入延迟，避免协调遗漏（coordinated omission）把尾延迟藏起来
+ *
+ * 用法示例：
+ *   im_bench --connections=200 --pipeline=4 --duration=30
+ *   im_bench --connections=1000 --rate=20000 --mix=echo:80,login:15,register:5
+ *   im_bench --connections=200 --pipeline=64 --batch=16   # 每 16 个请求打包成一个 PacketBatch 帧
+ */
+
+#define ASIO_STANDALONE
+#include <asio.hpp>
+#include <spdlog/spdlog.h>
+#include <messages.pb.h>
+#include "protocol/protocol_handler.h"
+#include "metrics/histogram.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+enum RequestKind
+{
+    KIND_ECHO = 0,
+    KIND_LOGIN,
+    KIND_REGISTER,
+    KIND_COUNT
+};
+
+const char *const KIND_NAMES[KIND_COUNT] = {"echo", "login", "register"};
+
+struct BenchOptions
+{
+    std::string host = "127.0.0.1";
+    uint16_t port = 8080;
+    size_t connections = 100;
+    size_t pipeline = 1;      // 每条连接的最大在途请求数
+    double rate = 0.0;        // 总目标 QPS，0 表示闭环压测
+    int duration_sec = 10;    // 统计窗口长度
+    int warmup_sec = 2;       // 统计开始前的预热时间
+    size_t threads = 1;       // 压测端 io 线程数
+    size_t payload_size = 32; // echo 内容长度
+    size_t batch = 1;         // 每帧最多打包的请求数，> 1 时用 PacketBatch 发送
+    std::array<unsigned, KIND_COUNT> mix{{100, 0, 0}};
+    std::string user_prefix = "bench";
+    std::string password = "bench_pass_123";
+};
+
+// 统计窗口：只统计计划发送时间落在 [measure_begin, measure_end) 内、且在 measure_end 之前完成的请求
+struct BenchWindow
+{
+    Clock::time_point measure_begin;
+    Clock::time_point measure_end;
+};
+
+struct BenchStats
+{
+    std::array<LatencyHistogram, KIND_COUNT> latency;
+    LatencyHistogram overall;
+    std::array<std::atomic<uint64_t>, KIND_COUNT> completed{};
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> connect_failures{0};
+    std::atomic<uint64_t> disconnects{0};
+    std::atomic<size_t> ready_connections{0};
+};
+
+/**
+ * 一条压测连接，所有回调都在它所属 io_context 的单个线程上执行，内部状态不需要加锁
+ */
+class BenchConnection : public std::enable_shared_from_this<BenchConnection>
+{
+public:
+    BenchConnection(asio::io_context &io, const BenchOptions &options, const BenchWindow &window,
+                    BenchStats &stats, size_t id)
+        : socket_(io), timer_(io), options_(options), window_(window), stats_(stats),
+          rng_(static_cast<uint32_t>(id * 7919 + 17))
+    {
+        username_ = options_.user_prefix + "_" + std::to_string(::getpid()) + "_" + std::to_string(id);
+        read_buffer_.resize(64 * 1024);
+
+        unsigned total = 0;
+        for (unsigned weight : options_.mix)
+        {
+            total += weight;
+        }
+        mix_total_ = total == 0 ? 1 : total;
+    }
+
+    void start(const asio::ip::tcp::resolver::results_type &endpoints)
+    {
+        auto self = shared_from_this();
+        asio::async_connect(socket_, endpoints,
+                            [this, self](std::error_code ec, const asio::ip::tcp::endpoint &)
+                            {
+                                if (ec)
+                                {
+                                    stats_.connect_failures.fetch_add(1, std::memory_order_relaxed);
+                                    return;
+                                }
+
+                                asio::error_code ignored;
+                                socket_.set_option(asio::ip::tcp::no_delay(true), ignored);
+                                do_read();
+                                setup();
+                            });
+    }
+
+private:
+    struct InFlight
+    {
+        Clock::time_point scheduled;
+        RequestKind kind;
+    };
+
+    /**
+     * 混合中包含 login 时，先为这条连接注册一个专用账号（已存在也可以），响应到达后再开始发压
+     */
+    void setup()
+    {
+        if (options_.mix[KIND_LOGIN] == 0)
+        {
+            begin_load();
+            return;
+        }
+
+        Packet packet = ProtocolHandler::create_packet();
+        setup_sequence_ = next_sequence_++;
+        packet.set_sequence(setup_sequence_);
+        auto *request = packet.mutable_register_request();
+        request->set_username(username_);
+        request->set_password(options_.password);
+        queue_frame(packet);
+        flush();
+    }
+
+    void begin_load()
+    {
+        ready_ = true;
+        stats_.ready_connections.fetch_add(1, std::memory_order_relaxed);
+
+        if (options_.rate > 0)
+        {
+            // 开环：每条连接承担 rate / connections 的速率，首个发送时间随机错开，避免所有连接同时发送
+            interval_ = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(static_cast<double>(options_.connections) / options_.rate));
+            std::uniform_int_distribution<Clock::rep> offset(0, std::max<Clock::rep>(1, interval_.count()));
+            next_send_ = Clock::now() + Clock::duration(offset(rng_));
+            schedule_next();
+        }
+        else
+        {
+            pump();
+        }
+    }
+
+    void schedule_next()
+    {
+        auto self = shared_from_this();
+        timer_.expires_at(next_send_);
+        timer_.async_wait([this, self](std::error_code ec)
+                          {
+                              if (ec || !socket_.is_open())
+                              {
+                                  return;
+                              }
+
+                              auto now = Clock::now();
+                              if (now >= window_.measure_end)
+                              {
+                                  return;
+                              }
+
+                              while (next_send_ <= now)
+                              {
+                                  backlog_.push_back(next_send_);
+                                  next_send_ += interval_;
+                              }
+                              pump();
+                              schedule_next(); });
+    }
+
+    /**
+     * 在 pipeline 窗口允许的范围内发送请求
+     * 开环时发送积压的计划请求（计划时间保留用于计算延迟），闭环时直接补满窗口
+     */
+    void pump()
+    {
+        if (!ready_ || !socket_.is_open())
+        {
+            return;
+        }
+
+        auto now = Clock::now();
+        if (now >= window_.measure_end)
+        {
+            return;
+        }
+
+        if (options_.rate > 0)
+        {
+            while (!backlog_.empty() && in_flight_.size() < options_.pipeline)
+            {
+                send_request(pick_kind(), backlog_.front());
+                backlog_.pop_front();
+            }
+        }
+        else
+        {
+            while (in_flight_.size() < options_.pipeline)
+            {
+                send_request(pick_kind(), now);
+            }
+        }
+
+        flush();
+    }
+
+    RequestKind pick_kind()
+    {
+        std::uniform_int_distribution<unsigned> dist(0, mix_total_ - 1);
+        unsigned roll = dist(rng_);
+        for (int kind = 0; kind < KIND_COUNT; ++kind)
+        {
+            if (roll < options_.mix[kind])
+            {
+                return static_cast<RequestKind>(kind);
+            }
+            roll -= options_.mix[kind];
+        }
+        return KIND_ECHO;
+    }
+
+    void send_request(RequestKind kind, Clock::time_point scheduled)
+    {
+        Packet packet = ProtocolHandler::create_packet();
+        uint32_t sequence = next_sequence_++;
+        packet.set_sequence(sequence);
+
+        switch (kind)
+        {
+        case KIND_ECHO:
+            packet.mutable_echo_request()->set_content(std::string(options_.payload_size, 'x'));
+            break;
+        case KIND_LOGIN:
+        {
+            auto *request = packet.mutable_login_request();
+            request->set_username(username_);
+            request->set_password(options_.password);
+            break;
+        }
+        case KIND_REGISTER:
+        {
+            // 每次注册一个新用户名
+            auto *request = packet.mutable_register_request();
+            request->set_username(username_ + "_r" + std::to_string(register_counter_++));
+            request->set_password(options_.password);
+            break;
+        }
+        default:
+            return;
+        }
+
+        in_flight_.emplace(sequence, InFlight{scheduled, kind});
+        queue_request(packet);
+        stats_.sent.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // --batch > 1 时请求先攒进 pending_batch_，满 batch 个或 flush() 时编码成一帧
+    void queue_request(const Packet &packet)
+    {
+        if (options_.batch <= 1)
+        {
+            queue_frame(packet);
+            return;
+        }
+
+        auto *batch = pending_batch_.mutable_batch();
+        batch->add_packets()->CopyFrom(packet);
+        if (static_cast<size_t>(batch->packets_size()) >= options_.batch)
+        {
+            queue_pending_batch();
+        }
+    }
+
+    void queue_pending_batch()
+    {
+        if (pending_batch_.batch().packets_size() == 0)
+        {
+            return;
+        }
+        pending_batch_.set_version(ProtocolHandler::PROTOCOL_VERSION);
+        queue_frame(pending_batch_);
+        pending_batch_.mutable_batch()->clear_packets();
+    }
+
+    void queue_frame(const Packet &packet)
+    {
+        ProtocolHandler::serialize_frame_into(packet, write_pending_);
+    }
+
+    // 同一时刻只有一个 async_write，期间新产生的帧攒在 write_pending_ 里下一次一起发出
+    void flush()
+    {
+        queue_pending_batch();
+        if (writing_ || write_pending_.empty() || !socket_.is_open())
+        {
+            return;
+        }
+
+        writing_ = true;
+        write_in_flight_.swap(write_pending_);
+        write_pending_.clear();
+
+        auto self = shared_from_this();
+        asio::async_write(socket_, asio::buffer(write_in_flight_),
+                          [this, self](std::error_code ec, std::size_t)
+                          {
+                              writing_ = false;
+                              write_in_flight_.clear();
+                              if (ec)
+                              {
+                                  close();
+                                  return;
+                              }
+                              flush();
+                          });
+    }
+
+    void do_read()
+    {
+        if (read_size_ == read_buffer_.size())
+        {
+            read_buffer_.resize(read_buffer_.size() * 2);
+        }
+
+        auto self = shared_from_this();
+        socket_.async_read_some(
+            asio::buffer(read_buffer_.data() + read_size_, read_buffer_.size() - read_size_),
+            [this, self](std::error_code ec, std::size_t length)
+            {
+                if (ec)
+                {
+                    close();
+                    return;
+                }
+
+                read_size_ += length;
+                if (!process_frames())
+                {
+                    close();
+                    return;
+                }
+                do_read();
+            });
+    }
+
+    bool process_frames()
+    {
+        size_t offset = 0;
+        while (offset < read_size_)
+        {
+            ProtocolHandler::FrameView view;
+            size_t consumed = 0;
+            if (!ProtocolHandler::parse_frame(read_buffer_.data() + offset, read_size_ - offset, view, consumed))
+            {
+                if (consumed > 0)
+                {
+                    // 非法长度头，连接无法恢复
+                    stats_.errors.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                break;
+            }
+
+            Packet packet;
+            if (ProtocolHandler::deserialize_frame(view.data, view.length, packet))
+            {
+                handle_response(packet);
+            }
+            else
+            {
+                stats_.errors.fetch_add(1, std::memory_order_relaxed);
+            }
+            offset += consumed;
+        }
+
+        if (offset > 0)
+        {
+            std::memmove(read_buffer_.data(), read_buffer_.data() + offset, read_size_ - offset);
+            read_size_ -= offset;
+        }
+        return true;
+    }
+
+    // 批量回复逐个拆开处理，整批处理完再补发请求，补发的请求也能凑成一批
+    void handle_response(const Packet &packet)
+    {
+        if (packet.has_batch())
+        {
+            for (const Packet &sub_packet : packet.batch().packets())
+            {
+                complete_request(sub_packet);
+            }
+        }
+        else
+        {
+            complete_request(packet);
+        }
+        if (ready_)
+        {
+            pump();
+        }
+    }
+
+    void complete_request(const Packet &packet)
+    {
+        auto now = Clock::now();
+
+        if (!ready_ && packet.sequence() == setup_sequence_)
+        {
+            // 注册成功或用户名已存在都可以继续，登录失败会计入错误数
+            begin_load();
+            return;
+        }
+
+        auto it = in_flight_.find(packet.sequence());
+        if (it == in_flight_.end())
+        {
+            return;
+        }
+
+        InFlight request = it->second;
+        in_flight_.erase(it);
+
+        bool ok = true;
+        if (packet.has_error())
+        {
+            ok = false;
+        }
+        else if (request.kind == KIND_LOGIN)
+        {
+            ok = packet.has_login_response() && packet.login_response().success();
+        }
+        else if (request.kind == KIND_REGISTER)
+        {
+            ok = packet.has_register_response() && packet.register_response().success();
+        }
+
+        if (!ok)
+        {
+            stats_.errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (request.scheduled >= window_.measure_begin && now < window_.measure_end)
+        {
+            auto latency_us = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - request.scheduled).count());
+            stats_.latency[request.kind].record(latency_us);
+            stats_.overall.record(latency_us);
+            stats_.completed[request.kind].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void close()
+    {
+        if (!socket_.is_open())
+        {
+            return;
+        }
+
+        if (Clock::now() < window_.measure_end)
+        {
+            stats_.disconnects.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        asio::error_code ignored;
+        timer_.cancel(ignored);
+        socket_.close(ignored);
+    }
+
+    asio::ip::tcp::socket socket_;
+    asio::steady_timer timer_;
+    const BenchOptions &options_;
+    const BenchWindow &window_;
+    BenchStats &stats_;
+
+    std::mt19937 rng_;
+    unsigned mix_total_ = 1;
+    std::string username_;
+    uint64_t register_counter_ = 0;
+
+    bool ready_ = false;
+    uint32_t setup_sequence_ = 0;
+    uint32_t next_sequence_ = 1;
+    std::unordered_map<uint32_t, InFlight> in_flight_;
+    Packet pending_batch_;
+
+    // 开环模式：已经到了计划时间、但因 pipeline 窗口已满尚未发出的请求
+    std::deque<Clock::time_point> backlog_;
+    Clock::time_point next_send_;
+    Clock::duration interval_{0};
+
+    std::vector<uint8_t> read_buffer_;
+    size_t read_size_ = 0;
+    std::string write_pending_;
+    std::string write_in_flight_;
+    bool writing_ = false;
+};
+
+void print_usage(const char *program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --host=ADDR          server address (default 127.0.0.1)\n"
+              << "  --port=N             server port (default 8080)\n"
+              << "  --connections=N      concurrent connections (default 100)\n"
+              << "  --pipeline=N         max in-flight requests per connection (default 1)\n"
+              << "  --rate=QPS           total target rate, 0 = closed loop (default 0)\n"
+              << "  --duration=SEC       measurement window (default 10)\n"
+              << "  --warmup=SEC         warmup before measuring (default 2)\n"
+              << "  --threads=N          client io threads (default 1)\n"
+              << "  --payload=BYTES      echo payload size (default 32)\n"
+              << "  --batch=N            pack up to N requests into one PacketBatch frame (default 1)\n"
+              << "  --mix=echo:W,login:W,register:W  request weights (default echo:100)\n"
+              << "  --user-prefix=NAME   username prefix for login/register (default bench)\n";
+}
+
+bool parse_mix(const std::string &value, std::array<unsigned, KIND_COUNT> &mix)
+{
+    mix.fill(0);
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        auto colon = item.find(':');
+        if (colon == std::string::npos)
+        {
+            return false;
+        }
+
+        std::string name = item.substr(0, colon);
+        unsigned weight = static_cast<unsigned>(std::stoul(item.substr(colon + 1)));
+        bool found = false;
+        for (int kind = 0; kind < KIND_COUNT; ++kind)
+        {
+            if (name == KIND_NAMES[kind])
+            {
+                mix[kind] = weight;
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_options(int argc, char *argv[], BenchOptions &options)
+{
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h")
+            {
+                return false;
+            }
+
+            auto eq = arg.find('=');
+            if (arg.rfind("--", 0) != 0 || eq == std::string::npos)
+            {
+                std::cerr << "Invalid argument: " << arg << std::endl;
+                return false;
+            }
+
+            std::string key = arg.substr(2, eq - 2);
+            std::string value = arg.substr(eq + 1);
+
+            if (key == "host")
+                options.host = value;
+            else if (key == "port")
+                options.port = static_cast<uint16_t>(std::stoul(value));
+            else if (key == "connections")
+                options.connections = std::max<size_t>(1, std::stoul(value));
+            else if (key == "pipeline")
+                options.pipeline = std::max<size_t>(1, std::stoul(value));
+            else if (key == "rate")
+                options.rate = std::stod(value);
+            else if (key == "duration")
+                options.duration_sec = std::max(1, std::stoi(value));
+            else if (key == "warmup")
+                options.warmup_sec = std::max(0, std::stoi(value));
+            else if (key == "threads")
+                options.threads = std::max<size_t>(1, std::stoul(value));
+            else if (key == "payload")
+                options.payload_size = std::stoul(value);
+            else if (key == "batch")
+                options.batch = std::max<size_t>(1, std::stoul(value));
+            else if (key == "user-prefix")
+                options.user_prefix = value;
+            else if (key == "mix")
+            {
+                if (!parse_mix(value, options.mix))
+                {
+                    std::cerr << "Invalid mix: " << value << std::endl;
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Unknown option: --" << key << std::endl;
+                return false;
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Invalid option value: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void print_row(const char *name, const LatencyHistogram &histogram, uint64_t completed, double seconds)
+{
+    auto ms = [](uint64_t us)
+    { return static_cast<double>(us) / 1000.0; };
+
+    double mean = completed == 0 ? 0.0 : static_cast<double>(histogram.sum()) / static_cast<double>(histogram.count());
+    std::printf("%-10s %12llu %12.1f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                name,
+                static_cast<unsigned long long>(completed),
+                static_cast<double>(completed) / seconds,
+                mean / 1000.0,
+                ms(histogram.percentile(0.50)),
+                ms(histogram.percentile(0.99)),
+                ms(histogram.percentile(0.999)),
+                ms(histogram.max()));
+}
+
+void print_report(const BenchOptions &options, const BenchStats &stats)
+{
+    double seconds = static_cast<double>(options.duration_sec);
+
+    std::printf("\n=== im_bench results ===\n");
+    std::printf("connections=%zu ready=%zu pipeline=%zu batch=%zu threads=%zu mode=%s",
+                options.connections, stats.ready_connections.load(), options.pipeline, options.batch, options.threads,
+                options.rate > 0 ? "open-loop" : "closed-loop");
+    if (options.rate > 0)
+    {
+        std::printf(" target=%.0f qps", options.rate);
+    }
+    std::printf(" window=%ds\n", options.duration_sec);
+    std::printf("sent=%llu errors=%llu connect_failures=%llu disconnects=%llu\n\n",
+                static_cast<unsigned long long>(stats.sent.load()),
+                static_cast<unsigned long long>(stats.errors.load()),
+                static_cast<unsigned long long>(stats.connect_failures.load()),
+                static_cast<unsigned long long>(stats.disconnects.load()));
+
+    std::printf("%-10s %12s %12s %10s %10s %10s %10s %10s\n",
+                "type", "completed", "qps", "mean(ms)", "p50(ms)", "p99(ms)", "p999(ms)", "max(ms)");
+
+    uint64_t total = 0;
+    for (int kind = 0; kind < KIND_COUNT; ++kind)
+    {
+        uint64_t completed = stats.completed[kind].load();
+        total += completed;
+        if (options.mix[kind] > 0)
+        {
+            print_row(KIND_NAMES[kind], stats.latency[kind], completed, seconds);
+        }
+    }
+    print_row("all", stats.overall, total, seconds);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // 服务器代码里的 spdlog 调用只保留错误
+    spdlog::set_level(spdlog::level::err);
+
+    BenchStats stats;
+    BenchWindow window;
+
+    // 每个压测线程一个 io_context，连接轮流分配
+    std::vector<std::unique_ptr<asio::io_context>> contexts;
+    for (size_t i = 0; i < options.threads; ++i)
+    {
+        contexts.push_back(std::make_unique<asio::io_context>(1));
+    }
+
+    asio::ip::tcp::resolver resolver(*contexts.front());
+    asio::ip::tcp::resolver::results_type endpoints;
+    try
+    {
+        endpoints = resolver.resolve(options.host, std::to_string(options.port));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Failed to resolve " << options.host << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    auto start = Clock::now();
+    window.measure_begin = start + std::chrono::seconds(options.warmup_sec);
+    window.measure_end = window.measure_begin + std::chrono::seconds(options.duration_sec);
+
+    std::cout << "Connecting " << options.connections << " connections to "
+              << options.host << ":" << options.port << " ..." << std::endl;
+
+    for (size_t i = 0; i < options.connections; ++i)
+    {
+        auto connection = std::make_shared<BenchConnection>(*contexts[i % contexts.size()], options, window, stats, i);
+        connection->start(endpoints);
+    }
+
+    std::vector<std::thread> threads;
+    for (auto &context : contexts)
+    {
+        threads.emplace_back([&context]()
+                             { context->run(); });
+    }
+
+    // 统计窗口结束后再留一点时间让在途响应返回（超出窗口的不计入），然后停止
+    std::this_thread::sleep_until(window.measure_end + std::chrono::milliseconds(500));
+    for (auto &context : contexts)
+    {
+        context->stop();
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    print_report(options, stats);
+    return stats.ready_connections.load() == 0 ? 1 : 0;
+}
@@ -0,0 +1,275 @@
+/**
+ * im_microbench：服务器热路径的微基准（Google Benchmark）
+ *
+ * 覆盖：
+ * - 帧编解码：ProtocolHandler::serialize_frame / serialize_frame_into / parse_frame / deserialize_frame，
+ *   EchoRequest 负载从 16B 到 64KB
+ * - 分发：MessageRouter::route_message 查稠密路由表并调用一个空处理器（不含处理器本身的开销）
+ * - 批量：N 个小请求逐帧解析 + 分发，对比打包成一个 PacketBatch 帧解析 + 分发
+ * - 输入校验：UserManager::is_valid_username，附带旧版每次构造 std::regex 的实现作对照
+ * - SessionManager::register_session / unregister_session 在 1-N 个线程并发下的吞吐
+ *
+ * 只在进程内调用，不需要数据库和网络。结果导出为 JSON 便于版本间比较：
+ *   im_microbench --benchmark_out=microbench.json --benchmark_out_format=json
+ *   make microbench_json   # 同上，输出到构建目录
+ */
+
+#define ASIO_STANDALONE
+#include <asio.hpp>
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+#include <messages.pb.h>
+#include "protocol/protocol_handler.h"
+#include "router/message_router.h"
+#include "router/message_handler.h"
+#include "server/session.h"
+#include "server/session_manager.h"
+#include "user/user_manager.h"
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+Packet make_echo_packet(size_t payload_size)
+{
+    Packet packet = ProtocolHandler::create_packet(ProtocolHandler::PROTOCOL_VERSION, 42);
+    packet.mutable_echo_request()->set_content(std::string(payload_size, 'x'));
+    return packet;
+}
+
+// ---------------------------------------------------------------- 帧编解码
+
+void BM_SerializeFrame(benchmark::State &state)
+{
+    Packet packet = make_echo_packet(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        std::string frame = ProtocolHandler::serialize_frame(packet);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * (state.range(0) + 4));
+}
+BENCHMARK(BM_SerializeFrame)->RangeMultiplier(8)->Range(16, 64 << 10);
+
+// 出站队列使用的原地编码：缓冲区复用，不分配
+void BM_SerializeFrameInto(benchmark::State &state)
+{
+    Packet packet = make_echo_packet(static_cast<size_t>(state.range(0)));
+    std::string out;
+    for (auto _ : state)
+    {
+        out.clear();
+        ProtocolHandler::serialize_frame_into(packet, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * (state.range(0) + 4));
+}
+BENCHMARK(BM_SerializeFrameInto)->RangeMultiplier(8)->Range(16, 64 << 10);
+
+void BM_ParseFrame(benchmark::State &state)
+{
+    std::string frame = ProtocolHandler::serialize_frame(make_echo_packet(static_cast<size_t>(state.range(0))));
+    const auto *data = reinterpret_cast<const uint8_t *>(frame.data());
+    for (auto _ : state)
+    {
+        ProtocolHandler::FrameView view;
+        size_t consumed = 0;
+        bool ok = ProtocolHandler::parse_frame(data, frame.size(), view, consumed);
+        benchmark::DoNotOptimize(ok);
+        benchmark::DoNotOptimize(view);
+    }
+}
+BENCHMARK(BM_ParseFrame)->RangeMultiplier(8)->Range(16, 64 << 10);
+
+// 与 Session 相同：在 Arena 上反序列化，每次迭代重置
+void BM_DeserializeFrame(benchmark::State &state)
+{
+    std::string frame = ProtocolHandler::serialize_frame(make_echo_packet(static_cast<size_t>(state.range(0))));
+    const auto *body = reinterpret_cast<const uint8_t *>(frame.data()) + 4;
+    size_t body_size = frame.size() - 4;
+
+    google::protobuf::Arena arena;
+    for (auto _ : state)
+    {
+        Packet *packet = google::protobuf::Arena::CreateMessage<Packet>(&arena);
+        bool ok = ProtocolHandler::deserialize_frame(body, body_size, *packet);
+        benchmark::DoNotOptimize(ok);
+        arena.Reset();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(body_size));
+}
+BENCHMARK(BM_DeserializeFrame)->RangeMultiplier(8)->Range(16, 64 << 10);
+
+// ---------------------------------------------------------------- 分发
+
+// 什么都不做的处理器，测出来的是路由表查找、计数和延迟直方图记录的开销
+class NoopHandler : public MessageHandler
+{
+public:
+    bool handle(const Packet &packet, Session &) override
+    {
+        benchmark::DoNotOptimize(&packet);
+        return true;
+    }
+    std::string get_handler_name() const override { return "NoopHandler"; }
+};
+
+void BM_RouteMessage(benchmark::State &state)
+{
+    MessageRouter router;
+    router.register_handler(Packet::kEchoRequest, std::make_shared<NoopHandler>());
+
+    asio::io_context io_context;
+    auto session = std::make_shared<Session>(asio::ip::tcp::socket(io_context), nullptr);
+
+    google::protobuf::Arena arena;
+    Packet *packet = ProtocolHandler::create_packet(&arena, ProtocolHandler::PROTOCOL_VERSION, 1);
+    packet->mutable_echo_request()->set_content("hello");
+
+    for (auto _ : state)
+    {
+        bool ok = router.route_message(*packet, *session);
+        benchmark::DoNotOptimize(ok);
+    }
+}
+BENCHMARK(BM_RouteMessage);
+
+// N 个 16 字节的 echo 请求：每个一帧（N 次帧解析、反序列化、分发） vs 一个 PacketBatch 帧
+// 两者都以"子请求数"计 items，直接比较每个请求的摊销开销
+void run_frames(benchmark::State &state, const std::string &stream, size_t requests)
+{
+    MessageRouter router;
+    router.register_handler(Packet::kEchoRequest, std::make_shared<NoopHandler>());
+
+    asio::io_context io_context;
+    auto session = std::make_shared<Session>(asio::ip::tcp::socket(io_context), nullptr);
+
+    const auto *data = reinterpret_cast<const uint8_t *>(stream.data());
+    google::protobuf::Arena arena;
+    for (auto _ : state)
+    {
+        size_t offset = 0;
+        while (offset < stream.size())
+        {
+            ProtocolHandler::FrameView view;
+            size_t consumed = 0;
+            ProtocolHandler::parse_frame(data + offset, stream.size() - offset, view, consumed);
+            Packet *packet = google::protobuf::Arena::CreateMessage<Packet>(&arena);
+            if (ProtocolHandler::deserialize_frame(view.data, view.length, *packet))
+            {
+                router.route_message(*packet, *session);
+            }
+            offset += consumed;
+        }
+        arena.Reset();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(requests));
+}
+
+void BM_RouteUnbatched(benchmark::State &state)
+{
+    size_t requests = static_cast<size_t>(state.range(0));
+    std::string stream;
+    for (size_t i = 0; i < requests; ++i)
+    {
+        ProtocolHandler::serialize_frame_into(make_echo_packet(16), stream);
+    }
+    run_frames(state, stream, requests);
+}
+BENCHMARK(BM_RouteUnbatched)->RangeMultiplier(4)->Range(1, 256);
+
+void BM_RouteBatched(benchmark::State &state)
+{
+    size_t requests = static_cast<size_t>(state.range(0));
+    Packet batch = ProtocolHandler::create_packet();
+    for (size_t i = 0; i < requests; ++i)
+    {
+        *batch.mutable_batch()->add_packets() = make_echo_packet(16);
+    }
+    run_frames(state, ProtocolHandler::serialize_frame(batch), requests);
+}
+BENCHMARK(BM_RouteBatched)->RangeMultiplier(4)->Range(1, 256);
+
+// ---------------------------------------------------------------- 输入校验
+
+const std::vector<std::string> &sample_usernames()
+{
+    static const std::vector<std::string> names = {
+        "alice", "bob_1984", "a_very_long_user_name_with_digits_0123456789", "bad name!", "x",
+        "UPPER_lower_123", "semi;colon", "under_score_"};
+    return names;
+}
+
+void BM_IsValidUsername(benchmark::State &state)
+{
+    const auto &names = sample_usernames();
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        bool ok = UserManager::is_valid_username(names[i++ % names.size()]);
+        benchmark::DoNotOptimize(ok);
+    }
+}
+BENCHMARK(BM_IsValidUsername);
+
+// 对照：旧实现每次调用都构造 std::regex
+void BM_IsValidUsernameRegexBaseline(benchmark::State &state)
+{
+    const auto &names = sample_usernames();
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const std::string &name = names[i++ % names.size()];
+        bool ok = name.size() >= 3 && name.size() <= 50 && std::regex_match(name, std::regex("^[a-zA-Z0-9_]+$"));
+        benchmark::DoNotOptimize(ok);
+    }
+}
+BENCHMARK(BM_IsValidUsernameRegexBaseline);
+
+// ---------------------------------------------------------------- SessionManager 并发
+
+// 每个线程注册 / 注销自己的一批会话，测分片锁在并发下的吞吐
+void BM_SessionRegisterUnregister(benchmark::State &state)
+{
+    constexpr size_t SESSIONS_PER_THREAD = 256;
+
+    asio::io_context io_context;
+    std::vector<std::shared_ptr<Session>> sessions;
+    sessions.reserve(SESSIONS_PER_THREAD);
+    for (size_t i = 0; i < SESSIONS_PER_THREAD; ++i)
+    {
+        sessions.push_back(std::make_shared<Session>(asio::ip::tcp::socket(io_context), nullptr));
+    }
+
+    auto &manager = SessionManager::get_instance();
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const auto &session = sessions[i++ % SESSIONS_PER_THREAD];
+        manager.register_session(session);
+        manager.unregister_session(session);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_SessionRegisterUnregister)->ThreadRange(1, 16)->UseRealTime();
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    // 构造 Session 时的 null router 报错和每次注册的日志不计入结果
+    spdlog::set_level(spdlog::level::off);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
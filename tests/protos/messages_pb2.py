@@ -13,7 +13,7 @@ _sym_db = _symbol_database.Default()
 
 
 
-DESCRIPTOR = _descriptor_pool.Default().AddSerializedFile(b'\n\x15protos/messages.proto\"\x1e\n\x0b\x45\x63hoRequest\x12\x0f\n\x07\x63ontent\x18\x01 \x01(\t\"\x1f\n\x0c\x45\x63hoResponse\x12\x0f\n\x07\x63ontent\x18\x01 \x01(\t\"5\n\x0fRegisterRequest\x12\x10\n\x08username\x18\x01 \x01(\t\x12\x10\n\x08password\x18\x02 \x01(\t\"E\n\x10RegisterResponse\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x0f\n\x07user_id\x18\x03 \x01(\x03\"2\n\x0cLoginRequest\x12\x10\n\x08username\x18\x01 \x01(\t\x12\x10\n\x08password\x18\x02 \x01(\t\"T\n\rLoginResponse\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x0f\n\x07user_id\x18\x03 \x01(\x03\x12\x10\n\x08username\x18\x04 \x01(\t\"\x92\x01\n\rErrorResponse\x12\x12\n\nerror_code\x18\x01 \x01(\r\x12\x0f\n\x07message\x18\x02 \x01(\t\x12,\n\x07\x64\x65tails\x18\x03 \x03(\x0b\x32\x1b.ErrorResponse.DetailsEntry\x1a.\n\x0c\x44\x65tailsEntry\x12\x0b\n\x03key\x18\x01 \x01(\t\x12\r\n\x05value\x18\x02 \x01(\t:\x02\x38\x01\"\xd6\x02\n\x06Packet\x12\x0f\n\x07version\x18\x01 \x01(\r\x12\x10\n\x08sequence\x18\x02 \x01(\r\x12$\n\x0c\x65\x63ho_request\x18\n \x01(\x0b\x32\x0c.EchoRequestH\x00\x12&\n\recho_response\x18\x0b \x01(\x0b\x32\r.EchoResponseH\x00\x12,\n\x10register_request\x18\x64 \x01(\x0b\x32\x10.RegisterRequestH\x00\x12.\n\x11register_response\x18\x65 \x01(\x0b\x32\x11.RegisterResponseH\x00\x12&\n\rlogin_request\x18\x66 \x01(\x0b\x32\r.LoginRequestH\x00\x12(\n\x0elogin_response\x18g \x01(\x0b\x32\x0e.LoginResponseH\x00\x12 \n\x05\x65rror\x18\xe7\x07 \x01(\x0b\x32\x0e.ErrorResponseH\x00\x42\t\n\x07payloadb\x06proto3')
+DESCRIPTOR = _descriptor_pool.Default().AddSerializedFile(b'\n\x15protos/messages.proto\"\x1e\n\x0b\x45\x63hoRequest\x12\x0f\n\x07\x63ontent\x18\x01 \x01(\t\"\x1f\n\x0c\x45\x63hoResponse\x12\x0f\n\x07\x63ontent\x18\x01 \x01(\t\"\x1c\n\x04Ping\x12\x14\n\x0ctimestamp_ms\x18\x01 \x01(\x03\"\x1c\n\x04Pong\x12\x14\n\x0ctimestamp_ms\x18\x01 \x01(\x03\"=\n\x11\x43\x61pabilityRequest\x12\x13\n\x0b\x63ompression\x18\x01 \x01(\r\x12\x13\n\x0boffline_ack\x18\x02 \x01(\x08\"]\n\x12\x43\x61pabilityResponse\x12\x13\n\x0b\x63ompression\x18\x01 \x01(\r\x12\x1d\n\x15\x63ompression_threshold\x18\x02 \x01(\r\x12\x13\n\x0boffline_ack\x18\x03 \x01(\x08\"\'\n\x0bPacketBatch\x12\x18\n\x07packets\x18\x01 \x03(\x0b\x32\x07.Packet\"5\n\x0fRegisterRequest\x12\x10\n\x08username\x18\x01 \x01(\t\x12\x10\n\x08password\x18\x02 \x01(\t\"E\n\x10RegisterResponse\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x0f\n\x07user_id\x18\x03 \x01(\x03\"2\n\x0cLoginRequest\x12\x10\n\x08username\x18\x01 \x01(\t\x12\x10\n\x08password\x18\x02 \x01(\t\"\x85\x01\n\rLoginResponse\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x0f\n\x07user_id\x18\x03 \x01(\x03\x12\x10\n\x08username\x18\x04 \x01(\t\x12\x14\n\x0cresume_token\x18\x05 \x01(\t\x12\x19\n\x11resume_expires_at\x18\x06 \x01(\x03\"%\n\rResumeRequest\x12\x14\n\x0cresume_token\x18\x01 \x01(\t\"\x86\x01\n\x0eResumeResponse\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x0f\n\x07user_id\x18\x03 \x01(\x03\x12\x10\n\x08username\x18\x04 \x01(\t\x12\x14\n\x0cresume_token\x18\x05 \x01(\t\x12\x19\n\x11resume_expires_at\x18\x06 \x01(\x03\"\x84\x01\n\x0b\x43hatMessage\x12\x14\n\x0crecipient_id\x18\x01 \x01(\x03\x12\x0f\n\x07\x63ontent\x18\x02 \x01(\t\x12\x15\n\rclient_msg_id\x18\x03 \x01(\t\x12\x11\n\tsender_id\x18\x04 \x01(\x03\x12\x0e\n\x06msg_id\x18\x05 \x01(\x04\x12\x14\n\x0ctimestamp_ms\x18\x06 \x01(\x03\"\xcf\x01\n\x07\x43hatAck\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x0e\n\x06msg_id\x18\x03 \x01(\x04\x12\x15\n\rclient_msg_id\x18\x04 \x01(\t\x12\x14\n\x0ctimestamp_ms\x18\x05 \x01(\x03\x12\x1a\n\x12\x64\x65livered_sessions\x18\x06 \x01(\r\x12\x16\n\x0estored_offline\x18\x07 \x01(\x08\x12\x17\n\x0f\x66orwarded_nodes\x18\x08 \x01(\r\x12\x18\n\x10\x64ropped_sessions\x18\t \x01(\r\"\x1d\n\nOfflineAck\x12\x0f\n\x07msg_ids\x18\x01 \x03(\x04\"6\n\x12\x43reateGroupRequest\x12\x0c\n\x04name\x18\x01 \x01(\t\x12\x12\n\nmember_ids\x18\x02 \x03(\x03\"$\n\x10JoinGroupRequest\x12\x10\n\x08group_id\x18\x01 \x01(\x03\"%\n\x11LeaveGroupRequest\x12\x10\n\x08group_id\x18\x01 \x01(\x03\"Y\n\rGroupResponse\x12\x0f\n\x07success\x18\x01 \x01(\x08\x12\x0f\n\x07message\x18\x02 \x01(\t\x12\x10\n\x08group_id\x18\x03 \x01(\x03\x12\x14\n\x0cmember_count\x18\x04 \x01(\r\"\x81\x01\n\x0cGroupMessage\x12\x10\n\x08group_id\x18\x01 \x01(\x03\x12\x0f\n\x07\x63ontent\x18\x02 \x01(\t\x12\x15\n\rclient_msg_id\x18\x03 \x01(\t\x12\x11\n\tsender_id\x18\x04 \x01(\x03\x12\x0e\n\x06msg_id\x18\x05 \x01(\x04\x12\x14\n\x0ctimestamp_ms\x18\x06 \x01(\x03\"\x1f\n\x0c\x43lusterHello\x12\x0f\n\x07node_id\x18\x01 \x01(\r\"D\n\x0ePresenceUpdate\x12\x11\n\tfull_sync\x18\x01 \x01(\x08\x12\x0e\n\x06online\x18\x02 \x03(\x03\x12\x0f\n\x07offline\x18\x03 \x03(\x03\"(\n\x10\x43lusterHeartbeat\x12\x14\n\x0ctimestamp_ms\x18\x01 \x01(\x03\"2\n\x0f\x43lusterDelivery\x12\x10\n\x08user_ids\x18\x01 \x03(\x03\x12\r\n\x05\x66rame\x18\x02 \x01(\x0c\"\x92\x01\n\rErrorResponse\x12\x12\n\nerror_code\x18\x01 \x01(\r\x12\x0f\n\x07message\x18\x02 \x01(\t\x12,\n\x07\x64\x65tails\x18\x03 \x03(\x0b\x32\x1b.ErrorResponse.DetailsEntry\x1a.\n\x0c\x44\x65tailsEntry\x12\x0b\n\x03key\x18\x01 \x01(\t\x12\r\n\x05value\x18\x02 \x01(\t:\x02\x38\x01\"\xf0\x08\n\x06Packet\x12\x0f\n\x07version\x18\x01 \x01(\r\x12\x10\n\x08sequence\x18\x02 \x01(\r\x12$\n\x0c\x65\x63ho_request\x18\n \x01(\x0b\x32\x0c.EchoRequestH\x00\x12&\n\recho_response\x18\x0b \x01(\x0b\x32\r.EchoResponseH\x00\x12\x15\n\x04ping\x18\x0c \x01(\x0b\x32\x05.PingH\x00\x12\x15\n\x04pong\x18\r \x01(\x0b\x32\x05.PongH\x00\x12\x30\n\x12\x63\x61pability_request\x18\x0e \x01(\x0b\x32\x12.CapabilityRequestH\x00\x12\x32\n\x13\x63\x61pability_response\x18\x0f \x01(\x0b\x32\x13.CapabilityResponseH\x00\x12\x1d\n\x05\x62\x61tch\x18\x10 \x01(\x0b\x32\x0c.PacketBatchH\x00\x12,\n\x10register_request\x18\x64 \x01(\x0b\x32\x10.RegisterRequestH\x00\x12.\n\x11register_response\x18\x65 \x01(\x0b\x32\x11.RegisterResponseH\x00\x12&\n\rlogin_request\x18\x66 \x01(\x0b\x32\r.LoginRequestH\x00\x12(\n\x0elogin_response\x18g \x01(\x0b\x32\x0e.LoginResponseH\x00\x12(\n\x0eresume_request\x18h \x01(\x0b\x32\x0e.ResumeRequestH\x00\x12*\n\x0fresume_response\x18i \x01(\x0b\x32\x0f.ResumeResponseH\x00\x12%\n\x0c\x63hat_message\x18\xc8\x01 \x01(\x0b\x32\x0c.ChatMessageH\x00\x12\x1d\n\x08\x63hat_ack\x18\xc9\x01 \x01(\x0b\x32\x08.ChatAckH\x00\x12#\n\x0boffline_ack\x18\xca\x01 \x01(\x0b\x32\x0b.OfflineAckH\x00\x12\x34\n\x14\x63reate_group_request\x18\xd2\x01 \x01(\x0b\x32\x13.CreateGroupRequestH\x00\x12\x30\n\x12join_group_request\x18\xd3\x01 \x01(\x0b\x32\x11.JoinGroupRequestH\x00\x12\x32\n\x13leave_group_request\x18\xd4\x01 \x01(\x0b\x32\x12.LeaveGroupRequestH\x00\x12)\n\x0egroup_response\x18\xd5\x01 \x01(\x0b\x32\x0e.GroupResponseH\x00\x12\'\n\rgroup_message\x18\xd6\x01 \x01(\x0b\x32\r.GroupMessageH\x00\x12\'\n\rcluster_hello\x18\xac\x02 \x01(\x0b\x32\r.ClusterHelloH\x00\x12+\n\x0fpresence_update\x18\xad\x02 \x01(\x0b\x32\x0f.PresenceUpdateH\x00\x12/\n\x11\x63luster_heartbeat\x18\xae\x02 \x01(\x0b\x32\x11.ClusterHeartbeatH\x00\x12-\n\x10\x63luster_delivery\x18\xaf\x02 \x01(\x0b\x32\x10.ClusterDeliveryH\x00\x12 \n\x05\x65rror\x18\xe7\x07 \x01(\x0b\x32\x0e.ErrorResponseH\x00\x42\t\n\x07payloadb\x06proto3')
 
 _builder.BuildMessageAndEnumDescriptors(DESCRIPTOR, globals())
 _builder.BuildTopDescriptorsAndMessages(DESCRIPTOR, 'protos.messages_pb2', globals())
@@ -26,18 +26,56 @@ if _descriptor._USE_C_DESCRIPTORS == False:
   _ECHOREQUEST._serialized_end=55
   _ECHORESPONSE._serialized_start=57
   _ECHORESPONSE._serialized_end=88
-  _REGISTERREQUEST._serialized_start=90
-  _REGISTERREQUEST._serialized_end=143
-  _REGISTERRESPONSE._serialized_start=145
-  _REGISTERRESPONSE._serialized_end=214
-  _LOGINREQUEST._serialized_start=216
-  _LOGINREQUEST._serialized_end=266
-  _LOGINRESPONSE._serialized_start=268
-  _LOGINRESPONSE._serialized_end=352
-  _ERRORRESPONSE._serialized_start=355
-  _ERRORRESPONSE._serialized_end=501
-  _ERRORRESPONSE_DETAILSENTRY._serialized_start=455
-  _ERRORRESPONSE_DETAILSENTRY._serialized_end=501
-  _PACKET._serialized_start=504
-  _PACKET._serialized_end=846
+  _PING._serialized_start=90
+  _PING._serialized_end=118
+  _PONG._serialized_start=120
+  _PONG._serialized_end=148
+  _CAPABILITYREQUEST._serialized_start=150
+  _CAPABILITYREQUEST._serialized_end=211
+  _CAPABILITYRESPONSE._serialized_start=213
+  _CAPABILITYRESPONSE._serialized_end=306
+  _PACKETBATCH._serialized_start=308
+  _PACKETBATCH._serialized_end=347
+  _REGISTERREQUEST._serialized_start=349
+  _REGISTERREQUEST._serialized_end=402
+  _REGISTERRESPONSE._serialized_start=404
+  _REGISTERRESPONSE._serialized_end=473
+  _LOGINREQUEST._serialized_start=475
+  _LOGINREQUEST._serialized_end=525
+  _LOGINRESPONSE._serialized_start=528
+  _LOGINRESPONSE._serialized_end=661
+  _RESUMEREQUEST._serialized_start=663
+  _RESUMEREQUEST._serialized_end=700
+  _RESUMERESPONSE._serialized_start=703
+  _RESUMERESPONSE._serialized_end=837
+  _CHATMESSAGE._serialized_start=840
+  _CHATMESSAGE._serialized_end=972
+  _CHATACK._serialized_start=975
+  _CHATACK._serialized_end=1182
+  _OFFLINEACK._serialized_start=1184
+  _OFFLINEACK._serialized_end=1213
+  _CREATEGROUPREQUEST._serialized_start=1215
+  _CREATEGROUPREQUEST._serialized_end=1269
+  _JOINGROUPREQUEST._serialized_start=1271
+  _JOINGROUPREQUEST._serialized_end=1307
+  _LEAVEGROUPREQUEST._serialized_start=1309
+  _LEAVEGROUPREQUEST._serialized_end=1346
+  _GROUPRESPONSE._serialized_start=1348
+  _GROUPRESPONSE._serialized_end=1437
+  _GROUPMESSAGE._serialized_start=1440
+  _GROUPMESSAGE._serialized_end=1569
+  _CLUSTERHELLO._serialized_start=1571
+  _CLUSTERHELLO._serialized_end=1602
+  _PRESENCEUPDATE._serialized_start=1604
+  _PRESENCEUPDATE._serialized_end=1672
+  _CLUSTERHEARTBEAT._serialized_start=1674
+  _CLUSTERHEARTBEAT._serialized_end=1714
+  _CLUSTERDELIVERY._serialized_start=1716
+  _CLUSTERDELIVERY._serialized_end=1766
+  _ERRORRESPONSE._serialized_start=1769
+  _ERRORRESPONSE._serialized_end=1915
+  _ERRORRESPONSE_DETAILSENTRY._serialized_start=1869
+  _ERRORRESPONSE_DETAILSENTRY._serialized_end=1915
+  _PACKET._serialized_start=1918
+  _PACKET._serialized_end=3054
 # @@protoc_insertion_point(module_scope)
@@ -176,6 +176,46 @@ def test_invalid_version(client: ProtocolClient):
         return False
 
 
+def test_pipelined_echo(client: ProtocolClient, count: int = 20):
+    """Test pipelining: send many requests before reading any response"""
+    print(f"\n=== Testing Pipelined Echo x{count} ===")
+
+    # Build all frames first and send them in one write
+    frames = b''
+    for i in range(count):
+        packet = messages_pb2.Packet()
+        packet.version = 1
+        packet.sequence = 1000 + i
+        packet.echo_request.content = f"pipelined {i}"
+        data = packet.SerializeToString()
+        frames += struct.pack('!I', len(data)) + data
+
+    try:
+        client.socket.sendall(frames)
+    except Exception as e:
+        print(f"❌ Failed to send pipelined frames: {e}")
+        return False
+
+    # Every request must be answered exactly once, matched by sequence
+    received = {}
+    for _ in range(count):
+        response = client.receive_packet()
+        if not response:
+            return False
+        if not response.HasField('echo_response'):
+            print(f"❌ Unexpected response type: {response.WhichOneof('payload')}")
+            return False
+        received[response.sequence] = response.echo_response.content
+
+    for i in range(count):
+        if received.get(1000 + i) != f"pipelined {i}":
+            print(f"❌ Missing or wrong response for sequence {1000 + i}")
+            return False
+
+    print(f"✅ Success: Got all {count} pipelined responses")
+    return True
+
+
 def main():
     print("MyTelegram Stage 3 - Protobuf Protocol Test Client")
     print("=" * 50)
@@ -217,6 +257,11 @@ def main():
         if test_invalid_version(client):
             success_count += 1
 
+        # Test 6: Pipelined requests on one connection
+        total_tests += 1
+        if test_pipelined_echo(client):
+            success_count += 1
+
         # Results
         print(f"\n" + "=" * 50)
         print(f"Test Results: {success_count}/{total_tests} tests passed")
@@ -4,6 +4,8 @@ MyTelegram Stage 4 Test Client - Message Router System
 Test client for message routing and session management
 """
 
+import ctypes
+import ctypes.util
 import socket
 import struct
 import sys
@@ -150,6 +152,35 @@ def test_echo_routing(client: RouterTestClient, message: str, sequence: int = 1)
         return False
 
 
+def test_ping_pong(client: RouterTestClient, sequence: int = 20):
+    """Test that a Ping is answered with a Pong carrying the same timestamp"""
+    print(f"\n=== Testing Ping/Pong Heartbeat ===")
+
+    timestamp_ms = int(time.time() * 1000)
+    packet = messages_pb2.Packet()
+    packet.version = 1
+    packet.sequence = sequence
+    packet.ping.timestamp_ms = timestamp_ms
+
+    if not client.send_packet(packet):
+        return False
+
+    response = client.receive_packet()
+    if not response:
+        return False
+
+    if response.HasField('pong'):
+        if response.pong.timestamp_ms == timestamp_ms and response.sequence == sequence:
+            rtt_ms = int(time.time() * 1000) - timestamp_ms
+            print(f"✅ Success: Pong received (rtt {rtt_ms} ms)")
+            return True
+        print(f"❌ Pong mismatch: timestamp={response.pong.timestamp_ms}, sequence={response.sequence}")
+        return False
+    else:
+        print(f"❌ Expected pong, got: {response.WhichOneof('payload')}")
+        return False
+
+
 def test_unknown_message_type(client: RouterTestClient):
     """Test routing of unknown message types"""
     print(f"\n=== Testing Unknown Message Type Handling ===")
@@ -217,6 +248,80 @@ def test_multiple_sessions():
         return False
 
 
+def test_frame_compression():
+    """Test LZ4 frame compression negotiated through CapabilityRequest"""
+    print(f"\n=== Testing Frame Compression ===")
+
+    COMPRESSION_LZ4 = 1  # CapabilityRequest.compression 位掩码
+
+    client = RouterTestClient()
+    if not client.connect():
+        return False
+
+    try:
+        packet = messages_pb2.Packet()
+        packet.version = 1
+        packet.sequence = 30
+        packet.capability_request.compression = COMPRESSION_LZ4
+        if not client.send_packet(packet):
+            return False
+
+        response = client.receive_packet()
+        if not response or not response.HasField('capability_response'):
+            print("❌ Expected capability_response")
+            return False
+        if response.capability_response.compression != COMPRESSION_LZ4:
+            print("❌ Server did not accept LZ4 compression")
+            return False
+        threshold = response.capability_response.compression_threshold
+        print(f"Compression negotiated: lz4, threshold={threshold}")
+
+        # 大块可压缩内容：应答帧头最高位必须置位
+        message = "compress me " * 8000
+        packet = messages_pb2.Packet()
+        packet.version = 1
+        packet.sequence = 31
+        packet.echo_request.content = message
+        if not client.send_packet(packet):
+            return False
+
+        client.socket.settimeout(5.0)
+        header = client._receive_exactly(4)
+        if not header:
+            return False
+        frame_header = struct.unpack('!I', header)[0]
+        body = client._receive_exactly(frame_header & 0x7fffffff)
+        if not body:
+            return False
+        if not frame_header & 0x80000000:
+            print("❌ Large echo response was not compressed")
+            return False
+
+        raw_size = struct.unpack('!I', body[:4])[0]
+        print(f"Compressed frame: {len(body)} bytes on the wire, {raw_size} bytes raw")
+
+        library = ctypes.util.find_library('lz4')
+        if not library:
+            print("✅ Success: compressed frame received (liblz4 not found, payload not verified)")
+            return True
+
+        lz4 = ctypes.CDLL(library)
+        raw = ctypes.create_string_buffer(raw_size)
+        if lz4.LZ4_decompress_safe(body[4:], raw, len(body) - 4, raw_size) != raw_size:
+            print("❌ LZ4 decompression failed")
+            return False
+
+        echoed = messages_pb2.Packet()
+        echoed.ParseFromString(raw.raw)
+        if echoed.echo_response.content == message:
+            print("✅ Success: compressed echo response decoded correctly")
+            return True
+        print("❌ Decompressed content mismatch")
+        return False
+    finally:
+        client.disconnect()
+
+
 def test_invalid_protocol_version(client: RouterTestClient):
     """Test invalid protocol version handling"""
     print(f"\n=== Testing Invalid Protocol Version ===")
@@ -288,14 +393,24 @@ def main():
         if test_invalid_protocol_version(client):
             success_count += 1
 
+        # Test 6: Heartbeat
+        total_tests += 1
+        if test_ping_pong(client):
+            success_count += 1
+
     finally:
         client.disconnect()
 
-    # Test 6: Multiple session management (separate test)
+    # Test 7: Multiple session management (separate test)
     total_tests += 1
     if test_multiple_sessions():
         success_count += 1
 
+    # Test 8: Frame compression
+    total_tests += 1
+    if test_frame_compression():
+        success_count += 1
+
     # Results
     print(f"\n" + "=" * 60)
     print(f"Router Test Results: {success_count}/{total_tests} tests passed")
@@ -307,6 +422,8 @@ def main():
         print("  • Unknown message types return proper errors")
         print("  • Session management works with multiple clients")
         print("  • Protocol version validation functioning")
+        print("  • Ping answered with Pong")
+        print("  • LZ4 frame compression negotiated")
         print("  • Error handling and logging operational")
         return 0
     else:
@@ -131,6 +131,70 @@ class UserSystemClient:
         response_packet.ParseFromString(response_data)
         return response_packet
 
+    def resume_session(self, token: str, sequence: int = 3) -> Optional[messages_pb2.Packet]:
+        """Resume a session with a token from a previous login/resume"""
+        packet = messages_pb2.Packet()
+        packet.version = 1
+        packet.sequence = sequence
+        packet.resume_request.resume_token = token
+
+        data = packet.SerializeToString()
+        if not self.send_frame(data):
+            return None
+
+        response_data = self.receive_frame()
+        if not response_data:
+            return None
+
+        response_packet = messages_pb2.Packet()
+        response_packet.ParseFromString(response_data)
+        return response_packet
+
+
+    def send_chat(self, recipient_id: int, content: str, client_msg_id: str = "", sequence: int = 10) -> bool:
+        """Send a chat message; the ChatAck is read separately with receive_packet()"""
+        packet = messages_pb2.Packet()
+        packet.version = 1
+        packet.sequence = sequence
+        packet.chat_message.recipient_id = recipient_id
+        packet.chat_message.content = content
+        packet.chat_message.client_msg_id = client_msg_id
+        return self.send_frame(packet.SerializeToString())
+
+    def send_group_request(self, packet: messages_pb2.Packet, sequence: int) -> Optional[messages_pb2.Packet]:
+        """Send a packet with one of the group payloads filled in and wait for the response"""
+        packet.version = 1
+        packet.sequence = sequence
+        if not self.send_frame(packet.SerializeToString()):
+            return None
+        return self.receive_packet()
+
+    def create_group(self, name: str, member_ids, sequence: int = 20) -> Optional[messages_pb2.Packet]:
+        """Create a group; the creator is added as a member"""
+        packet = messages_pb2.Packet()
+        packet.create_group_request.name = name
+        packet.create_group_request.member_ids.extend(member_ids)
+        return self.send_group_request(packet, sequence)
+
+    def send_group_message(self, group_id: int, content: str, client_msg_id: str = "", sequence: int = 21) -> bool:
+        """Send a group message; the ChatAck is read separately with receive_packet()"""
+        packet = messages_pb2.Packet()
+        packet.version = 1
+        packet.sequence = sequence
+        packet.group_message.group_id = group_id
+        packet.group_message.content = content
+        packet.group_message.client_msg_id = client_msg_id
+        return self.send_frame(packet.SerializeToString())
+
+    def receive_packet(self) -> Optional[messages_pb2.Packet]:
+        """Receive and parse the next packet"""
+        response_data = self.receive_frame()
+        if not response_data:
+            return None
+        response_packet = messages_pb2.Packet()
+        response_packet.ParseFromString(response_data)
+        return response_packet
+
 
 class TestUserSystem(unittest.TestCase):
     """Test cases for user system functionality"""
@@ -257,6 +321,216 @@ class TestUserSystem(unittest.TestCase):
         self.assertFalse(login_resp.success, "Login should have failed for non-existent user")
         self.assertIn("not found", login_resp.message.lower(), "Error message should mention user not found")
     
+    def test_session_resume(self):
+        """Test reconnecting with the resume token instead of the password"""
+        print("\n=== Testing Session Resume ===")
+
+        username = f"resumetest_{int(time.time())}"
+        password = "resumepassword123"
+
+        reg_response = self.client.register_user(username, password, sequence=1)
+        self.assertIsNotNone(reg_response, "Registration failed")
+        self.assertTrue(reg_response.register_response.success, "Registration failed")
+
+        login_response = self.client.login_user(username, password, sequence=2)
+        self.assertIsNotNone(login_response, "No login response received")
+        login_resp = login_response.login_response
+        self.assertTrue(login_resp.success, f"Login failed: {login_resp.message}")
+        self.assertTrue(login_resp.resume_token, "Login response should carry a resume token")
+
+        # Reconnect on a new connection with the token
+        resumed = UserSystemClient()
+        self.assertTrue(resumed.connect(), "Failed to reconnect")
+        try:
+            response = resumed.resume_session(login_resp.resume_token, sequence=3)
+            self.assertIsNotNone(response, "No resume response received")
+            self.assertTrue(response.HasField('resume_response'), "Response is not a resume response")
+
+            resume_resp = response.resume_response
+            print(f"Resume result: {resume_resp.success}")
+            print(f"Message: {resume_resp.message}")
+            self.assertTrue(resume_resp.success, f"Resume failed: {resume_resp.message}")
+            self.assertEqual(resume_resp.user_id, login_resp.user_id, "User ID mismatch")
+            self.assertEqual(resume_resp.username, username, "Username mismatch")
+            self.assertTrue(resume_resp.resume_token, "Resume response should carry a rotated token")
+            self.assertNotEqual(resume_resp.resume_token, login_resp.resume_token, "Token should be rotated")
+
+            # The original token is single-use
+            replay = resumed.resume_session(login_resp.resume_token, sequence=4)
+            self.assertIsNotNone(replay, "No response for replayed token")
+            self.assertFalse(replay.resume_response.success, "Replayed token should be rejected")
+
+            # A tampered token is rejected
+            token = resume_resp.resume_token
+            tampered = token[:-1] + ('0' if token[-1] != '0' else '1')
+            bad = resumed.resume_session(tampered, sequence=5)
+            self.assertIsNotNone(bad, "No response for tampered token")
+            self.assertFalse(bad.resume_response.success, "Tampered token should be rejected")
+        finally:
+            resumed.disconnect()
+
+    def test_chat_message_delivery(self):
+        """Test point-to-point chat between two logged-in users"""
+        print("\n=== Testing Chat Message Delivery ===")
+
+        suffix = int(time.time())
+        alice_name, bob_name = f"chat_alice_{suffix}", f"chat_bob_{suffix}"
+        password = "chatpassword123"
+
+        bob = UserSystemClient()
+        self.assertTrue(bob.connect(), "Failed to connect second client")
+        try:
+            self.assertTrue(self.client.register_user(alice_name, password).register_response.success)
+            self.assertTrue(bob.register_user(bob_name, password).register_response.success)
+            alice_login = self.client.login_user(alice_name, password).login_response
+            bob_login = bob.login_user(bob_name, password).login_response
+            self.assertTrue(alice_login.success and bob_login.success, "Login failed")
+
+            self.assertTrue(self.client.send_chat(bob_login.user_id, "hello bob", client_msg_id="c-1", sequence=11))
+
+            ack_packet = self.client.receive_packet()
+            self.assertIsNotNone(ack_packet, "No chat ack received")
+            self.assertTrue(ack_packet.HasField('chat_ack'), "Response is not a chat ack")
+            ack = ack_packet.chat_ack
+            print(f"Ack: success={ack.success}, msg_id={ack.msg_id}, delivered={ack.delivered_sessions}")
+            self.assertTrue(ack.success, f"Chat rejected: {ack.message}")
+            self.assertEqual(ack.client_msg_id, "c-1")
+            self.assertEqual(ack_packet.sequence, 11)
+            self.assertEqual(ack.delivered_sessions, 1)
+
+            delivered = bob.receive_packet()
+            self.assertIsNotNone(delivered, "Recipient received nothing")
+            self.assertTrue(delivered.HasField('chat_message'), "Recipient did not get a chat message")
+            message = delivered.chat_message
+            self.assertEqual(message.content, "hello bob")
+            self.assertEqual(message.sender_id, alice_login.user_id)
+            self.assertEqual(message.msg_id, ack.msg_id)
+
+            # A second message gets a larger id
+            self.assertTrue(self.client.send_chat(bob_login.user_id, "second", sequence=12))
+            second_ack = self.client.receive_packet().chat_ack
+            self.assertGreater(second_ack.msg_id, ack.msg_id)
+            self.assertEqual(bob.receive_packet().chat_message.content, "second")
+        finally:
+            bob.disconnect()
+
+    def test_offline_message_delivery(self):
+        """Test that a message to an offline user is stored and delivered at login"""
+        print("\n=== Testing Offline Message Delivery ===")
+
+        suffix = int(time.time())
+        sender_name, offline_name = f"off_sender_{suffix}", f"off_recipient_{suffix}"
+        password = "offlinepassword123"
+
+        recipient = UserSystemClient()
+        self.assertTrue(recipient.connect(), "Failed to connect second client")
+        try:
+            self.assertTrue(self.client.register_user(sender_name, password).register_response.success)
+            self.assertTrue(recipient.register_user(offline_name, password).register_response.success)
+            sender = self.client.login_user(sender_name, password).login_response
+            self.assertTrue(sender.success, "Sender login failed")
+
+            # Recipient is registered but not logged in, so it has no online session
+            probe = UserSystemClient()
+            self.assertTrue(probe.connect())
+            try:
+                recipient_id = probe.login_user(offline_name, password).login_response.user_id
+            finally:
+                probe.disconnect()
+            time.sleep(0.2)
+
+            self.assertTrue(self.client.send_chat(recipient_id, "while you were away", sequence=14))
+            ack = self.client.receive_packet().chat_ack
+            print(f"Ack: success={ack.success}, delivered={ack.delivered_sessions}, stored={ack.stored_offline}")
+            self.assertTrue(ack.success, ack.message)
+            self.assertEqual(ack.delivered_sessions, 0)
+            self.assertTrue(ack.stored_offline, "Message should be stored for the offline recipient")
+
+            login = recipient.login_user(offline_name, password)
+            self.assertTrue(login.login_response.success)
+            delivered = recipient.receive_packet()
+            self.assertIsNotNone(delivered, "Offline message was not delivered at login")
+            self.assertTrue(delivered.HasField('chat_message'), "Expected a chat message after login")
+            self.assertEqual(delivered.chat_message.content, "while you were away")
+            self.assertEqual(delivered.chat_message.sender_id, sender.user_id)
+            self.assertEqual(delivered.chat_message.msg_id, ack.msg_id)
+        finally:
+            recipient.disconnect()
+
+    def test_chat_requires_login(self):
+        """Test that an unauthenticated session cannot send chat messages"""
+        print("\n=== Testing Chat Without Login ===")
+
+        self.assertTrue(self.client.send_chat(1, "hello", sequence=13))
+        response = self.client.receive_packet()
+        self.assertIsNotNone(response, "No response received")
+        self.assertTrue(response.HasField('chat_ack'), "Response is not a chat ack")
+        self.assertFalse(response.chat_ack.success, "Chat should be rejected before login")
+
+    def test_group_message_fanout(self):
+        """Test group creation, fan-out to members and leaving a group"""
+        print("\n=== Testing Group Message Fan-out ===")
+
+        suffix = int(time.time())
+        password = "grouppassword123"
+        others = [UserSystemClient() for _ in range(2)]
+        try:
+            self.assertTrue(self.client.register_user(f"grp_owner_{suffix}", password).register_response.success)
+            owner = self.client.login_user(f"grp_owner_{suffix}", password).login_response
+            self.assertTrue(owner.success, "Owner login failed")
+
+            member_ids = []
+            for i, other in enumerate(others):
+                self.assertTrue(other.connect(), "Failed to connect member client")
+                name = f"grp_member{i}_{suffix}"
+                self.assertTrue(other.register_user(name, password).register_response.success)
+                login = other.login_user(name, password).login_response
+                self.assertTrue(login.success, "Member login failed")
+                member_ids.append(login.user_id)
+
+            created = self.client.create_group(f"group_{suffix}", member_ids[:1], sequence=20)
+            self.assertIsNotNone(created, "No response for create_group")
+            self.assertTrue(created.HasField('group_response'), "Response is not a group response")
+            self.assertTrue(created.group_response.success, created.group_response.message)
+            self.assertEqual(created.group_response.member_count, 2)
+            group_id = created.group_response.group_id
+
+            # Second member joins on its own
+            join = messages_pb2.Packet()
+            join.join_group_request.group_id = group_id
+            joined = others[1].send_group_request(join, sequence=22).group_response
+            self.assertTrue(joined.success, joined.message)
+            self.assertEqual(joined.member_count, 3)
+
+            self.assertTrue(self.client.send_group_message(group_id, "hello group", client_msg_id="g-1"))
+            ack = self.client.receive_packet().chat_ack
+            print(f"Group ack: success={ack.success}, msg_id={ack.msg_id}, delivered={ack.delivered_sessions}")
+            self.assertTrue(ack.success, ack.message)
+            self.assertEqual(ack.client_msg_id, "g-1")
+            self.assertEqual(ack.delivered_sessions, 2)
+
+            for other in others:
+                delivered = other.receive_packet()
+                self.assertIsNotNone(delivered, "Member received nothing")
+                self.assertTrue(delivered.HasField('group_message'), "Member did not get a group message")
+                self.assertEqual(delivered.group_message.content, "hello group")
+                self.assertEqual(delivered.group_message.sender_id, owner.user_id)
+                self.assertEqual(delivered.group_message.msg_id, ack.msg_id)
+
+            # After leaving, the member can no longer post to the group
+            leave = messages_pb2.Packet()
+            leave.leave_group_request.group_id = group_id
+            left = others[0].send_group_request(leave, sequence=23).group_response
+            self.assertTrue(left.success, left.message)
+            self.assertEqual(left.member_count, 2)
+
+            self.assertTrue(others[0].send_group_message(group_id, "still here?"))
+            rejected = others[0].receive_packet().chat_ack
+            self.assertFalse(rejected.success, "Non-member should not be able to post")
+        finally:
+            for other in others:
+                other.disconnect()
+
     def test_invalid_username_registration(self):
         """Test registration with invalid username"""
         print("\n=== Testing Invalid Username Registration ===")